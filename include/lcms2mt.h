@@ -58,6 +58,9 @@
 // Uncomment to get rid of pthreads/windows dependency
 // #define CMS_NO_PTHREADS  1
 
+// Uncomment to get rid of memory mapped files. Files opened with the "m" access mode are then read in one go
+// #define CMS_NO_MMAP  1
+
 // Uncomment this for special windows mutex initialization (see lcms2_internal.h)
 // #define CMS_RELY_ON_WINDOWS_STATIC_MUTEX_INIT
 
@@ -1278,6 +1281,8 @@ CMSAPI cmsStage*         CMSEXPORT cmsPipelineGetPtrToLastStage(cmsContext Conte
 
 CMSAPI void              CMSEXPORT cmsPipelineEval16(cmsContext ContextID, const cmsUInt16Number In[], cmsUInt16Number Out[], const cmsPipeline* lut);
 CMSAPI void              CMSEXPORT cmsPipelineEvalFloat(cmsContext ContextID, const cmsFloat32Number In[], cmsFloat32Number Out[], const cmsPipeline* lut);
+CMSAPI void              CMSEXPORT cmsPipelineEval16N(cmsContext ContextID, const cmsUInt16Number In[], cmsUInt16Number Out[], cmsUInt32Number nPixels, const cmsPipeline* lut);
+CMSAPI void              CMSEXPORT cmsPipelineEvalFloatN(cmsContext ContextID, const cmsFloat32Number In[], cmsFloat32Number Out[], cmsUInt32Number nPixels, const cmsPipeline* lut);
 CMSAPI cmsBool           CMSEXPORT cmsPipelineEvalReverseFloat(cmsContext ContextID, cmsFloat32Number Target[], cmsFloat32Number Result[], cmsFloat32Number Hint[], const cmsPipeline* lut);
 CMSAPI cmsBool           CMSEXPORT cmsPipelineCat(cmsContext ContextID, cmsPipeline* l1, const cmsPipeline* l2);
 CMSAPI cmsBool           CMSEXPORT cmsPipelineSetSaveAs8bitsFlag(cmsContext ContextID, cmsPipeline* lut, cmsBool On);
@@ -1325,12 +1330,26 @@ typedef cmsInt32Number (* cmsSAMPLERFLOAT)(cmsContext ContextID, CMSREGISTER con
                                            CMSREGISTER cmsFloat32Number Out[],
                                            CMSREGISTER void * Cargo);
 
+// Row samplers. In holds nNodes grid nodes along the innermost dimension, packed, and Out their nNodes outputs
+typedef cmsInt32Number (* cmsSAMPLER16N)   (cmsContext ContextID, const cmsUInt16Number In[],
+                                            cmsUInt16Number Out[], cmsUInt32Number nNodes,
+                                            void * Cargo);
+
+typedef cmsInt32Number (* cmsSAMPLERFLOATN)(cmsContext ContextID, const cmsFloat32Number In[],
+                                            cmsFloat32Number Out[], cmsUInt32Number nNodes,
+                                            void * Cargo);
+
 // Use this flag to prevent changes being written to destination
 #define SAMPLER_INSPECT     0x01000000
 
+// Use this flag when the sampler is reentrant, so grid nodes may be sampled by several threads at once
+#define SAMPLER_THREADSAFE  0x02000000
+
 // For CLUT only
 CMSAPI cmsBool           CMSEXPORT cmsStageSampleCLut16bit(cmsContext ContextID, cmsStage* mpe, cmsSAMPLER16 Sampler, void* Cargo, cmsUInt32Number dwFlags);
 CMSAPI cmsBool           CMSEXPORT cmsStageSampleCLutFloat(cmsContext ContextID, cmsStage* mpe, cmsSAMPLERFLOAT Sampler, void* Cargo, cmsUInt32Number dwFlags);
+CMSAPI cmsBool           CMSEXPORT cmsStageSampleCLut16bitN(cmsContext ContextID, cmsStage* mpe, cmsSAMPLER16N Sampler, void* Cargo, cmsUInt32Number dwFlags);
+CMSAPI cmsBool           CMSEXPORT cmsStageSampleCLutFloatN(cmsContext ContextID, cmsStage* mpe, cmsSAMPLERFLOATN Sampler, void* Cargo, cmsUInt32Number dwFlags);
 
 // Slicers
 CMSAPI cmsBool           CMSEXPORT cmsSliceSpace16(cmsContext ContextID, cmsUInt32Number nInputs, const cmsUInt32Number clutPoints[],
@@ -1516,6 +1535,17 @@ CMSAPI cmsBool           CMSEXPORT cmsWriteTag(cmsContext ContextID, cmsHPROFILE
 CMSAPI cmsBool           CMSEXPORT cmsLinkTag(cmsContext ContextID, cmsHPROFILE hProfile, cmsTagSignature sig, cmsTagSignature dest);
 CMSAPI cmsTagSignature   CMSEXPORT cmsTagLinkedTo(cmsContext ContextID, cmsHPROFILE hProfile, cmsTagSignature sig);
 
+// Memory taken by decoded LUT based tags (AToB, BToA, DToB, BToD, gamut, preview...) of a profile read from file or
+// memory. Above MaxBytes, least recently read tags are released and decoded again when needed. Zero means no limit,
+// which is the default. cmsDropDecodedTags releases all of them now. In both cases, pointers returned by cmsReadTag
+// on those tags are only valid until the next call to cmsReadTag or cmsDropDecodedTags on the same profile. Released
+// tags are freed at once, so neither may be used on a profile that other threads are reading, even one without a budget
+// that was read without locking. Pooled profiles (see cmsOpenProfileFromMemPooled) are always shared, so both calls
+// fail on them; their decoded tags are bounded by the pool size instead. cmsDropDecodedTags returns the number of
+// tags released.
+CMSAPI cmsBool           CMSEXPORT cmsSetDecodedTagsBudget(cmsContext ContextID, cmsHPROFILE hProfile, cmsUInt32Number MaxBytes);
+CMSAPI cmsUInt32Number   CMSEXPORT cmsDropDecodedTags(cmsContext ContextID, cmsHPROFILE hProfile);
+
 // Read and write raw data
 CMSAPI cmsUInt32Number   CMSEXPORT cmsReadRawTag(cmsContext ContextID, cmsHPROFILE hProfile, cmsTagSignature sig, void* Buffer, cmsUInt32Number BufferSize);
 CMSAPI cmsBool           CMSEXPORT cmsWriteRawTag(cmsContext ContextID, cmsHPROFILE hProfile, cmsTagSignature sig, const void* data, cmsUInt32Number Size);
@@ -1608,6 +1638,7 @@ typedef struct _cms_io_handler cmsIOHANDLER;
 CMSAPI cmsIOHANDLER*     CMSEXPORT cmsOpenIOhandlerFromFile(cmsContext ContextID, const char* FileName, const char* AccessMode);
 CMSAPI cmsIOHANDLER*     CMSEXPORT cmsOpenIOhandlerFromStream(cmsContext ContextID, FILE* Stream);
 CMSAPI cmsIOHANDLER*     CMSEXPORT cmsOpenIOhandlerFromMem(cmsContext ContextID, void *Buffer, cmsUInt32Number size, const char* AccessMode);
+CMSAPI cmsIOHANDLER*     CMSEXPORT cmsOpenIOhandlerFromMemNoCopy(cmsContext ContextID, const void *Buffer, cmsUInt32Number size);
 CMSAPI cmsIOHANDLER*     CMSEXPORT cmsOpenIOhandlerFromNULL(cmsContext ContextID);
 CMSAPI cmsIOHANDLER*     CMSEXPORT cmsGetProfileIOhandler(cmsContext ContextID, cmsHPROFILE hProfile);
 CMSAPI cmsBool           CMSEXPORT cmsCloseIOhandler(cmsContext ContextID, cmsIOHANDLER* io);
@@ -1621,6 +1652,16 @@ CMSAPI cmsBool           CMSEXPORT cmsMD5computeID(cmsContext ContextID, cmsHPRO
 CMSAPI cmsHPROFILE      CMSEXPORT cmsOpenProfileFromFile(cmsContext ContextID, const char *ICCProfile, const char *sAccess);
 CMSAPI cmsHPROFILE      CMSEXPORT cmsOpenProfileFromStream(cmsContext ContextID, FILE* ICCProfile, const char* sAccess);
 CMSAPI cmsHPROFILE      CMSEXPORT cmsOpenProfileFromMem(cmsContext ContextID, const void * MemPtr, cmsUInt32Number dwSize);
+CMSAPI cmsHPROFILE      CMSEXPORT cmsOpenProfileFromMemNoCopy(cmsContext ContextID, const void * MemPtr, cmsUInt32Number dwSize);
+
+// Profile pool, disabled by default. Profiles opened by cmsOpenProfileFromMemPooled are shared by content (MD5 of the
+// block), along with their parsed tags. Each call returns a handle to be closed by cmsCloseProfile as usual. Pooled
+// profiles are read only. MaxBytes bounds the size of the pooled blocks plus their decoded LUT based tags, least
+// recently used ones are evicted first. Evicted profiles stay valid until their last handle is closed.
+// MaxBytes = 0 disables the pool and releases it.
+CMSAPI void             CMSEXPORT cmsSetProfilePoolSize(cmsContext ContextID, cmsUInt32Number MaxBytes);
+CMSAPI void             CMSEXPORT cmsGetProfilePoolStats(cmsContext ContextID, cmsUInt32Number* Hits, cmsUInt32Number* Misses);
+CMSAPI cmsHPROFILE      CMSEXPORT cmsOpenProfileFromMemPooled(cmsContext ContextID, const void * MemPtr, cmsUInt32Number dwSize);
 CMSAPI cmsHPROFILE      CMSEXPORT cmsOpenProfileFromIOhandler(cmsContext ContextID, cmsIOHANDLER* io);
 CMSAPI cmsHPROFILE      CMSEXPORT cmsOpenProfileFromIOhandler2(cmsContext ContextID, cmsIOHANDLER* io, cmsBool write);
 CMSAPI cmsBool          CMSEXPORT cmsCloseProfile(cmsContext ContextID, cmsHPROFILE hProfile);
@@ -1746,6 +1787,12 @@ CMSAPI cmsUInt32Number  CMSEXPORT cmsGetSupportedIntents(cmsContext ContextID,
 // CRD special
 #define cmsFLAGS_NODEFAULTRESOURCEDEF     0x01000000
 
+// Bypass the transform cache of the context (see cmsSetTransformCacheSize)
+#define cmsFLAGS_NOTRANSFORMCACHE         0x10000000
+
+// Use a multi-entry pixel cache on 16 bits transforms of up to 4 input channels
+#define cmsFLAGS_HASHCACHE                0x20000000
+
 // Transforms ---------------------------------------------------------------------------------------------------
 
 CMSAPI cmsHTRANSFORM    CMSEXPORT cmsCreateTransform(cmsContext ContextID,
@@ -1823,6 +1870,31 @@ CMSAPI void             CMSEXPORT cmsGetAlarmCodes(cmsContext ContextID,
 // Adaptation state for absolute colorimetric intent
 CMSAPI cmsFloat64Number CMSEXPORT cmsSetAdaptationState(cmsContext ContextID, cmsFloat64Number d);
 
+// Error budget for CLUT optimization, in 16 bits units. When positive, and the grid is not given by cmsFLAGS_GRIDPOINTS
+// nor asked by cmsFLAGS_HIGHRESPRECALC, the optimizer picks the smallest grid reproducing the transform within that error, up to the default grid.
+// Zero (the default) disables it. Returns the previous value; negative values just query it.
+CMSAPI cmsFloat64Number CMSEXPORT cmsSetGridpointsErrorBudget(cmsContext ContextID, cmsFloat64Number MaxError);
+
+// Transform cache, disabled by default. Transforms created with the same profiles (by MD5 of their contents, not
+// by the ID in the header), intents, BPC, adaptation states, formats and flags are shared. Each call still returns its own handle, to be freed
+// by cmsDeleteTransform as usual. MaxEntries = 0 disables the cache and releases it.
+CMSAPI void             CMSEXPORT cmsSetTransformCacheSize(cmsContext ContextID, cmsUInt32Number MaxEntries);
+CMSAPI void             CMSEXPORT cmsGetTransformCacheStats(cmsContext ContextID, cmsUInt32Number* Hits, cmsUInt32Number* Misses);
+
+// Hits and misses of the multi-entry pixel cache selected by cmsFLAGS_HASHCACHE
+CMSAPI void             CMSEXPORT cmsGetTransformPixelCacheStats(cmsContext ContextID, cmsHTRANSFORM hTransform, cmsUInt32Number* Hits, cmsUInt32Number* Misses);
+
+
+// Optimized transforms may be saved to memory and loaded back without linking and optimizing again. The block keeps
+// the MD5 of the profiles in the chain (pass the same profiles used to create the transform), formats and library version.
+// Colorant tables and the profile sequence (cmsFLAGS_KEEP_SEQUENCE) are kept too, so devicelinks can be made from loaded transforms.
+// When loading, nProfiles = 0 skips the profile check. Floating point, gamut check and plug-in transforms cannot be saved.
+CMSAPI cmsBool          CMSEXPORT cmsSaveTransformToMem(cmsContext ContextID, cmsHTRANSFORM hTransform,
+                                                        cmsUInt32Number nProfiles, cmsHPROFILE hProfiles[],
+                                                        void* MemPtr, cmsUInt32Number* BytesNeeded);
+CMSAPI cmsHTRANSFORM    CMSEXPORT cmsLoadTransformFromMem(cmsContext ContextID, const void* MemPtr, cmsUInt32Number dwSize,
+                                                          cmsUInt32Number nProfiles, cmsHPROFILE hProfiles[],
+                                                          cmsUInt32Number InputFormat, cmsUInt32Number OutputFormat);
 
 // Grab the input/output formats
 CMSAPI cmsUInt32Number CMSEXPORT cmsGetTransformInputFormat(cmsContext ContextID, cmsHTRANSFORM hTransform);
@@ -147,6 +147,7 @@ CMSAPI cmsBool           CMSEXPORT  _cmsReadUInt64Number(cmsContext ContextID, c
 CMSAPI cmsBool           CMSEXPORT  _cmsRead15Fixed16Number(cmsContext ContextID, cmsIOHANDLER* io, cmsFloat64Number* n);
 CMSAPI cmsBool           CMSEXPORT  _cmsReadXYZNumber(cmsContext ContextID, cmsIOHANDLER* io, cmsCIEXYZ* XYZ);
 CMSAPI cmsBool           CMSEXPORT  _cmsReadUInt16Array(cmsContext ContextID, cmsIOHANDLER* io, cmsUInt32Number n, cmsUInt16Number* Array);
+CMSAPI cmsBool           CMSEXPORT  _cmsReadFloat32Array(cmsContext ContextID, cmsIOHANDLER* io, cmsUInt32Number n, cmsFloat32Number* Array);
 
 CMSAPI cmsBool           CMSEXPORT  _cmsWriteUInt8Number(cmsContext ContextID, cmsIOHANDLER* io, cmsUInt8Number n);
 CMSAPI cmsBool           CMSEXPORT  _cmsWriteUInt16Number(cmsContext ContextID, cmsIOHANDLER* io, cmsUInt16Number n);
@@ -280,6 +281,24 @@ typedef union {
     _cmsInterpFnFloat    LerpFloat;         // Forward interpolation in floating point
 } cmsInterpFunction;
 
+// Batch versions of the above. Input holds nPixels pixels of nInputs channels each, one after the
+// other, and Output receives nPixels pixels of nOutputs channels. Those let the implementation
+// amortize setup and work on many pixels at once.
+typedef void (* _cmsInterpFn16N)(cmsContext ContextID, const cmsUInt16Number Input[],
+                                 cmsUInt16Number Output[],
+                                 cmsUInt32Number nPixels,
+                                 const struct _cms_interp_struc* p);
+
+typedef void (* _cmsInterpFnFloatN)(cmsContext ContextID, const cmsFloat32Number Input[],
+                                    cmsFloat32Number Output[],
+                                    cmsUInt32Number nPixels,
+                                    const struct _cms_interp_struc* p);
+
+typedef union {
+    _cmsInterpFn16N      Lerp16N;           // Batch interpolation in 16 bits
+    _cmsInterpFnFloatN   LerpFloatN;        // Batch interpolation in floating point
+} cmsInterpFunctionN;
+
 // Flags for interpolator selection
 #define CMS_LERP_FLAGS_16BITS             0x0000        // The default
 #define CMS_LERP_FLAGS_FLOAT              0x0001        // Requires different implementation
@@ -303,11 +322,13 @@ typedef struct _cms_interp_struc {  // Used on all interpolations. Supplied by l
 
     const void *Table;                // Points to the actual interpolation table
     cmsInterpFunction Interpolation;  // Points to the function to do the interpolation
+    cmsInterpFunctionN InterpolationN; // Same, on many pixels at once. Never NULL
 
  } cmsInterpParams;
 
 // Interpolators factory
 typedef cmsInterpFunction (* cmsInterpFnFactory)(cmsContext ContextID, cmsUInt32Number nInputChannels, cmsUInt32Number nOutputChannels, cmsUInt32Number dwFlags);
+typedef cmsInterpFunctionN (* cmsInterpFnFactoryN)(cmsContext ContextID, cmsUInt32Number nInputChannels, cmsUInt32Number nOutputChannels, cmsUInt32Number dwFlags);
 
 // The plug-in
 typedef struct {
@@ -316,6 +337,10 @@ typedef struct {
     // Points to a user-supplied function which implements the factory
     cmsInterpFnFactory InterpolatorsFactory;
 
+    // Optional batch interpolators (2.17). If NULL, or not supplied for some combination, the
+    // interpolators above are called once per pixel.
+    cmsInterpFnFactoryN InterpolatorsFactoryN;
+
 } cmsPluginInterpolation;
 
 //----------------------------------------------------------------------------------------------------------
@@ -489,6 +514,10 @@ typedef void (* _cmsStageEvalFn)     (cmsContext ContextID, const cmsFloat32Numb
 typedef void*(* _cmsStageDupElemFn)  (cmsContext ContextID, cmsStage* mpe);
 typedef void (* _cmsStageFreeElemFn) (cmsContext ContextID, cmsStage* mpe);
 
+// Optional evaluation of a block of nPixels. Samples are planar: channel i of pixel k is at [i * Stride + k]
+typedef void (* _cmsStageEvalNFn)    (cmsContext ContextID, const cmsFloat32Number In[], cmsFloat32Number Out[],
+                                      cmsUInt32Number nPixels, cmsUInt32Number Stride, const cmsStage* mpe);
+
 
 // This function allocates a generic MPE
 CMSAPI cmsStage* CMSEXPORT _cmsStageAllocPlaceholder(cmsContext ContextID,
@@ -499,6 +528,10 @@ CMSAPI cmsStage* CMSEXPORT _cmsStageAllocPlaceholder(cmsContext ContextID,
                                 _cmsStageDupElemFn    DupElemPtr,         // Points to a fn that duplicates the stage
                                 _cmsStageFreeElemFn   FreePtr,            // Points to a fn that sets the element free
                                 void*                 Data);              // A generic pointer to whatever memory needed by the element
+
+// Sets the block evaluator of a stage. If none is set, stages are evaluated pixel by pixel
+CMSAPI void      CMSEXPORT _cmsStageSetEvalN(cmsContext ContextID, cmsStage* mpe, _cmsStageEvalNFn EvalNPtr);
+
 typedef struct {
       cmsPluginBase     base;
       cmsTagTypeHandler Handler;
@@ -677,9 +710,22 @@ CMSAPI _cmsTransform2Fn CMSEXPORT _cmsGetTransformWorker(struct _cmstransform_st
 CMSAPI cmsInt32Number   CMSEXPORT _cmsGetTransformMaxWorkers(struct _cmstransform_struct* CMMcargo);
 CMSAPI cmsUInt32Number  CMSEXPORT _cmsGetTransformWorkerFlags(struct _cmstransform_struct* CMMcargo);
 
+// Maximum number of workers the plug-in was installed with on this context, or -1 to auto. Used for tasks
+// other than transforms, which have no transform to ask.
+CMSAPI cmsInt32Number   CMSEXPORT _cmsGetContextMaxWorkers(cmsContext ContextID);
+
 // Let's plug-in to guess the best number of workers
 #define CMS_GUESS_MAX_WORKERS -1
 
+// Called when the plug-in is removed from a context, either by cmsUnregisterPlugins() or
+// cmsDeleteContext(). Schedulers keeping per-context resources (i.e. thread pools) should free them here.
+typedef void (* _cmsParallelizationReleaseFn)(cmsContext ContextID);
+
+// Runs Task on every index from 0 to nTasks-1, possibly on several threads at once, and returns when all are
+// done. lcms uses it for independent work other than transforms, like sampling CLUT grids.
+typedef void (* _cmsParallelTaskFn)(cmsContext ContextID, cmsUInt32Number nTask, void* Cargo);
+typedef void (* _cmsParallelizationRunFn)(cmsContext ContextID, cmsUInt32Number nTasks, _cmsParallelTaskFn Task, void* Cargo);
+
 typedef struct {
     cmsPluginBase       base;
 
@@ -687,6 +733,12 @@ typedef struct {
     cmsUInt32Number     WorkerFlags;      // Reserved
     _cmsTransform2Fn    SchedulerFn;      // callback to setup functions     
 
+    // Since 2.17. Only read if ExpectedVersion >= (2170 - 2000), may be NULL
+    _cmsParallelizationReleaseFn ReleaseFn;
+
+    // Since 2.17. Only read if ExpectedVersion >= (2170 - 2000), may be NULL
+    _cmsParallelizationRunFn     RunTasksFn;
+
 }  cmsPluginParalellization;
 
 
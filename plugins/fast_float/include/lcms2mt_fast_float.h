@@ -42,6 +42,12 @@ extern "C" {
 
 //  #define CMS_DONT_USE_SSE2 1
 
+// Uncomment this if you want to avoid AVX2 only. Float matrix-shaper, float curves and tetrahedral kernels
+// have an AVX2 version that is selected when the transform is created, and only if the CPU does support it.
+// Disabling SSE2 disables AVX2 as well.
+
+//  #define CMS_DONT_USE_AVX2 1
+
 
 // The one and only plug-in entry point. To install this plugin in your code
 // you need to place this in some initialization place:
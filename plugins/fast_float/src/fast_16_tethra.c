@@ -21,14 +21,6 @@
 
 #include "fast_float_internal.h"
 
-// lcms internal
-CMSAPI cmsBool  CMSEXPORT _cmsOptimizePipeline(cmsContext ContextID,
-                              cmsPipeline** Lut,
-                              cmsUInt32Number  Intent,
-                              cmsUInt32Number* InputFormat,
-                              cmsUInt32Number* OutputFormat,
-                              cmsUInt32Number* dwFlags);
-
 
 // Optimization for 16 bits, 3 inputs only
 typedef struct {
@@ -304,7 +296,197 @@ void PerformanceEval16(cmsContext ContextID,
 
 #undef DENS
 
+#ifdef CMS_FF_AVX2
+
+// Gathers one output channel of the vertices at Index. All but the last channel read the 32 bit
+// word that starts at the sample, the last one the word that ends there, so the gather never
+// touches memory outside the table (needs more than one output channel).
+CMS_FF_TARGET_AVX2 cmsINLINE
+__m256i Gather16(const cmsUInt16Number* BaseTable, __m256i Index, cmsUInt32Number OutChan, cmsUInt32Number TotalOut)
+{
+    if (OutChan + 1 < TotalOut)
+        return _mm256_and_si256(_mm256_i32gather_epi32((const int*) (BaseTable + OutChan), Index, 2), _mm256_set1_epi32(0xFFFF));
+    else
+        return _mm256_srli_epi32(_mm256_i32gather_epi32((const int*) (BaseTable + OutChan - 1), Index, 2), 16);
+}
+
+// Same as PerformanceEval16, on blocks of 8 pixels. Each lane walks its own tetrahedron by stepping the
+// axes by decreasing rest, and the difference of each step goes with the rest of its axis. All is integer
+// and wraps the same as the plain C version, so the results are bit-exact.
+CMS_FF_TARGET_AVX2
+static
+void PerformanceEval16AVX2(cmsContext ContextID,
+                           struct _cmstransform_struct *CMMcargo,
+                           const cmsUInt8Number* Input,
+                           cmsUInt8Number* Output,
+                           cmsUInt32Number PixelsPerLine,
+                           cmsUInt32Number LineCount,
+                           const cmsStride* Stride)
+{
+       __m256i                r, g, b, fx, fy, fz, rx, ry, rz;
+       __m256i                X0, Y0, Z0, IncX, IncY, IncZ, Step1, Step3, I0, I1, I2, I3;
+       __m256i                GYX, GZX, GZY, XFirst, XLast, YFirst, YLast, ZFirst, ZLast;
+       __m256i                c0, v1, v2, v3, d1, d2, d3, cx, cy, cz, Rest;
+       const __m256i          AllOnes = _mm256_set1_epi32(-1);
+       cmsUInt32Number        OutChan, TotalPlusAlpha;
+       Performance16Data*     p16 = (Performance16Data*)_cmsGetTransformUserData(CMMcargo);
+       const cmsInterpParams* p = p16->p;
+       cmsUInt32Number        TotalOut = p->nOutputs;
+       const cmsUInt16Number* BaseTable = (const cmsUInt16Number*)p->Table;
+
+       cmsUInt8Number* out[cmsMAXCHANNELS];
+       const cmsUInt8Number* in[4];
+       cmsUInt32Number In[3][8], Res[8];
+       cmsUInt16Number res16;
+
+       cmsUInt32Number i, ii, j, k;
+
+       cmsUInt32Number SourceStartingOrder[cmsMAXCHANNELS];
+       cmsUInt32Number SourceIncrements[cmsMAXCHANNELS];
+       cmsUInt32Number DestStartingOrder[cmsMAXCHANNELS];
+       cmsUInt32Number DestIncrements[cmsMAXCHANNELS];
+
+       int    in16, out16;  // Used by macros!
+
+       cmsUInt32Number nalpha;
+       cmsUInt32Number nBlocks = PixelsPerLine / 8;
+       size_t strideIn, strideOut;
+
+       cmsUInt32Number dwInFormat = cmsGetTransformInputFormat(ContextID, (cmsHTRANSFORM)CMMcargo);
+       cmsUInt32Number dwOutFormat = cmsGetTransformOutputFormat(ContextID, (cmsHTRANSFORM)CMMcargo);
+       _cmsComputeComponentIncrements(dwInFormat, Stride->BytesPerPlaneIn, NULL, &nalpha, SourceStartingOrder, SourceIncrements);
+       _cmsComputeComponentIncrements(dwOutFormat, Stride->BytesPerPlaneOut, NULL, &nalpha, DestStartingOrder, DestIncrements);
+
+       in16  = (T_BYTES(dwInFormat) == 2);
+       out16 = (T_BYTES(dwOutFormat) == 2);
+
+       if (!(_cmsGetTransformFlags(CMMcargo) & cmsFLAGS_COPY_ALPHA))
+           nalpha = 0;
+
+       TotalPlusAlpha = TotalOut + nalpha;
+
+       strideIn = strideOut = 0;
+       for (i = 0; i < LineCount; i++) {
+
+              for (k = 0; k < 3 + nalpha; k++)
+                     in[k] = (const cmsUInt8Number*)Input + SourceStartingOrder[k] + strideIn;
+
+              for (OutChan = 0; OutChan < TotalPlusAlpha; OutChan++)
+                     out[OutChan] = (cmsUInt8Number*)Output + DestStartingOrder[OutChan] + strideOut;
+
+              for (ii = 0; ii < nBlocks; ii++) {
+
+                  for (j = 0; j < 8; j++) {
+                      for (k = 0; k < 3; k++) {
+
+                          In[k][j] = FROM_INPUT(in[k]);
+                          in[k] += SourceIncrements[k];
+                      }
+                  }
+
+                  r = _mm256_loadu_si256((const __m256i*) In[0]);
+                  g = _mm256_loadu_si256((const __m256i*) In[1]);
+                  b = _mm256_loadu_si256((const __m256i*) In[2]);
+
+                  // _cmsToFixedDomain, the division by 0xFFFF is exact on the whole range of r * Domain
+                  fx = _mm256_mullo_epi32(r, _mm256_set1_epi32((int) p->Domain[0]));
+                  fy = _mm256_mullo_epi32(g, _mm256_set1_epi32((int) p->Domain[1]));
+                  fz = _mm256_mullo_epi32(b, _mm256_set1_epi32((int) p->Domain[2]));
+
+                  rx = _mm256_add_epi32(fx, _mm256_set1_epi32(0x8000));
+                  ry = _mm256_add_epi32(fy, _mm256_set1_epi32(0x8000));
+                  rz = _mm256_add_epi32(fz, _mm256_set1_epi32(0x8000));
+
+                  fx = _mm256_add_epi32(fx, _mm256_srli_epi32(_mm256_add_epi32(rx, _mm256_srli_epi32(rx, 16)), 16));
+                  fy = _mm256_add_epi32(fy, _mm256_srli_epi32(_mm256_add_epi32(ry, _mm256_srli_epi32(ry, 16)), 16));
+                  fz = _mm256_add_epi32(fz, _mm256_srli_epi32(_mm256_add_epi32(rz, _mm256_srli_epi32(rz, 16)), 16));
+
+                  rx = _mm256_and_si256(fx, _mm256_set1_epi32(0xFFFF));
+                  ry = _mm256_and_si256(fy, _mm256_set1_epi32(0xFFFF));
+                  rz = _mm256_and_si256(fz, _mm256_set1_epi32(0xFFFF));
+
+                  X0 = _mm256_mullo_epi32(_mm256_srli_epi32(fx, 16), _mm256_set1_epi32((int) p->opta[2]));
+                  Y0 = _mm256_mullo_epi32(_mm256_srli_epi32(fy, 16), _mm256_set1_epi32((int) p->opta[1]));
+                  Z0 = _mm256_mullo_epi32(_mm256_srli_epi32(fz, 16), _mm256_set1_epi32((int) p->opta[0]));
+
+                  IncX = _mm256_andnot_si256(_mm256_cmpeq_epi32(r, _mm256_set1_epi32(0xFFFF)), _mm256_set1_epi32((int) p->opta[2]));
+                  IncY = _mm256_andnot_si256(_mm256_cmpeq_epi32(g, _mm256_set1_epi32(0xFFFF)), _mm256_set1_epi32((int) p->opta[1]));
+                  IncZ = _mm256_andnot_si256(_mm256_cmpeq_epi32(b, _mm256_set1_epi32(0xFFFF)), _mm256_set1_epi32((int) p->opta[0]));
+
+                  // Order of the axes, ties go to x first, then y
+                  GYX = _mm256_cmpgt_epi32(ry, rx);
+                  GZX = _mm256_cmpgt_epi32(rz, rx);
+                  GZY = _mm256_cmpgt_epi32(rz, ry);
+
+                  XFirst = _mm256_andnot_si256(_mm256_or_si256(GYX, GZX), AllOnes);
+                  XLast  = _mm256_and_si256(GYX, GZX);
+                  YFirst = _mm256_andnot_si256(GZY, GYX);
+                  YLast  = _mm256_andnot_si256(GYX, GZY);
+                  ZFirst = _mm256_and_si256(GZX, GZY);
+                  ZLast  = _mm256_andnot_si256(_mm256_or_si256(GZX, GZY), AllOnes);
+
+                  Step1 = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(XFirst, IncX), _mm256_and_si256(YFirst, IncY)), _mm256_and_si256(ZFirst, IncZ));
+                  Step3 = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(XLast, IncX), _mm256_and_si256(YLast, IncY)), _mm256_and_si256(ZLast, IncZ));
+
+                  I0 = _mm256_add_epi32(_mm256_add_epi32(X0, Y0), Z0);
+                  I1 = _mm256_add_epi32(I0, Step1);
+                  I3 = _mm256_add_epi32(I0, _mm256_add_epi32(_mm256_add_epi32(IncX, IncY), IncZ));
+                  I2 = _mm256_sub_epi32(I3, Step3);
+
+                  for (OutChan = 0; OutChan < TotalOut; OutChan++) {
+
+                      c0 = Gather16(BaseTable, I0, OutChan, TotalOut);
+                      v1 = Gather16(BaseTable, I1, OutChan, TotalOut);
+                      v2 = Gather16(BaseTable, I2, OutChan, TotalOut);
+                      v3 = Gather16(BaseTable, I3, OutChan, TotalOut);
+
+                      d1 = _mm256_sub_epi32(v1, c0);
+                      d2 = _mm256_sub_epi32(v2, v1);
+                      d3 = _mm256_sub_epi32(v3, v2);
+
+                      cx = _mm256_blendv_epi8(_mm256_blendv_epi8(d2, d1, XFirst), d3, XLast);
+                      cy = _mm256_blendv_epi8(_mm256_blendv_epi8(d2, d1, YFirst), d3, YLast);
+                      cz = _mm256_blendv_epi8(_mm256_blendv_epi8(d2, d1, ZFirst), d3, ZLast);
+
+                      Rest = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(cx, rx), _mm256_mullo_epi32(cy, ry)),
+                                              _mm256_add_epi32(_mm256_mullo_epi32(cz, rz), _mm256_set1_epi32(0x8001)));
+                      Rest = _mm256_srai_epi32(_mm256_add_epi32(Rest, _mm256_srai_epi32(Rest, 16)), 16);
+
+                      _mm256_storeu_si256((__m256i*) Res, _mm256_add_epi32(c0, Rest));
+
+                      for (j = 0; j < 8; j++) {
+
+                          res16 = (cmsUInt16Number) Res[j];
+                          TO_OUTPUT(out[OutChan], res16);
+                          out[OutChan] += DestIncrements[OutChan];
+                      }
+                  }
+
+                  if (nalpha) {
+
+                      for (j = 0; j < 8; j++) {
+
+                          res16 = *(const cmsUInt16Number*)in[3];
+                          TO_OUTPUT(out[TotalOut], res16);
+                          in[3] += SourceIncrements[3];
+                          out[TotalOut] += DestIncrements[TotalOut];
+                      }
+                  }
+              }
+
+              // Increments are the same for all channels, either chunky or planar
+              if (PixelsPerLine % 8)
+                  PerformanceEval16(ContextID, CMMcargo,
+                                    Input + strideIn + nBlocks * 8 * SourceIncrements[0],
+                                    Output + strideOut + nBlocks * 8 * DestIncrements[0],
+                                    PixelsPerLine % 8, 1, Stride);
+
+              strideIn += Stride->BytesPerLineIn;
+              strideOut += Stride->BytesPerLineOut;
+       }
+}
 
+#endif
 
 // --------------------------------------------------------------------------------------------------------------
 
@@ -370,6 +552,10 @@ cmsBool Optimize16BitRGBTransform(cmsContext ContextID,
     if (p16 == NULL) return FALSE;
 
     *TransformFn = PerformanceEval16;
+#ifdef CMS_FF_AVX2
+    if (p16->p->nOutputs > 1 && (FastFloatCPUFeatures() & FF_CPU_AVX2))
+        *TransformFn = PerformanceEval16AVX2;
+#endif
     *UserData   = p16;
     *FreeDataFn = Performance16free;
     *InputFormat  |= 0x02000000;
@@ -30,7 +30,6 @@
 #include <intrin.h>
 #else
 #include <x86intrin.h>
-#include <cpuid.h>
 #endif
 
 #include <emmintrin.h>
@@ -295,30 +294,6 @@ void MatShaperXform8SSE(cmsContext ContextID,
 }
 
 
-static
-cmsBool IsSSE2Available(void)
-{
-#ifdef _MSC_VER
-    int cpuinfo[4];
-
-    __cpuid(cpuinfo, 1);
-    if (!(cpuinfo[3] & (1 << 26))) return FALSE;
-    return TRUE;
-
-#else
-  unsigned int level = 1u;
-  unsigned int eax, ebx, ecx, edx;
-  unsigned int bits = (1u << 26);
-  unsigned int max = __get_cpuid_max(0, NULL);
-  if (level > max) {
-    return FALSE;
-  }
-  __cpuid_count(level, 0, eax, ebx, ecx, edx);
-  return (edx & bits) == bits;
-#endif
-}
-
-
 //  8 bits on input allows matrix-shaper boost up a little bit
 cmsBool Optimize8MatrixShaperSSE(cmsContext ContextID,
                                   _cmsTransform2Fn* TransformFn,
@@ -339,7 +314,7 @@ cmsBool Optimize8MatrixShaperSSE(cmsContext ContextID,
     cmsUInt32Number nChans;
 
     // Check for SSE2 support
-    if (!(IsSSE2Available())) return FALSE;
+    if (!(FastFloatCPUFeatures() & FF_CPU_SSE2)) return FALSE;
 
     // Only works on 3 to 3, probably RGB
     if ( !( (T_CHANNELS(*InputFormat) == 3 && T_CHANNELS(*OutputFormat) == 3) ) ) return FALSE;
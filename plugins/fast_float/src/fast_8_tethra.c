@@ -106,9 +106,34 @@ int XFormSampler16(cmsContext ContextID, CMSREGISTER const cmsUInt16Number In[],
 }
 
 
-// A optimized interpolation for 8-bit input.
-#define DENS(i,j,k) (LutTable[(i)+(j)+(k)+OutChan])
+// Interpolates all output channels in the tetrahedron given by the offsets of its vertices from the base node
+// (O1, O2, O3) and the weights along each edge. Constant channel counts get unrolled by the compiler.
+cmsINLINE void TetrahedralPixel8(const cmsUInt16Number* LutTable,
+                                 cmsUInt32Number O1, cmsUInt32Number O2, cmsUInt32Number O3,
+                                 cmsS15Fixed16Number w1, cmsS15Fixed16Number w2, cmsS15Fixed16Number w3,
+                                 cmsUInt8Number* out[], const cmsUInt32Number DestIncrements[],
+                                 cmsUInt32Number TotalOut)
+{
+    cmsS15Fixed16Number c0, c1, c2, c3, Rest;
+    cmsUInt16Number res16;
+    cmsUInt32Number OutChan;
+
+    for (OutChan = 0; OutChan < TotalOut; OutChan++) {
+
+        c0 = LutTable[OutChan];
+        c1 = LutTable[O1 + OutChan];
+        c2 = LutTable[O2 + OutChan];
+        c3 = LutTable[O3 + OutChan];
+
+        Rest = (c1 - c0) * w1 + (c2 - c1) * w2 + (c3 - c2) * w3 + 0x8001;
+        res16 = (cmsUInt16Number)c0 + ((Rest + (Rest >> 16)) >> 16);
+
+        *out[OutChan] = FROM_16_TO_8(res16);
+        out[OutChan] += DestIncrements[OutChan];
+    }
+}
 
+// A optimized interpolation for 8-bit input. Any number of outputs, chunky or planar.
 static
 void PerformanceEval8(cmsContext ContextID,
                       struct _cmstransform_struct *CMMcargo,
@@ -121,16 +146,17 @@ void PerformanceEval8(cmsContext ContextID,
 
     cmsUInt8Number         r, g, b;
     cmsS15Fixed16Number    rx, ry, rz;
-    cmsS15Fixed16Number    c0, c1, c2, c3, Rest;
+    cmsUInt32Number        X1, Y1, Z1;
+    cmsUInt32Number        O1, O2, O3;
+    cmsS15Fixed16Number    w1, w2, w3;
     cmsUInt32Number        OutChan, TotalPlusAlpha;
-    cmsS15Fixed16Number    X0, X1, Y0, Y1, Z0, Z1;
     Performance8Data*      p8 = (Performance8Data*)_cmsGetTransformUserData(CMMcargo);
     const cmsInterpParams* p = p8->p;
     cmsUInt32Number        TotalOut = p->nOutputs;
-    const cmsUInt16Number* LutTable = (const cmsUInt16Number*)p->Table;
+    const cmsUInt16Number* BaseTable = (const cmsUInt16Number*)p->Table;
+    const cmsUInt16Number* LutTable;
 
     cmsUInt8Number* out[cmsMAXCHANNELS];
-    cmsUInt16Number res16;
 
     cmsUInt32Number i, ii;
 
@@ -178,76 +204,51 @@ void PerformanceEval8(cmsContext ContextID,
             gin += SourceIncrements[1];
             bin += SourceIncrements[2];
 
-            X0 = X1 = p8->X0[r];
-            Y0 = Y1 = p8->Y0[g];
-            Z0 = Z1 = p8->Z0[b];
+            LutTable = BaseTable + p8->X0[r] + p8->Y0[g] + p8->Z0[b];
 
             rx = p8->rx[r];
             ry = p8->ry[g];
             rz = p8->rz[b];
 
-            X1 = X0 + ((rx == 0) ? 0 : p->opta[2]);
-            Y1 = Y0 + ((ry == 0) ? 0 : p->opta[1]);
-            Z1 = Z0 + ((rz == 0) ? 0 : p->opta[0]);
-
+            X1 = (rx == 0) ? 0 : p->opta[2];
+            Y1 = (ry == 0) ? 0 : p->opta[1];
+            Z1 = (rz == 0) ? 0 : p->opta[0];
 
-            // These are the 6 Tetrahedral
-            for (OutChan = 0; OutChan < TotalOut; OutChan++) {
+            // Which of the 6 tetrahedra. Its edges are walked from the base node, biggest rest first.
+            // On ties, both tetrahedra give the same values.
+            if (rx >= ry) {
 
-                c0 = DENS(X0, Y0, Z0);
+                if (ry >= rz) {
+                    O1 = X1; w1 = rx; O2 = O1 + Y1; w2 = ry; w3 = rz;
+                }
+                else if (rz >= rx) {
+                    O1 = Z1; w1 = rz; O2 = O1 + X1; w2 = rx; w3 = ry;
+                }
+                else {
+                    O1 = X1; w1 = rx; O2 = O1 + Z1; w2 = rz; w3 = ry;
+                }
+            }
+            else {
 
-                if (rx >= ry && ry >= rz)
-                {
-                    c1 = DENS(X1, Y0, Z0) - c0;
-                    c2 = DENS(X1, Y1, Z0) - DENS(X1, Y0, Z0);
-                    c3 = DENS(X1, Y1, Z1) - DENS(X1, Y1, Z0);
+                if (rx >= rz) {
+                    O1 = Y1; w1 = ry; O2 = O1 + X1; w2 = rx; w3 = rz;
+                }
+                else if (ry >= rz) {
+                    O1 = Y1; w1 = ry; O2 = O1 + Z1; w2 = rz; w3 = rx;
+                }
+                else {
+                    O1 = Z1; w1 = rz; O2 = O1 + Y1; w2 = ry; w3 = rx;
                 }
-                else
-                    if (rx >= rz && rz >= ry)
-                    {
-                        c1 = DENS(X1, Y0, Z0) - c0;
-                        c2 = DENS(X1, Y1, Z1) - DENS(X1, Y0, Z1);
-                        c3 = DENS(X1, Y0, Z1) - DENS(X1, Y0, Z0);
-                    }
-                    else
-                        if (rz >= rx && rx >= ry)
-                        {
-                            c1 = DENS(X1, Y0, Z1) - DENS(X0, Y0, Z1);
-                            c2 = DENS(X1, Y1, Z1) - DENS(X1, Y0, Z1);
-                            c3 = DENS(X0, Y0, Z1) - c0;
-                        }
-                        else
-                            if (ry >= rx && rx >= rz)
-                            {
-                                c1 = DENS(X1, Y1, Z0) - DENS(X0, Y1, Z0);
-                                c2 = DENS(X0, Y1, Z0) - c0;
-                                c3 = DENS(X1, Y1, Z1) - DENS(X1, Y1, Z0);
-                            }
-                            else
-                                if (ry >= rz && rz >= rx)
-                                {
-                                    c1 = DENS(X1, Y1, Z1) - DENS(X0, Y1, Z1);
-                                    c2 = DENS(X0, Y1, Z0) - c0;
-                                    c3 = DENS(X0, Y1, Z1) - DENS(X0, Y1, Z0);
-                                }
-                                else
-                                    if (rz >= ry && ry >= rx)
-                                    {
-                                        c1 = DENS(X1, Y1, Z1) - DENS(X0, Y1, Z1);
-                                        c2 = DENS(X0, Y1, Z1) - DENS(X0, Y0, Z1);
-                                        c3 = DENS(X0, Y0, Z1) - c0;
-                                    }
-                                    else {
-                                        c1 = c2 = c3 = 0;
-                                    }
-
-
-                Rest = c1 * rx + c2 * ry + c3 * rz + 0x8001;
-                res16 = (cmsUInt16Number)c0 + ((Rest + (Rest >> 16)) >> 16);
-
-                *out[OutChan] = FROM_16_TO_8(res16);
-                out[OutChan] += DestIncrements[OutChan];
+            }
+
+            O3 = X1 + Y1 + Z1;
 
+            switch (TotalOut) {
+
+            case 1:  TetrahedralPixel8(LutTable, O1, O2, O3, w1, w2, w3, out, DestIncrements, 1); break;
+            case 3:  TetrahedralPixel8(LutTable, O1, O2, O3, w1, w2, w3, out, DestIncrements, 3); break;
+            case 4:  TetrahedralPixel8(LutTable, O1, O2, O3, w1, w2, w3, out, DestIncrements, 4); break;
+            default: TetrahedralPixel8(LutTable, O1, O2, O3, w1, w2, w3, out, DestIncrements, TotalOut); break;
             }
 
             if (ain) {
@@ -263,8 +264,6 @@ void PerformanceEval8(cmsContext ContextID,
     }
 }
 
-#undef DENS
-
 
 // Curves that contain wide empty areas are not optimizeable
 static
@@ -362,9 +361,9 @@ cmsBool Optimize8BitRGBTransform( cmsContext ContextID,
 
     // Only on RGB
     if (T_COLORSPACE(*InputFormat)  != PT_RGB) return FALSE;
-   
-    // This optimization only works on RGB8->RGB8
-    if (T_COLORSPACE(*OutputFormat) != PT_RGB) return FALSE;
+
+    // Any output, as long as there is room for the alpha channel
+    if (cmsPipelineOutputChannels(ContextID, *Lut) >= cmsMAXCHANNELS) return FALSE;
 
     OriginalLut = *Lut;
     nGridPoints      = _cmsReasonableGridpointsByColorspace(ContextID, cmsSigRgbData, *dwFlags);
@@ -373,6 +372,33 @@ cmsBool Optimize8BitRGBTransform( cmsContext ContextID,
     memset(Trans, 0, sizeof(Trans));
     memset(TransReverse, 0, sizeof(TransReverse));
 
+    // The gray ramp only gives prelinearization curves on RGB8->RGB8, other outputs go thru the CLUT alone
+    if (T_COLORSPACE(*OutputFormat) != PT_RGB || cmsPipelineOutputChannels(ContextID, OriginalLut) != 3) {
+
+        OptimizedLUT = cmsPipelineAlloc(ContextID, 3, cmsPipelineOutputChannels(ContextID, OriginalLut));
+        if (OptimizedLUT == NULL) return FALSE;
+
+        OptimizedCLUTmpe = cmsStageAllocCLut16bit(ContextID, nGridPoints, 3, cmsPipelineOutputChannels(ContextID, OriginalLut), NULL);
+        if (!cmsPipelineInsertStage(ContextID, OptimizedLUT, cmsAT_END, OptimizedCLUTmpe)) goto Error;
+
+        if (!cmsStageSampleCLut16bit(ContextID, OptimizedCLUTmpe, XFormSampler16, (void*) OriginalLut, SAMPLER_THREADSAFE)) goto Error;
+
+        data = (_cmsStageCLutData*) cmsStageData(ContextID, OptimizedCLUTmpe);
+
+        p8 = Performance8alloc(ContextID, data ->Params, NULL);
+        if (p8 == NULL) goto Error;
+
+        cmsPipelineFree(ContextID, OriginalLut);
+
+        *dwFlags &= ~cmsFLAGS_CAN_CHANGE_FORMATTER;
+        *Lut = OptimizedLUT;
+        *TransformFn = PerformanceEval8;
+        *UserData   = p8;
+        *FreeDataFn = Performance8free;
+
+        return TRUE;
+    }
+
     MyTable[0] = (cmsUInt16Number*) _cmsMallocZero(ContextID, sizeof(cmsUInt16Number) * PRELINEARIZATION_POINTS);
     MyTable[1] = (cmsUInt16Number*) _cmsMallocZero(ContextID, sizeof(cmsUInt16Number) * PRELINEARIZATION_POINTS);
     MyTable[2] = (cmsUInt16Number*) _cmsMallocZero(ContextID, sizeof(cmsUInt16Number) * PRELINEARIZATION_POINTS);
@@ -446,7 +472,7 @@ cmsBool Optimize8BitRGBTransform( cmsContext ContextID,
     cmsPipelineInsertStage(ContextID, OptimizedLUT, cmsAT_END, OptimizedCLUTmpe);
 
     // Resample the LUT
-    if (!cmsStageSampleCLut16bit(ContextID, OptimizedCLUTmpe, XFormSampler16, (void*) LutPlusCurves, 0)) goto Error;
+    if (!cmsStageSampleCLut16bit(ContextID, OptimizedCLUTmpe, XFormSampler16, (void*) LutPlusCurves, SAMPLER_THREADSAFE)) goto Error;
 
     // Set the evaluator
     data = (_cmsStageCLutData*) cmsStageData(ContextID, OptimizedCLUTmpe);
@@ -362,7 +362,7 @@ cmsBool OptimizeCLUTCMYKTransform(cmsContext ContextID,
     cmsPipelineInsertStage(ContextID, OptimizedLUT, cmsAT_BEGIN, OptimizedCLUTmpe);
 
     // Resample the LUT
-    if (!cmsStageSampleCLutFloat(ContextID, OptimizedCLUTmpe, XFormSampler, (void*)OriginalLut, 0)) goto Error;
+    if (!cmsStageSampleCLutFloat(ContextID, OptimizedCLUTmpe, XFormSampler, (void*)OriginalLut, SAMPLER_THREADSAFE)) goto Error;
 
     // Set the evaluator, copy parameters
     data = (_cmsStageCLutData*) cmsStageData(ContextID, OptimizedCLUTmpe);
@@ -386,3 +386,305 @@ Error:
 
     return FALSE;
 }
+
+
+// 8 and 16 bits -------------------------------------------------------------------------------------------------
+
+// Integer 4D interpolation, same arithmetic as Eval4Inputs in lcms core: two tetrahedral interpolations in the
+// CLUT slices around the first channel, then a linear interpolation between them. 8 bit input goes thru
+// precomputed tables.
+typedef struct {
+
+    const cmsInterpParams* p;   // Tetrahedrical interpolation parameters. This is a not-owned pointer.
+
+    // For 8 bits input, indexed by channel and value. Offset of the node, offset to the next node and rest.
+    cmsUInt32Number Base[4][256];
+    cmsUInt32Number Next[4][256];
+    cmsS15Fixed16Number Rest[4][256];
+
+} Performance16CMYKData;
+
+
+// Precomputes tables for 8-bit on input devicelink.
+static
+Performance16CMYKData* Performance16CMYKalloc(cmsContext ContextID, const cmsInterpParams* p)
+{
+    Performance16CMYKData* p16;
+    cmsUInt32Number i, v;
+    cmsS15Fixed16Number f;
+
+    p16 = (Performance16CMYKData*) _cmsMallocZero(ContextID, sizeof(Performance16CMYKData));
+    if (p16 == NULL) return NULL;
+
+    p16 ->p = p;
+
+    // Channel i goes with opta[3 - i]
+    for (i=0; i < 4; i++) {
+        for (v=0; v < 256; v++) {
+
+            f = _cmsToFixedDomain((int) FROM_8_TO_16(v) * p ->Domain[i]);
+
+            p16 ->Base[i][v] = p ->opta[3 - i] * FIXED_TO_INT(f);
+            p16 ->Next[i][v] = (v == 255 ? 0 : p ->opta[3 - i]);
+            p16 ->Rest[i][v] = FIXED_REST_TO_INT(f);
+        }
+    }
+
+    return p16;
+}
+
+static
+void Performance16CMYKfree(cmsContext ContextID, void* ptr)
+{
+    _cmsFree(ContextID, ptr);
+}
+
+cmsINLINE cmsUInt16Number LinearInterp16(cmsS15Fixed16Number a, cmsS15Fixed16Number l, cmsS15Fixed16Number h)
+{
+    cmsUInt32Number dif = (cmsUInt32Number) (h - l) * a + 0x8000;
+    dif = (dif >> 16) + l;
+    return (cmsUInt16Number) (dif);
+}
+
+#define ROUND_FIXED_TO_INT16(x) (((x)+0x8000)>>16)
+
+#define TO_OUTPUT_16(d,v)  do { *(cmsUInt16Number*) (d) = v; } while(0)
+#define TO_OUTPUT_8(d,v)   do { *(cmsUInt8Number*) (d) = FROM_16_TO_8(v); } while(0)
+
+#define TO_OUTPUT(d,v) do { if (out16) TO_OUTPUT_16(d,v); else TO_OUTPUT_8(d,v); } while(0)
+
+static
+void PerformanceEval16CMYK(cmsContext ContextID,
+                           struct _cmstransform_struct *CMMcargo,
+                           const cmsUInt8Number* Input,
+                           cmsUInt8Number* Output,
+                           cmsUInt32Number PixelsPerLine,
+                           cmsUInt32Number LineCount,
+                           const cmsStride* Stride)
+{
+    cmsUInt32Number        v[4];
+    cmsUInt32Number        Base[4], Next[4];
+    cmsS15Fixed16Number    Rest[4];
+    cmsS15Fixed16Number    f;
+    cmsUInt32Number        O1, O2, O3;
+    cmsS15Fixed16Number    w1, w2, w3;
+    cmsS15Fixed16Number    c0, c1, c2, c3, Sum;
+    cmsUInt16Number        Tmp1, Tmp2, res16;
+    cmsUInt32Number        OutChan, TotalPlusAlpha, ch;
+    Performance16CMYKData* p16 = (Performance16CMYKData*) _cmsGetTransformUserData(CMMcargo);
+    const cmsInterpParams* p = p16 ->p;
+    cmsUInt32Number        TotalOut = p ->nOutputs;
+    const cmsUInt16Number* BaseTable = (const cmsUInt16Number*) p ->Table;
+    const cmsUInt16Number* Lut0;
+    const cmsUInt16Number* Lut1;
+
+    cmsUInt8Number* out[cmsMAXCHANNELS];
+    const cmsUInt8Number* in[4];
+    const cmsUInt8Number* ain = NULL;
+
+    cmsUInt32Number i, ii;
+
+    cmsUInt32Number SourceStartingOrder[cmsMAXCHANNELS];
+    cmsUInt32Number SourceIncrements[cmsMAXCHANNELS];
+    cmsUInt32Number DestStartingOrder[cmsMAXCHANNELS];
+    cmsUInt32Number DestIncrements[cmsMAXCHANNELS];
+
+    int    in16, out16;  // Used by macros!
+
+    cmsUInt32Number nalpha;
+    size_t strideIn, strideOut;
+
+    cmsUInt32Number dwInFormat  = cmsGetTransformInputFormat(ContextID, (cmsHTRANSFORM)CMMcargo);
+    cmsUInt32Number dwOutFormat = cmsGetTransformOutputFormat(ContextID, (cmsHTRANSFORM)CMMcargo);
+    _cmsComputeComponentIncrements(dwInFormat, Stride->BytesPerPlaneIn, NULL, &nalpha, SourceStartingOrder, SourceIncrements);
+    _cmsComputeComponentIncrements(dwOutFormat, Stride->BytesPerPlaneOut, NULL, &nalpha, DestStartingOrder, DestIncrements);
+
+    in16  = (T_BYTES(dwInFormat) == 2);
+    out16 = (T_BYTES(dwOutFormat) == 2);
+
+    if (!(_cmsGetTransformFlags(CMMcargo) & cmsFLAGS_COPY_ALPHA))
+        nalpha = 0;
+
+    strideIn = strideOut = 0;
+    for (i = 0; i < LineCount; i++) {
+
+        for (ch = 0; ch < 4; ch++)
+            in[ch] = (const cmsUInt8Number*)Input + SourceStartingOrder[ch] + strideIn;
+
+        if (nalpha)
+            ain = (const cmsUInt8Number*)Input + SourceStartingOrder[4] + strideIn;
+
+        TotalPlusAlpha = TotalOut;
+        if (ain) TotalPlusAlpha++;
+
+        for (OutChan = 0; OutChan < TotalPlusAlpha; OutChan++) {
+            out[OutChan] = (cmsUInt8Number*)Output + DestStartingOrder[OutChan] + strideOut;
+        }
+
+        for (ii = 0; ii < PixelsPerLine; ii++) {
+
+            if (in16) {
+
+                for (ch = 0; ch < 4; ch++) {
+
+                    v[ch] = *(const cmsUInt16Number*) in[ch];
+                    in[ch] += SourceIncrements[ch];
+
+                    f = _cmsToFixedDomain((int) v[ch] * p ->Domain[ch]);
+
+                    Base[ch] = p ->opta[3 - ch] * FIXED_TO_INT(f);
+                    Next[ch] = (v[ch] == 0xFFFFU ? 0 : p ->opta[3 - ch]);
+                    Rest[ch] = FIXED_REST_TO_INT(f);
+                }
+            }
+            else {
+
+                for (ch = 0; ch < 4; ch++) {
+
+                    v[ch] = *in[ch];
+                    in[ch] += SourceIncrements[ch];
+
+                    Base[ch] = p16 ->Base[ch][v[ch]];
+                    Next[ch] = p16 ->Next[ch][v[ch]];
+                    Rest[ch] = p16 ->Rest[ch][v[ch]];
+                }
+            }
+
+            // Walk the tetrahedron from the node to the opposite corner, biggest rest first. Ties give the
+            // same result whatever the order, so this matches the six cases of Eval4Inputs.
+            if (Rest[1] >= Rest[2]) {
+
+                if (Rest[2] >= Rest[3]) {
+                    O1 = Next[1]; w1 = Rest[1]; O2 = O1 + Next[2]; w2 = Rest[2]; w3 = Rest[3];
+                }
+                else if (Rest[3] >= Rest[1]) {
+                    O1 = Next[3]; w1 = Rest[3]; O2 = O1 + Next[1]; w2 = Rest[1]; w3 = Rest[2];
+                }
+                else {
+                    O1 = Next[1]; w1 = Rest[1]; O2 = O1 + Next[3]; w2 = Rest[3]; w3 = Rest[2];
+                }
+            }
+            else {
+
+                if (Rest[1] >= Rest[3]) {
+                    O1 = Next[2]; w1 = Rest[2]; O2 = O1 + Next[1]; w2 = Rest[1]; w3 = Rest[3];
+                }
+                else if (Rest[2] >= Rest[3]) {
+                    O1 = Next[2]; w1 = Rest[2]; O2 = O1 + Next[3]; w2 = Rest[3]; w3 = Rest[1];
+                }
+                else {
+                    O1 = Next[3]; w1 = Rest[3]; O2 = O1 + Next[2]; w2 = Rest[2]; w3 = Rest[1];
+                }
+            }
+
+            O3 = Next[1] + Next[2] + Next[3];
+
+            Lut0 = BaseTable + Base[0] + Base[1] + Base[2] + Base[3];
+            Lut1 = Lut0 + Next[0];
+
+            for (OutChan = 0; OutChan < TotalOut; OutChan++) {
+
+                c0 = Lut0[0]; c1 = Lut0[O1]; c2 = Lut0[O2]; c3 = Lut0[O3];
+                Sum = (c1 - c0) * w1 + (c2 - c1) * w2 + (c3 - c2) * w3;
+                Tmp1 = (cmsUInt16Number) (c0 + ROUND_FIXED_TO_INT16(_cmsToFixedDomain(Sum)));
+
+                c0 = Lut1[0]; c1 = Lut1[O1]; c2 = Lut1[O2]; c3 = Lut1[O3];
+                Sum = (c1 - c0) * w1 + (c2 - c1) * w2 + (c3 - c2) * w3;
+                Tmp2 = (cmsUInt16Number) (c0 + ROUND_FIXED_TO_INT16(_cmsToFixedDomain(Sum)));
+
+                res16 = LinearInterp16(Rest[0], Tmp1, Tmp2);
+
+                TO_OUTPUT(out[OutChan], res16);
+                out[OutChan] += DestIncrements[OutChan];
+
+                Lut0++;
+                Lut1++;
+            }
+
+            if (ain)
+            {
+                res16 = in16 ? *(const cmsUInt16Number*) ain : FROM_8_TO_16(*ain);
+                TO_OUTPUT(out[TotalOut], res16);
+                ain += SourceIncrements[4];
+                out[TotalOut] += DestIncrements[TotalOut];
+            }
+        }
+
+        strideIn += Stride->BytesPerLineIn;
+        strideOut += Stride->BytesPerLineOut;
+    }
+}
+
+#undef TO_OUTPUT
+#undef TO_OUTPUT_8
+#undef TO_OUTPUT_16
+#undef ROUND_FIXED_TO_INT16
+
+
+// --------------------------------------------------------------------------------------------------------------
+
+cmsBool Optimize16BitCMYKTransform(cmsContext ContextID,
+                                   _cmsTransform2Fn* TransformFn,
+                                   void** UserData,
+                                   _cmsFreeUserDataFn* FreeDataFn,
+                                   cmsPipeline** Lut,
+                                   cmsUInt32Number* InputFormat,
+                                   cmsUInt32Number* OutputFormat,
+                                   cmsUInt32Number* dwFlags)
+{
+    Performance16CMYKData* p16;
+    _cmsStageCLutData* data;
+    cmsUInt32Number newFlags;
+    cmsStage* OptimizedCLUTmpe;
+
+    // For empty transforms, do nothing
+    if (*Lut == NULL) return FALSE;
+
+    // This is a lossy optimization! does not apply in floating-point cases
+    if (T_FLOAT(*InputFormat) || T_FLOAT(*OutputFormat)) return FALSE;
+
+    // Only on 8 and 16 bits
+    if (T_BYTES(*InputFormat) != 1 && T_BYTES(*InputFormat) != 2) return FALSE;
+    if (T_BYTES(*OutputFormat) != 1 && T_BYTES(*OutputFormat) != 2) return FALSE;
+
+    // Only real 16 bits
+    if (T_BIT15(*InputFormat) != 0 || T_BIT15(*OutputFormat) != 0) return FALSE;
+
+    // Swap endian and premultiplied alpha are not supported
+    if (T_ENDIAN16(*InputFormat) != 0 || T_ENDIAN16(*OutputFormat) != 0) return FALSE;
+    if (T_PREMUL(*InputFormat) || T_PREMUL(*OutputFormat)) return FALSE;
+
+    // Only on input CMYK
+    if (T_COLORSPACE(*InputFormat) != PT_CMYK || T_CHANNELS(*InputFormat) != 4) return FALSE;
+
+    // Room for the alpha channel
+    if (cmsPipelineOutputChannels(ContextID, *Lut) >= cmsMAXCHANNELS) return FALSE;
+
+    // A single CLUT is needed, prelinearization or postlinearization curves would get in the way
+    newFlags = (*dwFlags | cmsFLAGS_FORCE_CLUT) & ~(cmsFLAGS_CLUT_PRE_LINEARIZATION | cmsFLAGS_CLUT_POST_LINEARIZATION);
+
+    if (!_cmsOptimizePipeline(ContextID,
+                               Lut,
+                               INTENT_PERCEPTUAL,  // Dont care
+                               InputFormat,
+                               OutputFormat,
+                               &newFlags)) return FALSE;
+
+    if (!cmsPipelineCheckAndRetreiveStages(ContextID, *Lut, 1, cmsSigCLutElemType, &OptimizedCLUTmpe)) return FALSE;
+
+    // Set the evaluator
+    data = (_cmsStageCLutData*)cmsStageData(ContextID, OptimizedCLUTmpe);
+    if (data ->HasFloatValues || data ->Params ->nInputs != 4) return FALSE;
+
+    p16 = Performance16CMYKalloc(ContextID, data->Params);
+    if (p16 == NULL) return FALSE;
+
+    *TransformFn = PerformanceEval16CMYK;
+    *UserData   = p16;
+    *FreeDataFn = Performance16CMYKfree;
+    *InputFormat  |= cmsFLAGS_CAN_CHANGE_FORMATTER;
+    *OutputFormat |= cmsFLAGS_CAN_CHANGE_FORMATTER;
+    *dwFlags |= cmsFLAGS_CAN_CHANGE_FORMATTER;
+
+    return TRUE;
+}
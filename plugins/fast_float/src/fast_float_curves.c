@@ -141,6 +141,96 @@ static void FastEvaluateFloatRGBCurves(cmsContext ContextID,
     }
 }
 
+#ifdef CMS_FF_AVX2
+
+// Same as above, on blocks of 8 pixels. Increments are the same for all channels, either chunky
+// or planar, so the pixels left on each line are handed to the plain C version.
+CMS_FF_TARGET_AVX2
+static void FastEvaluateFloatRGBCurvesAVX2(cmsContext ContextID,
+                                           struct _cmstransform_struct *CMMcargo,
+                                           const cmsUInt8Number* Input,
+                                           cmsUInt8Number* Output,
+                                           cmsUInt32Number PixelsPerLine,
+                                           cmsUInt32Number LineCount,
+                                           const cmsStride* Stride)
+{
+    cmsUInt32Number i, ii, j, k;
+    cmsUInt32Number SourceStartingOrder[cmsMAXCHANNELS];
+    cmsUInt32Number SourceIncrements[cmsMAXCHANNELS];
+    cmsUInt32Number DestStartingOrder[cmsMAXCHANNELS];
+    cmsUInt32Number DestIncrements[cmsMAXCHANNELS];
+    cmsFloat32Number Values[3][8];
+
+    const cmsUInt8Number* in[4];
+    cmsUInt8Number* out[4];
+
+    cmsUInt32Number InputFormat  = cmsGetTransformInputFormat(ContextID, (cmsHTRANSFORM) CMMcargo);
+    cmsUInt32Number OutputFormat = cmsGetTransformOutputFormat(ContextID, (cmsHTRANSFORM) CMMcargo);
+
+    CurvesFloatData* Data = (CurvesFloatData*)  _cmsGetTransformUserData(CMMcargo);
+
+    cmsUInt32Number nchans, nalpha;
+    cmsUInt32Number nBlocks = PixelsPerLine / 8;
+    size_t strideIn, strideOut;
+
+    _cmsComputeComponentIncrements(InputFormat,  Stride->BytesPerPlaneIn, &nchans, &nalpha, SourceStartingOrder, SourceIncrements);
+    _cmsComputeComponentIncrements(OutputFormat, Stride->BytesPerPlaneOut, &nchans, &nalpha, DestStartingOrder, DestIncrements);
+
+    if (!(_cmsGetTransformFlags(CMMcargo) & cmsFLAGS_COPY_ALPHA))
+        nalpha = 0;
+
+    strideIn = strideOut = 0;
+    for (i = 0; i < LineCount; i++) {
+
+        for (k = 0; k < 3 + nalpha; k++) {
+
+            in[k]  = (const cmsUInt8Number*)Input + SourceStartingOrder[k] + strideIn;
+            out[k] = (cmsUInt8Number*)Output + DestStartingOrder[k] + strideOut;
+        }
+
+        for (ii = 0; ii < nBlocks; ii++) {
+
+            for (j = 0; j < 8; j++) {
+                for (k = 0; k < 3; k++) {
+
+                    Values[k][j] = *(const cmsFloat32Number*)in[k];
+                    in[k] += SourceIncrements[k];
+                }
+            }
+
+            _mm256_storeu_ps(Values[0], flerp8(Data->CurveR, _mm256_loadu_ps(Values[0])));
+            _mm256_storeu_ps(Values[1], flerp8(Data->CurveG, _mm256_loadu_ps(Values[1])));
+            _mm256_storeu_ps(Values[2], flerp8(Data->CurveB, _mm256_loadu_ps(Values[2])));
+
+            for (j = 0; j < 8; j++) {
+                for (k = 0; k < 3; k++) {
+
+                    *(cmsFloat32Number*)out[k] = Values[k][j];
+                    out[k] += DestIncrements[k];
+                }
+
+                if (nalpha) {
+
+                    *(cmsFloat32Number*)out[3] = *(const cmsFloat32Number*)in[3];
+                    in[3] += SourceIncrements[3];
+                    out[3] += DestIncrements[3];
+                }
+            }
+        }
+
+        if (PixelsPerLine % 8)
+            FastEvaluateFloatRGBCurves(ContextID, CMMcargo,
+                                       Input + strideIn + nBlocks * 8 * SourceIncrements[0],
+                                       Output + strideOut + nBlocks * 8 * DestIncrements[0],
+                                       PixelsPerLine % 8, 1, Stride);
+
+        strideIn += Stride->BytesPerLineIn;
+        strideOut += Stride->BytesPerLineOut;
+    }
+}
+
+#endif
+
 // Do nothing but arrange the RGB format.
 static void FastFloatRGBIdentity(cmsContext ContextID,
                                 struct _cmstransform_struct *CMMcargo,
@@ -478,6 +568,11 @@ cmsBool OptimizeFloatByJoiningCurves(cmsContext ContextID,
     else
       *TransformFn = (AllRGBCurvesAreLinear(Data) ? FastFloatRGBIdentity : FastEvaluateFloatRGBCurves);
 
+#ifdef CMS_FF_AVX2
+    if (*TransformFn == FastEvaluateFloatRGBCurves && (FastFloatCPUFeatures() & FF_CPU_AVX2))
+        *TransformFn = FastEvaluateFloatRGBCurvesAVX2;
+#endif
+
     return TRUE;
 
 }
@@ -76,6 +76,24 @@
 
 #define cmsFLAGS_CAN_CHANGE_FORMATTER     0x02000000   // Allow change buffer format
 
+// AVX2 kernels are built by using the target attribute, so no special compiler switch is needed.
+// Whatever the plug-in is compiled for, the kernel is selected at runtime when the transform is created.
+#if !defined(CMS_DONT_USE_SSE2) && !defined(CMS_DONT_USE_AVX2) && !defined(CMS_DONT_USE_SIMD) && \
+    (defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1700)) && \
+    (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#   define CMS_FF_AVX2 1
+#   include <immintrin.h>
+#   ifdef _MSC_VER
+#       define CMS_FF_TARGET_AVX2
+#   else
+#       define CMS_FF_TARGET_AVX2 __attribute__((target("avx2")))
+#   endif
+#endif
+
+// CPU features the kernels may use
+#define FF_CPU_SSE2     0x0001
+#define FF_CPU_AVX2     0x0002
+
 #ifndef CMS_USE_CPP_API
 #ifdef __cplusplus
 extern "C" {
@@ -171,10 +189,55 @@ cmsINLINE cmsFloat32Number flerp(const cmsFloat32Number LutTable[], cmsFloat32Nu
        return y0 + (y1 - y0) * rest;
 }
 
+#ifdef CMS_FF_AVX2
+
+// flerp on 8 values at once, bit-exact with the scalar version above. Note there is no
+// FMA, as the scalar code does not contract the multiply-add either.
+CMS_FF_TARGET_AVX2 cmsINLINE
+__m256 flerp8(const cmsFloat32Number LutTable[], __m256 v)
+{
+       __m256  NaN, Outside, x, rest, y0, y1, res;
+       __m256i cell0, cell1;
+
+       NaN     = _mm256_cmp_ps(v, v, _CMP_UNORD_Q);
+       Outside = _mm256_or_ps(_mm256_cmp_ps(v, _mm256_set1_ps(1.0e-9f), _CMP_LT_OQ),
+                              _mm256_cmp_ps(v, _mm256_set1_ps(1.0f), _CMP_GE_OQ));
+       Outside = _mm256_or_ps(Outside, NaN);
+
+       // Lanes going out of the table are evaluated at zero and discarded later
+       x = _mm256_mul_ps(_mm256_andnot_ps(Outside, v), _mm256_set1_ps((cmsFloat32Number) (MAX_NODES_IN_CURVE - 1)));
+
+#ifdef CMS_DONT_USE_FAST_FLOOR
+       cell0 = _mm256_cvttps_epi32(_mm256_floor_ps(x));
+#else
+       // Same as _cmsQuickFloor: round to 1/65536 and then drop the fraction
+       cell0 = _mm256_srai_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(65536.0f))), 16);
+#endif
+       cell1 = _mm256_cvttps_epi32(_mm256_ceil_ps(x));
+
+       rest = _mm256_sub_ps(x, _mm256_cvtepi32_ps(cell0));
+
+       y0 = _mm256_i32gather_ps(LutTable, cell0, 4);
+       y1 = _mm256_i32gather_ps(LutTable, cell1, 4);
+
+       res = _mm256_add_ps(y0, _mm256_mul_ps(_mm256_sub_ps(y1, y0), rest));
+       res = _mm256_blendv_ps(res, v, Outside);
+
+       return _mm256_blendv_ps(res, _mm256_set1_ps(LutTable[0]), NaN);
+}
+
+#endif
+
 
 
 // Some secret sauce from lcms
 CMSAPI cmsUInt32Number  CMSEXPORT _cmsReasonableGridpointsByColorspace(cmsContext ContextID, cmsColorSpaceSignature Colorspace, cmsUInt32Number dwFlags);
+CMSAPI cmsBool          CMSEXPORT _cmsOptimizePipeline(cmsContext ContextID,
+                                                       cmsPipeline** Lut,
+                                                       cmsUInt32Number  Intent,
+                                                       cmsUInt32Number* InputFormat,
+                                                       cmsUInt32Number* OutputFormat,
+                                                       cmsUInt32Number* dwFlags);
 
 
 
@@ -192,6 +255,12 @@ CMSCHECKPOINT cmsFormatter CMSEXPORT Formatter_15Bit_Factory(cmsContext ContextI
                                                              cmsFormatterDirection Dir,
                                                              cmsUInt32Number dwFlags);
 
+// Runtime CPU detection. Returns the FF_CPU_xxx features of this CPU the kernels can use.
+cmsUInt32Number FastFloatCPUFeatures(void);
+
+// Restricts the features above. Transforms created afterwards only use the allowed kernels.
+CMSCHECKPOINT void CMSEXPORT FastFloatRestrictCPUFeatures(cmsUInt32Number Allowed);
+
 // Optimizers
 
 //  8 bits on input allows matrix-shaper boost up a little bit
@@ -286,6 +355,14 @@ cmsBool OptimizeCLUTCMYKTransform(cmsContext ContextID,
 					              cmsUInt32Number* OutputFormat,
 					              cmsUInt32Number* dwFlags);
 
+cmsBool Optimize16BitCMYKTransform(cmsContext ContextID,
+                                   _cmsTransform2Fn* TransformFn,
+                                   void** UserData,
+                                   _cmsFreeUserDataFn* FreeDataFn,
+                                   cmsPipeline** Lut,
+                                   cmsUInt32Number* InputFormat,
+                                   cmsUInt32Number* OutputFormat,
+                                   cmsUInt32Number* dwFlags);
 
 cmsBool OptimizeCLUTLabTransform(cmsContext ContextID,
                                  _cmsTransform2Fn* TransformFn,
@@ -413,7 +413,7 @@ cmsBool OptimizeCLUTLabTransform(cmsContext ContextID,
     container.original = OriginalLut;
 
     // Resample the LUT
-    if (!cmsStageSampleCLutFloat(ContextID, OptimizedCLUTmpe, XFormSampler, (void*)&container, 0)) goto Error;
+    if (!cmsStageSampleCLutFloat(ContextID, OptimizedCLUTmpe, XFormSampler, (void*)&container, SAMPLER_THREADSAFE)) goto Error;
 
     // And return the obtained LUT
     cmsPipelineFree(ContextID, OriginalLut);
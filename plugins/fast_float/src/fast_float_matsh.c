@@ -230,7 +230,113 @@ void MatShaperFloat(cmsContext ContextID, struct _cmstransform_struct *CMMcargo,
     }
 }
 
+#ifdef CMS_FF_AVX2
 
+// Same as above, on blocks of 8 pixels. Increments are the same for all channels, either chunky
+// or planar, so the pixels left on each line are handed to the plain C version.
+CMS_FF_TARGET_AVX2
+static
+void MatShaperFloatAVX2(cmsContext ContextID, struct _cmstransform_struct *CMMcargo,
+                        const cmsUInt8Number* Input,
+                        cmsUInt8Number* Output,
+                        cmsUInt32Number PixelsPerLine,
+                        cmsUInt32Number LineCount,
+                        const cmsStride* Stride)
+{
+    VXMatShaperFloatData* p = (VXMatShaperFloatData*) _cmsGetTransformUserData(CMMcargo);
+    __m256 r, g, b, l1, l2, l3;
+    cmsUInt32Number i, ii, j, k;
+    cmsUInt32Number SourceStartingOrder[cmsMAXCHANNELS];
+    cmsUInt32Number SourceIncrements[cmsMAXCHANNELS];
+    cmsUInt32Number DestStartingOrder[cmsMAXCHANNELS];
+    cmsUInt32Number DestIncrements[cmsMAXCHANNELS];
+    cmsFloat32Number In[3][8], Out[3][8];
+
+    const cmsUInt8Number* in[4];
+    cmsUInt8Number* out[4];
+
+    cmsUInt32Number nchans, nalpha;
+    cmsUInt32Number nBlocks = PixelsPerLine / 8;
+    size_t strideIn, strideOut;
+
+    _cmsComputeComponentIncrements(cmsGetTransformInputFormat(ContextID, (cmsHTRANSFORM)CMMcargo), Stride->BytesPerPlaneIn, &nchans, &nalpha, SourceStartingOrder, SourceIncrements);
+    _cmsComputeComponentIncrements(cmsGetTransformOutputFormat(ContextID, (cmsHTRANSFORM)CMMcargo), Stride->BytesPerPlaneOut, &nchans, &nalpha, DestStartingOrder, DestIncrements);
+
+    if (!(_cmsGetTransformFlags(CMMcargo) & cmsFLAGS_COPY_ALPHA))
+        nalpha = 0;
+
+    strideIn = strideOut = 0;
+    for (i = 0; i < LineCount; i++) {
+
+        for (k = 0; k < 3 + nalpha; k++) {
+
+            in[k]  = (const cmsUInt8Number*)Input + SourceStartingOrder[k] + strideIn;
+            out[k] = (cmsUInt8Number*)Output + DestStartingOrder[k] + strideOut;
+        }
+
+        for (ii = 0; ii < nBlocks; ii++) {
+
+            for (j = 0; j < 8; j++) {
+                for (k = 0; k < 3; k++) {
+
+                    In[k][j] = *(const cmsFloat32Number*)in[k];
+                    in[k] += SourceIncrements[k];
+                }
+            }
+
+            r = flerp8(p->Shaper1R, _mm256_loadu_ps(In[0]));
+            g = flerp8(p->Shaper1G, _mm256_loadu_ps(In[1]));
+            b = flerp8(p->Shaper1B, _mm256_loadu_ps(In[2]));
+
+            l1 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p->Mat[0][0]), r),
+                                             _mm256_mul_ps(_mm256_set1_ps(p->Mat[0][1]), g)),
+                                             _mm256_mul_ps(_mm256_set1_ps(p->Mat[0][2]), b));
+            l2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p->Mat[1][0]), r),
+                                             _mm256_mul_ps(_mm256_set1_ps(p->Mat[1][1]), g)),
+                                             _mm256_mul_ps(_mm256_set1_ps(p->Mat[1][2]), b));
+            l3 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p->Mat[2][0]), r),
+                                             _mm256_mul_ps(_mm256_set1_ps(p->Mat[2][1]), g)),
+                                             _mm256_mul_ps(_mm256_set1_ps(p->Mat[2][2]), b));
+
+            if (p->UseOff) {
+
+                l1 = _mm256_add_ps(l1, _mm256_set1_ps(p->Off[0]));
+                l2 = _mm256_add_ps(l2, _mm256_set1_ps(p->Off[1]));
+                l3 = _mm256_add_ps(l3, _mm256_set1_ps(p->Off[2]));
+            }
+
+            _mm256_storeu_ps(Out[0], flerp8(p->Shaper2R, l1));
+            _mm256_storeu_ps(Out[1], flerp8(p->Shaper2G, l2));
+            _mm256_storeu_ps(Out[2], flerp8(p->Shaper2B, l3));
+
+            for (j = 0; j < 8; j++) {
+                for (k = 0; k < 3; k++) {
+
+                    *(cmsFloat32Number*)out[k] = Out[k][j];
+                    out[k] += DestIncrements[k];
+                }
+
+                if (nalpha) {
+
+                    *(cmsFloat32Number*)out[3] = *(const cmsFloat32Number*)in[3];
+                    in[3] += SourceIncrements[3];
+                    out[3] += DestIncrements[3];
+                }
+            }
+        }
+
+        if (PixelsPerLine % 8)
+            MatShaperFloat(ContextID, CMMcargo,
+                           Input + strideIn + nBlocks * 8 * SourceIncrements[0],
+                           Output + strideOut + nBlocks * 8 * DestIncrements[0],
+                           PixelsPerLine % 8, 1, Stride);
+
+        strideIn += Stride->BytesPerLineIn;
+        strideOut += Stride->BytesPerLineOut;
+    }
+}
+
+#endif
 
 cmsBool OptimizeFloatMatrixShaper(cmsContext ContextID,
                                   _cmsTransform2Fn* TransformFn,
@@ -372,6 +478,11 @@ cmsBool OptimizeFloatMatrixShaper(cmsContext ContextID,
         *FreeUserData = FreeMatShaper;
 
         *TransformFn = MatShaperFloat;
+
+#ifdef CMS_FF_AVX2
+        if (nChans == 3 && (FastFloatCPUFeatures() & FF_CPU_AVX2))
+            *TransformFn = MatShaperFloatAVX2;
+#endif
     }
 
     *dwFlags &= ~cmsFLAGS_CAN_CHANGE_FORMATTER;
@@ -22,6 +22,81 @@
 
 #include "fast_float_internal.h"
 
+#if !defined(CMS_DONT_USE_SSE2) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#   define CMS_FF_CPUID 1
+#   ifdef _MSC_VER
+#       include <intrin.h>
+#   else
+#       include <cpuid.h>
+#   endif
+#endif
+
+// Detected once. Races are harmless since all threads would write the same value
+static cmsBool         CPUFeaturesDetected = FALSE;
+static cmsUInt32Number CPUFeatures = 0;
+static cmsUInt32Number AllowedCPUFeatures = 0xFFFFFFFFU;
+
+static
+cmsUInt32Number DetectCPUFeatures(void)
+{
+    cmsUInt32Number Features = 0;
+
+#ifdef CMS_FF_CPUID
+#ifdef _MSC_VER
+    int cpuinfo[4];
+    int max;
+
+    __cpuid(cpuinfo, 0);
+    max = cpuinfo[0];
+    if (max < 1) return 0;
+
+    __cpuid(cpuinfo, 1);
+    if (cpuinfo[3] & (1 << 26)) Features |= FF_CPU_SSE2;
+
+#ifdef CMS_FF_AVX2
+    // OS must save the YMM registers
+    if (max >= 7 && (cpuinfo[2] & (1 << 27)) && (cpuinfo[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6)) {
+
+        __cpuidex(cpuinfo, 7, 0);
+        if (cpuinfo[1] & (1 << 5)) Features |= FF_CPU_AVX2;
+    }
+#endif
+
+#else
+    unsigned int eax, ebx, ecx, edx;
+
+    if (__get_cpuid_max(0, NULL) < 1) return 0;
+
+    __cpuid_count(1, 0, eax, ebx, ecx, edx);
+    if (edx & (1u << 26)) Features |= FF_CPU_SSE2;
+
+#ifdef CMS_FF_AVX2
+    // This one checks for the OS support as well
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) Features |= FF_CPU_AVX2;
+#endif
+#endif
+#endif
+
+    return Features;
+}
+
+cmsUInt32Number FastFloatCPUFeatures(void)
+{
+    if (!CPUFeaturesDetected) {
+
+        CPUFeatures = DetectCPUFeatures();
+        CPUFeaturesDetected = TRUE;
+    }
+
+    return CPUFeatures & AllowedCPUFeatures;
+}
+
+void CMSEXPORT FastFloatRestrictCPUFeatures(cmsUInt32Number Allowed)
+{
+    AllowedCPUFeatures = Allowed;
+}
+
 // This is the main dispatcher
 static
 cmsBool Floating_Point_Transforms_Dispatcher(cmsContext ContextID,
@@ -70,6 +145,9 @@ cmsBool Floating_Point_Transforms_Dispatcher(cmsContext ContextID,
     // Try to optimize using prelinearization plus tetrahedral
     if (Optimize16BitRGBTransform(ContextID, TransformFn, UserData, FreeUserData, Lut, InputFormat, OutputFormat, dwFlags)) return TRUE;
 
+    // Try to optimize 8 and 16 bits CMYK using tetrahedral plus linear interpolation on the first channel
+    if (Optimize16BitCMYKTransform(ContextID, TransformFn, UserData, FreeUserData, Lut, InputFormat, OutputFormat, dwFlags)) return TRUE;
+
     // Try to optimize using prelinearization plus tetrahedral
     if (OptimizeCLUTRGBTransform(ContextID, TransformFn, UserData, FreeUserData, Lut, InputFormat, OutputFormat, dwFlags)) return TRUE;
 
@@ -222,7 +222,185 @@ void FloatCLUTEval(cmsContext ContextID,
 
 #undef DENS
 
+#ifdef CMS_FF_AVX2
 
+// fclamp on 8 values at once
+CMS_FF_TARGET_AVX2 cmsINLINE
+__m256 fclamp8(__m256 v)
+{
+    __m256 Zero = _mm256_or_ps(_mm256_cmp_ps(v, _mm256_set1_ps(1.0e-9f), _CMP_LT_OQ), _mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+    __m256 One  = _mm256_cmp_ps(v, _mm256_set1_ps(1.0f), _CMP_GT_OQ);
+
+    return _mm256_andnot_ps(Zero, _mm256_blendv_ps(v, _mm256_set1_ps(1.0f), One));
+}
+
+// Same as FloatCLUTEval, on blocks of 8 pixels. Each lane walks its own tetrahedron: the vertices
+// are reached by stepping the axes by decreasing rest, and the difference of each step goes with the
+// rest of its axis. Ties are broken as the if-chain above does, so results are bit-exact.
+CMS_FF_TARGET_AVX2
+static
+void FloatCLUTEvalAVX2(cmsContext ContextID,
+                       struct _cmstransform_struct *CMMcargo,
+                       const cmsUInt8Number* Input,
+                       cmsUInt8Number* Output,
+                       cmsUInt32Number PixelsPerLine,
+                       cmsUInt32Number LineCount,
+                       const cmsStride* Stride)
+{
+    FloatCLUTData* pfloat = (FloatCLUTData*)_cmsGetTransformUserData(CMMcargo);
+
+    __m256  r, g, b, px, py, pz, rx, ry, rz;
+    __m256  XbY, XbZ, YbZ, XFirst, XLast, YFirst, YLast, ZFirst, ZLast;
+    __m256  c0, v1, v2, v3, d1, d2, d3, cx, cy, cz, res;
+    __m256i X0, Y0, Z0, IncX, IncY, IncZ, Step1, Step3, I0, I1, I2, I3;
+    const __m256  One = _mm256_set1_ps(1.0f);
+    const __m256  AllOnes = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    cmsUInt32Number OutChan;
+
+    const cmsInterpParams* p = pfloat->p;
+    cmsUInt32Number        TotalOut = p->nOutputs;
+    cmsUInt32Number        TotalPlusAlpha;
+    const cmsFloat32Number* LutTable = (const cmsFloat32Number*)p->Table;
+
+    cmsUInt32Number       i, ii, j, k;
+    const cmsUInt8Number* in[4];
+    cmsFloat32Number      In[3][8], Res[8];
+
+    cmsUInt8Number* out[cmsMAXCHANNELS];
+    cmsUInt32Number SourceStartingOrder[cmsMAXCHANNELS];
+    cmsUInt32Number SourceIncrements[cmsMAXCHANNELS];
+    cmsUInt32Number DestStartingOrder[cmsMAXCHANNELS];
+    cmsUInt32Number DestIncrements[cmsMAXCHANNELS];
+
+    cmsUInt32Number InputFormat  = cmsGetTransformInputFormat(ContextID, (cmsHTRANSFORM) CMMcargo);
+    cmsUInt32Number OutputFormat = cmsGetTransformOutputFormat(ContextID, (cmsHTRANSFORM) CMMcargo);
+
+    cmsUInt32Number nchans, nalpha;
+    cmsUInt32Number nBlocks = PixelsPerLine / 8;
+    size_t strideIn, strideOut;
+
+    _cmsComputeComponentIncrements(InputFormat, Stride->BytesPerPlaneIn, &nchans, &nalpha, SourceStartingOrder, SourceIncrements);
+    _cmsComputeComponentIncrements(OutputFormat, Stride->BytesPerPlaneOut, &nchans, &nalpha, DestStartingOrder, DestIncrements);
+
+    if (!(_cmsGetTransformFlags(CMMcargo) & cmsFLAGS_COPY_ALPHA))
+        nalpha = 0;
+
+    TotalPlusAlpha = TotalOut + nalpha;
+
+    strideIn = strideOut = 0;
+    for (i = 0; i < LineCount; i++) {
+
+        for (k = 0; k < 3 + nalpha; k++)
+            in[k] = (const cmsUInt8Number*)Input + SourceStartingOrder[k] + strideIn;
+
+        for (k = 0; k < TotalPlusAlpha; k++)
+            out[k] = (cmsUInt8Number*)Output + DestStartingOrder[k] + strideOut;
+
+        for (ii = 0; ii < nBlocks; ii++) {
+
+            for (j = 0; j < 8; j++) {
+                for (k = 0; k < 3; k++) {
+
+                    In[k][j] = *(const cmsFloat32Number*)in[k];
+                    in[k] += SourceIncrements[k];
+                }
+            }
+
+            r = fclamp8(_mm256_loadu_ps(In[0]));
+            g = fclamp8(_mm256_loadu_ps(In[1]));
+            b = fclamp8(_mm256_loadu_ps(In[2]));
+
+            px = _mm256_mul_ps(r, _mm256_set1_ps((cmsFloat32Number) p->Domain[0]));
+            py = _mm256_mul_ps(g, _mm256_set1_ps((cmsFloat32Number) p->Domain[1]));
+            pz = _mm256_mul_ps(b, _mm256_set1_ps((cmsFloat32Number) p->Domain[2]));
+
+            X0 = _mm256_cvttps_epi32(_mm256_floor_ps(px)); rx = _mm256_sub_ps(px, _mm256_cvtepi32_ps(X0));
+            Y0 = _mm256_cvttps_epi32(_mm256_floor_ps(py)); ry = _mm256_sub_ps(py, _mm256_cvtepi32_ps(Y0));
+            Z0 = _mm256_cvttps_epi32(_mm256_floor_ps(pz)); rz = _mm256_sub_ps(pz, _mm256_cvtepi32_ps(Z0));
+
+            X0 = _mm256_mullo_epi32(X0, _mm256_set1_epi32((int) p->opta[2]));
+            Y0 = _mm256_mullo_epi32(Y0, _mm256_set1_epi32((int) p->opta[1]));
+            Z0 = _mm256_mullo_epi32(Z0, _mm256_set1_epi32((int) p->opta[0]));
+
+            IncX = _mm256_andnot_si256(_mm256_castps_si256(_mm256_cmp_ps(r, One, _CMP_GE_OQ)), _mm256_set1_epi32((int) p->opta[2]));
+            IncY = _mm256_andnot_si256(_mm256_castps_si256(_mm256_cmp_ps(g, One, _CMP_GE_OQ)), _mm256_set1_epi32((int) p->opta[1]));
+            IncZ = _mm256_andnot_si256(_mm256_castps_si256(_mm256_cmp_ps(b, One, _CMP_GE_OQ)), _mm256_set1_epi32((int) p->opta[0]));
+
+            // Order of the axes, ties go to x first, then y
+            XbY = _mm256_cmp_ps(rx, ry, _CMP_GE_OQ);
+            XbZ = _mm256_cmp_ps(rx, rz, _CMP_GE_OQ);
+            YbZ = _mm256_cmp_ps(ry, rz, _CMP_GE_OQ);
+
+            XFirst = _mm256_and_ps(XbY, XbZ);
+            XLast  = _mm256_andnot_ps(_mm256_or_ps(XbY, XbZ), AllOnes);
+            YFirst = _mm256_andnot_ps(XbY, YbZ);
+            YLast  = _mm256_andnot_ps(YbZ, XbY);
+            ZFirst = _mm256_andnot_ps(_mm256_or_ps(XbZ, YbZ), AllOnes);
+            ZLast  = _mm256_and_ps(XbZ, YbZ);
+
+            Step1 = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(_mm256_castps_si256(XFirst), IncX),
+                                                    _mm256_and_si256(_mm256_castps_si256(YFirst), IncY)),
+                                                    _mm256_and_si256(_mm256_castps_si256(ZFirst), IncZ));
+            Step3 = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(_mm256_castps_si256(XLast), IncX),
+                                                    _mm256_and_si256(_mm256_castps_si256(YLast), IncY)),
+                                                    _mm256_and_si256(_mm256_castps_si256(ZLast), IncZ));
+
+            I0 = _mm256_add_epi32(_mm256_add_epi32(X0, Y0), Z0);
+            I1 = _mm256_add_epi32(I0, Step1);
+            I3 = _mm256_add_epi32(I0, _mm256_add_epi32(_mm256_add_epi32(IncX, IncY), IncZ));
+            I2 = _mm256_sub_epi32(I3, Step3);
+
+            for (OutChan = 0; OutChan < TotalOut; OutChan++) {
+
+                c0 = _mm256_i32gather_ps(LutTable + OutChan, I0, 4);
+                v1 = _mm256_i32gather_ps(LutTable + OutChan, I1, 4);
+                v2 = _mm256_i32gather_ps(LutTable + OutChan, I2, 4);
+                v3 = _mm256_i32gather_ps(LutTable + OutChan, I3, 4);
+
+                d1 = _mm256_sub_ps(v1, c0);
+                d2 = _mm256_sub_ps(v2, v1);
+                d3 = _mm256_sub_ps(v3, v2);
+
+                cx = _mm256_blendv_ps(_mm256_blendv_ps(d2, d1, XFirst), d3, XLast);
+                cy = _mm256_blendv_ps(_mm256_blendv_ps(d2, d1, YFirst), d3, YLast);
+                cz = _mm256_blendv_ps(_mm256_blendv_ps(d2, d1, ZFirst), d3, ZLast);
+
+                res = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(c0, _mm256_mul_ps(cx, rx)),
+                                                  _mm256_mul_ps(cy, ry)),
+                                                  _mm256_mul_ps(cz, rz));
+                _mm256_storeu_ps(Res, res);
+
+                for (j = 0; j < 8; j++) {
+
+                    *(cmsFloat32Number*)(out[OutChan]) = Res[j];
+                    out[OutChan] += DestIncrements[OutChan];
+                }
+            }
+
+            if (nalpha) {
+
+                for (j = 0; j < 8; j++) {
+
+                    *(cmsFloat32Number*)(out[TotalOut]) = *(const cmsFloat32Number*)in[3];
+                    in[3] += SourceIncrements[3];
+                    out[TotalOut] += DestIncrements[TotalOut];
+                }
+            }
+        }
+
+        // Increments are the same for all channels, either chunky or planar
+        if (PixelsPerLine % 8)
+            FloatCLUTEval(ContextID, CMMcargo,
+                          Input + strideIn + nBlocks * 8 * SourceIncrements[0],
+                          Output + strideOut + nBlocks * 8 * DestIncrements[0],
+                          PixelsPerLine % 8, 1, Stride);
+
+        strideIn  += Stride->BytesPerLineIn;
+        strideOut += Stride->BytesPerLineOut;
+    }
+}
+
+#endif
 
 // --------------------------------------------------------------------------------------------------------------
 
@@ -323,7 +501,7 @@ cmsBool OptimizeCLUTRGBTransform(cmsContext ContextID,
 
 
     // Resample the LUT
-    if (!cmsStageSampleCLutFloat(ContextID, OptimizedCLUTmpe, XFormSampler, (void*)OriginalLut, 0)) goto Error;
+    if (!cmsStageSampleCLutFloat(ContextID, OptimizedCLUTmpe, XFormSampler, (void*)OriginalLut, SAMPLER_THREADSAFE)) goto Error;
     
     if (T_COLORSPACE(*OutputFormat) == PT_CMYK) {
         cmsPipelineUnlinkStage(ContextID, OriginalLut, cmsAT_END, NULL);
@@ -340,6 +518,10 @@ cmsBool OptimizeCLUTRGBTransform(cmsContext ContextID,
 
     *Lut = OptimizedLUT;
     *TransformFn = FloatCLUTEval;
+#ifdef CMS_FF_AVX2
+    if (FastFloatCPUFeatures() & FF_CPU_AVX2)
+        *TransformFn = FloatCLUTEvalAVX2;
+#endif
     *UserData   = pfloat;
     *FreeDataFn = _cmsFree;
     *dwFlags &= ~cmsFLAGS_CAN_CHANGE_FORMATTER;
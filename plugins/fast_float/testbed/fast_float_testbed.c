@@ -541,6 +541,297 @@ void TryAllValues16bits(cmsContext Raw, cmsContext Plugin, cmsHPROFILE hlcmsProf
     cmsDeleteTransform(Plugin, xformPlugin);
 }
 
+// RGB on 8 bits to any number of channels, chunky or planar, against the default 8 bits path
+static
+void TryRGB8Values(cmsContext Raw, cmsContext Plugin, cmsHPROFILE hIn, cmsHPROFILE hOut,
+                   cmsUInt32Number InFormat, cmsUInt32Number OutFormat, cmsUInt32Number dwFlags)
+{
+    cmsUInt32Number r, g, b, i, j, npixels = 52 * 52 * 52;
+    cmsUInt32Number nIn  = T_CHANNELS(InFormat) + T_EXTRA(InFormat);
+    cmsUInt32Number nOut = T_CHANNELS(OutFormat) + T_EXTRA(OutFormat);
+    cmsUInt8Number *bufferIn, *bufferRawOut, *bufferPluginOut;
+    int diff, MaxDiff = 0;
+
+    cmsHTRANSFORM xformRaw = cmsCreateTransform(Raw, hIn, InFormat, hOut, OutFormat, INTENT_PERCEPTUAL, cmsFLAGS_NOCACHE | dwFlags);
+    cmsHTRANSFORM xformPlugin = cmsCreateTransform(Plugin, hIn, InFormat, hOut, OutFormat, INTENT_PERCEPTUAL, cmsFLAGS_NOCACHE | dwFlags);
+
+    if (xformRaw == NULL || xformPlugin == NULL) {
+
+        Fail("NULL transforms on check RGB 8 bits conversions");
+    }
+
+    // Again, no checking on mem alloc because this is just a test
+    bufferIn = (cmsUInt8Number*)malloc(npixels * nIn);
+    bufferRawOut = (cmsUInt8Number*)malloc(npixels * nOut);
+    bufferPluginOut = (cmsUInt8Number*)malloc(npixels * nOut);
+
+    // Planar buffers hold the whole plane of each channel, so the layout does not matter here
+    j = 0;
+    for (r = 0; r < 52; r++)
+        for (g = 0; g < 52; g++)
+            for (b = 0; b < 52; b++) {
+
+                cmsUInt8Number v[4];
+
+                v[0] = (cmsUInt8Number) (r * 5); v[1] = (cmsUInt8Number) (g * 5); v[2] = (cmsUInt8Number) (b * 5); v[3] = (cmsUInt8Number) (r + b);
+
+                for (i = 0; i < nIn; i++) {
+
+                    if (T_PLANAR(InFormat))
+                        bufferIn[i * npixels + j] = v[i];
+                    else
+                        bufferIn[j * nIn + i] = v[i];
+                }
+                j++;
+            }
+
+    cmsDoTransform(Raw, xformRaw, bufferIn, bufferRawOut, npixels);
+    cmsDoTransform(Plugin, xformPlugin, bufferIn, bufferPluginOut, npixels);
+
+    // Both use a 16 bits CLUT of the same size, which is sampled on different ways
+    for (j = 0; j < npixels * nOut; j++) {
+
+        diff = abs((int) bufferRawOut[j] - (int) bufferPluginOut[j]);
+        if (diff > MaxDiff) MaxDiff = diff;
+    }
+
+    if (MaxDiff > 1)
+        Fail("RGB 8 bits conversion differs by %d", MaxDiff);
+
+    free(bufferIn); free(bufferRawOut);
+    free(bufferPluginOut);
+
+    cmsDeleteTransform(Raw, xformRaw);
+    cmsDeleteTransform(Plugin, xformPlugin);
+}
+
+static
+void CheckRGB8toNChannels(cmsContext Raw, cmsContext Plugin)
+{
+    cmsHPROFILE hRGB  = cmsOpenProfileFromFile(Raw, PROFILES_DIR "test5.icc", "r");
+    cmsHPROFILE hCMYK = cmsOpenProfileFromFile(Raw, PROFILES_DIR "test1.icc", "r");
+    cmsToneCurve* Gamma = cmsBuildGamma(Raw, 2.2);
+    cmsHPROFILE hGray = cmsCreateGrayProfile(Raw, cmsD50_xyY(Raw), Gamma);
+
+    trace("Checking RGB 8 bits to CMYK, gray, chunky and planar...");
+
+    TryRGB8Values(Raw, Plugin, hRGB, hCMYK, TYPE_RGB_8, TYPE_CMYK_8, 0);
+    TryRGB8Values(Raw, Plugin, hRGB, hCMYK, TYPE_RGB_8, TYPE_CMYK_8_PLANAR, 0);
+    TryRGB8Values(Raw, Plugin, hRGB, hCMYK, TYPE_RGB_8_PLANAR, TYPE_KYMC_8, 0);
+    TryRGB8Values(Raw, Plugin, hRGB, hCMYK, TYPE_RGBA_8, TYPE_CMYKA_8, cmsFLAGS_COPY_ALPHA);
+    TryRGB8Values(Raw, Plugin, hRGB, hGray, TYPE_RGB_8, TYPE_GRAY_8, 0);
+
+    cmsFreeToneCurve(Raw, Gamma);
+    cmsCloseProfile(Raw, hRGB);
+    cmsCloseProfile(Raw, hCMYK);
+    cmsCloseProfile(Raw, hGray);
+
+    trace("Ok\n");
+}
+
+// Vector kernels are selected when the transform is created. Build the same transform with and
+// without AVX2 and check both give same results. Tails of lines go to the plain C kernel.
+static
+void TryAVX2Kernel(cmsContext Plugin, cmsHPROFILE hIn, cmsHPROFILE hOut,
+                   cmsUInt32Number InFormat, cmsUInt32Number OutFormat, cmsUInt32Number dwFlags)
+{
+    cmsUInt32Number i, npixels = 50003, seed = 1;
+    cmsUInt32Number nIn  = T_CHANNELS(InFormat) + T_EXTRA(InFormat);
+    cmsUInt32Number nOut = T_CHANNELS(OutFormat) + T_EXTRA(OutFormat);
+    cmsUInt32Number bIn = T_BYTES(InFormat), bOut = T_BYTES(OutFormat);
+    cmsHTRANSFORM xformVector, xformPlain;
+    cmsUInt8Number *bufferIn, *bufferVector, *bufferPlain;
+
+    xformVector = cmsCreateTransform(Plugin, hIn, InFormat, hOut, OutFormat, INTENT_PERCEPTUAL, cmsFLAGS_NOCACHE | dwFlags);
+
+    FastFloatRestrictCPUFeatures(~FF_CPU_AVX2);
+    xformPlain = cmsCreateTransform(Plugin, hIn, InFormat, hOut, OutFormat, INTENT_PERCEPTUAL, cmsFLAGS_NOCACHE | dwFlags);
+    FastFloatRestrictCPUFeatures(0xFFFFFFFFU);
+
+    if (xformVector == NULL || xformPlain == NULL) {
+
+        Fail("NULL transforms on check AVX2 kernels");
+    }
+
+    // Again, no checking on mem alloc because this is just a test
+    bufferIn = (cmsUInt8Number*)malloc(npixels * nIn * bIn);
+    bufferVector = (cmsUInt8Number*)malloc(npixels * nOut * bOut);
+    bufferPlain = (cmsUInt8Number*)malloc(npixels * nOut * bOut);
+
+    for (i = 0; i < npixels * nIn; i++) {
+
+        seed = seed * 1103515245U + 12345U;
+
+        if (bIn == 2)
+            ((cmsUInt16Number*)bufferIn)[i] = (i % 97 == 0) ? 0xFFFF : (cmsUInt16Number)(seed >> 16);
+        else {
+            // Some values out of range, some exact nodes and some NaN
+            cmsFloat32Number v = (cmsFloat32Number)(seed >> 8) / (cmsFloat32Number)(1 << 24) * 1.1f - 0.05f;
+
+            if (i % 101 == 0) v = 1.0f;
+            if (i % 103 == 0) v = 0.0f;
+            if (i % 1009 == 0) v = (cmsFloat32Number) sqrt(-1.0);
+
+            ((cmsFloat32Number*)bufferIn)[i] = v;
+        }
+    }
+
+    cmsDoTransform(Plugin, xformVector, bufferIn, bufferVector, npixels);
+    cmsDoTransform(Plugin, xformPlain, bufferIn, bufferPlain, npixels);
+
+    for (i = 0; i < npixels * nOut; i++) {
+
+        if (bOut == 2) {
+
+            if (((cmsUInt16Number*)bufferVector)[i] != ((cmsUInt16Number*)bufferPlain)[i])
+                Fail("AVX2 kernel differs at %d: %d != %d", i, ((cmsUInt16Number*)bufferVector)[i], ((cmsUInt16Number*)bufferPlain)[i]);
+        }
+        else {
+            // Allow for contracted multiply-add in the plain C version
+            if (fabs(((cmsFloat32Number*)bufferVector)[i] - ((cmsFloat32Number*)bufferPlain)[i]) > 1.0E-6)
+                Fail("AVX2 kernel differs at %d: %g != %g", i, ((cmsFloat32Number*)bufferVector)[i], ((cmsFloat32Number*)bufferPlain)[i]);
+        }
+    }
+
+    free(bufferIn); free(bufferVector);
+    free(bufferPlain);
+
+    cmsDeleteTransform(Plugin, xformVector);
+    cmsDeleteTransform(Plugin, xformPlain);
+}
+
+static
+void CheckAVX2Kernels(cmsContext Plugin)
+{
+    cmsHPROFILE hRGB   = cmsOpenProfileFromFile(Plugin, PROFILES_DIR "test5.icc", "r");
+    cmsHPROFILE hRGB2  = cmsOpenProfileFromFile(Plugin, PROFILES_DIR "test3.icc", "r");
+    cmsHPROFILE hCMYK  = cmsOpenProfileFromFile(Plugin, PROFILES_DIR "test1.icc", "r");
+    cmsHPROFILE hMatSh = cmsOpenProfileFromFile(Plugin, PROFILES_DIR "test0.icc", "r");
+    cmsHPROFILE hsRGB  = cmsCreate_sRGBProfile(Plugin);
+    cmsHPROFILE hCurves = CreateCurves(Plugin);
+
+    trace("Checking AVX2 kernels against plain C...");
+
+    if (!(FastFloatCPUFeatures() & FF_CPU_AVX2))
+        trace("(no AVX2 on this CPU) ");
+
+    // Matrix-shaper and curves
+    TryAVX2Kernel(Plugin, hMatSh, hsRGB, TYPE_RGB_FLT, TYPE_RGB_FLT, 0);
+    TryAVX2Kernel(Plugin, hMatSh, hsRGB, TYPE_RGB_FLT|PLANAR_SH(1), TYPE_RGB_FLT|PLANAR_SH(1), 0);
+    TryAVX2Kernel(Plugin, hCurves, NULL, TYPE_RGB_FLT, TYPE_RGB_FLT, 0);
+    TryAVX2Kernel(Plugin, hCurves, NULL, TYPE_RGBA_FLT, TYPE_RGBA_FLT, cmsFLAGS_COPY_ALPHA);
+
+    // Tetrahedral in float
+    TryAVX2Kernel(Plugin, hRGB, hRGB2, TYPE_RGB_FLT, TYPE_RGB_FLT, 0);
+    TryAVX2Kernel(Plugin, hRGB, hCMYK, TYPE_RGB_FLT, TYPE_CMYK_FLT, 0);
+    TryAVX2Kernel(Plugin, hRGB, hRGB2, TYPE_RGBA_FLT, TYPE_RGBA_FLT, cmsFLAGS_COPY_ALPHA);
+
+    // Tetrahedral in 16 bits
+    TryAVX2Kernel(Plugin, hRGB, hRGB2, TYPE_RGB_16, TYPE_RGB_16, 0);
+    TryAVX2Kernel(Plugin, hRGB, hCMYK, TYPE_RGB_16, TYPE_CMYK_16, 0);
+    TryAVX2Kernel(Plugin, hRGB, hRGB2, TYPE_RGB_16_PLANAR, TYPE_RGB_16_PLANAR, 0);
+    TryAVX2Kernel(Plugin, hRGB, hRGB2, TYPE_RGBA_16, TYPE_RGBA_16, cmsFLAGS_COPY_ALPHA);
+
+    cmsCloseProfile(Plugin, hRGB);
+    cmsCloseProfile(Plugin, hRGB2);
+    cmsCloseProfile(Plugin, hCMYK);
+    cmsCloseProfile(Plugin, hMatSh);
+    cmsCloseProfile(Plugin, hsRGB);
+    cmsCloseProfile(Plugin, hCurves);
+
+    trace("Ok\n");
+}
+
+// CMYK on 8 and 16 bits should match the default 4D interpolation
+static
+void TryCMYKValues(cmsContext Raw, cmsContext Plugin, cmsHPROFILE hIn, cmsHPROFILE hOut,
+                   cmsUInt32Number InFormat, cmsUInt32Number OutFormat, cmsUInt32Number dwFlags)
+{
+    cmsUInt32Number c, m, y, k, i, j, npixels = 18 * 18 * 18 * 18;
+    cmsUInt32Number nIn  = T_CHANNELS(InFormat) + T_EXTRA(InFormat);
+    cmsUInt32Number nOut = T_CHANNELS(OutFormat) + T_EXTRA(OutFormat);
+    cmsUInt32Number bIn  = T_BYTES(InFormat), bOut = T_BYTES(OutFormat);
+    cmsUInt8Number *bufferIn, *bufferRawOut, *bufferPluginOut;
+
+    cmsHTRANSFORM xformRaw = cmsCreateTransform(Raw, hIn, InFormat, hOut, OutFormat, INTENT_PERCEPTUAL, cmsFLAGS_NOCACHE | dwFlags);
+    cmsHTRANSFORM xformPlugin = cmsCreateTransform(Plugin, hIn, InFormat, hOut, OutFormat, INTENT_PERCEPTUAL, cmsFLAGS_NOCACHE | dwFlags);
+
+    if (xformRaw == NULL || xformPlugin == NULL) {
+
+        Fail("NULL transforms on check CMYK conversions");
+    }
+
+    // Again, no checking on mem alloc because this is just a test
+    bufferIn = (cmsUInt8Number*)malloc(npixels * nIn * bIn);
+    bufferRawOut = (cmsUInt8Number*)malloc(npixels * nOut * bOut);
+    bufferPluginOut = (cmsUInt8Number*)malloc(npixels * nOut * bOut);
+
+    // Nodes, ends and values in between. Alpha, if any, is the last channel
+    j = 0;
+    for (c = 0; c < 18; c++)
+        for (m = 0; m < 18; m++)
+            for (y = 0; y < 18; y++)
+                for (k = 0; k < 18; k++) {
+
+                    cmsUInt32Number v[5];
+
+                    v[0] = c * 15; v[1] = m * 15; v[2] = y * 15; v[3] = k * 15; v[4] = (c + k) * 7;
+
+                    for (i = 0; i < nIn; i++) {
+
+                        if (bIn == 1)
+                            bufferIn[j * nIn + i] = (cmsUInt8Number) v[i];
+                        else
+                            ((cmsUInt16Number*) bufferIn)[j * nIn + i] = (cmsUInt16Number) (v[i] * 257 + (v[i] < 255 ? 99 : 0));
+                    }
+                    j++;
+                }
+
+    cmsDoTransform(Raw, xformRaw, bufferIn, bufferRawOut, npixels);
+    cmsDoTransform(Plugin, xformPlugin, bufferIn, bufferPluginOut, npixels);
+
+    for (j = 0; j < npixels * nOut * bOut; j++) {
+
+        if (bufferRawOut[j] != bufferPluginOut[j])
+            Fail("CMYK conversion failed at pixel %u: %x != %x", j / (nOut * bOut), bufferRawOut[j], bufferPluginOut[j]);
+    }
+
+    free(bufferIn); free(bufferRawOut);
+    free(bufferPluginOut);
+
+    cmsDeleteTransform(Raw, xformRaw);
+    cmsDeleteTransform(Plugin, xformPlugin);
+}
+
+static
+void CheckCMYK8and16Bits(cmsContext Raw, cmsContext Plugin)
+{
+    cmsHPROFILE hCMYK1 = cmsOpenProfileFromFile(Raw, PROFILES_DIR "test1.icc", "r");
+    cmsHPROFILE hCMYK2 = cmsOpenProfileFromFile(Raw, PROFILES_DIR "test2.icc", "r");
+    cmsHPROFILE hRGB   = cmsOpenProfileFromFile(Raw, PROFILES_DIR "test3.icc", "r");
+    cmsToneCurve* Gamma = cmsBuildGamma(Raw, 2.2);
+    cmsHPROFILE hGray  = cmsCreateGrayProfile(Raw, cmsD50_xyY(Raw), Gamma);
+
+    trace("Checking CMYK on 8 and 16 bits...");
+
+    TryCMYKValues(Raw, Plugin, hCMYK1, hRGB, TYPE_CMYK_8, TYPE_RGB_8, 0);
+    TryCMYKValues(Raw, Plugin, hCMYK1, hCMYK2, TYPE_CMYK_8, TYPE_CMYK_8, 0);
+    TryCMYKValues(Raw, Plugin, hCMYK1, hRGB, TYPE_CMYK_16, TYPE_RGB_16, 0);
+    TryCMYKValues(Raw, Plugin, hCMYK1, hCMYK2, TYPE_CMYK_16, TYPE_CMYK_16, 0);
+    TryCMYKValues(Raw, Plugin, hCMYK1, hCMYK2, TYPE_CMYK_8, TYPE_CMYK_16, 0);
+    TryCMYKValues(Raw, Plugin, hCMYK1, hGray, TYPE_CMYK_16, TYPE_GRAY_8, 0);
+    TryCMYKValues(Raw, Plugin, hCMYK1, hRGB, TYPE_CMYKA_8, TYPE_RGBA_8, cmsFLAGS_COPY_ALPHA);
+    TryCMYKValues(Raw, Plugin, hCMYK1, hRGB, TYPE_CMYKA_16, TYPE_RGBA_8, cmsFLAGS_COPY_ALPHA);
+
+    cmsFreeToneCurve(Raw, Gamma);
+    cmsCloseProfile(Raw, hCMYK1);
+    cmsCloseProfile(Raw, hCMYK2);
+    cmsCloseProfile(Raw, hRGB);
+    cmsCloseProfile(Raw, hGray);
+
+    trace("Ok\n");
+}
+
 static
 void CheckAccuracy16Bits(cmsContext Raw, cmsContext Plugin)
 {
@@ -2673,6 +2964,13 @@ int main(void)
 
        // 16 bits functionality
        CheckAccuracy16Bits(raw, plugin);
+       CheckCMYK8and16Bits(raw, plugin);
+
+       // 8 bits RGB to anything
+       CheckRGB8toNChannels(raw, plugin);
+
+       // Vector kernels
+       CheckAVX2Kernels(plugin);
 
        // Lab to whatever
        CheckLab2RGB(plugin);
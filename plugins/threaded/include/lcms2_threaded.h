@@ -38,17 +38,50 @@ extern "C" {
 
 // Configuration toggles
 
+// Cut the image in many small chunks, held in per-worker queues. Workers that run out of
+// work steal chunks from the others, so one slow band no longer stalls the whole call.
+#define CMS_THREADED_WORK_STEALING      0x0001
+
+// Cut the image in 2D tiles that fit in L2 instead of bands of lines. Helps on very wide images,
+// where a single line may be larger than the cache. Tiles are handed out as in work stealing.
+#define CMS_THREADED_TILING             0x0002
+
+// Working set of one tile in KB, input and output together. Default is 256K
+#define CMS_THREADED_TILE_KB(kb)        ((((cmsUInt32Number) (kb)) & 0xFFFF) << 16)
+
 // The one and only plug-in entry point. To install this plugin in your code you need to place this in 
 // some initialization place. If you want to combine this plug-in with fastfloat, make sure to call 
-// the threaded entry point comes last in chain. flags is a reserved field for future use
+// the threaded entry point comes last in chain. flags is a combination of the toggles above
 //
 //  cmsPlugin(cmsThreadedExtensions(CMS_THREADED_GUESS_MAX_THREADS, 0));
+//  cmsPlugin(cmsThreadedExtensions(CMS_THREADED_GUESS_MAX_THREADS, CMS_THREADED_TILING|CMS_THREADED_TILE_KB(512)));
 // 
 
 #define CMS_THREADED_GUESS_MAX_THREADS -1
 
 CMSAPI void* CMSEXPORT cmsThreadedExtensions(cmsInt32Number max_threads, cmsUInt32Number flags);
 
+// Asynchronous transforms. cmsThreadedSubmitTransform queues the same work as cmsDoTransformLineStride
+// and returns at once with a handle, or NULL on error. The buffers must stay valid until the handle
+// is waited. Many jobs may be in flight at once, even on the same transform. cmsThreadedTestTransform
+// tells whether the job is done without blocking. cmsThreadedWaitTransform blocks until the job is
+// done and releases the handle, so every handle must be waited exactly once. ContextID should have
+// this plug-in installed, as the workers are torn down along with it.
+
+CMSAPI cmsHANDLE CMSEXPORT cmsThreadedSubmitTransform(cmsContext ContextID,
+                                                      cmsHTRANSFORM Transform,
+                                                      const void* InputBuffer,
+                                                      void* OutputBuffer,
+                                                      cmsUInt32Number PixelsPerLine,
+                                                      cmsUInt32Number LineCount,
+                                                      cmsUInt32Number BytesPerLineIn,
+                                                      cmsUInt32Number BytesPerLineOut,
+                                                      cmsUInt32Number BytesPerPlaneIn,
+                                                      cmsUInt32Number BytesPerPlaneOut);
+
+CMSAPI cmsBool   CMSEXPORT cmsThreadedTestTransform(cmsContext ContextID, cmsHANDLE hJob);
+CMSAPI void      CMSEXPORT cmsThreadedWaitTransform(cmsContext ContextID, cmsHANDLE hJob);
+
 #ifndef CMS_USE_CPP_API
 #   ifdef __cplusplus
 }
@@ -31,8 +31,8 @@
 // To pass parameter to the thread
 typedef struct
 {
-    _cmsTransform2Fn worker;
-    _cmsWorkSlice* param;
+    _cmsThrEntryFn entry;
+    void* param;
 
 } thread_adaptor_param;
 
@@ -42,17 +42,15 @@ static
 DWORD WINAPI thread_adaptor(LPVOID p)
 {
     thread_adaptor_param* ap = (thread_adaptor_param*)p;
-    _cmsWorkSlice* s = ap->param;
 
-    ap->worker(s->ContextID, s->CMMcargo, s->InputBuffer, s->OutputBuffer,
-               s->PixelsPerLine, s->LineCount, s->Stride);
+    ap->entry(ap->param);
     _cmsFree(0, p);
     return 0;
 }
 
-// This function creates a thread and executes it. The thread calls the worker function
-// with the given parameters.
-cmsHANDLE _cmsThrCreateWorker(cmsContext ContextID, _cmsTransform2Fn worker, _cmsWorkSlice* param)
+// This function creates a thread and executes it. The thread calls the entry function
+// with the given parameter.
+cmsHANDLE _cmsThrCreateWorker(cmsContext ContextID, _cmsThrEntryFn entry, void* param)
 {
     DWORD ThreadID;
     thread_adaptor_param* p;
@@ -61,12 +59,13 @@ cmsHANDLE _cmsThrCreateWorker(cmsContext ContextID, _cmsTransform2Fn worker, _cm
     p = (thread_adaptor_param*)_cmsMalloc(0, sizeof(thread_adaptor_param));
     if (p == NULL) return NULL;
 
-    p->worker = worker;
+    p->entry = entry;
     p->param = param;
 
     handle  = CreateThread(NULL, 0, thread_adaptor, (LPVOID) p, 0, &ThreadID);
     if (handle == NULL)
     {
+        _cmsFree(0, p);
         cmsSignalError(ContextID, cmsERROR_UNDEFINED, "Cannot create thread");
     }
 
@@ -80,15 +79,90 @@ void _cmsThrJoinWorker(cmsContext ContextID, cmsHANDLE hWorker)
     {
         cmsSignalError(ContextID, cmsERROR_UNDEFINED, "Cannot join thread");
     }
+
+    CloseHandle((HANDLE)hWorker);
 }
 
 // Returns the ideal number of threads the system can run
 cmsInt32Number _cmsThrIdealThreadCount(void)
 {
-    SYSTEM_INFO sysinfo;
+    static cmsInt32Number nCPUs = 0;
+
+    if (nCPUs == 0) {
+
+        SYSTEM_INFO sysinfo;
+
+        GetSystemInfo(&sysinfo);
+        nCPUs = sysinfo.dwNumberOfProcessors; //Returns the number of processors in the system.
+    }
+
+    return nCPUs;
+}
+
+// Slim reader/writer locks are used as mutexes, so condition variables can work on them
+cmsHANDLE _cmsThrCreateMutex(cmsContext ContextID)
+{
+    SRWLOCK* lock = (SRWLOCK*)_cmsMalloc(ContextID, sizeof(SRWLOCK));
+    if (lock == NULL) return NULL;
+
+    InitializeSRWLock(lock);
+    return (cmsHANDLE)lock;
+}
+
+void _cmsThrDestroyMutex(cmsContext ContextID, cmsHANDLE hMutex)
+{
+    _cmsFree(ContextID, hMutex);
+}
+
+void _cmsThrLockMutex(cmsHANDLE hMutex)
+{
+    AcquireSRWLockExclusive((SRWLOCK*)hMutex);
+}
+
+void _cmsThrUnlockMutex(cmsHANDLE hMutex)
+{
+    ReleaseSRWLockExclusive((SRWLOCK*)hMutex);
+}
+
+cmsHANDLE _cmsThrCreateCondition(cmsContext ContextID)
+{
+    CONDITION_VARIABLE* cond = (CONDITION_VARIABLE*)_cmsMalloc(ContextID, sizeof(CONDITION_VARIABLE));
+    if (cond == NULL) return NULL;
 
-    GetSystemInfo(&sysinfo);
-    return sysinfo.dwNumberOfProcessors; //Returns the number of processors in the system.
+    InitializeConditionVariable(cond);
+    return (cmsHANDLE)cond;
+}
+
+void _cmsThrDestroyCondition(cmsContext ContextID, cmsHANDLE hCond)
+{
+    _cmsFree(ContextID, hCond);
+}
+
+void _cmsThrWaitCondition(cmsHANDLE hCond, cmsHANDLE hMutex)
+{
+    SleepConditionVariableSRW((CONDITION_VARIABLE*)hCond, (SRWLOCK*)hMutex, INFINITE, 0);
+}
+
+void _cmsThrSignalCondition(cmsHANDLE hCond)
+{
+    WakeConditionVariable((CONDITION_VARIABLE*)hCond);
+}
+
+void _cmsThrBroadcastCondition(cmsHANDLE hCond)
+{
+    WakeAllConditionVariable((CONDITION_VARIABLE*)hCond);
+}
+
+static SRWLOCK GlobalLock = SRWLOCK_INIT;
+
+void _cmsThrLockGlobal(void)
+{
+    AcquireSRWLockExclusive(&GlobalLock);
+}
+
+void _cmsThrUnlockGlobal(void)
+{
+    ReleaseSRWLockExclusive(&GlobalLock);
 }
 
 #else
@@ -100,8 +174,8 @@ cmsInt32Number _cmsThrIdealThreadCount(void)
 // To pass parameter to the thread
 typedef struct
 {
-    _cmsTransform2Fn worker;
-    _cmsWorkSlice* param;
+    _cmsThrEntryFn entry;
+    void* param;
 
 } thread_adaptor_param;
 
@@ -111,18 +185,16 @@ static
 void* thread_adaptor(void* p)
 {
     thread_adaptor_param* ap = (thread_adaptor_param*)p;
-    _cmsWorkSlice* s = ap->param;
 
-    ap->worker(s->ContextID, s->CMMcargo, s->InputBuffer, s->OutputBuffer,
-               s->PixelsPerLine, s->LineCount, s->Stride);
+    ap->entry(ap->param);
     _cmsFree(0, p);
 
     return NULL;
 }
 
-// This function creates a thread and executes it. The thread calls the worker function
-// with the given parameters.
-cmsHANDLE _cmsThrCreateWorker(cmsContext ContextID, _cmsTransform2Fn worker, _cmsWorkSlice* param)
+// This function creates a thread and executes it. The thread calls the entry function
+// with the given parameter.
+cmsHANDLE _cmsThrCreateWorker(cmsContext ContextID, _cmsThrEntryFn entry, void* param)
 {
     pthread_t threadId;
     thread_adaptor_param* p;
@@ -130,12 +202,13 @@ cmsHANDLE _cmsThrCreateWorker(cmsContext ContextID, _cmsTransform2Fn worker, _cm
     p = (thread_adaptor_param*)_cmsMalloc(0, sizeof(thread_adaptor_param));
     if (p == NULL) return NULL;
 
-    p->worker = worker;
+    p->entry = entry;
     p->param = param;
 
     int err = pthread_create(&threadId, NULL, thread_adaptor, p);
     if (err != 0)
     {
+        _cmsFree(0, p);
         cmsSignalError(ContextID, cmsERROR_UNDEFINED, "Cannot create thread [pthread error %d]", err);
         return NULL;
     }
@@ -153,13 +226,93 @@ void _cmsThrJoinWorker(cmsContext ContextID, cmsHANDLE hWorker)
     }
 }
 
+// sysconf() may hit the filesystem, so the count is taken only once
 cmsInt32Number _cmsThrIdealThreadCount(void)
 {    
-    long cores = sysconf(_SC_NPROCESSORS_ONLN);
-    if (cores == -1L)
-        return 1;
-    else
-        return (cmsInt32Number)cores;
+    static cmsInt32Number nCPUs = 0;
+
+    if (nCPUs == 0) {
+
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        nCPUs = (cores <= 0L) ? 1 : (cmsInt32Number)cores;
+    }
+
+    return nCPUs;
+}
+
+cmsHANDLE _cmsThrCreateMutex(cmsContext ContextID)
+{
+    pthread_mutex_t* mtx = (pthread_mutex_t*)_cmsMalloc(ContextID, sizeof(pthread_mutex_t));
+    if (mtx == NULL) return NULL;
+
+    if (pthread_mutex_init(mtx, NULL) != 0) {
+        _cmsFree(ContextID, mtx);
+        return NULL;
+    }
+
+    return (cmsHANDLE)mtx;
+}
+
+void _cmsThrDestroyMutex(cmsContext ContextID, cmsHANDLE hMutex)
+{
+    pthread_mutex_destroy((pthread_mutex_t*)hMutex);
+    _cmsFree(ContextID, hMutex);
+}
+
+void _cmsThrLockMutex(cmsHANDLE hMutex)
+{
+    pthread_mutex_lock((pthread_mutex_t*)hMutex);
+}
+
+void _cmsThrUnlockMutex(cmsHANDLE hMutex)
+{
+    pthread_mutex_unlock((pthread_mutex_t*)hMutex);
+}
+
+cmsHANDLE _cmsThrCreateCondition(cmsContext ContextID)
+{
+    pthread_cond_t* cond = (pthread_cond_t*)_cmsMalloc(ContextID, sizeof(pthread_cond_t));
+    if (cond == NULL) return NULL;
+
+    if (pthread_cond_init(cond, NULL) != 0) {
+        _cmsFree(ContextID, cond);
+        return NULL;
+    }
+
+    return (cmsHANDLE)cond;
+}
+
+void _cmsThrDestroyCondition(cmsContext ContextID, cmsHANDLE hCond)
+{
+    pthread_cond_destroy((pthread_cond_t*)hCond);
+    _cmsFree(ContextID, hCond);
+}
+
+void _cmsThrWaitCondition(cmsHANDLE hCond, cmsHANDLE hMutex)
+{
+    pthread_cond_wait((pthread_cond_t*)hCond, (pthread_mutex_t*)hMutex);
+}
+
+void _cmsThrSignalCondition(cmsHANDLE hCond)
+{
+    pthread_cond_signal((pthread_cond_t*)hCond);
+}
+
+void _cmsThrBroadcastCondition(cmsHANDLE hCond)
+{
+    pthread_cond_broadcast((pthread_cond_t*)hCond);
+}
+
+static pthread_mutex_t GlobalLock = PTHREAD_MUTEX_INITIALIZER;
+
+void _cmsThrLockGlobal(void)
+{
+    pthread_mutex_lock(&GlobalLock);
+}
+
+void _cmsThrUnlockGlobal(void)
+{
+    pthread_mutex_unlock(&GlobalLock);
 }
 
 #endif
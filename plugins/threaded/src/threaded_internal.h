@@ -23,8 +23,8 @@
 
 #include "lcms2_threaded.h"
 
-// This plugin requires lcms 2.14 or greater
-#define REQUIRED_LCMS_VERSION 2140
+// This plugin requires lcms 2.17 or greater
+#define REQUIRED_LCMS_VERSION (2170-2000)
 
 // Unused parameter warning suppression
 #define UNUSED_PARAMETER(x) ((void)x) 
@@ -63,12 +63,107 @@ cmsUInt32Number _cmsThrCountSlices(cmsContext ContextID, struct _cmstransform_st
 // Split work following several expert rules
 cmsBool		    _cmsThrSplitWork(cmsContext ContextID, const _cmsWorkSlice* master, cmsInt32Number nslices, _cmsWorkSlice slices[]);
 
+// Work stealing. Cuts the share of one worker in chunks of decreasing size. Returns the number
+// of chunks, which are stored only if chunks is not NULL
+cmsUInt32Number _cmsThrSplitChunks(cmsContext ContextID, const _cmsWorkSlice* master, cmsUInt32Number nWorkers,
+                                   cmsUInt32Number nWorker, _cmsWorkSlice chunks[]);
+
+// Tiling. Cuts the share of one worker in 2D tiles of about TileBytes (0 for default). Same
+// return as above
+cmsUInt32Number _cmsThrSplitTiles(cmsContext ContextID, const _cmsWorkSlice* master, cmsUInt32Number TileBytes,
+                                  cmsUInt32Number nWorkers, cmsUInt32Number nWorker, _cmsWorkSlice tiles[]);
+
+// Working set of tiles, as encoded in the plug-in flags
+#define T_TILE_KB(flags)    (((flags) >> 16) & 0xFFFF)
+
 // Thread primitives
-cmsHANDLE       _cmsThrCreateWorker(cmsContext ContextID, _cmsTransform2Fn worker, _cmsWorkSlice* param);
+typedef void (* _cmsThrEntryFn)(void* param);
+
+cmsHANDLE       _cmsThrCreateWorker(cmsContext ContextID, _cmsThrEntryFn entry, void* param);
 void            _cmsThrJoinWorker(cmsContext ContextID, cmsHANDLE hWorker);
 cmsInt32Number  _cmsThrIdealThreadCount(void);
 
+// Synchronization primitives
+cmsHANDLE       _cmsThrCreateMutex(cmsContext ContextID);
+void            _cmsThrDestroyMutex(cmsContext ContextID, cmsHANDLE hMutex);
+void            _cmsThrLockMutex(cmsHANDLE hMutex);
+void            _cmsThrUnlockMutex(cmsHANDLE hMutex);
+
+cmsHANDLE       _cmsThrCreateCondition(cmsContext ContextID);
+void            _cmsThrDestroyCondition(cmsContext ContextID, cmsHANDLE hCond);
+void            _cmsThrWaitCondition(cmsHANDLE hCond, cmsHANDLE hMutex);
+void            _cmsThrSignalCondition(cmsHANDLE hCond);
+void            _cmsThrBroadcastCondition(cmsHANDLE hCond);
+
+// Protects the list of pools. Statically initialized, never destroyed
+void            _cmsThrLockGlobal(void);
+void            _cmsThrUnlockGlobal(void);
+
+// The per-context worker pool, defined in threaded_pool.c
+typedef struct _cmsThrPool_s _cmsThrPool;
+
+// Chunks owned by one worker. The owner takes them from head, thieves take from tail, so
+// owners keep streaming forward and thieves get the small chunks at the end of each share.
+typedef struct {
+
+	cmsHANDLE       Lock;
+	cmsUInt32Number Head;
+	cmsUInt32Number Tail;           // One past the last chunk
+
+} _cmsThrDeque;
+
+// A set of slices sharing a completion count. Kept by the pool and recycled across calls
+typedef struct _cmsThrJob_s {
+
+	struct _cmsThrJob_s* Next;         // Free list
+
+	_cmsTransform2Fn     Worker;
+	cmsUInt32Number      nTasks;
+	cmsUInt32Number      nPending;     // Tasks not yet done, protected by the pool mutex
+	cmsBool              Stealing;     // Tasks are workers draining Deques rather than single slices
+
+	cmsUInt32Number      nAllocatedTasks;   // Capacity of Tasks and Deques
+	struct _cmsThrTask_s* Tasks;
+	_cmsThrDeque*        Deques;
+
+	cmsUInt32Number      nAllocatedSlices;  // Capacity of Slices
+	_cmsWorkSlice*       Slices;
+
+	cmsStride            Stride;       // Asynchronous jobs keep their own copy
+	_cmsThrPool*         Pool;
+
+	_cmsParallelTaskFn   TaskFn;       // Generic tasks, when not NULL. Worker i runs items i, i + nTasks, ...
+	void*                TaskCargo;
+	cmsContext           TaskContextID;
+	cmsUInt32Number      nTaskItems;
+
+} _cmsThrJob;
+
+// A slice, or a worker of a work stealing job, waiting in the pool queue
+typedef struct _cmsThrTask_s {
+
+	struct _cmsThrTask_s* Next;
+	_cmsThrJob*           Job;
+	_cmsWorkSlice*        Slice;
+	cmsUInt32Number       Deque;      // Own deque on work stealing
+
+} _cmsThrTask;
+
+// The per-context worker pool. Asynchronous submissions run as single task jobs
+_cmsThrPool*    _cmsThrGetPool(cmsContext ContextID);
+void            _cmsThrReleasePool(cmsContext ContextID);
+
+_cmsThrJob*     _cmsThrPoolAcquireJob(_cmsThrPool* pool, cmsUInt32Number nTasks, cmsUInt32Number nSlices);
+cmsBool         _cmsThrPoolPrepareDeques(_cmsThrJob* job, cmsUInt32Number nTasks);
+void            _cmsThrPoolReleaseJob(_cmsThrPool* pool, _cmsThrJob* job);
+void            _cmsThrPoolRun(_cmsThrPool* pool, _cmsThrJob* job, cmsUInt32Number nTasks);
+void            _cmsThrPoolSubmit(_cmsThrPool* pool, _cmsThrJob* job, cmsUInt32Number nTasks);
+cmsBool         _cmsThrPoolIsDone(_cmsThrPool* pool, _cmsThrJob* job);
+void            _cmsThrPoolWait(_cmsThrPool* pool, _cmsThrJob* job);
+
 // The scheduler
+void  _cmsThrRunTasks(cmsContext ContextID, cmsUInt32Number nTasks, _cmsParallelTaskFn Task, void* Cargo);
+
 void  _cmsThrScheduler(cmsContext ContextID, struct _cmstransform_struct* CMMcargo,
 							 const cmsUInt8Number* InputBuffer,
 							 cmsUInt8Number* OutputBuffer,
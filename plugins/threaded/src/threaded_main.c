@@ -29,7 +29,9 @@ static cmsPluginParalellization Plugin = {
 
   CMS_THREADED_GUESS_MAX_THREADS,
   0,
-  _cmsThrScheduler  
+  _cmsThrScheduler,
+  _cmsThrReleasePool,
+  _cmsThrRunTasks
 };
 
 // This is the main plug-in installer. 
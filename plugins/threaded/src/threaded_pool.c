@@ -0,0 +1,513 @@
+//---------------------------------------------------------------------------------
+//
+//  Little Color Management System, multithreaded extensions
+//  Copyright (c) 1998-2024 Marti Maria Saguer, all rights reserved
+//
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+//---------------------------------------------------------------------------------
+
+#include "threaded_internal.h"
+
+// Each context gets its own pool of long-lived workers, created on first use and
+// released when the plug-in is unregistered from the context (which cmsDeleteContext does).
+// Workers sleep on a queue of slices; the calling thread queues all slices but the first,
+// computes the first one itself and then helps draining the queue until its job is done.
+// All memory comes from the global allocator, as the pool may be keyed by a context that
+// does not own the plug-in.
+struct _cmsThrPool_s {
+
+    struct _cmsThrPool_s* Next;     // List of pools
+    cmsContext      ContextID;      // Owner
+
+    cmsHANDLE       Mutex;          // Protects everything below
+    cmsHANDLE       WorkAvailable;  // Signaled on new slices and on shutdown
+    cmsHANDLE       WorkDone;       // Broadcast each time a job completes
+
+    _cmsThrTask*    Head;           // Queue of pending slices
+    _cmsThrTask*    Tail;
+    cmsBool         Shutdown;
+
+    cmsUInt32Number nThreads;
+    cmsUInt32Number nAllocatedThreads;
+    cmsHANDLE*      Threads;
+
+    _cmsThrJob*     FreeJobs;       // Slice storage ready to be reused
+};
+
+// All pools. Protected by the global lock
+static _cmsThrPool* PoolList = NULL;
+
+
+// Evaluates one slice
+cmsINLINE void RunSlice(_cmsTransform2Fn Worker, const _cmsWorkSlice* s)
+{
+    Worker(s->ContextID, s->CMMcargo, s->InputBuffer, s->OutputBuffer,
+           s->PixelsPerLine, s->LineCount, s->Stride);
+}
+
+// Takes next chunk from own deque. Returns FALSE if empty
+static
+cmsBool PopChunk(_cmsThrDeque* d, cmsUInt32Number* chunk)
+{
+    cmsBool found = FALSE;
+
+    _cmsThrLockMutex(d->Lock);
+
+    if (d->Head < d->Tail) {
+        *chunk = d->Head++;
+        found = TRUE;
+    }
+
+    _cmsThrUnlockMutex(d->Lock);
+    return found;
+}
+
+// Takes last chunk from someone else's deque. Returns FALSE if empty
+static
+cmsBool StealChunk(_cmsThrDeque* d, cmsUInt32Number* chunk)
+{
+    cmsBool found = FALSE;
+
+    _cmsThrLockMutex(d->Lock);
+
+    if (d->Head < d->Tail) {
+        *chunk = --d->Tail;
+        found = TRUE;
+    }
+
+    _cmsThrUnlockMutex(d->Lock);
+    return found;
+}
+
+// Drains own deque, then steals from the others until there is nothing left.
+static
+void StealingLoop(_cmsThrJob* job, cmsUInt32Number me, cmsUInt32Number nWorkers)
+{
+    cmsUInt32Number chunk, i;
+
+    for (;;) {
+
+        if (!PopChunk(&job->Deques[me], &chunk)) {
+
+            cmsBool found = FALSE;
+
+            // Victims are visited starting by the next one, so thieves spread
+            for (i = 1; i < nWorkers && !found; i++)
+                found = StealChunk(&job->Deques[(me + i) % nWorkers], &chunk);
+
+            if (!found) return;
+        }
+
+        RunSlice(job->Worker, &job->Slices[chunk]);
+    }
+}
+
+// Evaluates one task
+cmsINLINE void RunTask(_cmsThrTask* task)
+{
+    _cmsThrJob* job = task->Job;
+    cmsUInt32Number i;
+
+    if (job->TaskFn != NULL) {
+
+        for (i = task->Deque; i < job->nTaskItems; i += job->nTasks)
+            job->TaskFn(job->TaskContextID, i, job->TaskCargo);
+    }
+    else
+    if (job->Stealing)
+        StealingLoop(job, task->Deque, job->nTasks);
+    else
+        RunSlice(job->Worker, task->Slice);
+}
+
+// Takes first slice from queue. Pool must be locked
+static
+_cmsThrTask* PopTask(_cmsThrPool* pool)
+{
+    _cmsThrTask* task = pool->Head;
+
+    if (task != NULL) {
+
+        pool->Head = task->Next;
+        if (pool->Head == NULL) pool->Tail = NULL;
+    }
+
+    return task;
+}
+
+// Accounts for a finished slice. Pool must be locked
+static
+void FinishTask(_cmsThrPool* pool, _cmsThrTask* task)
+{
+    if (--task->Job->nPending == 0)
+        _cmsThrBroadcastCondition(pool->WorkDone);
+}
+
+// The long-lived worker
+static
+void PoolThread(void* param)
+{
+    _cmsThrPool* pool = (_cmsThrPool*)param;
+    _cmsThrTask* task;
+
+    _cmsThrLockMutex(pool->Mutex);
+
+    for (;;) {
+
+        while (pool->Head == NULL && !pool->Shutdown)
+            _cmsThrWaitCondition(pool->WorkAvailable, pool->Mutex);
+
+        task = PopTask(pool);
+        if (task == NULL) break;    // Shutdown and nothing left
+
+        _cmsThrUnlockMutex(pool->Mutex);
+        RunTask(task);
+        _cmsThrLockMutex(pool->Mutex);
+
+        FinishTask(pool, task);
+    }
+
+    _cmsThrUnlockMutex(pool->Mutex);
+}
+
+// Grows the pool up to nNeeded workers. Pool must be locked. If a thread cannot be created
+// we just go on with what we have, the caller computes any slice left in the queue.
+static
+void EnsureThreads(_cmsThrPool* pool, cmsUInt32Number nNeeded)
+{
+    while (pool->nThreads < nNeeded) {
+
+        cmsHANDLE hThread;
+
+        if (pool->nThreads >= pool->nAllocatedThreads) {
+
+            cmsUInt32Number n = pool->nAllocatedThreads == 0 ? 8 : pool->nAllocatedThreads * 2;
+            cmsHANDLE* t = (cmsHANDLE*)(pool->Threads == NULL ? _cmsMalloc(0, n * sizeof(cmsHANDLE)) :
+                                                                _cmsRealloc(0, pool->Threads, n * sizeof(cmsHANDLE)));
+            if (t == NULL) return;
+
+            pool->Threads = t;
+            pool->nAllocatedThreads = n;
+        }
+
+        hThread = _cmsThrCreateWorker(pool->ContextID, PoolThread, pool);
+        if (hThread == NULL) return;
+
+        pool->Threads[pool->nThreads++] = hThread;
+    }
+}
+
+static
+void FreeJob(_cmsThrJob* job)
+{
+    cmsUInt32Number i;
+
+    if (job->Deques) {
+
+        for (i = 0; i < job->nAllocatedTasks; i++) {
+            if (job->Deques[i].Lock) _cmsThrDestroyMutex(0, job->Deques[i].Lock);
+        }
+
+        _cmsFree(0, job->Deques);
+    }
+
+    if (job->Tasks)  _cmsFree(0, job->Tasks);
+    if (job->Slices) _cmsFree(0, job->Slices);
+    _cmsFree(0, job);
+}
+
+// Stops all workers and frees the pool. Pool must be unlinked already.
+static
+void DestroyPool(_cmsThrPool* pool)
+{
+    cmsUInt32Number i;
+
+    if (pool->Mutex != NULL) {
+
+        _cmsThrLockMutex(pool->Mutex);
+        pool->Shutdown = TRUE;
+        _cmsThrBroadcastCondition(pool->WorkAvailable);
+        _cmsThrUnlockMutex(pool->Mutex);
+    }
+
+    for (i = 0; i < pool->nThreads; i++)
+        _cmsThrJoinWorker(pool->ContextID, pool->Threads[i]);
+
+    while (pool->FreeJobs != NULL) {
+
+        _cmsThrJob* job = pool->FreeJobs;
+        pool->FreeJobs = job->Next;
+        FreeJob(job);
+    }
+
+    if (pool->Threads)       _cmsFree(0, pool->Threads);
+    if (pool->WorkDone)      _cmsThrDestroyCondition(0, pool->WorkDone);
+    if (pool->WorkAvailable) _cmsThrDestroyCondition(0, pool->WorkAvailable);
+    if (pool->Mutex)         _cmsThrDestroyMutex(0, pool->Mutex);
+
+    _cmsFree(0, pool);
+}
+
+// Returns the pool of the given context, creating it if this is the first time. Threads
+// are not started until there is some work to do. Returns NULL on out of memory.
+_cmsThrPool* _cmsThrGetPool(cmsContext ContextID)
+{
+    _cmsThrPool* pool;
+
+    _cmsThrLockGlobal();
+
+    for (pool = PoolList; pool != NULL; pool = pool->Next) {
+
+        if (pool->ContextID == ContextID) {
+
+            _cmsThrUnlockGlobal();
+            return pool;
+        }
+    }
+
+    pool = (_cmsThrPool*)_cmsMallocZero(0, sizeof(_cmsThrPool));
+    if (pool != NULL) {
+
+        pool->ContextID     = ContextID;
+        pool->Mutex         = _cmsThrCreateMutex(0);
+        pool->WorkAvailable = _cmsThrCreateCondition(0);
+        pool->WorkDone      = _cmsThrCreateCondition(0);
+
+        if (pool->Mutex == NULL || pool->WorkAvailable == NULL || pool->WorkDone == NULL) {
+
+            DestroyPool(pool);
+            pool = NULL;
+        }
+        else {
+
+            pool->Next = PoolList;
+            PoolList = pool;
+        }
+    }
+
+    _cmsThrUnlockGlobal();
+    return pool;
+}
+
+// Called by lcms when the plug-in is removed from the context
+void _cmsThrReleasePool(cmsContext ContextID)
+{
+    _cmsThrPool** prev;
+    _cmsThrPool*  pool = NULL;
+
+    _cmsThrLockGlobal();
+
+    for (prev = &PoolList; *prev != NULL; prev = &(*prev)->Next) {
+
+        if ((*prev)->ContextID == ContextID) {
+
+            pool = *prev;
+            *prev = pool->Next;
+            break;
+        }
+    }
+
+    _cmsThrUnlockGlobal();
+
+    if (pool != NULL)
+        DestroyPool(pool);
+}
+
+// Gets storage for nTasks and nSlices. Storage is recycled, so once the pool is warm there are no allocations.
+_cmsThrJob* _cmsThrPoolAcquireJob(_cmsThrPool* pool, cmsUInt32Number nTasks, cmsUInt32Number nSlices)
+{
+    _cmsThrJob* job;
+
+    _cmsThrLockMutex(pool->Mutex);
+
+    job = pool->FreeJobs;
+    if (job != NULL)
+        pool->FreeJobs = job->Next;
+
+    _cmsThrUnlockMutex(pool->Mutex);
+
+    if (job == NULL) {
+
+        job = (_cmsThrJob*)_cmsMallocZero(0, sizeof(_cmsThrJob));
+        if (job == NULL) return NULL;
+    }
+
+    if (job->nAllocatedTasks < nTasks) {
+
+        _cmsThrTask*  Tasks  = (_cmsThrTask*)_cmsCalloc(0, nTasks, sizeof(_cmsThrTask));
+        _cmsThrDeque* Deques = (_cmsThrDeque*)_cmsCalloc(0, nTasks, sizeof(_cmsThrDeque));
+        cmsUInt32Number i;
+
+        if (Tasks == NULL || Deques == NULL) {
+
+            if (Tasks)  _cmsFree(0, Tasks);
+            if (Deques) _cmsFree(0, Deques);
+            FreeJob(job);
+            return NULL;
+        }
+
+        // Keep the locks we already have
+        for (i = 0; i < job->nAllocatedTasks; i++)
+            Deques[i].Lock = job->Deques[i].Lock;
+
+        if (job->Tasks)  _cmsFree(0, job->Tasks);
+        if (job->Deques) _cmsFree(0, job->Deques);
+
+        job->Tasks  = Tasks;
+        job->Deques = Deques;
+        job->nAllocatedTasks = nTasks;
+    }
+
+    if (job->nAllocatedSlices < nSlices) {
+
+        if (job->Slices) _cmsFree(0, job->Slices);
+
+        job->Slices = (_cmsWorkSlice*)_cmsCalloc(0, nSlices, sizeof(_cmsWorkSlice));
+        job->nAllocatedSlices = job->Slices != NULL ? nSlices : 0;
+
+        if (job->Slices == NULL) {
+
+            FreeJob(job);
+            return NULL;
+        }
+    }
+
+    job->Stealing = FALSE;
+    job->TaskFn = NULL;
+    job->Pool = pool;
+    return job;
+}
+
+// Deque locks are created only for jobs using work stealing
+cmsBool _cmsThrPoolPrepareDeques(_cmsThrJob* job, cmsUInt32Number nTasks)
+{
+    cmsUInt32Number i;
+
+    for (i = 0; i < nTasks; i++) {
+
+        if (job->Deques[i].Lock == NULL) {
+
+            job->Deques[i].Lock = _cmsThrCreateMutex(0);
+            if (job->Deques[i].Lock == NULL) return FALSE;
+        }
+    }
+
+    job->Stealing = TRUE;
+    return TRUE;
+}
+
+// Returns storage to the pool
+void _cmsThrPoolReleaseJob(_cmsThrPool* pool, _cmsThrJob* job)
+{
+    _cmsThrLockMutex(pool->Mutex);
+
+    job->Next = pool->FreeJobs;
+    pool->FreeJobs = job;
+
+    _cmsThrUnlockMutex(pool->Mutex);
+}
+
+// Queues tasks from first to nTasks - 1 and wakes up the workers
+static
+void Submit(_cmsThrPool* pool, _cmsThrJob* job, cmsUInt32Number first, cmsUInt32Number nTasks)
+{
+    cmsUInt32Number i;
+    _cmsThrTask* task;
+
+    for (i = 0; i < nTasks; i++) {
+
+        task = &job->Tasks[i];
+
+        task->Job   = job;
+        task->Slice = (job->Stealing || job->TaskFn != NULL) ? NULL : &job->Slices[i];
+        task->Deque = i;
+        task->Next  = NULL;
+    }
+
+    _cmsThrLockMutex(pool->Mutex);
+
+    EnsureThreads(pool, nTasks - first);
+
+    job->nTasks   = nTasks;
+    job->nPending = nTasks - first;
+
+    for (i = first; i < nTasks; i++) {
+
+        task = &job->Tasks[i];
+
+        if (pool->Tail) pool->Tail->Next = task;
+        else            pool->Head = task;
+        pool->Tail = task;
+    }
+
+    _cmsThrBroadcastCondition(pool->WorkAvailable);
+    _cmsThrUnlockMutex(pool->Mutex);
+}
+
+// Computes the already split job. First task is done by the calling thread, the rest go
+// to the queue. Returns when all tasks are done.
+void _cmsThrPoolRun(_cmsThrPool* pool, _cmsThrJob* job, cmsUInt32Number nTasks)
+{
+    Submit(pool, job, 1, nTasks);
+
+    // Do our portion of work
+    RunTask(&job->Tasks[0]);
+
+    _cmsThrPoolWait(pool, job);
+}
+
+// Queues all tasks of the job and returns at once
+void _cmsThrPoolSubmit(_cmsThrPool* pool, _cmsThrJob* job, cmsUInt32Number nTasks)
+{
+    Submit(pool, job, 0, nTasks);
+}
+
+// Non-blocking check for completion
+cmsBool _cmsThrPoolIsDone(_cmsThrPool* pool, _cmsThrJob* job)
+{
+    cmsBool done;
+
+    _cmsThrLockMutex(pool->Mutex);
+    done = (job->nPending == 0);
+    _cmsThrUnlockMutex(pool->Mutex);
+
+    return done;
+}
+
+// Helps with whatever is queued until the tasks of the job are done
+void _cmsThrPoolWait(_cmsThrPool* pool, _cmsThrJob* job)
+{
+    _cmsThrTask* task;
+
+    _cmsThrLockMutex(pool->Mutex);
+
+    while (job->nPending > 0) {
+
+        task = PopTask(pool);
+        if (task != NULL) {
+
+            _cmsThrUnlockMutex(pool->Mutex);
+            RunTask(task);
+            _cmsThrLockMutex(pool->Mutex);
+
+            FinishTask(pool, task);
+        }
+        else
+            _cmsThrWaitCondition(pool->WorkDone, pool->Mutex);
+    }
+
+    _cmsThrUnlockMutex(pool->Mutex);
+}
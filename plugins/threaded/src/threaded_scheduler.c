@@ -21,9 +21,61 @@
 
 #include "threaded_internal.h"
 
+// Cuts the share of one worker in chunks, or in tiles
+static
+cmsUInt32Number SplitShare(cmsContext ContextID, const _cmsWorkSlice* master, cmsUInt32Number flags,
+                           cmsUInt32Number nWorkers, cmsUInt32Number nWorker, _cmsWorkSlice slices[])
+{
+    if (flags & CMS_THREADED_TILING)
+        return _cmsThrSplitTiles(ContextID, master, T_TILE_KB(flags) * 1024, nWorkers, nWorker, slices);
+    else
+        return _cmsThrSplitChunks(ContextID, master, nWorkers, nWorker, slices);
+}
+
+// Work stealing. Every worker gets a deque of chunks (or tiles) covering its share of the image.
+static
+void StealingScheduler(cmsContext ContextID, _cmsTransform2Fn worker, const _cmsWorkSlice* master,
+                       cmsUInt32Number flags, cmsUInt32Number nWorkers)
+{
+    _cmsThrPool* pool;
+    _cmsThrJob* job = NULL;
+    cmsUInt32Number i, nChunks = 0;
+
+    for (i = 0; i < nWorkers; i++)
+        nChunks += SplitShare(ContextID, master, flags, nWorkers, i, NULL);
+
+    pool = _cmsThrGetPool(ContextID);
+    if (pool != NULL)
+        job = _cmsThrPoolAcquireJob(pool, nWorkers, nChunks);
+
+    if (job == NULL || !_cmsThrPoolPrepareDeques(job, nWorkers))
+    {
+        if (job != NULL) _cmsThrPoolReleaseJob(pool, job);
+
+        // Out of memory, do the work anyway
+        worker(ContextID, master->CMMcargo, master->InputBuffer, master->OutputBuffer,
+               master->PixelsPerLine, master->LineCount, master->Stride);
+        return;
+    }
+
+    nChunks = 0;
+    for (i = 0; i < nWorkers; i++) {
+
+        job->Deques[i].Head = nChunks;
+        nChunks += SplitShare(ContextID, master, flags, nWorkers, i, job->Slices + nChunks);
+        job->Deques[i].Tail = nChunks;
+    }
+
+    job->Worker = worker;
+    _cmsThrPoolRun(pool, job, nWorkers);
+
+    _cmsThrPoolReleaseJob(pool, job);
+}
+
+
 // The scheduler is responsible to split the work in several portions in a way that each
 // portion can be calculated by a different thread. All locking is already done by lcms 
-// mutexes, memory should not overlap.
+// mutexes, memory should not overlap. Portions are handed to the worker pool of the context.
 void  _cmsThrScheduler(cmsContext ContextID, struct _cmstransform_struct* CMMcargo,
 						const cmsUInt8Number* InputBuffer,
 						cmsUInt8Number* OutputBuffer,
@@ -33,14 +85,12 @@ void  _cmsThrScheduler(cmsContext ContextID, struct _cmstransform_struct* CMMcar
 {
     _cmsTransform2Fn worker = _cmsGetTransformWorker(CMMcargo);
     cmsInt32Number   MaxWorkers = _cmsGetTransformMaxWorkers(CMMcargo);
-
-    // flags are not actually being used
-    // cmsUInt32Number  flags = _cmsGetTransformWorkerFlags(CMMcargo);
+    cmsUInt32Number  flags = _cmsGetTransformWorkerFlags(CMMcargo);
 
     _cmsWorkSlice master;
-    _cmsWorkSlice* slices;
     cmsStride FixedStride = *Stride;
-    cmsHANDLE* handles;
+    _cmsThrPool* pool;
+    _cmsThrJob* job;
 
     //  Count the number of threads needed for this job. MaxWorkers is the upper limit or -1 to auto
     cmsUInt32Number nSlices = _cmsThrCountSlices(ContextID, CMMcargo, MaxWorkers, PixelsPerLine, LineCount, &FixedStride);
@@ -61,40 +111,29 @@ void  _cmsThrScheduler(cmsContext ContextID, struct _cmstransform_struct* CMMcar
     master.LineCount = LineCount;
     master.Stride = &FixedStride;
 
-    // Create memory for the slices
-    slices  = (_cmsWorkSlice*)_cmsCalloc(ContextID, nSlices, sizeof(_cmsWorkSlice));
-    handles = (cmsHANDLE*) _cmsCalloc(ContextID, nSlices, sizeof(cmsHANDLE));
+    if ((flags & (CMS_THREADED_WORK_STEALING|CMS_THREADED_TILING)) && PixelsPerLine > 0) {
 
-    if (slices == NULL || handles == NULL)
-    {
-        if (slices)  _cmsFree(ContextID, slices);
-        if (handles) _cmsFree(ContextID, handles);
+        StealingScheduler(ContextID, worker, &master, flags, nSlices);
+        return;
+    }
 
+    // Get the workers and the storage for the slices
+    pool = _cmsThrGetPool(ContextID);
+    job = (pool != NULL) ? _cmsThrPoolAcquireJob(pool, nSlices, nSlices) : NULL;
+
+    if (job == NULL)
+    {
         // Out of memory in this case only can come from a corruption, but we do the work anyway
         worker(ContextID, CMMcargo, InputBuffer, OutputBuffer, PixelsPerLine, LineCount, Stride);
         return;
     }
 
     // All seems ok so far
-    if (_cmsThrSplitWork(ContextID, &master, nSlices, slices))
+    if (_cmsThrSplitWork(ContextID, &master, nSlices, job->Slices))
     {
-        // Work is split. Create threads
-        cmsUInt32Number i;
-
-        for (i = 1; i < nSlices; i++)
-        {
-            handles[i] = _cmsThrCreateWorker(ContextID, worker, &slices[i]);
-        }
-
-        // Do our portion of work 
-        worker(ContextID, CMMcargo, slices[0].InputBuffer, slices[0].OutputBuffer,
-            slices[0].PixelsPerLine, slices[0].LineCount, slices[0].Stride);
-
-        // Wait until all threads are finished
-        for (i = 1; i < nSlices; i++)
-        {
-            _cmsThrJoinWorker(ContextID, handles[i]);
-        }
+        // Work is split. Let the pool do it
+        job->Worker = worker;
+        _cmsThrPoolRun(pool, job, nSlices);
     }
     else
     {
@@ -102,7 +141,124 @@ void  _cmsThrScheduler(cmsContext ContextID, struct _cmstransform_struct* CMMcar
         worker(ContextID, CMMcargo, InputBuffer, OutputBuffer, PixelsPerLine, LineCount, Stride);
     }
 
-    _cmsFree(ContextID, slices);
-    _cmsFree(ContextID, handles);
+    _cmsThrPoolReleaseJob(pool, job);
+}
+
+
+// Independent tasks other than transforms, as CLUT sampling. Items are dealt out round robin
+// to as many workers as the machine has cores, but no more than the plug-in was installed with.
+void _cmsThrRunTasks(cmsContext ContextID, cmsUInt32Number nTasks, _cmsParallelTaskFn Task, void* Cargo)
+{
+    cmsUInt32Number i, nWorkers = (cmsUInt32Number) _cmsThrIdealThreadCount();
+    cmsInt32Number  MaxWorkers = _cmsGetContextMaxWorkers(ContextID);
+    _cmsThrPool* pool;
+    _cmsThrJob* job = NULL;
+
+    // CMS_THREADED_GUESS_MAX_THREADS leaves it to the cores count
+    if (MaxWorkers >= 0 && nWorkers > (cmsUInt32Number) MaxWorkers)
+        nWorkers = (cmsUInt32Number) MaxWorkers;
+
+    if (nWorkers > nTasks) nWorkers = nTasks;
+
+    pool = (nWorkers > 1) ? _cmsThrGetPool(ContextID) : NULL;
+    if (pool != NULL)
+        job = _cmsThrPoolAcquireJob(pool, nWorkers, 0);
+
+    if (job == NULL) {
+
+        for (i = 0; i < nTasks; i++)
+            Task(ContextID, i, Cargo);
+        return;
+    }
+
+    job->TaskFn        = Task;
+    job->TaskCargo     = Cargo;
+    job->TaskContextID = ContextID;
+    job->nTaskItems    = nTasks;
+
+    _cmsThrPoolRun(pool, job, nWorkers);
+
+    _cmsThrPoolReleaseJob(pool, job);
+}
+
+
+// Asynchronous submissions. The whole call goes to one pool thread, which in turn runs the
+// transform through the scheduler above, so big images are still split across the pool.
+static
+void AsyncWorker(cmsContext ContextID, struct _cmstransform_struct* CMMcargo,
+                 const cmsUInt8Number* InputBuffer,
+                 cmsUInt8Number* OutputBuffer,
+                 cmsUInt32Number PixelsPerLine,
+                 cmsUInt32Number LineCount,
+                 const cmsStride* Stride)
+{
+    cmsDoTransformLineStrideEx(ContextID, (cmsHTRANSFORM) CMMcargo, InputBuffer, OutputBuffer,
+                               PixelsPerLine, LineCount,
+                               Stride->BytesPerLineIn, Stride->BytesPerLineOut,
+                               Stride->BytesPerPlaneIn, Stride->BytesPerPlaneOut);
+}
+
+cmsHANDLE CMSEXPORT cmsThreadedSubmitTransform(cmsContext ContextID,
+                                               cmsHTRANSFORM Transform,
+                                               const void* InputBuffer,
+                                               void* OutputBuffer,
+                                               cmsUInt32Number PixelsPerLine,
+                                               cmsUInt32Number LineCount,
+                                               cmsUInt32Number BytesPerLineIn,
+                                               cmsUInt32Number BytesPerLineOut,
+                                               cmsUInt32Number BytesPerPlaneIn,
+                                               cmsUInt32Number BytesPerPlaneOut)
+{
+    _cmsThrPool* pool;
+    _cmsThrJob* job;
+    _cmsWorkSlice* s;
+
+    if (Transform == NULL) return NULL;
+
+    pool = _cmsThrGetPool(ContextID);
+    if (pool == NULL) return NULL;
+
+    job = _cmsThrPoolAcquireJob(pool, 1, 1);
+    if (job == NULL) return NULL;
+
+    job->Stride.BytesPerLineIn   = BytesPerLineIn;
+    job->Stride.BytesPerLineOut  = BytesPerLineOut;
+    job->Stride.BytesPerPlaneIn  = BytesPerPlaneIn;
+    job->Stride.BytesPerPlaneOut = BytesPerPlaneOut;
+
+    s = &job->Slices[0];
+    s->ContextID     = ContextID;
+    s->CMMcargo      = (struct _cmstransform_struct*) Transform;
+    s->InputBuffer   = (const cmsUInt8Number*) InputBuffer;
+    s->OutputBuffer  = (cmsUInt8Number*) OutputBuffer;
+    s->PixelsPerLine = PixelsPerLine;
+    s->LineCount     = LineCount;
+    s->Stride        = &job->Stride;
+
+    job->Worker = AsyncWorker;
+    _cmsThrPoolSubmit(pool, job, 1);
+
+    return (cmsHANDLE) job;
+}
+
+cmsBool CMSEXPORT cmsThreadedTestTransform(cmsContext ContextID, cmsHANDLE hJob)
+{
+    _cmsThrJob* job = (_cmsThrJob*) hJob;
+
+    UNUSED_PARAMETER(ContextID);
+
+    if (job == NULL) return TRUE;
+    return _cmsThrPoolIsDone(job->Pool, job);
 }
 
+void CMSEXPORT cmsThreadedWaitTransform(cmsContext ContextID, cmsHANDLE hJob)
+{
+    _cmsThrJob* job = (_cmsThrJob*) hJob;
+
+    UNUSED_PARAMETER(ContextID);
+
+    if (job == NULL) return;
+
+    _cmsThrPoolWait(job->Pool, job);
+    _cmsThrPoolReleaseJob(job->Pool, job);
+}
@@ -44,6 +44,12 @@ cmsINLINE cmsUInt32Number PixelSpacing(cmsUInt32Number format)
         return ComponentSize(format) * (T_CHANNELS(format) + T_EXTRA(format));
 }
 
+// Bytes of a whole pixel, all planes included
+cmsINLINE cmsUInt32Number PixelSize(cmsUInt32Number format)
+{
+    return ComponentSize(format) * (T_CHANNELS(format) + T_EXTRA(format));
+}
+
 // macro is not portable
 cmsINLINE cmsUInt32Number minimum(cmsUInt32Number a, cmsUInt32Number b)
 {
@@ -214,3 +220,145 @@ cmsBool _cmsThrSplitWork(cmsContext ContextID, const _cmsWorkSlice* master, cmsI
 
     return TRUE;
 }
+
+
+// Work stealing chunks should fit comfortably in L1/L2. Smaller chunks would make locking show up.
+#define CHUNK_BYTES (16 * 1024)
+
+// Cuts lines [first, first + count), or pixels if there is only one line, from master
+static
+void MakeChunk(const _cmsWorkSlice* master, cmsUInt32Number PixelSpacingIn, cmsUInt32Number PixelSpacingOut,
+               cmsUInt32Number first, cmsUInt32Number count, _cmsWorkSlice* chunk)
+{
+    memcpy(chunk, master, sizeof(_cmsWorkSlice));
+
+    if (master->LineCount <= 1) {
+
+        chunk->InputBuffer   = master->InputBuffer  + (size_t) first * PixelSpacingIn;
+        chunk->OutputBuffer  = master->OutputBuffer + (size_t) first * PixelSpacingOut;
+        chunk->PixelsPerLine = count;
+    }
+    else {
+
+        chunk->InputBuffer  = master->InputBuffer  + (size_t) first * master->Stride->BytesPerLineIn;
+        chunk->OutputBuffer = master->OutputBuffer + (size_t) first * master->Stride->BytesPerLineOut;
+        chunk->LineCount    = count;
+    }
+}
+
+// Each worker gets an equal share of lines (or pixels), which is cut in chunks of decreasing
+// size: half of the remaining each time, down to CHUNK_BYTES. The owner goes through the big
+// ones first, and whoever runs out of work steals the small ones from the end. This way a slow
+// share gets finished by everybody at a fine grain without paying fine grain all along.
+cmsUInt32Number _cmsThrSplitChunks(cmsContext ContextID, const _cmsWorkSlice* master, cmsUInt32Number nWorkers,
+                                   cmsUInt32Number nWorker, _cmsWorkSlice chunks[])
+{
+    cmsUInt32Number InputFormat  = cmsGetTransformInputFormat(ContextID, (cmsHTRANSFORM)master->CMMcargo);
+    cmsUInt32Number OutputFormat = cmsGetTransformOutputFormat(ContextID, (cmsHTRANSFORM)master->CMMcargo);
+    cmsUInt32Number TotalUnits, UnitSize, MinUnits;
+    cmsUInt32Number first, last, left, count, nChunks = 0;
+
+    if (master->LineCount <= 1) {
+
+        TotalUnits = master->PixelsPerLine;
+        UnitSize   = PixelSize(InputFormat) + PixelSize(OutputFormat);
+    }
+    else {
+
+        TotalUnits = master->LineCount;
+        UnitSize   = (PixelSize(InputFormat) + PixelSize(OutputFormat)) * master->PixelsPerLine;
+    }
+
+    MinUnits = UnitSize == 0 ? 1 : CHUNK_BYTES / UnitSize;
+    if (MinUnits < 1) MinUnits = 1;
+
+    first = (cmsUInt32Number) (((cmsUInt64Number) TotalUnits * nWorker) / nWorkers);
+    last  = (cmsUInt32Number) (((cmsUInt64Number) TotalUnits * (nWorker + 1)) / nWorkers);
+
+    for (left = last - first; left > 0; left -= count) {
+
+        count = (left >= 2 * MinUnits) ? left / 2 : left;
+
+        if (chunks != NULL)
+            MakeChunk(master, PixelSpacing(InputFormat), PixelSpacing(OutputFormat), first, count, &chunks[nChunks]);
+
+        first += count;
+        nChunks++;
+    }
+
+    return nChunks;
+}
+
+
+// Default working set of one tile, input and output together. A good share of a typical L2
+#define TILE_BYTES (256 * 1024)
+
+// Tiles are as wide as the image when some lines fit in the working set, then as many lines
+// as fit are taken. Otherwise lines are cut in columns of about the working set size.
+static
+void TileGeometry(const _cmsWorkSlice* master, cmsUInt32Number UnitSize, cmsUInt32Number TileBytes,
+                  cmsUInt32Number* Width, cmsUInt32Number* Height, cmsUInt32Number* nCols, cmsUInt32Number* nRows)
+{
+    cmsUInt32Number Lines = master->LineCount == 0 ? 1 : master->LineCount;
+    cmsUInt32Number PixelsPerTile;
+
+    if (TileBytes == 0) TileBytes = TILE_BYTES;
+    if (UnitSize == 0)  UnitSize = 1;
+
+    PixelsPerTile = TileBytes / UnitSize;
+    if (PixelsPerTile < 1) PixelsPerTile = 1;
+
+    if (master->PixelsPerLine <= PixelsPerTile) {
+
+        *Width  = master->PixelsPerLine;
+        *Height = minimum(PixelsPerTile / master->PixelsPerLine, Lines);
+    }
+    else {
+
+        // Columns multiple of 64 pixels, so neighbour tiles seldom share a cache line
+        *Width  = (PixelsPerTile + 63) & ~63U;
+        *Height = 1;
+    }
+
+    *nCols = (master->PixelsPerLine + *Width - 1) / *Width;
+    *nRows = (Lines + *Height - 1) / *Height;
+}
+
+// Each worker gets an equal share of the tiles, in row order. Tiles keep the line and plane
+// strides of the whole image, only the origin moves, so planar buffers work as chunky ones.
+cmsUInt32Number _cmsThrSplitTiles(cmsContext ContextID, const _cmsWorkSlice* master, cmsUInt32Number TileBytes,
+                                  cmsUInt32Number nWorkers, cmsUInt32Number nWorker, _cmsWorkSlice tiles[])
+{
+    cmsUInt32Number InputFormat  = cmsGetTransformInputFormat(ContextID, (cmsHTRANSFORM)master->CMMcargo);
+    cmsUInt32Number OutputFormat = cmsGetTransformOutputFormat(ContextID, (cmsHTRANSFORM)master->CMMcargo);
+    cmsUInt32Number PixelSpacingIn  = PixelSpacing(InputFormat);
+    cmsUInt32Number PixelSpacingOut = PixelSpacing(OutputFormat);
+    cmsUInt32Number Width, Height, nCols, nRows;
+    cmsUInt32Number first, last, t, x, y;
+
+    TileGeometry(master, PixelSize(InputFormat) + PixelSize(OutputFormat), TileBytes, &Width, &Height, &nCols, &nRows);
+
+    first = (cmsUInt32Number) (((cmsUInt64Number) nCols * nRows * nWorker) / nWorkers);
+    last  = (cmsUInt32Number) (((cmsUInt64Number) nCols * nRows * (nWorker + 1)) / nWorkers);
+
+    if (tiles == NULL) return last - first;
+
+    for (t = first; t < last; t++) {
+
+        _cmsWorkSlice* tile = &tiles[t - first];
+
+        x = (t % nCols) * Width;
+        y = (t / nCols) * Height;
+
+        memcpy(tile, master, sizeof(_cmsWorkSlice));
+
+        tile->InputBuffer   = master->InputBuffer  + (size_t) y * master->Stride->BytesPerLineIn  + (size_t) x * PixelSpacingIn;
+        tile->OutputBuffer  = master->OutputBuffer + (size_t) y * master->Stride->BytesPerLineOut + (size_t) x * PixelSpacingOut;
+        tile->PixelsPerLine = minimum(Width, master->PixelsPerLine - x);
+
+        if (master->LineCount > 0)
+            tile->LineCount = minimum(Height, master->LineCount - y);
+    }
+
+    return last - first;
+}
@@ -352,6 +352,432 @@ void CheckAccuracy16Bits(cmsContext ContextID)
 }
 
 
+// Many medium-sized transforms on the same context. Slices go to the long-lived worker pool,
+// which is created on first use and torn down by cmsDeleteContext. Odd cycles use work stealing
+static
+void CheckWorkerPool(cmsContext ContextID)
+{
+    cmsContext Raw = cmsCreateContext(NULL, NULL);
+    cmsContext Plugin;
+    cmsHPROFILE hsRGB, hLab;
+    cmsHTRANSFORM xformRaw, xformPlugin;
+    Scanline_rgba8bits* bufferIn;
+    cmsUInt16Number* bufferRawOut;
+    cmsUInt16Number* bufferPluginOut;
+    cmsUInt32Number npixels = 512 * 512;
+    cmsUInt32Number i;
+    int round, cycle;
+
+    trace("Checking worker pool...");
+
+    bufferIn = (Scanline_rgba8bits*)malloc(npixels * sizeof(Scanline_rgba8bits));
+    bufferRawOut = (cmsUInt16Number*)malloc(npixels * 3 * sizeof(cmsUInt16Number));
+    bufferPluginOut = (cmsUInt16Number*)malloc(npixels * 3 * sizeof(cmsUInt16Number));
+
+    for (i = 0; i < npixels; i++) {
+
+        bufferIn[i].r = (cmsUInt8Number)i;
+        bufferIn[i].g = (cmsUInt8Number)(i >> 8);
+        bufferIn[i].b = (cmsUInt8Number)(i >> 16);
+        bufferIn[i].a = 0xff;
+    }
+
+    hsRGB = cmsCreate_sRGBProfile(Raw);
+    hLab = cmsCreateLab4Profile(Raw, NULL);
+
+    xformRaw = cmsCreateTransform(Raw, hsRGB, TYPE_RGBA_8, hLab, TYPE_Lab_16, INTENT_PERCEPTUAL, FLAGS);
+    cmsDoTransform(Raw, xformRaw, bufferIn, bufferRawOut, npixels);
+
+    // Several contexts in a row, to check pools are not leaked
+    for (cycle = 0; cycle < 4; cycle++) {
+
+        cmsUInt32Number flags = (cycle & 1) ? CMS_THREADED_WORK_STEALING : 0;
+
+        // Fixed number of workers, so the pool is used even on single core machines
+        Plugin = cmsCreateContext(cmsThreadedExtensions(4, flags), NULL);
+        xformPlugin = cmsCreateTransform(Plugin, hsRGB, TYPE_RGBA_8, hLab, TYPE_Lab_16, INTENT_PERCEPTUAL, FLAGS);
+
+        if (xformRaw == NULL || xformPlugin == NULL) {
+
+            Fail(ContextID, "NULL transforms on check worker pool");
+        }
+
+        for (round = 0; round < 50; round++) {
+
+            memset(bufferPluginOut, 0, npixels * 3 * sizeof(cmsUInt16Number));
+
+            // Single line is split by pixels, many lines are split by lines
+            if (round & 1)
+                cmsDoTransformLineStride(Plugin, xformPlugin, bufferIn, bufferPluginOut, 512, 512, 512 * sizeof(Scanline_rgba8bits), 512 * 3 * sizeof(cmsUInt16Number), 0, 0);
+            else
+                cmsDoTransform(Plugin, xformPlugin, bufferIn, bufferPluginOut, npixels);
+
+            if (memcmp(bufferRawOut, bufferPluginOut, npixels * 3 * sizeof(cmsUInt16Number)) != 0)
+                Fail(ContextID, "Worker pool results mismatch on round %d", round);
+        }
+
+        cmsDeleteTransform(Plugin, xformPlugin);
+        cmsDeleteContext(Plugin);
+    }
+
+    cmsDeleteTransform(Raw, xformRaw);
+    cmsCloseProfile(Raw, hsRGB);
+    cmsCloseProfile(Raw, hLab);
+    cmsDeleteContext(Raw);
+
+    free(bufferIn); free(bufferRawOut);
+    free(bufferPluginOut);
+
+    trace("Ok\n");
+}
+
+// Very wide images, chunky and planar, cut in small tiles
+static
+void CheckTiling(cmsContext ContextID)
+{
+    cmsContext Raw = cmsCreateContext(NULL, NULL);
+    cmsContext Plugin = cmsCreateContext(cmsThreadedExtensions(4, CMS_THREADED_TILING|CMS_THREADED_TILE_KB(16)), NULL);
+    cmsHPROFILE hsRGB, hLab;
+    cmsUInt32Number width = 20000, lines = 12;
+    cmsUInt32Number BytesPerLineIn = width * 3 + 5;      // Padded lines
+    cmsUInt32Number BytesPerLineOut = width * 6;
+    cmsUInt32Number size_in = BytesPerLineIn * lines * 3;
+    cmsUInt32Number size_out = BytesPerLineOut * lines;
+    cmsUInt8Number* bufferIn;
+    cmsUInt8Number* bufferRawOut;
+    cmsUInt8Number* bufferPluginOut;
+    cmsUInt32Number i;
+    int planar;
+
+    trace("Checking tiling...");
+
+    bufferIn = (cmsUInt8Number*)malloc(size_in);
+    bufferRawOut = (cmsUInt8Number*)malloc(size_out);
+    bufferPluginOut = (cmsUInt8Number*)malloc(size_out);
+
+    for (i = 0; i < size_in; i++)
+        bufferIn[i] = (cmsUInt8Number)(i * 7 + (i >> 9));
+
+    hsRGB = cmsCreate_sRGBProfile(Raw);
+    hLab = cmsCreateLab4Profile(Raw, NULL);
+
+    for (planar = 0; planar < 2; planar++) {
+
+        cmsUInt32Number InputFormat = planar ? TYPE_RGB_8_PLANAR : TYPE_RGB_8;
+        cmsUInt32Number LineIn = planar ? width + 5 : BytesPerLineIn;
+        cmsUInt32Number BytesPerPlaneIn = planar ? LineIn * lines : 0;
+        cmsHTRANSFORM xformRaw = cmsCreateTransform(Raw, hsRGB, InputFormat, hLab, TYPE_Lab_16, INTENT_PERCEPTUAL, FLAGS);
+        cmsHTRANSFORM xformPlugin = cmsCreateTransform(Plugin, hsRGB, InputFormat, hLab, TYPE_Lab_16, INTENT_PERCEPTUAL, FLAGS);
+
+        if (xformRaw == NULL || xformPlugin == NULL) {
+
+            Fail(ContextID, "NULL transforms on check tiling");
+        }
+
+        memset(bufferRawOut, 0, size_out);
+        memset(bufferPluginOut, 0, size_out);
+
+        cmsDoTransformLineStride(Raw, xformRaw, bufferIn, bufferRawOut, width, lines, LineIn, BytesPerLineOut, BytesPerPlaneIn, 0);
+        cmsDoTransformLineStride(Plugin, xformPlugin, bufferIn, bufferPluginOut, width, lines, LineIn, BytesPerLineOut, BytesPerPlaneIn, 0);
+
+        if (memcmp(bufferRawOut, bufferPluginOut, size_out) != 0)
+            Fail(ContextID, "Tiling results mismatch on %s", planar ? "planar" : "chunky");
+
+        cmsDeleteTransform(Raw, xformRaw);
+        cmsDeleteTransform(Plugin, xformPlugin);
+    }
+
+    cmsCloseProfile(Raw, hsRGB);
+    cmsCloseProfile(Raw, hLab);
+    cmsDeleteContext(Raw);
+    cmsDeleteContext(Plugin);
+
+    free(bufferIn); free(bufferRawOut);
+    free(bufferPluginOut);
+
+    trace("Ok\n");
+}
+
+// Several asynchronous jobs in flight on the same transform
+static
+void CheckAsyncTransforms(cmsContext ContextID)
+{
+    cmsContext Raw = cmsCreateContext(NULL, NULL);
+    cmsContext Plugin = cmsCreateContext(cmsThreadedExtensions(4, 0), NULL);
+    cmsHPROFILE hsRGB, hLab;
+    cmsHTRANSFORM xformRaw, xformPlugin;
+    Scanline_rgba8bits* bufferIn;
+    cmsUInt16Number* bufferRawOut;
+    cmsUInt16Number* bufferPluginOut[4];
+    cmsHANDLE jobs[4];
+    cmsUInt32Number npixels = 512 * 512;
+    cmsUInt32Number i;
+    int round, j;
+
+    trace("Checking asynchronous transforms...");
+
+    bufferIn = (Scanline_rgba8bits*)malloc(npixels * sizeof(Scanline_rgba8bits));
+    bufferRawOut = (cmsUInt16Number*)malloc(npixels * 3 * sizeof(cmsUInt16Number));
+    for (j = 0; j < 4; j++)
+        bufferPluginOut[j] = (cmsUInt16Number*)malloc(npixels * 3 * sizeof(cmsUInt16Number));
+
+    for (i = 0; i < npixels; i++) {
+
+        bufferIn[i].r = (cmsUInt8Number)(i >> 3);
+        bufferIn[i].g = (cmsUInt8Number)(i >> 11);
+        bufferIn[i].b = (cmsUInt8Number)i;
+        bufferIn[i].a = 0xff;
+    }
+
+    hsRGB = cmsCreate_sRGBProfile(Raw);
+    hLab = cmsCreateLab4Profile(Raw, NULL);
+
+    xformRaw = cmsCreateTransform(Raw, hsRGB, TYPE_RGBA_8, hLab, TYPE_Lab_16, INTENT_PERCEPTUAL, FLAGS);
+    xformPlugin = cmsCreateTransform(Plugin, hsRGB, TYPE_RGBA_8, hLab, TYPE_Lab_16, INTENT_PERCEPTUAL, FLAGS);
+
+    if (xformRaw == NULL || xformPlugin == NULL) {
+
+        Fail(ContextID, "NULL transforms on check asynchronous transforms");
+    }
+
+    cmsDoTransform(Raw, xformRaw, bufferIn, bufferRawOut, npixels);
+
+    for (round = 0; round < 10; round++) {
+
+        for (j = 0; j < 4; j++) {
+
+            memset(bufferPluginOut[j], 0, npixels * 3 * sizeof(cmsUInt16Number));
+
+            jobs[j] = cmsThreadedSubmitTransform(Plugin, xformPlugin, bufferIn, bufferPluginOut[j], 512, 512,
+                                                 512 * sizeof(Scanline_rgba8bits), 512 * 3 * sizeof(cmsUInt16Number), 0, 0);
+            if (jobs[j] == NULL)
+                Fail(ContextID, "Cannot submit asynchronous transform");
+        }
+
+        // Poll one, wait all, in reverse order
+        cmsThreadedTestTransform(Plugin, jobs[0]);
+
+        for (j = 3; j >= 0; j--) {
+
+            cmsThreadedWaitTransform(Plugin, jobs[j]);
+
+            if (memcmp(bufferRawOut, bufferPluginOut[j], npixels * 3 * sizeof(cmsUInt16Number)) != 0)
+                Fail(ContextID, "Asynchronous results mismatch on round %d, job %d", round, j);
+        }
+    }
+
+    cmsDeleteTransform(Plugin, xformPlugin);
+    cmsDeleteContext(Plugin);
+
+    cmsDeleteTransform(Raw, xformRaw);
+    cmsCloseProfile(Raw, hsRGB);
+    cmsCloseProfile(Raw, hLab);
+    cmsDeleteContext(Raw);
+
+    free(bufferIn); free(bufferRawOut);
+    for (j = 0; j < 4; j++)
+        free(bufferPluginOut[j]);
+
+    trace("Ok\n");
+}
+
+
+// A reentrant sampler, fails on the node given in cargo
+static
+cmsInt32Number MixSampler(cmsContext ContextID, const cmsUInt16Number In[], cmsUInt16Number Out[], void* Cargo)
+{
+    cmsUInt32Number FailOn = *(cmsUInt32Number*)Cargo;
+    UNUSED_PARAMETER(ContextID);
+
+    if (In[0] == FailOn && In[1] == FailOn && In[2] == FailOn) return FALSE;
+
+    Out[0] = (cmsUInt16Number)(In[0] ^ In[3]);
+    Out[1] = (cmsUInt16Number)(In[1] + In[2]);
+    Out[2] = (cmsUInt16Number)(In[2] * 3 + In[0]);
+    return TRUE;
+}
+
+// Grid nodes sampled by the pool should be the same as sampled serially
+static
+void CheckParallelSampling(cmsContext ContextID)
+{
+    cmsContext Raw = cmsCreateContext(NULL, NULL);
+    cmsContext Plugin = cmsCreateContext(cmsThreadedExtensions(CMS_THREADED_GUESS_MAX_THREADS, 0), NULL);
+    cmsStage *clutRaw, *clutPlugin;
+    cmsHPROFILE hsRGB, hLab;
+    cmsHTRANSFORM xformRaw, xformPlugin;
+    cmsUInt16Number In[256 * 3], OutRaw[256 * 3], OutPlugin[256 * 3];
+    cmsUInt32Number NoFail = 1, FailOn = 0x1000;
+    cmsUInt32Number i;
+
+    trace("Checking parallel CLUT sampling...");
+
+    clutRaw = cmsStageAllocCLut16bit(Raw, 17, 4, 3, NULL);
+    clutPlugin = cmsStageAllocCLut16bit(Plugin, 17, 4, 3, NULL);
+
+    if (!cmsStageSampleCLut16bit(Raw, clutRaw, MixSampler, &NoFail, 0) ||
+        !cmsStageSampleCLut16bit(Plugin, clutPlugin, MixSampler, &NoFail, SAMPLER_THREADSAFE))
+        Fail(ContextID, "Sampling failed");
+
+    if (memcmp(((_cmsStageCLutData*)cmsStageData(Raw, clutRaw))->Tab.T,
+               ((_cmsStageCLutData*)cmsStageData(Plugin, clutPlugin))->Tab.T, 17 * 17 * 17 * 17 * 3 * sizeof(cmsUInt16Number)) != 0)
+        Fail(ContextID, "Parallel sampling results mismatch");
+
+    // 0x1000 is node 1 on 17 points
+    if (cmsStageSampleCLut16bit(Plugin, clutPlugin, MixSampler, &FailOn, SAMPLER_THREADSAFE))
+        Fail(ContextID, "Sampler failure not reported");
+
+    cmsStageFree(Raw, clutRaw);
+    cmsStageFree(Plugin, clutPlugin);
+
+    // Transforms optimized by resampling
+    hsRGB = cmsCreate_sRGBProfile(Raw);
+    hLab = cmsCreateLab4Profile(Raw, NULL);
+
+    xformRaw = cmsCreateTransform(Raw, hsRGB, TYPE_RGB_16, hLab, TYPE_Lab_16, INTENT_PERCEPTUAL, cmsFLAGS_HIGHRESPRECALC);
+    xformPlugin = cmsCreateTransform(Plugin, hsRGB, TYPE_RGB_16, hLab, TYPE_Lab_16, INTENT_PERCEPTUAL, cmsFLAGS_HIGHRESPRECALC);
+
+    if (xformRaw == NULL || xformPlugin == NULL)
+        Fail(ContextID, "NULL transforms on check parallel sampling");
+
+    for (i = 0; i < 256 * 3; i++)
+        In[i] = (cmsUInt16Number)(i * 257 * 31);
+
+    cmsDoTransform(Raw, xformRaw, In, OutRaw, 256);
+    cmsDoTransform(Plugin, xformPlugin, In, OutPlugin, 256);
+
+    if (memcmp(OutRaw, OutPlugin, sizeof(OutRaw)) != 0)
+        Fail(ContextID, "Transform from parallel sampling mismatch");
+
+    cmsDeleteTransform(Raw, xformRaw);
+    cmsDeleteTransform(Plugin, xformPlugin);
+    cmsCloseProfile(Raw, hsRGB);
+    cmsCloseProfile(Raw, hLab);
+
+    cmsDeleteContext(Plugin);
+    cmsDeleteContext(Raw);
+
+    trace("Ok\n");
+}
+
+
+// Each worker gets a multi-entry cache table of its own, so split transforms never run uncached
+static
+void CheckPixelHashCacheWorkers(cmsContext ContextID)
+{
+    cmsContext Raw = cmsCreateContext(NULL, NULL);
+    cmsContext Plugin = cmsCreateContext(cmsThreadedExtensions(4, 0), NULL);
+    cmsHPROFILE hsRGB, hLab;
+    cmsHTRANSFORM xformRaw, xformPlugin;
+    Scanline_rgb8bits* In;
+    cmsUInt16Number *OutRaw, *OutPlugin;
+    cmsUInt32Number i, round, Hits, Misses, nPixels = 1024 * 256;
+
+    trace("Checking multi-entry cache on workers...");
+
+    In = (Scanline_rgb8bits*)malloc(nPixels * sizeof(Scanline_rgb8bits));
+    OutRaw = (cmsUInt16Number*)malloc(nPixels * 3 * sizeof(cmsUInt16Number));
+    OutPlugin = (cmsUInt16Number*)malloc(nPixels * 3 * sizeof(cmsUInt16Number));
+
+    // A palette of 97 colors
+    for (i = 0; i < nPixels; i++) {
+
+        cmsUInt32Number k = (i * 7) % 97;
+
+        In[i].r = (cmsUInt8Number)(k * 37);
+        In[i].g = (cmsUInt8Number)(k * 101);
+        In[i].b = (cmsUInt8Number)(255 - k);
+    }
+
+    hsRGB = cmsCreate_sRGBProfile(Raw);
+    hLab = cmsCreateLab4Profile(Raw, NULL);
+
+    xformRaw = cmsCreateTransform(Raw, hsRGB, TYPE_RGB_8, hLab, TYPE_Lab_16, INTENT_PERCEPTUAL, 0);
+    xformPlugin = cmsCreateTransform(Plugin, hsRGB, TYPE_RGB_8, hLab, TYPE_Lab_16, INTENT_PERCEPTUAL, cmsFLAGS_HASHCACHE);
+
+    if (xformRaw == NULL || xformPlugin == NULL)
+        Fail(ContextID, "NULL transforms on check multi-entry cache on workers");
+
+    cmsDoTransform(Raw, xformRaw, In, OutRaw, nPixels);
+
+    for (round = 0; round < 8; round++) {
+
+        cmsDoTransformLineStride(Plugin, xformPlugin, In, OutPlugin, 1024, 256, 1024 * sizeof(Scanline_rgb8bits), 1024 * 3 * sizeof(cmsUInt16Number), 0, 0);
+
+        if (memcmp(OutRaw, OutPlugin, nPixels * 3 * sizeof(cmsUInt16Number)) != 0)
+            Fail(ContextID, "Multi-entry cache on workers results mismatch on round %u", round);
+    }
+
+    cmsGetTransformPixelCacheStats(Plugin, xformPlugin, &Hits, &Misses);
+    if (Hits + Misses != 8 * nPixels || Misses > 4 * 97)
+        Fail(ContextID, "Multi-entry cache on workers: %u hits, %u misses", Hits, Misses);
+
+    cmsDeleteTransform(Raw, xformRaw);
+    cmsDeleteTransform(Plugin, xformPlugin);
+    cmsCloseProfile(Raw, hsRGB);
+    cmsCloseProfile(Raw, hLab);
+    cmsDeleteContext(Plugin);
+    cmsDeleteContext(Raw);
+
+    free(In); free(OutRaw); free(OutPlugin);
+
+    trace("Ok\n");
+}
+
+typedef struct {
+
+    cmsUInt32Number Running;
+    cmsUInt32Number MaxRunning;
+    cmsUInt32Number Done;
+
+} TaskTally;
+
+// Keeps track of how many tasks are running at once
+static
+void TallyTask(cmsContext ContextID, cmsUInt32Number nTask, void* Cargo)
+{
+    TaskTally* t = (TaskTally*)Cargo;
+    volatile cmsUInt32Number Spin = 0;
+    cmsUInt32Number i;
+    UNUSED_PARAMETER(ContextID);
+    UNUSED_PARAMETER(nTask);
+
+    _cmsThrLockGlobal();
+    if (++t->Running > t->MaxRunning) t->MaxRunning = t->Running;
+    _cmsThrUnlockGlobal();
+
+    for (i = 0; i < 100000; i++) Spin += i;
+
+    _cmsThrLockGlobal();
+    t->Running--;
+    t->Done++;
+    _cmsThrUnlockGlobal();
+}
+
+// Tasks other than transforms should honor the number of workers the plug-in was installed with
+static
+void CheckTaskWorkersLimit(cmsContext ContextID)
+{
+    cmsContext Plugin = cmsCreateContext(cmsThreadedExtensions(2, 0), NULL);
+    TaskTally t;
+
+    trace("Checking workers limit on tasks...");
+
+    memset(&t, 0, sizeof(t));
+    _cmsThrRunTasks(Plugin, 256, TallyTask, &t);
+
+    if (t.Done != 256)
+        Fail(ContextID, "Only %u tasks of 256 were run", t.Done);
+
+    if (t.MaxRunning > 2)
+        Fail(ContextID, "%u tasks were running at once, limit is 2", t.MaxRunning);
+
+    cmsDeleteContext(Plugin);
+
+    trace("Ok\n");
+}
+
+
 // --------------------------------------------------------------------------------------------------
 // P E R F O R M A N C E   C H E C K S
 // --------------------------------------------------------------------------------------------------
@@ -888,6 +1314,12 @@ int main(void)
     // Accuracy
     CheckAccuracy8Bits(ContextID);
     CheckAccuracy16Bits(ContextID);
+    CheckWorkerPool(ContextID);
+    CheckAsyncTransforms(ContextID);
+    CheckTiling(ContextID);
+    CheckParallelSampling(ContextID);
+    CheckPixelHashCacheWorkers(ContextID);
+    CheckTaskWorkersLimit(ContextID);
 
     // Check speed
     SpeedTest8();
@@ -701,23 +701,28 @@ typedef struct {
 } GrayOnlyParams;
 
 
-// Preserve black only if that is the only ink used
+// Preserve black only if that is the only ink used. The whole row goes across the normal transform,
+// and then nodes having black ink only are replaced.
 static
-int BlackPreservingGrayOnlySampler(cmsContext ContextID, CMSREGISTER const cmsUInt16Number In[], CMSREGISTER cmsUInt16Number Out[], CMSREGISTER void* Cargo)
+int BlackPreservingGrayOnlySampler(cmsContext ContextID, const cmsUInt16Number In[], cmsUInt16Number Out[], cmsUInt32Number nNodes, void* Cargo)
 {
     GrayOnlyParams* bp = (GrayOnlyParams*) Cargo;
+    cmsUInt32Number k;
 
-    // If going across black only, keep black only
-    if (In[0] == 0 && In[1] == 0 && In[2] == 0) {
+    // Keep normal transform for other colors
+    cmsPipelineEval16N(ContextID, In, Out, nNodes, bp ->cmyk2cmyk);
 
-        // TAC does not apply because it is black ink!
-        Out[0] = Out[1] = Out[2] = 0;
-        Out[3] = cmsEvalToneCurve16(ContextID, bp->KTone, In[3]);
-        return TRUE;
+    for (k = 0; k < nNodes; k++, In += 4, Out += 4) {
+
+        // If going across black only, keep black only
+        if (In[0] == 0 && In[1] == 0 && In[2] == 0) {
+
+            // TAC does not apply because it is black ink!
+            Out[0] = Out[1] = Out[2] = 0;
+            Out[3] = cmsEvalToneCurve16(ContextID, bp->KTone, In[3]);
+        }
     }
 
-    // Keep normal transform for other colors
-    bp ->cmyk2cmyk ->Eval16Fn(ContextID, In, Out, bp ->cmyk2cmyk->Data);
     return TRUE;
 }
 
@@ -822,7 +827,7 @@ cmsPipeline*  BlackPreservingKOnlyIntents(cmsContext     ContextID,
         goto Error;
 
     // Sample it. We cannot afford pre/post linearization this time.
-    if (!cmsStageSampleCLut16bit(ContextID, CLUT, BlackPreservingGrayOnlySampler, (void*) &bp, 0))
+    if (!cmsStageSampleCLut16bitN(ContextID, CLUT, BlackPreservingGrayOnlySampler, (void*) &bp, 0))
         goto Error;
 
 
@@ -871,42 +876,34 @@ typedef struct {
 } PreserveKPlaneParams;
 
 
-// The CLUT will be stored at 16 bits, but calculations are performed at cmsFloat32Number precision
+// The CLUT will be stored at 16 bits, but calculations are performed at cmsFloat32Number precision.
+// Outf holds the original transform of the node.
 static
-int BlackPreservingSampler(cmsContext ContextID, CMSREGISTER const cmsUInt16Number In[], CMSREGISTER cmsUInt16Number Out[], CMSREGISTER void* Cargo)
+void BlackPreservingNode(cmsContext ContextID, PreserveKPlaneParams* bp, const cmsUInt16Number In[], cmsFloat32Number Outf[], cmsUInt16Number Out[])
 {
     int i;
-    cmsFloat32Number Inf[4], Outf[4];
     cmsFloat32Number LabK[4];
     cmsFloat64Number SumCMY, SumCMYK, Error, Ratio;
     cmsCIELab ColorimetricLab, BlackPreservingLab;
-    PreserveKPlaneParams* bp = (PreserveKPlaneParams*) Cargo;
-
-    // Convert from 16 bits to floating point
-    for (i=0; i < 4; i++)
-        Inf[i] = (cmsFloat32Number) (In[i] / 65535.0);
 
     // Get the K across Tone curve
-    LabK[3] = cmsEvalToneCurveFloat(ContextID, bp ->KTone, Inf[3]);
+    LabK[3] = cmsEvalToneCurveFloat(ContextID, bp ->KTone, (cmsFloat32Number) (In[3] / 65535.0));
 
     // If going across black only, keep black only
     if (In[0] == 0 && In[1] == 0 && In[2] == 0) {
 
         Out[0] = Out[1] = Out[2] = 0;
         Out[3] = _cmsQuickSaturateWord(LabK[3] * 65535.0);
-        return TRUE;
+        return;
     }
 
-    // Try the original transform,
-    cmsPipelineEvalFloat(ContextID, Inf, Outf, bp ->cmyk2cmyk);
-
-    // Store a copy of the floating point result into 16-bit
+    // Store a copy of the floating point result of the original transform into 16-bit
     for (i=0; i < 4; i++)
             Out[i] = _cmsQuickSaturateWord(Outf[i] * 65535.0);
 
     // Maybe K is already ok (mostly on K=0)
     if (fabsf(Outf[3] - LabK[3]) < (3.0 / 65535.0)) {
-        return TRUE;
+        return;
     }
 
     // K differ, measure and keep Lab measurement for further usage
@@ -923,7 +920,7 @@ int BlackPreservingSampler(cmsContext ContextID, CMSREGISTER const cmsUInt16Numb
 
         // Cannot find a suitable value, so use colorimetric xform
         // which is already stored in Out[]
-        return TRUE;
+        return;
     }
 
     // Make sure to pass through K (which now is fixed)
@@ -952,6 +949,35 @@ int BlackPreservingSampler(cmsContext ContextID, CMSREGISTER const cmsUInt16Numb
     Error = cmsDeltaE(ContextID, &ColorimetricLab, &BlackPreservingLab);
     if (Error > bp -> MaxError)
         bp->MaxError = Error;
+}
+
+// The original transform is evaluated on chunks of the row, then each node is fixed
+#define KPLANE_SAMPLER_CHUNK 64
+
+static
+int BlackPreservingSampler(cmsContext ContextID, const cmsUInt16Number In[], cmsUInt16Number Out[], cmsUInt32Number nNodes, void* Cargo)
+{
+    PreserveKPlaneParams* bp = (PreserveKPlaneParams*) Cargo;
+    cmsFloat32Number Inf[KPLANE_SAMPLER_CHUNK * 4], Outf[KPLANE_SAMPLER_CHUNK * 4];
+    cmsUInt32Number i, k, n;
+
+    for (; nNodes > 0; nNodes -= n) {
+
+        n = nNodes < KPLANE_SAMPLER_CHUNK ? nNodes : KPLANE_SAMPLER_CHUNK;
+
+        // Convert from 16 bits to floating point
+        for (i=0; i < n * 4; i++)
+            Inf[i] = (cmsFloat32Number) (In[i] / 65535.0);
+
+        // Try the original transform,
+        cmsPipelineEvalFloatN(ContextID, Inf, Outf, n, bp ->cmyk2cmyk);
+
+        for (k=0; k < n; k++)
+            BlackPreservingNode(ContextID, bp, In + k * 4, Outf + k * 4, Out + k * 4);
+
+        In  += n * 4;
+        Out += n * 4;
+    }
 
     return TRUE;
 }
@@ -1047,7 +1073,7 @@ cmsPipeline* BlackPreservingKPlaneIntents(cmsContext     ContextID,
     bp.hProofOutput = cmsCreateTransform(ContextID, hLastProfile,
                                          CHANNELS_SH(4)|BYTES_SH(2), hLab, TYPE_Lab_DBL,
                                          INTENT_RELATIVE_COLORIMETRIC,
-                                         cmsFLAGS_NOCACHE|cmsFLAGS_NOOPTIMIZE);
+                                         cmsFLAGS_NOCACHE|cmsFLAGS_NOOPTIMIZE|cmsFLAGS_NOTRANSFORMCACHE);
     if ( bp.hProofOutput == NULL) goto Cleanup;
 
     // Same as anterior, but lab in the 0..1 range
@@ -1055,7 +1081,7 @@ cmsPipeline* BlackPreservingKPlaneIntents(cmsContext     ContextID,
                                      FLOAT_SH(1)|CHANNELS_SH(4)|BYTES_SH(4), hLab,
                                      FLOAT_SH(1)|CHANNELS_SH(3)|BYTES_SH(4),
                                      INTENT_RELATIVE_COLORIMETRIC,
-                                     cmsFLAGS_NOCACHE|cmsFLAGS_NOOPTIMIZE);
+                                     cmsFLAGS_NOCACHE|cmsFLAGS_NOOPTIMIZE|cmsFLAGS_NOTRANSFORMCACHE);
     if (bp.cmyk2Lab == NULL) goto Cleanup;
     cmsCloseProfile(ContextID, hLab);
 
@@ -1072,7 +1098,7 @@ cmsPipeline* BlackPreservingKPlaneIntents(cmsContext     ContextID,
     if (!cmsPipelineInsertStage(ContextID, Result, cmsAT_BEGIN, CLUT))
         goto Cleanup;
 
-    cmsStageSampleCLut16bit(ContextID, CLUT, BlackPreservingSampler, (void*) &bp, 0);
+    cmsStageSampleCLut16bitN(ContextID, CLUT, BlackPreservingSampler, (void*) &bp, 0);
 
     // Insert possible devicelinks at the end
     for (i = lastProfilePos + 1; i < nProfiles; i++)
@@ -680,12 +680,22 @@ cmsBool _cmsRegisterParallelizationPlugin(cmsContext ContextID, cmsPluginBase* D
     cmsPluginParalellization* Plugin = (cmsPluginParalellization*)Data;
     _cmsParallelizationPluginChunkType* ctx = (_cmsParallelizationPluginChunkType*)_cmsContextGetClientChunk(ContextID, ParallelizationPlugin);
 
+    // Let the previous scheduler free whatever it keeps for this context
+    if (ctx->ReleaseFn != NULL) {
+
+        _cmsParallelizationReleaseFn ReleaseFn = ctx->ReleaseFn;
+
+        ctx->ReleaseFn = NULL;
+        ReleaseFn(ContextID);
+    }
+
     if (Data == NULL) {
 
         // No parallelization routines
         ctx->MaxWorkers = 0;
         ctx->WorkerFlags = 0;
         ctx->SchedulerFn = NULL;        
+        ctx->RunTasksFn = NULL;
         return TRUE;
     }
 
@@ -695,8 +705,40 @@ cmsBool _cmsRegisterParallelizationPlugin(cmsContext ContextID, cmsPluginBase* D
     ctx->MaxWorkers = Plugin->MaxWorkers;
     ctx->WorkerFlags = Plugin->WorkerFlags;
     ctx->SchedulerFn = Plugin->SchedulerFn;
+
+    // Release and task callbacks were added in 2.17
+    ctx->RunTasksFn = NULL;
+    if (Plugin->base.ExpectedVersion >= (2170 - 2000)) {
+
+        ctx->ReleaseFn = Plugin->ReleaseFn;
+        ctx->RunTasksFn = Plugin->RunTasksFn;
+    }
     
     // All is ok
     return TRUE;
 }
 
+// Upper limit of workers as given by the plug-in, 0 if there is no one
+cmsInt32Number CMSEXPORT _cmsGetContextMaxWorkers(cmsContext ContextID)
+{
+    _cmsParallelizationPluginChunkType* ctx = (_cmsParallelizationPluginChunkType*)_cmsContextGetClientChunk(ContextID, ParallelizationPlugin);
+
+    return ctx->MaxWorkers;
+}
+
+// Runs independent tasks. Without a plug-in able to do so, tasks are done here, one after another
+void _cmsParallelRun(cmsContext ContextID, cmsUInt32Number nTasks, _cmsParallelTaskFn Task, void* Cargo)
+{
+    _cmsParallelizationPluginChunkType* ctx = (_cmsParallelizationPluginChunkType*)_cmsContextGetClientChunk(ContextID, ParallelizationPlugin);
+    cmsUInt32Number i;
+
+    if (ctx->RunTasksFn != NULL && nTasks > 1) {
+
+        ctx->RunTasksFn(ContextID, nTasks, Task, Cargo);
+        return;
+    }
+
+    for (i = 0; i < nTasks; i++)
+        Task(ContextID, i, Cargo);
+}
+
@@ -78,7 +78,7 @@ cmsHTRANSFORM _cmsChain2Lab(cmsContext            ContextID,
                                        NULL, 0,
                                        InputFormat,
                                        OutputFormat,
-                                       dwFlags);
+                                       dwFlags|cmsFLAGS_NOTRANSFORMCACHE);
 
     cmsCloseProfile(ContextID, hLab);
 
@@ -200,6 +200,8 @@ typedef struct {
     cmsHTRANSFORM hInput;               // From whatever input color space. 16 bits to DBL
     cmsHTRANSFORM hForward, hReverse;   // Transforms going from Lab to colorant and back
     cmsFloat64Number Threshold;         // The threshold after which is considered out of gamut
+    cmsUInt32Number nChannels;          // Channels of grid nodes
+    cmsUInt32Number nInputChannels;     // Channels hInput takes
 
     } GAMUTCHAIN;
 
@@ -210,70 +212,87 @@ typedef struct {
 #define ERR_THRESHOLD      5
 
 
+// Nodes are processed in chunks of this size, each transform being called once per chunk
+#define GAMUT_SAMPLER_CHUNK 64
+
 static
-int GamutSampler(cmsContext ContextID, CMSREGISTER const cmsUInt16Number In[], CMSREGISTER cmsUInt16Number Out[], CMSREGISTER void* Cargo)
+int GamutSampler(cmsContext ContextID, const cmsUInt16Number In[], cmsUInt16Number Out[], cmsUInt32Number nNodes, void* Cargo)
 {
     GAMUTCHAIN*  t = (GAMUTCHAIN* ) Cargo;
-    cmsCIELab LabIn1, LabOut1;
-    cmsCIELab LabIn2, LabOut2;
-    cmsUInt16Number Proof[cmsMAXCHANNELS], Proof2[cmsMAXCHANNELS];
+    cmsCIELab LabIn1[GAMUT_SAMPLER_CHUNK], LabOut1[GAMUT_SAMPLER_CHUNK], LabOut2[GAMUT_SAMPLER_CHUNK];
+    cmsUInt16Number Input[GAMUT_SAMPLER_CHUNK * cmsMAXCHANNELS];
+    cmsUInt16Number Proof[GAMUT_SAMPLER_CHUNK * cmsMAXCHANNELS], Proof2[GAMUT_SAMPLER_CHUNK * cmsMAXCHANNELS];
     cmsFloat64Number dE1, dE2, ErrorRatio;
+    cmsUInt32Number k, c, n, First;
 
-    // Assume in-gamut by default. NEVER READ, USED FOR DEBUG PURPOSES.
-    ErrorRatio = 1.0;
+    for (First = 0; First < nNodes; First += n) {
 
-    // Convert input to Lab
-    cmsDoTransform(ContextID, t -> hInput, In, &LabIn1, 1);
+        n = nNodes - First;
+        if (n > GAMUT_SAMPLER_CHUNK) n = GAMUT_SAMPLER_CHUNK;
 
-    // converts from PCS to colorant. This always
-    // does return in-gamut values,
-    cmsDoTransform(ContextID, t -> hForward, &LabIn1, Proof, 1);
+        // Nodes as taken by the input transform
+        for (k = 0; k < n; k++)
+            for (c = 0; c < t ->nInputChannels; c++)
+                Input[k * t ->nInputChannels + c] = c < t ->nChannels ? In[(First + k) * t ->nChannels + c] : 0;
 
-    // Now, do the inverse, from colorant to PCS.
-    cmsDoTransform(ContextID, t -> hReverse, Proof, &LabOut1, 1);
+        // Convert input to Lab
+        cmsDoTransform(ContextID, t -> hInput, Input, LabIn1, n);
 
-    memmove(&LabIn2, &LabOut1, sizeof(cmsCIELab));
+        // converts from PCS to colorant. This always
+        // does return in-gamut values,
+        cmsDoTransform(ContextID, t -> hForward, LabIn1, Proof, n);
 
-    // Try again, but this time taking Check as input
-    cmsDoTransform(ContextID, t -> hForward, &LabOut1, Proof2, 1);
-    cmsDoTransform(ContextID, t -> hReverse, Proof2, &LabOut2, 1);
+        // Now, do the inverse, from colorant to PCS.
+        cmsDoTransform(ContextID, t -> hReverse, Proof, LabOut1, n);
 
-    // Take difference of direct value
-    dE1 = cmsDeltaE(ContextID, &LabIn1, &LabOut1);
+        // Try again, but this time taking Check as input
+        cmsDoTransform(ContextID, t -> hForward, LabOut1, Proof2, n);
+        cmsDoTransform(ContextID, t -> hReverse, Proof2, LabOut2, n);
 
-    // Take difference of converted value
-    dE2 = cmsDeltaE(ContextID, &LabIn2, &LabOut2);
+        for (k = 0; k < n; k++) {
 
+            cmsUInt16Number* Result = Out + First + k;
 
-    // if dE1 is small and dE2 is small, value is likely to be in gamut
-    if (dE1 < t->Threshold && dE2 < t->Threshold)
-        Out[0] = 0;
-    else {
+            // Assume in-gamut by default. NEVER READ, USED FOR DEBUG PURPOSES.
+            ErrorRatio = 1.0;
 
-        // if dE1 is small and dE2 is big, undefined. Assume in gamut
-        if (dE1 < t->Threshold && dE2 > t->Threshold)
-            Out[0] = 0;
-        else
-            // dE1 is big and dE2 is small, clearly out of gamut
-            if (dE1 > t->Threshold && dE2 < t->Threshold)
-                Out[0] = (cmsUInt16Number) _cmsQuickFloor((dE1 - t->Threshold) + .5);
-            else  {
-
-                // dE1 is big and dE2 is also big, could be due to perceptual mapping
-                // so take error ratio
-                if (dE2 == 0.0)
-                    ErrorRatio = dE1;
-                else
-                    ErrorRatio = dE1 / dE2;
+            // Take difference of direct value
+            dE1 = cmsDeltaE(ContextID, &LabIn1[k], &LabOut1[k]);
 
-                if (ErrorRatio > t->Threshold)
-                    Out[0] = (cmsUInt16Number)  _cmsQuickFloor((ErrorRatio - t->Threshold) + .5);
+            // Take difference of converted value
+            dE2 = cmsDeltaE(ContextID, &LabOut1[k], &LabOut2[k]);
+
+
+            // if dE1 is small and dE2 is small, value is likely to be in gamut
+            if (dE1 < t->Threshold && dE2 < t->Threshold)
+                Result[0] = 0;
+            else {
+
+                // if dE1 is small and dE2 is big, undefined. Assume in gamut
+                if (dE1 < t->Threshold && dE2 > t->Threshold)
+                    Result[0] = 0;
                 else
-                    Out[0] = 0;
+                    // dE1 is big and dE2 is small, clearly out of gamut
+                    if (dE1 > t->Threshold && dE2 < t->Threshold)
+                        Result[0] = (cmsUInt16Number) _cmsQuickFloor((dE1 - t->Threshold) + .5);
+                    else  {
+
+                        // dE1 is big and dE2 is also big, could be due to perceptual mapping
+                        // so take error ratio
+                        if (dE2 == 0.0)
+                            ErrorRatio = dE1;
+                        else
+                            ErrorRatio = dE1 / dE2;
+
+                        if (ErrorRatio > t->Threshold)
+                            Result[0] = (cmsUInt16Number)  _cmsQuickFloor((ErrorRatio - t->Threshold) + .5);
+                        else
+                            Result[0] = 0;
+                    }
             }
+        }
     }
 
-
     return TRUE;
 }
 
@@ -354,6 +373,9 @@ cmsPipeline* _cmsCreateGamutCheckPipeline(cmsContext ContextID,
     nInputChannels  = cmsChannelsOfColorSpace(ContextID, InputColorSpace);
     dwFormat        = (CHANNELS_SH(nInputChannels)|BYTES_SH(2));
 
+    Chain.nChannels      = (cmsUInt32Number) nChannels;
+    Chain.nInputChannels = (cmsUInt32Number) nInputChannels;
+
     // 16 bits to Lab double
     Chain.hInput = cmsCreateExtendedTransform(ContextID,
         nGamutPCSposition + 1,
@@ -363,7 +385,7 @@ cmsPipeline* _cmsCreateGamutCheckPipeline(cmsContext ContextID,
         AdaptationList,
         NULL, 0,
         dwFormat, TYPE_Lab_DBL,
-        cmsFLAGS_NOCACHE);
+        cmsFLAGS_NOCACHE|cmsFLAGS_NOTRANSFORMCACHE);
 
 
     // Does create the forward step. Lab double to device
@@ -372,13 +394,13 @@ cmsPipeline* _cmsCreateGamutCheckPipeline(cmsContext ContextID,
         hLab, TYPE_Lab_DBL,
         hGamut, dwFormat,
         INTENT_RELATIVE_COLORIMETRIC,
-        cmsFLAGS_NOCACHE);
+        cmsFLAGS_NOCACHE|cmsFLAGS_NOTRANSFORMCACHE);
 
     // Does create the backwards step
     Chain.hReverse = cmsCreateTransform(ContextID, hGamut, dwFormat,
         hLab, TYPE_Lab_DBL,
         INTENT_RELATIVE_COLORIMETRIC,
-        cmsFLAGS_NOCACHE);
+        cmsFLAGS_NOCACHE|cmsFLAGS_NOTRANSFORMCACHE);
 
 
     // All ok?
@@ -396,7 +418,7 @@ cmsPipeline* _cmsCreateGamutCheckPipeline(cmsContext ContextID,
                 Gamut = NULL;
             }
             else {
-                cmsStageSampleCLut16bit(ContextID, CLUT, GamutSampler, (void*) &Chain, 0);
+                cmsStageSampleCLut16bitN(ContextID, CLUT, GamutSampler, (void*) &Chain, 0);
             }
         }
     }
@@ -487,7 +509,7 @@ cmsFloat64Number CMSEXPORT cmsDetectTAC(cmsContext ContextID, cmsHPROFILE hProfi
     if (hLab == NULL) return 0;
     // Setup a roundtrip on perceptual intent in output profile for TAC estimation
     bp.hRoundTrip = cmsCreateTransform(ContextID, hLab, TYPE_Lab_16,
-                                          hProfile, dwFormatter, INTENT_PERCEPTUAL, cmsFLAGS_NOOPTIMIZE|cmsFLAGS_NOCACHE);
+                                          hProfile, dwFormatter, INTENT_PERCEPTUAL, cmsFLAGS_NOOPTIMIZE|cmsFLAGS_NOCACHE|cmsFLAGS_NOTRANSFORMCACHE);
 
     cmsCloseProfile(ContextID, hLab);
     if (bp.hRoundTrip == NULL) return 0;
@@ -625,7 +647,7 @@ cmsFloat64Number CMSEXPORT cmsDetectRGBProfileGamma(cmsContext ContextID, cmsHPR
     if (hXYZ == NULL)
         return -1;
     xform = cmsCreateTransform(ContextID, hProfile, TYPE_RGB_16, hXYZ, TYPE_XYZ_DBL, 
-                                    INTENT_RELATIVE_COLORIMETRIC, cmsFLAGS_NOOPTIMIZE);
+                                    INTENT_RELATIVE_COLORIMETRIC, cmsFLAGS_NOOPTIMIZE|cmsFLAGS_NOTRANSFORMCACHE);
 
     if (xform == NULL) { // If not RGB or forward direction is not supported, regret with the previous error
 
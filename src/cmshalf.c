@@ -28,6 +28,20 @@
 
 #ifndef CMS_NO_HALF_SUPPORT 
 
+// Arrays are converted 8 values at a time with F16C, which is picked at runtime
+#if !defined(CMS_DONT_USE_SSE2) && !defined(CMS_DONT_USE_SIMD) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)) && \
+    (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || (defined(_M_IX86) && _MSC_VER >= 1700))
+#   define CMS_HALF_F16C 1
+#   include <immintrin.h>
+#   ifdef _MSC_VER
+#       include <intrin.h>
+#       define CMS_TARGET_F16C
+#   else
+#       include <cpuid.h>
+#       define CMS_TARGET_F16C __attribute__((target("avx,f16c")))
+#   endif
+#endif
+
 // This code is inspired in the paper "Fast Half Float Conversions"
 // by Jeroen van der Zijp
 
@@ -532,4 +546,119 @@ cmsUInt16Number CMSEXPORT _cmsFloat2Half(cmsFloat32Number flt)
     return (cmsUInt16Number) ((cmsUInt32Number) Base[ j ] + (( n & 0x007fffff) >> Shift[ j ]));
 }
 
+// Array conversions -----------------------------------------------------------------------------------------------------
+
+// Results are always the same as the tables above. F16C agrees with them on every value but NaN
+// payloads, which it quiets, and floats beyond the half range, which truncation takes to the
+// largest half instead of to infinity. Groups holding any of those go through the tables.
+
+#ifdef CMS_HALF_F16C
+
+// The outcome never changes, so a race on first use is harmless
+static
+cmsBool HasF16C(void)
+{
+    static volatile int Available = -1;
+
+    if (Available < 0) {
+#ifdef _MSC_VER
+        int cpuinfo[4];
+
+        // OS must save the YMM registers
+        __cpuid(cpuinfo, 1);
+        Available = (cpuinfo[2] & (1 << 27)) && (cpuinfo[2] & (1 << 28)) && (cpuinfo[2] & (1 << 29)) &&
+                    ((_xgetbv(0) & 6) == 6);
+#else
+        unsigned int eax, ebx, ecx, edx;
+
+        __builtin_cpu_init();
+        Available = __builtin_cpu_supports("avx") && __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & (1U << 29));
+#endif
+    }
+
+    return Available;
+}
+
+CMS_TARGET_F16C static
+void Half2FloatArrayF16C(const cmsUInt16Number In[], cmsFloat32Number Out[], cmsUInt32Number n)
+{
+    const __m128i ExpMask = _mm_set1_epi16(0x7c00);
+    cmsUInt32Number i = 0, k;
+
+    for (; i + 8 <= n; i += 8) {
+
+        __m128i h = _mm_loadu_si128((const __m128i*) (In + i));
+
+        _mm256_storeu_ps(Out + i, _mm256_cvtph_ps(h));
+
+        // Infinities and NaN
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(h, ExpMask), ExpMask)) != 0) {
+
+            for (k = i; k < i + 8; k++)
+                Out[k] = _cmsHalf2Float(In[k]);
+        }
+    }
+
+    for (; i < n; i++)
+        Out[i] = _cmsHalf2Float(In[i]);
+}
+
+CMS_TARGET_F16C static
+void Float2HalfArrayF16C(const cmsFloat32Number In[], cmsUInt16Number Out[], cmsUInt32Number n)
+{
+    const __m256 Abs   = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 Range = _mm256_set1_ps(65536.0F);
+    cmsUInt32Number i = 0, k;
+
+    for (; i + 8 <= n; i += 8) {
+
+        __m256 f = _mm256_loadu_ps(In + i);
+
+        // The tables truncate
+        _mm_storeu_si128((__m128i*) (Out + i), _mm256_cvtps_ph(f, _MM_FROUND_TO_ZERO));
+
+        // Out of range, infinities and NaN
+        if (_mm256_movemask_ps(_mm256_cmp_ps(_mm256_and_ps(f, Abs), Range, _CMP_NLT_UQ)) != 0) {
+
+            for (k = i; k < i + 8; k++)
+                Out[k] = _cmsFloat2Half(In[k]);
+        }
+    }
+
+    for (; i < n; i++)
+        Out[i] = _cmsFloat2Half(In[i]);
+}
+
+#endif
+
+void CMSEXPORT _cmsHalf2FloatArray(const cmsUInt16Number In[], cmsFloat32Number Out[], cmsUInt32Number n)
+{
+    cmsUInt32Number i;
+
+#ifdef CMS_HALF_F16C
+    if (HasF16C()) {
+        Half2FloatArrayF16C(In, Out, n);
+        return;
+    }
+#endif
+
+    for (i = 0; i < n; i++)
+        Out[i] = _cmsHalf2Float(In[i]);
+}
+
+void CMSEXPORT _cmsFloat2HalfArray(const cmsFloat32Number In[], cmsUInt16Number Out[], cmsUInt32Number n)
+{
+    cmsUInt32Number i;
+
+#ifdef CMS_HALF_F16C
+    if (HasF16C()) {
+        Float2HalfArrayF16C(In, Out, n);
+        return;
+    }
+#endif
+
+    for (i = 0; i < n; i++)
+        Out[i] = _cmsFloat2Half(In[i]);
+}
+
 #endif
@@ -38,6 +38,11 @@
 
 // Interpolation routines by default
 static cmsInterpFunction DefaultInterpolatorsFactory(cmsUInt32Number nInputChannels, cmsUInt32Number nOutputChannels, cmsUInt32Number dwFlags);
+static cmsInterpFunctionN DefaultInterpolatorsFactoryN(cmsUInt32Number nInputChannels, cmsUInt32Number nOutputChannels, cmsUInt32Number dwFlags);
+
+// Batch interpolation on top of the single pixel one, for the interpolators lacking a batch version
+static void Lerp16NLoop(cmsContext ContextID, const cmsUInt16Number Input[], cmsUInt16Number Output[], cmsUInt32Number nPixels, const cmsInterpParams* p);
+static void LerpFloatNLoop(cmsContext ContextID, const cmsFloat32Number Input[], cmsFloat32Number Output[], cmsUInt32Number nPixels, const cmsInterpParams* p);
 
 // This is the default factory
 _cmsInterpPluginChunkType _cmsInterpPluginChunk = { NULL };
@@ -72,11 +77,18 @@ cmsBool  _cmsRegisterInterpPlugin(cmsContext ContextID, cmsPluginBase* Data)
     if (Data == NULL) {
 
         ptr ->Interpolators = NULL;
+        ptr ->InterpolatorsN = NULL;
         return TRUE;
     }
 
     // Set replacement functions
     ptr ->Interpolators = Plugin ->InterpolatorsFactory;
+
+    // Batch factory was added in 2.17
+    ptr ->InterpolatorsN = NULL;
+    if (Plugin->base.ExpectedVersion >= (2170 - 2000))
+        ptr ->InterpolatorsN = Plugin ->InterpolatorsFactoryN;
+
     return TRUE;
 }
 
@@ -87,21 +99,39 @@ cmsBool _cmsSetInterpolationRoutine(cmsContext ContextID, cmsInterpParams* p)
     _cmsInterpPluginChunkType* ptr = (_cmsInterpPluginChunkType*) _cmsContextGetClientChunk(ContextID, InterpPlugin);
 
     p ->Interpolation.Lerp16 = NULL;
+    p ->InterpolationN.Lerp16N = NULL;
 
    // Invoke factory, possibly in the Plug-in
-    if (ptr ->Interpolators != NULL)
+    if (ptr ->Interpolators != NULL) {
+
         p ->Interpolation = ptr->Interpolators(ContextID, p -> nInputs, p ->nOutputs, p ->dwFlags);
 
+        // The batch version must come from the same plug-in
+        if (p ->Interpolation.Lerp16 != NULL && ptr ->InterpolatorsN != NULL)
+            p ->InterpolationN = ptr ->InterpolatorsN(ContextID, p -> nInputs, p ->nOutputs, p ->dwFlags);
+    }
+
     // If unsupported by the plug-in, go for the LittleCMS default.
     // If happens only if an extern plug-in is being used
-    if (p ->Interpolation.Lerp16 == NULL)
-        p ->Interpolation = DefaultInterpolatorsFactory(p ->nInputs, p ->nOutputs, p ->dwFlags);
+    if (p ->Interpolation.Lerp16 == NULL) {
+        p ->Interpolation  = DefaultInterpolatorsFactory(p ->nInputs, p ->nOutputs, p ->dwFlags);
+        p ->InterpolationN = DefaultInterpolatorsFactoryN(p ->nInputs, p ->nOutputs, p ->dwFlags);
+    }
 
     // Check for valid interpolator (we just check one member of the union)
     if (p ->Interpolation.Lerp16 == NULL) {
             return FALSE;
     }
 
+    // Batches can always be done pixel by pixel
+    if (p ->InterpolationN.Lerp16N == NULL) {
+
+        if (p ->dwFlags & CMS_LERP_FLAGS_FLOAT)
+            p ->InterpolationN.LerpFloatN = LerpFloatNLoop;
+        else
+            p ->InterpolationN.Lerp16N = Lerp16NLoop;
+    }
+
     return TRUE;
 }
 
@@ -859,6 +889,314 @@ void TetrahedralInterp16(cmsContext ContextID, CMSREGISTER const cmsUInt16Number
 }
 
 
+// Tetrahedral interpolation of many pixels at once. Input holds nPixels groups of 3 channels and
+// Output nPixels groups of p->nOutputs channels, both packed. Vector versions run the pixels in
+// lanes and are bit-exact with TetrahedralInterp16: the tetrahedron is chosen by sorting the
+// three fractional parts and Rest is accumulated with the same wrap-around 32 bit arithmetic.
+// Ties among the fractional parts don't matter, as the vertex they pick goes with a zero weight.
+
+#if !defined(CMS_DONT_USE_SSE2) && !defined(CMS_DONT_USE_SIMD) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)) && \
+    (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || (defined(_M_IX86) && _MSC_VER >= 1700))
+#   define CMS_INTRP_AVX2 1
+#   include <immintrin.h>
+#   ifdef _MSC_VER
+#       include <intrin.h>
+#       define CMS_TARGET_AVX2
+#   else
+#       define CMS_TARGET_AVX2 __attribute__((target("avx2")))
+#   endif
+#elif !defined(CMS_DONT_USE_SIMD) && (defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64))
+#   define CMS_INTRP_NEON 1
+#   include <arm_neon.h>
+#endif
+
+static
+void TetrahedralInterp16Block(cmsContext ContextID, const cmsUInt16Number Input[],
+                              cmsUInt16Number Output[],
+                              cmsUInt32Number nPixels,
+                              const cmsInterpParams* p)
+{
+    cmsUInt32Number i;
+    cmsUInt32Number nOut = p->nOutputs;
+
+    for (i = 0; i < nPixels; i++) {
+
+        TetrahedralInterp16(ContextID, Input, Output, p);
+        Input  += 3;
+        Output += nOut;
+    }
+}
+
+#ifdef CMS_INTRP_AVX2
+
+static
+cmsBool IsAVX2Available(void)
+{
+#ifdef _MSC_VER
+    int cpuinfo[4];
+
+    __cpuid(cpuinfo, 0);
+    if (cpuinfo[0] < 7) return FALSE;
+
+    // OS must save the YMM registers
+    __cpuid(cpuinfo, 1);
+    if ((cpuinfo[2] & (1 << 27)) == 0 || (cpuinfo[2] & (1 << 28)) == 0) return FALSE;
+    if ((_xgetbv(0) & 6) != 6) return FALSE;
+
+    __cpuidex(cpuinfo, 7, 0);
+    return (cpuinfo[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+// Gathers one output channel of the vertices at Index. All but the last channel read the 32 bit
+// word that starts at the sample, the last one the word that ends there, so the gather never
+// touches memory outside the table (needs nOutputs > 1).
+CMS_TARGET_AVX2 cmsINLINE
+__m256i GatherSamples(const cmsUInt16Number* LutTable, __m256i Index, cmsUInt32Number OutChan, cmsUInt32Number nOut)
+{
+    if (OutChan + 1 < nOut) {
+
+        __m256i v = _mm256_i32gather_epi32((const int*) (LutTable + OutChan), Index, 2);
+        return _mm256_and_si256(v, _mm256_set1_epi32(0xFFFF));
+    }
+    else {
+
+        __m256i v = _mm256_i32gather_epi32((const int*) (LutTable + OutChan - 1), Index, 2);
+        return _mm256_srli_epi32(v, 16);
+    }
+}
+
+CMS_TARGET_AVX2 static
+void TetrahedralInterp16BlockAVX2(cmsContext ContextID, const cmsUInt16Number Input[],
+                                  cmsUInt16Number Output[],
+                                  cmsUInt32Number nPixels,
+                                  const cmsInterpParams* p)
+{
+    const cmsUInt16Number* LutTable = (const cmsUInt16Number*) p->Table;
+    cmsUInt32Number nOut = p->nOutputs;
+    cmsUInt32Number i, j, OutChan;
+    const __m256i Max = _mm256_set1_epi32(0xFFFF);
+    const __m256i Bias = _mm256_set1_epi32(0x7FFF);
+    const __m256i One = _mm256_set1_epi32(1);
+    const __m256i RestBias = _mm256_set1_epi32(0x8001);
+    const __m256i DomainX = _mm256_set1_epi32((int) p->Domain[0]);
+    const __m256i DomainY = _mm256_set1_epi32((int) p->Domain[1]);
+    const __m256i DomainZ = _mm256_set1_epi32((int) p->Domain[2]);
+    const __m256i OptaX = _mm256_set1_epi32((int) p->opta[2]);
+    const __m256i OptaY = _mm256_set1_epi32((int) p->opta[1]);
+    const __m256i OptaZ = _mm256_set1_epi32((int) p->opta[0]);
+    cmsInt32Number Lane[3][8];
+    cmsInt32Number Res[8];
+
+    for (i = 0; i + 8 <= nPixels; i += 8) {
+
+        __m256i In[3], Fixed[3], Rest[3], Base, Near[3];
+        __m256i Hi, Lo, Mid, V1, Vmin, V3, Idx0, Idx1, Idx2, Idx3;
+
+        for (j = 0; j < 8; j++) {
+            Lane[0][j] = Input[0];
+            Lane[1][j] = Input[1];
+            Lane[2][j] = Input[2];
+            Input += 3;
+        }
+
+        for (j = 0; j < 3; j++) {
+
+            __m256i a, n, q;
+            const __m256i Domain = j == 0 ? DomainX : (j == 1 ? DomainY : DomainZ);
+
+            In[j] = _mm256_loadu_si256((const __m256i*) Lane[j]);
+
+            // _cmsToFixedDomain, the division by 0xFFFF is exact in this range
+            a = _mm256_mullo_epi32(In[j], Domain);
+            n = _mm256_add_epi32(a, Bias);
+            q = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(n, _mm256_srli_epi32(n, 16)), One), 16);
+            Fixed[j] = _mm256_add_epi32(a, q);
+            Rest[j]  = _mm256_and_si256(Fixed[j], Max);
+        }
+
+        Base = _mm256_add_epi32(_mm256_add_epi32(
+                    _mm256_mullo_epi32(_mm256_srli_epi32(Fixed[0], 16), OptaX),
+                    _mm256_mullo_epi32(_mm256_srli_epi32(Fixed[1], 16), OptaY)),
+                    _mm256_mullo_epi32(_mm256_srli_epi32(Fixed[2], 16), OptaZ));
+
+        Near[0] = _mm256_andnot_si256(_mm256_cmpeq_epi32(In[0], Max), OptaX);
+        Near[1] = _mm256_andnot_si256(_mm256_cmpeq_epi32(In[1], Max), OptaY);
+        Near[2] = _mm256_andnot_si256(_mm256_cmpeq_epi32(In[2], Max), OptaZ);
+
+        // Sort the fractional parts, the walk goes first along the largest one
+        Hi  = _mm256_max_epi32(_mm256_max_epi32(Rest[0], Rest[1]), Rest[2]);
+        Lo  = _mm256_min_epi32(_mm256_min_epi32(Rest[0], Rest[1]), Rest[2]);
+        Mid = _mm256_sub_epi32(_mm256_add_epi32(_mm256_add_epi32(Rest[0], Rest[1]), Rest[2]), _mm256_add_epi32(Hi, Lo));
+
+        V1   = _mm256_blendv_epi8(_mm256_blendv_epi8(Near[2], Near[1], _mm256_cmpeq_epi32(Rest[1], Hi)),
+                                  Near[0], _mm256_cmpeq_epi32(Rest[0], Hi));
+        Vmin = _mm256_blendv_epi8(_mm256_blendv_epi8(Near[0], Near[1], _mm256_cmpeq_epi32(Rest[1], Lo)),
+                                  Near[2], _mm256_cmpeq_epi32(Rest[2], Lo));
+        V3   = _mm256_add_epi32(_mm256_add_epi32(Near[0], Near[1]), Near[2]);
+
+        Idx0 = Base;
+        Idx1 = _mm256_add_epi32(Base, V1);
+        Idx2 = _mm256_add_epi32(Base, _mm256_sub_epi32(V3, Vmin));
+        Idx3 = _mm256_add_epi32(Base, V3);
+
+        for (OutChan = 0; OutChan < nOut; OutChan++) {
+
+            __m256i c0 = GatherSamples(LutTable, Idx0, OutChan, nOut);
+            __m256i c1 = GatherSamples(LutTable, Idx1, OutChan, nOut);
+            __m256i c2 = GatherSamples(LutTable, Idx2, OutChan, nOut);
+            __m256i c3 = GatherSamples(LutTable, Idx3, OutChan, nOut);
+            __m256i r;
+
+            r = _mm256_add_epi32(_mm256_add_epi32(
+                    _mm256_mullo_epi32(_mm256_sub_epi32(c1, c0), Hi),
+                    _mm256_mullo_epi32(_mm256_sub_epi32(c2, c1), Mid)),
+                    _mm256_add_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(c3, c2), Lo), RestBias));
+
+            r = _mm256_add_epi32(c0, _mm256_srai_epi32(_mm256_add_epi32(r, _mm256_srai_epi32(r, 16)), 16));
+
+            _mm256_storeu_si256((__m256i*) Res, r);
+            for (j = 0; j < 8; j++)
+                Output[j * nOut + OutChan] = (cmsUInt16Number) Res[j];
+        }
+
+        Output += 8 * nOut;
+    }
+
+    TetrahedralInterp16Block(ContextID, Input, Output, nPixels - i, p);
+}
+
+#endif
+
+#ifdef CMS_INTRP_NEON
+
+// NEON has no gathers, the vertices are fetched one by one and the rest runs in lanes
+static
+void TetrahedralInterp16BlockNEON(cmsContext ContextID, const cmsUInt16Number Input[],
+                                  cmsUInt16Number Output[],
+                                  cmsUInt32Number nPixels,
+                                  const cmsInterpParams* p)
+{
+    const cmsUInt16Number* LutTable = (const cmsUInt16Number*) p->Table;
+    cmsUInt32Number nOut = p->nOutputs;
+    cmsUInt32Number i, j, OutChan;
+    const uint32x4_t Max = vdupq_n_u32(0xFFFF);
+    const uint32x4_t Bias = vdupq_n_u32(0x7FFF);
+    const uint32x4_t One = vdupq_n_u32(1);
+    const uint32x4_t Opta[3] = { vdupq_n_u32(p->opta[2]), vdupq_n_u32(p->opta[1]), vdupq_n_u32(p->opta[0]) };
+    cmsUInt32Number Lane[3][4];
+    cmsUInt32Number Idx[4][4];
+    cmsInt32Number  c[4][4];
+    cmsInt32Number  Res[4];
+
+    for (i = 0; i + 4 <= nPixels; i += 4) {
+
+        uint32x4_t In, Fixed, Rest[3], Near[3], Base, Hi, Lo, Mid, V1, Vmin, V3;
+
+        for (j = 0; j < 4; j++) {
+            Lane[0][j] = Input[0];
+            Lane[1][j] = Input[1];
+            Lane[2][j] = Input[2];
+            Input += 3;
+        }
+
+        Base = vdupq_n_u32(0);
+        for (j = 0; j < 3; j++) {
+
+            uint32x4_t a, n, q;
+
+            In = vld1q_u32(Lane[j]);
+
+            // _cmsToFixedDomain, the division by 0xFFFF is exact in this range
+            a = vmulq_u32(In, vdupq_n_u32(p->Domain[j]));
+            n = vaddq_u32(a, Bias);
+            q = vshrq_n_u32(vaddq_u32(vaddq_u32(n, vshrq_n_u32(n, 16)), One), 16);
+            Fixed = vaddq_u32(a, q);
+
+            Rest[j] = vandq_u32(Fixed, Max);
+            Base = vmlaq_u32(Base, vshrq_n_u32(Fixed, 16), Opta[j]);
+            Near[j] = vbicq_u32(Opta[j], vceqq_u32(In, Max));
+        }
+
+        Hi  = vmaxq_u32(vmaxq_u32(Rest[0], Rest[1]), Rest[2]);
+        Lo  = vminq_u32(vminq_u32(Rest[0], Rest[1]), Rest[2]);
+        Mid = vsubq_u32(vaddq_u32(vaddq_u32(Rest[0], Rest[1]), Rest[2]), vaddq_u32(Hi, Lo));
+
+        V1   = vbslq_u32(vceqq_u32(Rest[0], Hi), Near[0], vbslq_u32(vceqq_u32(Rest[1], Hi), Near[1], Near[2]));
+        Vmin = vbslq_u32(vceqq_u32(Rest[2], Lo), Near[2], vbslq_u32(vceqq_u32(Rest[1], Lo), Near[1], Near[0]));
+        V3   = vaddq_u32(vaddq_u32(Near[0], Near[1]), Near[2]);
+
+        vst1q_u32(Idx[0], Base);
+        vst1q_u32(Idx[1], vaddq_u32(Base, V1));
+        vst1q_u32(Idx[2], vaddq_u32(Base, vsubq_u32(V3, Vmin)));
+        vst1q_u32(Idx[3], vaddq_u32(Base, V3));
+
+        for (OutChan = 0; OutChan < nOut; OutChan++) {
+
+            int32x4_t c0, c1, c2, c3, r;
+
+            for (j = 0; j < 4; j++) {
+                c[0][j] = LutTable[Idx[0][j] + OutChan];
+                c[1][j] = LutTable[Idx[1][j] + OutChan];
+                c[2][j] = LutTable[Idx[2][j] + OutChan];
+                c[3][j] = LutTable[Idx[3][j] + OutChan];
+            }
+
+            c0 = vld1q_s32(c[0]); c1 = vld1q_s32(c[1]);
+            c2 = vld1q_s32(c[2]); c3 = vld1q_s32(c[3]);
+
+            r = vmulq_s32(vsubq_s32(c1, c0), vreinterpretq_s32_u32(Hi));
+            r = vmlaq_s32(r, vsubq_s32(c2, c1), vreinterpretq_s32_u32(Mid));
+            r = vmlaq_s32(r, vsubq_s32(c3, c2), vreinterpretq_s32_u32(Lo));
+            r = vaddq_s32(r, vdupq_n_s32(0x8001));
+            r = vaddq_s32(c0, vshrq_n_s32(vaddq_s32(r, vshrq_n_s32(r, 16)), 16));
+
+            vst1q_s32(Res, r);
+            for (j = 0; j < 4; j++)
+                Output[j * nOut + OutChan] = (cmsUInt16Number) Res[j];
+        }
+
+        Output += 4 * nOut;
+    }
+
+    TetrahedralInterp16Block(ContextID, Input, Output, nPixels - i, p);
+}
+
+#endif
+
+// Picks the best block kernel this CPU can run. The outcome never changes, so a race on first use
+// is harmless.
+static
+void TetrahedralInterp16N(cmsContext ContextID, const cmsUInt16Number Input[],
+                          cmsUInt16Number Output[],
+                          cmsUInt32Number nPixels,
+                          const cmsInterpParams* p)
+{
+#ifdef CMS_INTRP_AVX2
+    static volatile int HasAVX2 = -1;
+
+    if (HasAVX2 < 0)
+        HasAVX2 = IsAVX2Available() ? 1 : 0;
+
+    // Lanes are 32 bits wide, and the gather needs two output channels to stay in the table
+    if (HasAVX2 && p->nOutputs > 1 && p->Domain[0] < 0x8000 && p->Domain[1] < 0x8000 && p->Domain[2] < 0x8000) {
+        TetrahedralInterp16BlockAVX2(ContextID, Input, Output, nPixels, p);
+        return;
+    }
+#endif
+#ifdef CMS_INTRP_NEON
+    if (p->Domain[0] < 0x8000 && p->Domain[1] < 0x8000 && p->Domain[2] < 0x8000) {
+        TetrahedralInterp16BlockNEON(ContextID, Input, Output, nPixels, p);
+        return;
+    }
+#endif
+    TetrahedralInterp16Block(ContextID, Input, Output, nPixels, p);
+}
+
+
 #define DENS(i,j,k) (LutTable[(i)+(j)+(k)+OutChan])
 static CMS_NO_SANITIZE
 void Eval4Inputs(cmsContext ContextID, CMSREGISTER const cmsUInt16Number Input[],
@@ -1184,6 +1522,143 @@ EVAL_FNS(13, 12)
 EVAL_FNS(14, 13)
 EVAL_FNS(15, 14)
 
+// Batch interpolation --------------------------------------------------------------------------------------------
+
+// Loops on a known interpolator, so the compiler can inline it and keep the invariants of p in registers
+#define BATCH_FN16(NAME) static \
+void NAME##N(cmsContext ContextID, const cmsUInt16Number Input[], cmsUInt16Number Output[], \
+             cmsUInt32Number nPixels, const cmsInterpParams* p) \
+{\
+       cmsUInt32Number i;\
+       cmsUInt32Number nIn = p -> nInputs, nOut = p -> nOutputs;\
+\
+       for (i=0; i < nPixels; i++) {\
+\
+              NAME(ContextID, Input, Output, p);\
+              Input  += nIn;\
+              Output += nOut;\
+       }\
+}
+
+#define BATCH_FNFLOAT(NAME) static \
+void NAME##N(cmsContext ContextID, const cmsFloat32Number Input[], cmsFloat32Number Output[], \
+             cmsUInt32Number nPixels, const cmsInterpParams* p) \
+{\
+       cmsUInt32Number i;\
+       cmsUInt32Number nIn = p -> nInputs, nOut = p -> nOutputs;\
+\
+       for (i=0; i < nPixels; i++) {\
+\
+              NAME(ContextID, Input, Output, p);\
+              Input  += nIn;\
+              Output += nOut;\
+       }\
+}
+
+BATCH_FN16(LinLerp1D)
+BATCH_FN16(Eval1Input)
+BATCH_FN16(TrilinearInterp16)
+BATCH_FN16(Eval4Inputs)
+
+BATCH_FNFLOAT(LinLerp1Dfloat)
+BATCH_FNFLOAT(Eval1InputFloat)
+BATCH_FNFLOAT(TrilinearInterpFloat)
+BATCH_FNFLOAT(TetrahedralInterpFloat)
+BATCH_FNFLOAT(Eval4InputsFloat)
+
+static
+void Lerp16NLoop(cmsContext ContextID, const cmsUInt16Number Input[], cmsUInt16Number Output[],
+                 cmsUInt32Number nPixels, const cmsInterpParams* p)
+{
+    cmsUInt32Number i;
+
+    for (i=0; i < nPixels; i++) {
+
+        p ->Interpolation.Lerp16(ContextID, Input, Output, p);
+        Input  += p ->nInputs;
+        Output += p ->nOutputs;
+    }
+}
+
+static
+void LerpFloatNLoop(cmsContext ContextID, const cmsFloat32Number Input[], cmsFloat32Number Output[],
+                    cmsUInt32Number nPixels, const cmsInterpParams* p)
+{
+    cmsUInt32Number i;
+
+    for (i=0; i < nPixels; i++) {
+
+        p ->Interpolation.LerpFloat(ContextID, Input, Output, p);
+        Input  += p ->nInputs;
+        Output += p ->nOutputs;
+    }
+}
+
+// The default batch factory. Must pick the same algorithm as DefaultInterpolatorsFactory. Returns
+// NULL for the combinations that are just looped.
+static
+cmsInterpFunctionN DefaultInterpolatorsFactoryN(cmsUInt32Number nInputChannels, cmsUInt32Number nOutputChannels, cmsUInt32Number dwFlags)
+{
+    cmsInterpFunctionN Interpolation;
+    cmsBool  IsFloat     = (dwFlags & CMS_LERP_FLAGS_FLOAT);
+    cmsBool  IsTrilinear = (dwFlags & CMS_LERP_FLAGS_TRILINEAR);
+
+    memset(&Interpolation, 0, sizeof(Interpolation));
+
+    // Safety check
+    if (nInputChannels >= 4 && nOutputChannels >= MAX_STAGE_CHANNELS)
+        return Interpolation;
+
+    switch (nInputChannels) {
+
+           case 1:
+               if (nOutputChannels == 1) {
+
+                   if (IsFloat)
+                       Interpolation.LerpFloatN = LinLerp1DfloatN;
+                   else
+                       Interpolation.Lerp16N = LinLerp1DN;
+               }
+               else {
+
+                   if (IsFloat)
+                       Interpolation.LerpFloatN = Eval1InputFloatN;
+                   else
+                       Interpolation.Lerp16N = Eval1InputN;
+               }
+               break;
+
+           case 3:
+               if (IsTrilinear) {
+
+                   if (IsFloat)
+                       Interpolation.LerpFloatN = TrilinearInterpFloatN;
+                   else
+                       Interpolation.Lerp16N = TrilinearInterp16N;
+               }
+               else {
+
+                   if (IsFloat)
+                       Interpolation.LerpFloatN = TetrahedralInterpFloatN;
+                   else
+                       Interpolation.Lerp16N = TetrahedralInterp16N;
+               }
+               break;
+
+           case 4:
+               if (IsFloat)
+                   Interpolation.LerpFloatN = Eval4InputsFloatN;
+               else
+                   Interpolation.Lerp16N = Eval4InputsN;
+               break;
+
+           default:
+               break;
+    }
+
+    return Interpolation;
+}
+
 // The default factory
 static
 cmsInterpFunction DefaultInterpolatorsFactory(cmsUInt32Number nInputChannels, cmsUInt32Number nOutputChannels, cmsUInt32Number dwFlags)
@@ -26,6 +26,21 @@
 
 #include "lcms2_internal.h"
 
+// Memory mapped files. Where not available, files opened in this way are read in one go
+#ifndef CMS_NO_MMAP
+#   ifdef CMS_IS_WINDOWS_
+#       include <windows.h>
+#   elif defined(__unix__) || defined(__unix) || defined(__APPLE__)
+#       include <sys/types.h>
+#       include <sys/stat.h>
+#       include <sys/mman.h>
+#       include <fcntl.h>
+#       include <unistd.h>
+#   else
+#       define CMS_NO_MMAP 1
+#   endif
+#endif
+
 // Generic I/O, tag dictionary management, profile struct
 
 // IOhandlers are abstractions used by littleCMS to read from whatever file, stream,
@@ -143,6 +158,7 @@ typedef struct {
     cmsUInt32Number Size;     // Size of allocated memory
     cmsUInt32Number Pointer;  // Points to current location
     int FreeBlockOnClose;     // As title
+    int IsMapped;             // Block is a view of a memory mapped file
 
 } FILEMEM;
 
@@ -153,10 +169,11 @@ cmsUInt32Number MemoryRead(cmsContext ContextID, struct _cms_io_handler* iohandl
     cmsUInt8Number* Ptr;
     cmsUInt32Number len = size * count;
 
-    if (ResData -> Pointer + len > ResData -> Size){
+    // Bulk readers ask for whole tables at once, so check without overflowing
+    if ((count != 0 && len / count != size) || len > ResData -> Size - ResData -> Pointer) {
 
         len = (ResData -> Size - ResData -> Pointer);
-        cmsSignalError(ContextID, cmsERROR_READ, "Read from memory error. Got %d bytes, block should be of %d bytes", len, count * size);
+        cmsSignalError(ContextID, cmsERROR_READ, "Read from memory error. Got %u bytes, block should be of %u items of %u bytes", len, count, size);
         return 0;
     }
 
@@ -221,11 +238,32 @@ cmsBool MemoryWrite(cmsContext ContextID, struct _cms_io_handler* iohandler, cms
 }
 
 
+// Blocks not owned by the handler, as borrowed memory or mapped files, are never written
+static
+cmsBool MemoryWriteDenied(cmsContext ContextID, struct _cms_io_handler* iohandler, cmsUInt32Number size, const void *Ptr)
+{
+    cmsUNUSED_PARAMETER(iohandler);
+    cmsUNUSED_PARAMETER(Ptr);
+
+    if (size == 0) return TRUE;
+
+    cmsSignalError(ContextID, cmsERROR_WRITE, "Read only memory block");
+    return FALSE;
+}
+
+static
+void UnmapFileView(FILEMEM* ResData);
+
 static
 cmsBool  MemoryClose(cmsContext ContextID, struct _cms_io_handler* iohandler)
 {
     FILEMEM* ResData = (FILEMEM*) iohandler ->stream;
 
+    if (ResData ->IsMapped) {
+
+        UnmapFileView(ResData);
+    }
+    else
     if (ResData ->FreeBlockOnClose) {
 
         if (ResData ->Block) _cmsFree(ContextID, ResData ->Block);
@@ -317,6 +355,205 @@ Error:
     return NULL;
 }
 
+// Create a read-only iohandler that works directly on a block owned by the caller. No copy is done, so the block
+// must stay valid and unchanged for the whole life of the iohandler (and of any profile opened on it).
+cmsIOHANDLER* CMSEXPORT cmsOpenIOhandlerFromMemNoCopy(cmsContext ContextID, const void *Buffer, cmsUInt32Number size)
+{
+    cmsIOHANDLER* iohandler;
+
+    if (Buffer == NULL) {
+        cmsSignalError(ContextID, cmsERROR_READ, "Couldn't read profile from NULL pointer");
+        return NULL;
+    }
+
+    // A write handler on the block is exactly what we need, just disable writting and report the size
+    iohandler = cmsOpenIOhandlerFromMem(ContextID, (void*) Buffer, size, "w");
+    if (iohandler == NULL) return NULL;
+
+    iohandler ->ReportedSize = size;
+    iohandler ->Write = MemoryWriteDenied;
+
+    return iohandler;
+}
+
+// Memory mapped files -----------------------------------------------------------------------------------
+
+#ifndef CMS_NO_MMAP
+#ifdef CMS_IS_WINDOWS_
+
+static
+cmsBool MapFileView(cmsContext ContextID, const char* FileName, FILEMEM* fm)
+{
+    HANDLE hFile, hMap;
+    LARGE_INTEGER Size;
+    void* View = NULL;
+
+    hFile = CreateFileA(FileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return FALSE;
+
+    if (!GetFileSizeEx(hFile, &Size) || Size.QuadPart <= 0 || Size.QuadPart > 0xFFFFFFFFL) {
+        CloseHandle(hFile);
+        return FALSE;
+    }
+
+    hMap = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (hMap != NULL) {
+        View = MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(hMap);
+    }
+
+    // The view keeps the file alive
+    CloseHandle(hFile);
+    if (View == NULL) return FALSE;
+
+    fm ->Block = (cmsUInt8Number*) View;
+    fm ->Size  = (cmsUInt32Number) Size.QuadPart;
+    fm ->IsMapped = TRUE;
+
+    cmsUNUSED_PARAMETER(ContextID);
+    return TRUE;
+}
+
+static
+void UnmapFileView(FILEMEM* ResData)
+{
+    UnmapViewOfFile(ResData ->Block);
+}
+
+#else
+
+static
+cmsBool MapFileView(cmsContext ContextID, const char* FileName, FILEMEM* fm)
+{
+    struct stat st;
+    void* View;
+    int fd;
+
+    fd = open(FileName, O_RDONLY);
+    if (fd < 0) return FALSE;
+
+    // Iohandlers are limited to 4GB
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || ((st.st_size >> 16) >> 16) != 0) {
+        close(fd);
+        return FALSE;
+    }
+
+    View = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping keeps the file alive
+    close(fd);
+    if (View == MAP_FAILED) return FALSE;
+
+    fm ->Block = (cmsUInt8Number*) View;
+    fm ->Size  = (cmsUInt32Number) st.st_size;
+    fm ->IsMapped = TRUE;
+
+    cmsUNUSED_PARAMETER(ContextID);
+    return TRUE;
+}
+
+static
+void UnmapFileView(FILEMEM* ResData)
+{
+    munmap((void*) ResData ->Block, ResData ->Size);
+}
+
+#endif
+#else
+
+static
+cmsBool MapFileView(cmsContext ContextID, const char* FileName, FILEMEM* fm)
+{
+    cmsUNUSED_PARAMETER(ContextID);
+    cmsUNUSED_PARAMETER(FileName);
+    cmsUNUSED_PARAMETER(fm);
+    return FALSE;
+}
+
+static
+void UnmapFileView(FILEMEM* ResData)
+{
+    cmsUNUSED_PARAMETER(ResData);
+}
+
+#endif
+
+// When the file cannot be mapped, the whole file is read in one go
+static
+cmsBool ReadWholeFile(cmsContext ContextID, const char* FileName, FILEMEM* fm)
+{
+    FILE* f;
+    long int Size;
+
+    f = fopen(FileName, "rb");
+    if (f == NULL) return FALSE;
+
+    Size = cmsfilelength(f);
+    if (Size <= 0) {
+        fclose(f);
+        return FALSE;
+    }
+
+    fm ->Block = (cmsUInt8Number*) _cmsMalloc(ContextID, (cmsUInt32Number) Size);
+    if (fm ->Block == NULL) {
+        fclose(f);
+        return FALSE;
+    }
+
+    if (fread(fm ->Block, (size_t) Size, 1, f) != 1) {
+        _cmsFree(ContextID, fm ->Block);
+        fm ->Block = NULL;
+        fclose(f);
+        return FALSE;
+    }
+
+    fclose(f);
+    fm ->Size = (cmsUInt32Number) Size;
+    fm ->FreeBlockOnClose = TRUE;
+    return TRUE;
+}
+
+// Read only iohandler on a memory mapped file. Tags are then read from the page cache with no stdio calls. The file
+// should not be truncated while the handler is open.
+static
+cmsIOHANDLER* OpenIOhandlerFromMappedFile(cmsContext ContextID, const char* FileName)
+{
+    cmsIOHANDLER* iohandler;
+    FILEMEM* fm;
+
+    iohandler = (cmsIOHANDLER*) _cmsMallocZero(ContextID, sizeof(cmsIOHANDLER));
+    if (iohandler == NULL) return NULL;
+
+    fm = (FILEMEM*) _cmsMallocZero(ContextID, sizeof(FILEMEM));
+    if (fm == NULL) {
+        _cmsFree(ContextID, iohandler);
+        return NULL;
+    }
+
+    if (!MapFileView(ContextID, FileName, fm) && !ReadWholeFile(ContextID, FileName, fm)) {
+
+        _cmsFree(ContextID, fm);
+        _cmsFree(ContextID, iohandler);
+        cmsSignalError(ContextID, cmsERROR_FILE, "File '%s' not found", FileName);
+        return NULL;
+    }
+
+    iohandler ->stream  = (void*) fm;
+    iohandler ->UsedSpace = 0;
+    iohandler ->ReportedSize = fm ->Size;
+
+    strncpy(iohandler -> PhysicalFile, FileName, sizeof(iohandler -> PhysicalFile)-1);
+    iohandler -> PhysicalFile[sizeof(iohandler -> PhysicalFile)-1] = 0;
+
+    iohandler ->Read    = MemoryRead;
+    iohandler ->Seek    = MemorySeek;
+    iohandler ->Close   = MemoryClose;
+    iohandler ->Tell    = MemoryTell;
+    iohandler ->Write   = MemoryWriteDenied;
+
+    return iohandler;
+}
+
 // File-based stream -------------------------------------------------------
 
 // Read count elements of size bytes each. Return number of elements read
@@ -379,13 +616,15 @@ cmsBool  FileClose(cmsContext ContextID, cmsIOHANDLER* iohandler)
     return TRUE;
 }
 
-// Create a iohandler for disk based files.
+// Create a iohandler for disk based files. Adding "m" to the read access mode maps the file in memory instead of
+// going through stdio.
 cmsIOHANDLER* CMSEXPORT cmsOpenIOhandlerFromFile(cmsContext ContextID, const char* FileName, const char* AccessMode)
 {
     cmsIOHANDLER* iohandler = NULL;
     FILE* fm = NULL;
     cmsInt32Number fileLen;
     char mode[4] = { 0,0,0,0 };
+    cmsBool Mapped = FALSE;
 
     _cmsAssert(FileName != NULL);
     _cmsAssert(AccessMode != NULL);
@@ -417,6 +656,11 @@ cmsIOHANDLER* CMSEXPORT cmsOpenIOhandlerFromFile(cmsContext ContextID, const cha
             mode[2] = 'e';
             break;
 
+        // Memory mapped, read only
+        case 'm':
+            Mapped = TRUE;
+            break;
+
         default:
             _cmsFree(ContextID, iohandler);
             cmsSignalError(ContextID, cmsERROR_FILE, "Wrong access mode '%c'", *AccessMode);
@@ -426,6 +670,18 @@ cmsIOHANDLER* CMSEXPORT cmsOpenIOhandlerFromFile(cmsContext ContextID, const cha
         AccessMode++;
     }
 
+    if (Mapped) {
+
+        _cmsFree(ContextID, iohandler);
+
+        if (mode[0] != 'r') {
+            cmsSignalError(ContextID, cmsERROR_FILE, "Memory mapped files are read only");
+            return NULL;
+        }
+
+        return OpenIOhandlerFromMappedFile(ContextID, FileName);
+    }
+
     switch (mode[0]) {
 
     case 'r':
@@ -594,15 +850,41 @@ cmsTagSignature CMSEXPORT cmsGetTagSignature(cmsContext ContextID, cmsHPROFILE h
 }
 
 
+// The directory is indexed by a small open addressing hash table. Positions never move and are only added, so
+// there are at most MAX_TABLE_TAG entries and the table is never full. Entries are checked against TagNames, as
+// deleted or failed tags leave stale entries behind.
+cmsINLINE cmsUInt32Number TagIndexHash(cmsTagSignature sig)
+{
+    return (((cmsUInt32Number) sig * 2654435761U) >> 24) & (TAG_INDEX_SIZE - 1);
+}
+
+static
+void IndexTag(_cmsICCPROFILE* Profile, int n)
+{
+    cmsUInt32Number h = TagIndexHash(Profile ->TagNames[n]);
+
+    while (Profile ->TagIndex[h] != 0) {
+
+        if (Profile ->TagIndex[h] == (cmsUInt8Number) (n + 1)) return;   // Already there
+        h = (h + 1) & (TAG_INDEX_SIZE - 1);
+    }
+
+    Profile ->TagIndex[h] = (cmsUInt8Number) (n + 1);
+}
+
 static
 int SearchOneTag(_cmsICCPROFILE* Profile, cmsTagSignature sig)
 {
-    int i;
+    cmsUInt32Number h = TagIndexHash(sig);
+    int n;
 
-    for (i=0; i < (int) Profile -> TagCount; i++) {
+    while (Profile ->TagIndex[h] != 0) {
 
-        if (sig == Profile -> TagNames[i])
-            return i;
+        n = Profile ->TagIndex[h] - 1;
+        if (n < (int) Profile ->TagCount && Profile ->TagNames[n] == sig)
+            return n;
+
+        h = (h + 1) & (TAG_INDEX_SIZE - 1);
     }
 
     return -1;
@@ -662,11 +944,13 @@ void _cmsDeleteTagByPos(cmsContext ContextID, _cmsICCPROFILE* Icc, int i)
                 cmsTagTypeHandler LocalTypeHandler = *TypeHandler;
                 LocalTypeHandler.ICCVersion = Icc ->Version;
                 LocalTypeHandler.FreePtr(ContextID, &LocalTypeHandler, Icc -> TagPtrs[i]);
-                Icc ->TagPtrs[i] = NULL;
             }
         }
 
+        Icc ->TagPtrs[i] = NULL;
     }
+
+    Icc ->TagMemory[i] = 0;
 }
 
 
@@ -693,7 +977,10 @@ cmsBool _cmsNewTag(cmsContext ContextID, _cmsICCPROFILE* Icc, cmsTagSignature si
         }
 
         *NewPos = (int) Icc ->TagCount;
+        Icc -> TagNames[*NewPos] = sig;
         Icc -> TagCount++;
+
+        IndexTag(Icc, *NewPos);
     }
 
     return TRUE;
@@ -848,6 +1135,7 @@ cmsBool _cmsReadHeader(cmsContext ContextID, _cmsICCPROFILE* Icc)
 
     // Read tag directory
     Icc -> TagCount = 0;
+    memset(Icc ->TagIndex, 0, sizeof(Icc ->TagIndex));
     for (i=0; i < TagCount; i++) {
 
         if (!_cmsReadUInt32Number(ContextID, io, (cmsUInt32Number *) &Tag.sig)) return FALSE;
@@ -880,20 +1168,14 @@ cmsBool _cmsReadHeader(cmsContext ContextID, _cmsICCPROFILE* Icc)
 
         }
 
-        Icc ->TagCount++;
-    }
-
-
-    for (i = 0; i < Icc->TagCount; i++) {
-        for (j = 0; j < Icc->TagCount; j++) {
-
-            // Tags cannot be duplicate
-            if ((i != j) && (Icc->TagNames[i] == Icc->TagNames[j])) {
-                cmsSignalError(ContextID, cmsERROR_RANGE, "Duplicate tag found");
-                return FALSE;
-            }
-
+        // Tags cannot be duplicate
+        if (SearchOneTag(Icc, Tag.sig) >= 0) {
+            cmsSignalError(ContextID, cmsERROR_RANGE, "Duplicate tag found");
+            return FALSE;
         }
+
+        IndexTag(Icc, (int) Icc ->TagCount);
+        Icc ->TagCount++;
     }
 
     return TRUE;
@@ -975,6 +1257,15 @@ cmsBool _cmsWriteHeader(cmsContext ContextID, _cmsICCPROFILE* Icc, cmsUInt32Numb
 // ----------------------------------------------------------------------- Set/Get several struct members
 
 
+// Changes on the contents drop the content ID, which is no longer taken from the block the profile was read from.
+// Flags, rendering intent and profile ID are not part of it.
+static
+void ContentsChanged(_cmsICCPROFILE* Icc)
+{
+    Icc ->HasContentID = FALSE;
+    Icc ->IsModified = TRUE;
+}
+
 cmsUInt32Number CMSEXPORT cmsGetHeaderRenderingIntent(cmsContext ContextID, cmsHPROFILE hProfile)
 {
     _cmsICCPROFILE*  Icc = (_cmsICCPROFILE*) hProfile;
@@ -985,7 +1276,7 @@ cmsUInt32Number CMSEXPORT cmsGetHeaderRenderingIntent(cmsContext ContextID, cmsH
 void CMSEXPORT cmsSetHeaderRenderingIntent(cmsContext ContextID, cmsHPROFILE hProfile, cmsUInt32Number RenderingIntent)
 {
     _cmsICCPROFILE*  Icc = (_cmsICCPROFILE*) hProfile;
-    cmsUNUSED_PARAMETER(ContextID);
+    if (_cmsIsPooledProfile(ContextID, Icc)) return;
     Icc -> RenderingIntent = RenderingIntent;
 }
 
@@ -999,7 +1290,7 @@ cmsUInt32Number CMSEXPORT cmsGetHeaderFlags(cmsContext ContextID, cmsHPROFILE hP
 void CMSEXPORT cmsSetHeaderFlags(cmsContext ContextID, cmsHPROFILE hProfile, cmsUInt32Number Flags)
 {
     _cmsICCPROFILE*  Icc = (_cmsICCPROFILE*) hProfile;
-    cmsUNUSED_PARAMETER(ContextID);
+    if (_cmsIsPooledProfile(ContextID, Icc)) return;
     Icc -> flags = (cmsUInt32Number) Flags;
 }
 
@@ -1013,7 +1304,8 @@ cmsUInt32Number CMSEXPORT cmsGetHeaderManufacturer(cmsContext ContextID, cmsHPRO
 void CMSEXPORT cmsSetHeaderManufacturer(cmsContext ContextID, cmsHPROFILE hProfile, cmsUInt32Number manufacturer)
 {
     _cmsICCPROFILE*  Icc = (_cmsICCPROFILE*) hProfile;
-    cmsUNUSED_PARAMETER(ContextID);
+    if (_cmsIsPooledProfile(ContextID, Icc)) return;
+    ContentsChanged(Icc);
     Icc -> manufacturer = manufacturer;
 }
 
@@ -1034,7 +1326,8 @@ cmsUInt32Number CMSEXPORT cmsGetHeaderModel(cmsContext ContextID, cmsHPROFILE hP
 void CMSEXPORT cmsSetHeaderModel(cmsContext ContextID, cmsHPROFILE hProfile, cmsUInt32Number model)
 {
     _cmsICCPROFILE*  Icc = (_cmsICCPROFILE*) hProfile;
-    cmsUNUSED_PARAMETER(ContextID);
+    if (_cmsIsPooledProfile(ContextID, Icc)) return;
+    ContentsChanged(Icc);
     Icc -> model = model;
 }
 
@@ -1048,7 +1341,8 @@ void CMSEXPORT cmsGetHeaderAttributes(cmsContext ContextID, cmsHPROFILE hProfile
 void CMSEXPORT cmsSetHeaderAttributes(cmsContext ContextID, cmsHPROFILE hProfile, cmsUInt64Number Flags)
 {
     _cmsICCPROFILE*  Icc = (_cmsICCPROFILE*) hProfile;
-    cmsUNUSED_PARAMETER(ContextID);
+    if (_cmsIsPooledProfile(ContextID, Icc)) return;
+    ContentsChanged(Icc);
     memmove(&Icc -> attributes, &Flags, sizeof(cmsUInt64Number));
 }
 
@@ -1062,7 +1356,7 @@ void CMSEXPORT cmsGetHeaderProfileID(cmsContext ContextID, cmsHPROFILE hProfile,
 void CMSEXPORT cmsSetHeaderProfileID(cmsContext ContextID, cmsHPROFILE hProfile, cmsUInt8Number* ProfileID)
 {
     _cmsICCPROFILE*  Icc = (_cmsICCPROFILE*) hProfile;
-    cmsUNUSED_PARAMETER(ContextID);
+    if (_cmsIsPooledProfile(ContextID, Icc)) return;
     memmove(&Icc -> ProfileID, ProfileID, 16);
 }
 
@@ -1084,7 +1378,8 @@ cmsColorSpaceSignature CMSEXPORT cmsGetPCS(cmsContext ContextID, cmsHPROFILE hPr
 void CMSEXPORT cmsSetPCS(cmsContext ContextID, cmsHPROFILE hProfile, cmsColorSpaceSignature pcs)
 {
     _cmsICCPROFILE*  Icc = (_cmsICCPROFILE*) hProfile;
-    cmsUNUSED_PARAMETER(ContextID);
+    if (_cmsIsPooledProfile(ContextID, Icc)) return;
+    ContentsChanged(Icc);
     Icc -> PCS = pcs;
 }
 
@@ -1098,7 +1393,8 @@ cmsColorSpaceSignature CMSEXPORT cmsGetColorSpace(cmsContext ContextID, cmsHPROF
 void CMSEXPORT cmsSetColorSpace(cmsContext ContextID, cmsHPROFILE hProfile, cmsColorSpaceSignature sig)
 {
     _cmsICCPROFILE*  Icc = (_cmsICCPROFILE*) hProfile;
-    cmsUNUSED_PARAMETER(ContextID);
+    if (_cmsIsPooledProfile(ContextID, Icc)) return;
+    ContentsChanged(Icc);
     Icc -> ColorSpace = sig;
 }
 
@@ -1112,7 +1408,8 @@ cmsProfileClassSignature CMSEXPORT cmsGetDeviceClass(cmsContext ContextID, cmsHP
 void CMSEXPORT cmsSetDeviceClass(cmsContext ContextID, cmsHPROFILE hProfile, cmsProfileClassSignature sig)
 {
     _cmsICCPROFILE*  Icc = (_cmsICCPROFILE*) hProfile;
-    cmsUNUSED_PARAMETER(ContextID);
+    if (_cmsIsPooledProfile(ContextID, Icc)) return;
+    ContentsChanged(Icc);
     Icc -> DeviceClass = sig;
 }
 
@@ -1126,7 +1423,8 @@ cmsUInt32Number CMSEXPORT cmsGetEncodedICCversion(cmsContext ContextID, cmsHPROF
 void CMSEXPORT cmsSetEncodedICCversion(cmsContext ContextID, cmsHPROFILE hProfile, cmsUInt32Number Version)
 {
     _cmsICCPROFILE*  Icc = (_cmsICCPROFILE*) hProfile;
-    cmsUNUSED_PARAMETER(ContextID);
+    if (_cmsIsPooledProfile(ContextID, Icc)) return;
+    ContentsChanged(Icc);
     Icc -> Version = Version;
 }
 
@@ -1154,7 +1452,8 @@ cmsUInt32Number BaseToBase(cmsUInt32Number in, int BaseIn, int BaseOut)
 void  CMSEXPORT cmsSetProfileVersion(cmsContext ContextID, cmsHPROFILE hProfile, cmsFloat64Number Version)
 {
     _cmsICCPROFILE*  Icc = (_cmsICCPROFILE*) hProfile;
-    cmsUNUSED_PARAMETER(ContextID);
+    if (_cmsIsPooledProfile(ContextID, Icc)) return;
+    ContentsChanged(Icc);
 
     // 4.2 -> 0x4200000
 
@@ -1300,6 +1599,293 @@ Error:
 }
 
 
+// Open from a memory block owned by the caller, which should not be freed or modified until the profile is closed.
+cmsHPROFILE CMSEXPORT cmsOpenProfileFromMemNoCopy(cmsContext ContextID, const void* MemPtr, cmsUInt32Number dwSize)
+{
+    _cmsICCPROFILE* NewIcc;
+    cmsHPROFILE hEmpty;
+
+    hEmpty = cmsCreateProfilePlaceholder(ContextID);
+    if (hEmpty == NULL) return NULL;
+
+    NewIcc = (_cmsICCPROFILE*) hEmpty;
+
+    NewIcc ->IOhandler = cmsOpenIOhandlerFromMemNoCopy(ContextID, MemPtr, dwSize);
+    if (NewIcc ->IOhandler == NULL) goto Error;
+
+    if (!_cmsReadHeader(ContextID, NewIcc)) goto Error;
+
+    return hEmpty;
+
+Error:
+    cmsCloseProfile(ContextID, hEmpty);
+    return NULL;
+}
+
+// Profile pool -----------------------------------------------------------------------------------------------------
+
+typedef struct _cmsProfilePoolEntry_st {
+
+    struct _cmsProfilePoolEntry_st* Next;
+
+    cmsProfileID     Hash;          // MD5 of the whole block
+    cmsUInt32Number  Size;
+    cmsUInt64Number  Decoded;       // Decoded tags, which count in the pool size as well
+    cmsHPROFILE      hProfile;      // The pool holds one reference
+
+} _cmsProfilePoolEntry;
+
+_cmsProfilePoolChunkType _cmsProfilePoolChunk = { NULL, 0, 0, NULL, 0, 0 };
+
+// Pooled profiles belong to the context, so duplicates start empty and disabled
+void _cmsAllocProfilePoolChunk(struct _cmsContext_struct* ctx,
+                               const struct _cmsContext_struct* src)
+{
+    static _cmsProfilePoolChunkType ProfilePoolChunk = { NULL, 0, 0, NULL, 0, 0 };
+
+    cmsUNUSED_PARAMETER(src);
+
+    ctx ->chunks[ProfilePoolContext] = _cmsSubAllocDup(ctx ->MemPool, &ProfilePoolChunk, sizeof(_cmsProfilePoolChunkType));
+}
+
+// Unlinks the least recently used entries until the pool fits in the given size and returns them as a list.
+// Pool must be locked
+static
+_cmsProfilePoolEntry* TrimProfilePool(_cmsProfilePoolChunkType* pool, cmsUInt32Number MaxBytes)
+{
+    _cmsProfilePoolEntry** pt = &pool ->Head;
+    _cmsProfilePoolEntry* Evicted;
+    cmsUInt64Number Used = 0;
+
+    if (pool ->UsedBytes <= MaxBytes) return NULL;
+
+    while (*pt != NULL && Used + (*pt) ->Size + (*pt) ->Decoded <= MaxBytes) {
+
+        Used += (*pt) ->Size + (*pt) ->Decoded;
+        pt = &(*pt) ->Next;
+    }
+
+    Evicted = *pt;
+    *pt = NULL;
+    pool ->UsedBytes = Used;
+
+    return Evicted;
+}
+
+// Drops the pool reference of a list of entries, out of the pool lock
+static
+void FreeProfilePoolEntries(cmsContext ContextID, _cmsProfilePoolEntry* e)
+{
+    _cmsProfilePoolEntry* Next;
+
+    for (; e != NULL; e = Next) {
+
+        Next = e ->Next;
+        cmsCloseProfile(ContextID, e ->hProfile);
+        _cmsFree(ContextID, e);
+    }
+}
+
+// Sets the amount of profile data kept by the pool of this context. Zero disables the pool and drops all entries;
+// profiles still open by the caller remain valid. Not meant to be called while other threads are opening profiles.
+void CMSEXPORT cmsSetProfilePoolSize(cmsContext ContextID, cmsUInt32Number MaxBytes)
+{
+    _cmsProfilePoolChunkType* pool = (_cmsProfilePoolChunkType*) _cmsContextGetClientChunk(ContextID, ProfilePoolContext);
+    _cmsProfilePoolEntry* Evicted;
+
+    if (pool ->Mutex == NULL) {
+
+        if (MaxBytes == 0) return;
+
+        pool ->Mutex = _cmsCreateMutex(ContextID);
+        if (pool ->Mutex == NULL) return;
+    }
+
+    if (!_cmsLockMutex(ContextID, pool ->Mutex)) return;
+
+    pool ->MaxBytes = MaxBytes;
+    Evicted = TrimProfilePool(pool, MaxBytes);
+
+    _cmsUnlockMutex(ContextID, pool ->Mutex);
+
+    FreeProfilePoolEntries(ContextID, Evicted);
+}
+
+// Hit and miss counts since the context was created
+void CMSEXPORT cmsGetProfilePoolStats(cmsContext ContextID, cmsUInt32Number* Hits, cmsUInt32Number* Misses)
+{
+    _cmsProfilePoolChunkType* pool = (_cmsProfilePoolChunkType*) _cmsContextGetClientChunk(ContextID, ProfilePoolContext);
+    cmsBool Locked = pool ->Mutex != NULL && _cmsLockMutex(ContextID, pool ->Mutex);
+
+    if (Hits)   *Hits   = pool ->Hits;
+    if (Misses) *Misses = pool ->Misses;
+
+    if (Locked) _cmsUnlockMutex(ContextID, pool ->Mutex);
+}
+
+// Called on context deletion
+void _cmsFreeProfilePool(cmsContext ContextID)
+{
+    _cmsProfilePoolChunkType* pool = (_cmsProfilePoolChunkType*) _cmsContextGetClientChunk(ContextID, ProfilePoolContext);
+
+    if (pool ->Mutex == NULL) return;
+
+    cmsSetProfilePoolSize(ContextID, 0);
+
+    _cmsDestroyMutex(ContextID, pool ->Mutex);
+    pool ->Mutex = NULL;
+}
+
+// Returns a new reference on a pooled profile, or NULL if not found. The entry becomes the most recent one.
+// Pool must be locked
+static
+cmsHPROFILE LookupProfilePool(_cmsProfilePoolChunkType* pool, const cmsProfileID* Hash, cmsUInt32Number Size)
+{
+    _cmsProfilePoolEntry** pt;
+    _cmsProfilePoolEntry* e;
+
+    for (pt = &pool ->Head; *pt != NULL; pt = &(*pt) ->Next) {
+
+        e = *pt;
+        if (e ->Size == Size && memcmp(&e ->Hash, Hash, sizeof(cmsProfileID)) == 0) {
+
+            // Move to front
+            *pt = e ->Next;
+            e ->Next = pool ->Head;
+            pool ->Head = e;
+
+            (void) _cmsAdjustReferenceCount(&((_cmsICCPROFILE*) e ->hProfile) ->PoolRefs, 1);
+            return e ->hProfile;
+        }
+    }
+
+    return NULL;
+}
+
+// Decoded tags of pooled profiles cannot be released while the profile is shared, so they count in the pool size
+// instead. Called by cmsReadTag, out of the profile lock, once a tag of Bytes is decoded. The profile becomes the
+// most recently used one and older ones are evicted if needed. If it doesn't fit by itself, the pool drops it as
+// well, and it is freed when the last handle is closed.
+static
+void ChargeProfilePool(cmsContext ContextID, cmsHPROFILE hProfile, cmsUInt32Number Bytes)
+{
+    _cmsProfilePoolChunkType* pool = (_cmsProfilePoolChunkType*) _cmsContextGetClientChunk(ContextID, ProfilePoolContext);
+    _cmsProfilePoolEntry** pt;
+    _cmsProfilePoolEntry* e;
+    _cmsProfilePoolEntry* Evicted = NULL;
+
+    if (pool ->Mutex == NULL || !_cmsLockMutex(ContextID, pool ->Mutex)) return;
+
+    // Not there if already evicted, or pooled by another context
+    for (pt = &pool ->Head; *pt != NULL; pt = &(*pt) ->Next) {
+
+        e = *pt;
+        if (e ->hProfile == hProfile) {
+
+            e ->Decoded += Bytes;
+            pool ->UsedBytes += Bytes;
+
+            *pt = e ->Next;
+            e ->Next = pool ->Head;
+            pool ->Head = e;
+
+            Evicted = TrimProfilePool(pool, pool ->MaxBytes);
+            break;
+        }
+    }
+
+    _cmsUnlockMutex(ContextID, pool ->Mutex);
+
+    FreeProfilePoolEntries(ContextID, Evicted);
+}
+
+// Open from memory block, sharing the profile with previous calls on the same contents if the pool is enabled
+cmsHPROFILE CMSEXPORT cmsOpenProfileFromMemPooled(cmsContext ContextID, const void* MemPtr, cmsUInt32Number dwSize)
+{
+    _cmsProfilePoolChunkType* pool = (_cmsProfilePoolChunkType*) _cmsContextGetClientChunk(ContextID, ProfilePoolContext);
+    _cmsProfilePoolEntry* e;
+    _cmsProfilePoolEntry* Evicted;
+    cmsProfileID Hash;
+    cmsHANDLE MD5;
+    cmsHPROFILE hProfile, hShared;
+    _cmsICCPROFILE* Icc;
+
+    if (pool ->Mutex == NULL || pool ->MaxBytes == 0 || dwSize > pool ->MaxBytes || MemPtr == NULL)
+        return cmsOpenProfileFromMem(ContextID, MemPtr, dwSize);
+
+    MD5 = cmsMD5alloc(ContextID);
+    if (MD5 == NULL) return NULL;
+
+    cmsMD5add(MD5, (const cmsUInt8Number*) MemPtr, dwSize);
+    cmsMD5finish(ContextID, &Hash, MD5);
+
+    if (!_cmsLockMutex(ContextID, pool ->Mutex)) return NULL;
+
+    hShared = LookupProfilePool(pool, &Hash, dwSize);
+    if (hShared != NULL) pool ->Hits++;
+    else                 pool ->Misses++;
+
+    _cmsUnlockMutex(ContextID, pool ->Mutex);
+    if (hShared != NULL) return hShared;
+
+    hProfile = cmsOpenProfileFromMem(ContextID, MemPtr, dwSize);
+    if (hProfile == NULL) return NULL;
+
+    // Transform caches take the content ID, which is computed now, before the profile is shared and
+    // becomes read only. It goes to the header as well, replacing any ID in the block that may not match.
+    Icc = (_cmsICCPROFILE*) hProfile;
+    if (!_cmsGetProfileContentID(ContextID, hProfile, &Icc ->ProfileID)) {
+        cmsCloseProfile(ContextID, hProfile);
+        return NULL;
+    }
+
+    e = (_cmsProfilePoolEntry*) _cmsMalloc(ContextID, sizeof(_cmsProfilePoolEntry));
+    if (e == NULL) return hProfile;     // Just not pooled
+
+    e ->Hash = Hash;
+    e ->Size = dwSize;
+    e ->Decoded = 0;
+    e ->hProfile = hProfile;
+
+    if (!_cmsLockMutex(ContextID, pool ->Mutex)) {
+        _cmsFree(ContextID, e);
+        return hProfile;
+    }
+
+    // Some other thread may have been faster
+    hShared = LookupProfilePool(pool, &Hash, dwSize);
+    if (hShared != NULL) {
+
+        _cmsUnlockMutex(ContextID, pool ->Mutex);
+        _cmsFree(ContextID, e);
+        cmsCloseProfile(ContextID, hProfile);
+        return hShared;
+    }
+
+    // One reference for the pool and one for the caller
+    Icc ->PoolRefs = 2;
+
+    e ->Next = pool ->Head;
+    pool ->Head = e;
+    pool ->UsedBytes += dwSize;
+
+    Evicted = TrimProfilePool(pool, pool ->MaxBytes);
+
+    _cmsUnlockMutex(ContextID, pool ->Mutex);
+
+    FreeProfilePoolEntries(ContextID, Evicted);
+    return hProfile;
+}
+
+// Pooled profiles are shared, so they cannot be modified
+cmsBool _cmsIsPooledProfile(cmsContext ContextID, _cmsICCPROFILE* Icc)
+{
+    if (Icc ->PoolRefs == 0) return FALSE;
+
+    cmsSignalError(ContextID, cmsERROR_NOT_SUITABLE, "Pooled profiles are read only");
+    return TRUE;
+}
+
 
 // Dump tag contents. If the profile is being modified, untouched tags are copied from FileOrig
 static
@@ -1571,6 +2157,8 @@ void freeOneTag(cmsContext ContextID, _cmsICCPROFILE* Icc, cmsUInt32Number i)
 		}
 		Icc->TagPtrs[i] = NULL;
 	}
+
+    Icc->TagMemory[i] = 0;
 }
 
 // Closes a profile freeing any involved resources
@@ -1582,6 +2170,9 @@ cmsBool CMSEXPORT cmsCloseProfile(cmsContext ContextID, cmsHPROFILE hProfile)
 
     if (!Icc) return FALSE;
 
+    // Other handles from the profile pool are still alive
+    if (Icc ->PoolRefs != 0 && _cmsAdjustReferenceCount(&Icc ->PoolRefs, -1) > 0) return TRUE;
+
     // Was open in write mode?
     if (Icc ->IsWrite) {
 
@@ -1628,18 +2219,193 @@ cmsBool IsTypeSupported(cmsTagDescriptor* TagDescriptor, cmsTagTypeSignature Typ
 
 
 // That's the main read function
+// Checks a tag already in memory can be returned as the requested signature
+static
+cmsBool IsCookedTagUsable(cmsContext ContextID, _cmsICCPROFILE* Icc, int n, cmsTagSignature sig)
+{
+    cmsTagTypeSignature BaseType;
+    cmsTagDescriptor*  TagDescriptor;
+
+    if (Icc->TagTypeHandlers[n] == NULL) return FALSE;
+
+    // Sanity check
+    BaseType = Icc->TagTypeHandlers[n]->Signature;
+    if (BaseType == 0) return FALSE;
+
+    TagDescriptor = _cmsGetTagDescriptor(ContextID, sig);
+    if (TagDescriptor == NULL) return FALSE;
+
+    if (!IsTypeSupported(TagDescriptor, BaseType)) return FALSE;
+
+    return !Icc ->TagSaveAsRaw[n];  // We don't support read raw tags as cooked
+}
+
+// Decoded tags budget -----------------------------------------------------------------------------------------------
+
+// Rough size of a decoded pipeline. Only the tables really matter. Sizes beyond 4G are clipped, as no budget could hold them
+static
+cmsUInt32Number DecodedPipelineSize(cmsContext ContextID, const cmsPipeline* Lut)
+{
+    cmsStage* mpe;
+    cmsUInt32Number i, j;
+    size_t Size = sizeof(cmsPipeline);
+
+    for (mpe = cmsPipelineGetPtrToFirstStage(ContextID, Lut); mpe != NULL; mpe = cmsStageNext(ContextID, mpe)) {
+
+        Size += sizeof(cmsStage);
+
+        switch (cmsStageType(ContextID, mpe)) {
+
+        case cmsSigCLutElemType: {
+
+            _cmsStageCLutData* Data = (_cmsStageCLutData*) cmsStageData(ContextID, mpe);
+
+            Size += (size_t) Data ->nEntries * (Data ->HasFloatValues ? sizeof(cmsFloat32Number) : sizeof(cmsUInt16Number));
+            }
+            break;
+
+        case cmsSigCurveSetElemType: {
+
+            _cmsStageToneCurvesData* Data = (_cmsStageToneCurvesData*) cmsStageData(ContextID, mpe);
+
+            for (i=0; i < Data ->nCurves; i++) {
+
+                cmsToneCurve* Curve = Data ->TheCurves[i];
+
+                Size += sizeof(cmsToneCurve) + (size_t) Curve ->nEntries * sizeof(cmsUInt16Number);
+                for (j=0; j < Curve ->nSegments; j++)
+                    Size += sizeof(cmsCurveSegment) + (size_t) Curve ->Segments[j].nGridPoints * sizeof(cmsFloat32Number);
+            }
+            }
+            break;
+
+        case cmsSigMatrixElemType:
+            Size += (size_t) (cmsStageInputChannels(ContextID, mpe) + 1) * cmsStageOutputChannels(ContextID, mpe) * sizeof(cmsFloat64Number);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return Size > 0xFFFFFFFFU ? 0xFFFFFFFFU : (cmsUInt32Number) Size;
+}
+
+// Size of a decoded tag if it is worth releasing, zero otherwise. Only LUT based tags are, as the rest are small and
+// some of them (as the matrix-shaper curves) are used by the caller together with other tags.
+static
+cmsUInt32Number DecodedTagSize(cmsContext ContextID, cmsTagTypeSignature Type, void* Data)
+{
+    switch (Type) {
+
+    case cmsSigLut8Type:
+    case cmsSigLut16Type:
+    case cmsSigLutAtoBType:
+    case cmsSigLutBtoAType:
+    case cmsSigMultiProcessElementType:
+        return DecodedPipelineSize(ContextID, (cmsPipeline*) Data);
+
+    default:
+        return 0;
+    }
+}
+
+// Releases the least recently read tags until the decoded ones fit in MaxBytes. Tag Keep is never released.
+// Released tags are decoded again on next cmsReadTag. Profile must be locked. Returns the number of tags released.
+static
+cmsUInt32Number TrimDecodedTags(cmsContext ContextID, _cmsICCPROFILE* Icc, cmsUInt32Number MaxBytes, int Keep)
+{
+    cmsUInt32Number i, nReleased = 0;
+    cmsUInt64Number Used;
+    int Oldest;
+
+    for (;;) {
+
+        Used = 0;
+        Oldest = -1;
+
+        for (i=0; i < Icc ->TagCount; i++) {
+
+            if (Icc ->TagMemory[i] == 0 || Icc ->TagPtrs[i] == NULL) continue;
+
+            Used += Icc ->TagMemory[i];
+
+            if ((int) i != Keep && (Oldest < 0 || Icc ->TagLastUse[i] < Icc ->TagLastUse[Oldest]))
+                Oldest = (int) i;
+        }
+
+        if (Used <= MaxBytes || Oldest < 0) break;
+
+        freeOneTag(ContextID, Icc, (cmsUInt32Number) Oldest);
+        nReleased++;
+    }
+
+    return nReleased;
+}
+
+// Sets the memory budget for decoded LUT tags. Zero means no limit. Released tags are freed at once, so pooled
+// profiles, whose tags other threads may be using, cannot have a budget. Their decoded tags count in the pool size.
+cmsBool CMSEXPORT cmsSetDecodedTagsBudget(cmsContext ContextID, cmsHPROFILE hProfile, cmsUInt32Number MaxBytes)
+{
+    _cmsICCPROFILE* Icc = (_cmsICCPROFILE*) hProfile;
+
+    if (_cmsIsPooledProfile(ContextID, Icc)) return FALSE;
+    if (!_cmsLockMutex(ContextID, Icc ->UsrMutex)) return FALSE;
+
+    Icc ->DecodedBudget = MaxBytes;
+    if (MaxBytes != 0)
+        TrimDecodedTags(ContextID, Icc, MaxBytes, -1);
+
+    _cmsUnlockMutex(ContextID, Icc ->UsrMutex);
+    return TRUE;
+}
+
+// Releases all decoded LUT tags that can be read again. Not on pooled profiles, as above
+cmsUInt32Number CMSEXPORT cmsDropDecodedTags(cmsContext ContextID, cmsHPROFILE hProfile)
+{
+    _cmsICCPROFILE* Icc = (_cmsICCPROFILE*) hProfile;
+    cmsUInt32Number nReleased;
+
+    if (_cmsIsPooledProfile(ContextID, Icc)) return 0;
+    if (!_cmsLockMutex(ContextID, Icc ->UsrMutex)) return 0;
+
+    nReleased = TrimDecodedTags(ContextID, Icc, 0, -1);
+
+    _cmsUnlockMutex(ContextID, Icc ->UsrMutex);
+    return nReleased;
+}
+
+// Read a tag from the profile, parsing it the first time. Parsed tags are published with release semantics, so
+// profiles shared across threads return them without locking. Writing tags on a profile that other threads are
+// reading is not supported. Only the parsing takes the mutex and, on memory based profiles (including memory
+// mapped files), the mutex is not held while parsing, so several tags may be parsed at the same time. Profiles with
+// a budget for decoded tags always lock, as they keep track of the last use of each tag.
 void* CMSEXPORT cmsReadTag(cmsContext ContextID, cmsHPROFILE hProfile, cmsTagSignature sig)
 {
     _cmsICCPROFILE* Icc = (_cmsICCPROFILE*) hProfile;
     cmsIOHANDLER* io;
+    cmsIOHANDLER LocalIO;
+    FILEMEM LocalMem;
     cmsTagTypeHandler* TypeHandler;
     cmsTagTypeHandler LocalTypeHandler;
     cmsTagDescriptor*  TagDescriptor;
     cmsTagTypeSignature BaseType;
     cmsUInt32Number Offset, TagSize;
-    cmsUInt32Number ElemCount;
+    cmsUInt32Number ElemCount, PoolCharge;
+    cmsBool Unlocked = FALSE;
+    void* Data;
     int n;
 
+#ifdef CMS_ATOMIC_POINTERS
+
+    // Fast path, the tag is already in memory
+    n = _cmsSearchTag(ContextID, Icc, sig, TRUE);
+    if (n < 0) return NULL;
+
+    Data = _cmsAtomicLoadPtr(&Icc -> TagPtrs[n]);
+    if (Data != NULL && Icc ->DecodedBudget == 0 && IsCookedTagUsable(ContextID, Icc, n, sig)) return Data;
+#endif
+
     if (!_cmsLockMutex(ContextID, Icc ->UsrMutex)) return NULL;
 
     n = _cmsSearchTag(ContextID, Icc, sig, TRUE);
@@ -1653,21 +2419,18 @@ void* CMSEXPORT cmsReadTag(cmsContext ContextID, cmsHPROFILE hProfile, cmsTagSig
     // If the element is already in memory, return the pointer
     if (Icc -> TagPtrs[n]) {
 
-        if (Icc->TagTypeHandlers[n] == NULL) goto Error;
-
-        // Sanity check
-        BaseType = Icc->TagTypeHandlers[n]->Signature;
-        if (BaseType == 0) goto Error;
+        if (!IsCookedTagUsable(ContextID, Icc, n, sig)) {
 
-        TagDescriptor = _cmsGetTagDescriptor(ContextID, sig);
-        if (TagDescriptor == NULL) goto Error;
-
-        if (!IsTypeSupported(TagDescriptor, BaseType)) goto Error;
+            freeOneTag(ContextID, Icc, n);
+            _cmsUnlockMutex(ContextID, Icc ->UsrMutex);
+            return NULL;
+        }
 
-        if (Icc ->TagSaveAsRaw[n]) goto Error;  // We don't support read raw tags as cooked
+        Icc ->TagLastUse[n] = ++Icc ->TagClock;
+        Data = Icc -> TagPtrs[n];
 
         _cmsUnlockMutex(ContextID, Icc ->UsrMutex);
-        return Icc -> TagPtrs[n];
+        return Data;
     }
 
     // We need to read it. Get the offset and size to the file
@@ -1684,6 +2447,21 @@ void* CMSEXPORT cmsReadTag(cmsContext ContextID, cmsHPROFILE hProfile, cmsTagSig
         goto Error;
     }
 
+    // Memory blocks don't change while reading, so a private position on the same block lets other threads go on
+    if (io ->Read == MemoryRead && !Icc ->IsWrite) {
+
+        LocalMem = *(FILEMEM*) io ->stream;
+        LocalMem.FreeBlockOnClose = FALSE;
+        LocalMem.IsMapped = FALSE;
+
+        LocalIO = *io;
+        LocalIO.stream = (void*) &LocalMem;
+        io = &LocalIO;
+
+        _cmsUnlockMutex(ContextID, Icc ->UsrMutex);
+        Unlocked = TRUE;
+    }
+
     // Seek to its location
     if (!io -> Seek(ContextID, io, Offset))
         goto Error;
@@ -1716,14 +2494,12 @@ void* CMSEXPORT cmsReadTag(cmsContext ContextID, cmsHPROFILE hProfile, cmsTagSig
 
 
     // Read the tag
-    Icc -> TagTypeHandlers[n] = TypeHandler;
-
     LocalTypeHandler.ICCVersion = Icc ->Version;
-    Icc -> TagPtrs[n] = LocalTypeHandler.ReadPtr(ContextID, &LocalTypeHandler, io, &ElemCount, TagSize);
+    Data = LocalTypeHandler.ReadPtr(ContextID, &LocalTypeHandler, io, &ElemCount, TagSize);
 
     // The tag type is supported, but something wrong happened and we cannot read the tag.
     // let know the user about this (although it is just a warning)
-    if (Icc -> TagPtrs[n] == NULL) {
+    if (Data == NULL) {
 
         char String[5];
 
@@ -1741,21 +2517,57 @@ void* CMSEXPORT cmsReadTag(cmsContext ContextID, cmsHPROFILE hProfile, cmsTagSig
         _cmsTagSignature2String(String, sig);
         cmsSignalError(ContextID, cmsERROR_CORRUPTION_DETECTED, "'%s' Inconsistent number of items: expected %d, got %d",
             String, TagDescriptor ->ElemCount, ElemCount);
+
+        LocalTypeHandler.FreePtr(ContextID, &LocalTypeHandler, Data);
         goto Error;
     }
 
+    if (Unlocked) {
+
+        if (!_cmsLockMutex(ContextID, Icc ->UsrMutex)) {
+            LocalTypeHandler.FreePtr(ContextID, &LocalTypeHandler, Data);
+            return NULL;
+        }
+
+        // Some other thread was faster
+        if (Icc -> TagPtrs[n] != NULL) {
+
+            LocalTypeHandler.FreePtr(ContextID, &LocalTypeHandler, Data);
+
+            Data = IsCookedTagUsable(ContextID, Icc, n, sig) ? Icc -> TagPtrs[n] : NULL;
+            _cmsUnlockMutex(ContextID, Icc ->UsrMutex);
+            return Data;
+        }
+    }
+
+    // Publish the data. The handler goes first, as it is needed by anybody who sees the pointer
+    Icc -> TagTypeHandlers[n] = TypeHandler;
+    _cmsAtomicStorePtr(&Icc -> TagPtrs[n], Data);
+
+    // Tags of profiles being created cannot be read again, so they are kept
+    Icc ->TagMemory[n]  = Icc ->IsWrite ? 0 : DecodedTagSize(ContextID, BaseType, Data);
+    Icc ->TagLastUse[n] = ++Icc ->TagClock;
+
+    if (Icc ->DecodedBudget != 0)
+        TrimDecodedTags(ContextID, Icc, Icc ->DecodedBudget, n);
+
+    PoolCharge = Icc ->PoolRefs != 0 ? Icc ->TagMemory[n] : 0;
 
-    // Return the data
     _cmsUnlockMutex(ContextID, Icc ->UsrMutex);
-    return Icc -> TagPtrs[n];
 
+    // The caller holds a handle, so the profile stays alive even if the pool evicts it
+    if (PoolCharge != 0)
+        ChargeProfilePool(ContextID, hProfile, PoolCharge);
 
-    // Return error and unlock the data
+    return Data;
+
+
+    // Return error and unlock the data. Nothing has been stored in the profile
 Error:
 
-    freeOneTag(ContextID, Icc, n);
-    
-    _cmsUnlockMutex(ContextID, Icc ->UsrMutex);
+    if (!Unlocked)
+        _cmsUnlockMutex(ContextID, Icc ->UsrMutex);
+
     return NULL;
 }
 
@@ -1790,6 +2602,9 @@ cmsBool CMSEXPORT cmsWriteTag(cmsContext ContextID, cmsHPROFILE hProfile, cmsTag
     cmsFloat64Number Version;
     char TypeString[5], SigString[5];
 
+    if (_cmsIsPooledProfile(ContextID, Icc)) return FALSE;
+    ContentsChanged(Icc);
+
     if (!_cmsLockMutex(ContextID, Icc ->UsrMutex)) return FALSE;
 
     // To delete tags.
@@ -2027,6 +2842,9 @@ cmsBool CMSEXPORT cmsWriteRawTag(cmsContext ContextID, cmsHPROFILE hProfile, cms
     _cmsICCPROFILE* Icc = (_cmsICCPROFILE*) hProfile;
     int i;
 
+    if (_cmsIsPooledProfile(ContextID, Icc)) return FALSE;
+    ContentsChanged(Icc);
+
     if (!_cmsLockMutex(ContextID, Icc ->UsrMutex)) return 0;
 
     if (!_cmsNewTag(ContextID, Icc, sig, &i)) {
@@ -2058,6 +2876,9 @@ cmsBool CMSEXPORT cmsLinkTag(cmsContext ContextID, cmsHPROFILE hProfile, cmsTagS
     _cmsICCPROFILE* Icc = (_cmsICCPROFILE*) hProfile;
     int i;
 
+    if (_cmsIsPooledProfile(ContextID, Icc)) return FALSE;
+    ContentsChanged(Icc);
+
      if (!_cmsLockMutex(ContextID, Icc ->UsrMutex)) return FALSE;
 
     if (!_cmsNewTag(ContextID, Icc, sig, &i)) {
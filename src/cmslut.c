@@ -88,18 +88,38 @@ void EvaluateIdentity(cmsContext ContextID, const cmsFloat32Number In[],
     memmove(Out, In, mpe ->InputChannels * sizeof(cmsFloat32Number));
 }
 
+static
+void EvaluateIdentityN(cmsContext ContextID, const cmsFloat32Number In[],
+                             cmsFloat32Number Out[],
+                             cmsUInt32Number nPixels, cmsUInt32Number Stride,
+                       const cmsStage *mpe)
+{
+    cmsUInt32Number i;
+    cmsUNUSED_PARAMETER(ContextID);
+
+    for (i=0; i < mpe ->InputChannels; i++)
+        memmove(Out + i * Stride, In + i * Stride, nPixels * sizeof(cmsFloat32Number));
+}
+
 
 cmsStage* CMSEXPORT cmsStageAllocIdentity(cmsContext ContextID, cmsUInt32Number nChannels)
 {
-    return _cmsStageAllocPlaceholder(ContextID,
+    cmsStage* mpe = _cmsStageAllocPlaceholder(ContextID,
                                    cmsSigIdentityElemType,
                                    nChannels, nChannels,
                                    EvaluateIdentity,
                                    NULL,
                                    NULL,
                                    NULL);
+
+    if (mpe != NULL) mpe ->EvalNPtr = EvaluateIdentityN;
+    return mpe;
  }
 
+// Pipelines may be evaluated on blocks of pixels, one stage at time. Blocks are planar, channel i
+// of pixel k is at [i * Stride + k], and sized to keep both ping-pong buffers in first level cache.
+#define PIPELINE_BLOCK_FLOATS 2048
+
 // Conversion functions. From floating point to 16 bits
 static
 void FromFloatTo16(const cmsFloat32Number In[], cmsUInt16Number Out[], cmsUInt32Number n)
@@ -205,6 +225,34 @@ void EvaluateCurves(cmsContext ContextID, const cmsFloat32Number In[],
     }
 }
 
+static
+void EvaluateCurvesN(cmsContext ContextID, const cmsFloat32Number In[],
+                     cmsFloat32Number Out[],
+                     cmsUInt32Number nPixels, cmsUInt32Number Stride,
+                     const cmsStage *mpe)
+{
+    _cmsStageToneCurvesData* Data;
+    cmsUInt32Number i, k;
+
+    _cmsAssert(mpe != NULL);
+
+    Data = (_cmsStageToneCurvesData*) mpe ->Data;
+    if (Data == NULL) return;
+
+    if (Data ->TheCurves == NULL) return;
+
+    // One curve at time, so its table stays in cache
+    for (i=0; i < Data ->nCurves; i++) {
+
+        const cmsToneCurve* Curve = Data ->TheCurves[i];
+        const cmsFloat32Number* Src = In + i * Stride;
+        cmsFloat32Number* Dst = Out + i * Stride;
+
+        for (k=0; k < nPixels; k++)
+            Dst[k] = _cmsEvalToneCurveFloatWithSlopeLimit(ContextID, Curve, Src[k], mpe ->SlopeLimit);
+    }
+}
+
 static
 void CurveSetElemTypeFree(cmsContext ContextID, cmsStage* mpe)
 {
@@ -284,6 +332,8 @@ cmsStage* _cmsStageAllocToneCurvesWithSlopeLimit(cmsContext ContextID, cmsUInt32
                                      EvaluateCurves, CurveSetDup, CurveSetElemTypeFree, NULL, SlopeLimit );
     if (NewMPE == NULL) return NULL;
 
+    NewMPE ->EvalNPtr = EvaluateCurvesN;
+
     NewElem = (_cmsStageToneCurvesData*) _cmsMallocZero(ContextID, sizeof(_cmsStageToneCurvesData));
     if (NewElem == NULL) {
         cmsStageFree(ContextID, NewMPE);
@@ -364,6 +414,48 @@ void EvaluateMatrix(cmsContext ContextID, const cmsFloat32Number In[],
     // Output in 0..1.0 domain
 }
 
+// Same, on a block. Accumulation order is kept, so results are identical to the per-pixel version
+static
+void EvaluateMatrixN(cmsContext ContextID, const cmsFloat32Number In[],
+                     cmsFloat32Number Out[],
+                     cmsUInt32Number nPixels, cmsUInt32Number Stride,
+                     const cmsStage *mpe)
+{
+    cmsUInt32Number i, j, k, n, Start;
+    _cmsStageMatrixData* Data = (_cmsStageMatrixData*) mpe ->Data;
+    cmsFloat64Number Tmp[64];
+    cmsUNUSED_PARAMETER(ContextID);
+
+    for (Start = 0; Start < nPixels; Start += n) {
+
+        n = nPixels - Start;
+        if (n > 64) n = 64;
+
+        for (i=0; i < mpe ->OutputChannels; i++) {
+
+            for (k=0; k < n; k++)
+                Tmp[k] = 0;
+
+            for (j=0; j < mpe->InputChannels; j++) {
+
+                const cmsFloat32Number* Src = In + j * Stride + Start;
+                cmsFloat64Number m = Data->Double[i*mpe->InputChannels + j];
+
+                for (k=0; k < n; k++)
+                    Tmp[k] += Src[k] * m;
+            }
+
+            if (Data ->Offset != NULL) {
+                for (k=0; k < n; k++)
+                    Tmp[k] += Data->Offset[i];
+            }
+
+            for (k=0; k < n; k++)
+                Out[i * Stride + Start + k] = (cmsFloat32Number) Tmp[k];
+        }
+    }
+}
+
 
 // Duplicate a yet-existing matrix element
 static
@@ -424,6 +516,8 @@ cmsStage*  CMSEXPORT cmsStageAllocMatrix(cmsContext ContextID, cmsUInt32Number R
                                      EvaluateMatrix, MatrixElemDup, MatrixElemTypeFree, NULL );
     if (NewMPE == NULL) return NULL;
 
+    NewMPE ->EvalNPtr = EvaluateMatrixN;
+
 
     NewElem = (_cmsStageMatrixData*) _cmsMallocZero(ContextID, sizeof(_cmsStageMatrixData));
     if (NewElem == NULL) goto Error;
@@ -485,6 +579,62 @@ void EvaluateCLUTfloatIn16(cmsContext ContextID, const cmsFloat32Number In[], cm
 }
 
 
+// Batch versions. Interpolators take packed pixels, so the block is interleaved in chunks
+static
+void EvaluateCLUTfloatN(cmsContext ContextID, const cmsFloat32Number In[], cmsFloat32Number Out[],
+                        cmsUInt32Number nPixels, cmsUInt32Number Stride, const cmsStage *mpe)
+{
+    _cmsStageCLutData* Data = (_cmsStageCLutData*) mpe ->Data;
+    cmsFloat32Number PackedIn[PIPELINE_BLOCK_FLOATS], PackedOut[PIPELINE_BLOCK_FLOATS];
+    cmsUInt32Number nIn = mpe ->InputChannels, nOut = mpe ->OutputChannels;
+    cmsUInt32Number Chunk = PIPELINE_BLOCK_FLOATS / (nIn > nOut ? nIn : nOut);
+    cmsUInt32Number i, k, n, Start;
+
+    for (Start = 0; Start < nPixels; Start += n) {
+
+        n = nPixels - Start;
+        if (n > Chunk) n = Chunk;
+
+        for (i=0; i < nIn; i++)
+            for (k=0; k < n; k++)
+                PackedIn[k * nIn + i] = In[i * Stride + Start + k];
+
+        Data -> Params ->InterpolationN.LerpFloatN(ContextID, PackedIn, PackedOut, n, Data->Params);
+
+        for (i=0; i < nOut; i++)
+            for (k=0; k < n; k++)
+                Out[i * Stride + Start + k] = PackedOut[k * nOut + i];
+    }
+}
+
+static
+void EvaluateCLUTfloatIn16N(cmsContext ContextID, const cmsFloat32Number In[], cmsFloat32Number Out[],
+                            cmsUInt32Number nPixels, cmsUInt32Number Stride, const cmsStage *mpe)
+{
+    _cmsStageCLutData* Data = (_cmsStageCLutData*) mpe ->Data;
+    cmsUInt16Number PackedIn[PIPELINE_BLOCK_FLOATS], PackedOut[PIPELINE_BLOCK_FLOATS];
+    cmsUInt32Number nIn = mpe ->InputChannels, nOut = mpe ->OutputChannels;
+    cmsUInt32Number Chunk = PIPELINE_BLOCK_FLOATS / (nIn > nOut ? nIn : nOut);
+    cmsUInt32Number i, k, n, Start;
+
+    for (Start = 0; Start < nPixels; Start += n) {
+
+        n = nPixels - Start;
+        if (n > Chunk) n = Chunk;
+
+        for (i=0; i < nIn; i++)
+            for (k=0; k < n; k++)
+                PackedIn[k * nIn + i] = _cmsQuickSaturateWord(In[i * Stride + Start + k] * 65535.0);
+
+        Data -> Params ->InterpolationN.Lerp16N(ContextID, PackedIn, PackedOut, n, Data->Params);
+
+        for (i=0; i < nOut; i++)
+            for (k=0; k < n; k++)
+                Out[i * Stride + Start + k] = (cmsFloat32Number) PackedOut[k * nOut + i] / 65535.0F;
+    }
+}
+
+
 // Given an hypercube of b dimensions, with Dims[] number of nodes by dimension, calculate the total amount of nodes
 static
 cmsUInt32Number CubeSize(const cmsUInt32Number Dims[], cmsUInt32Number b)
@@ -595,6 +745,8 @@ cmsStage* CMSEXPORT cmsStageAllocCLut16bitGranular(cmsContext ContextID,
 
     if (NewMPE == NULL) return NULL;
 
+    NewMPE ->EvalNPtr = EvaluateCLUTfloatIn16N;
+
     NewElem = (_cmsStageCLutData*) _cmsMallocZero(ContextID, sizeof(_cmsStageCLutData));
     if (NewElem == NULL) {
         cmsStageFree(ContextID, NewMPE);
@@ -685,6 +837,8 @@ cmsStage* CMSEXPORT cmsStageAllocCLutFloatGranular(cmsContext ContextID, const c
                                              EvaluateCLUTfloat, CLUTElemDup, CLutElemTypeFree, NULL);
     if (NewMPE == NULL) return NULL;
 
+    NewMPE ->EvalNPtr = EvaluateCLUTfloatN;
+
 
     NewElem = (_cmsStageCLutData*) _cmsMallocZero(ContextID, sizeof(_cmsStageCLutData));
     if (NewElem == NULL) {
@@ -772,40 +926,46 @@ cmsUInt16Number CMSEXPORT _cmsQuantizeVal(cmsFloat64Number i, cmsUInt32Number Ma
 }
 
 
-// This routine does a sweep on whole input space, and calls its callback
-// function on knots. returns TRUE if all ok, FALSE otherwise.
-cmsBool CMSEXPORT cmsStageSampleCLut16bit(cmsContext ContextID, cmsStage* mpe, cmsSAMPLER16 Sampler, void * Cargo, cmsUInt32Number dwFlags)
-{
-    int i, t, index, rest;
-    cmsUInt32Number nTotalPoints;
-    cmsUInt32Number nInputs, nOutputs;
-    cmsUInt32Number* nSamples;
-    cmsUInt16Number In[MAX_INPUT_DIMENSIONS+1], Out[MAX_STAGE_CHANNELS];
-    _cmsStageCLutData* clut;
+// Grid nodes are independent, so samplers declared as thread-safe get the node index space
+// split in ranges that go to the parallelization plug-in. Each range has its own In/Out scratch.
+#define SAMPLER_NODES_PER_TASK  1024
+#define SAMPLER_MAX_TASKS       64
 
-    if (mpe == NULL) return FALSE;
+typedef struct {
 
-    clut = (_cmsStageCLutData*) mpe->Data;
+    _cmsStageCLutData* clut;
+    cmsSAMPLER16       Sampler16;       // Only one of these is set
+    cmsSAMPLERFLOAT    SamplerFloat;
+    cmsSAMPLER16N      Sampler16N;
+    cmsSAMPLERFLOATN   SamplerFloatN;
+    void*              Cargo;
+    cmsUInt32Number    dwFlags;
 
-    if (clut == NULL) return FALSE;
+    cmsUInt32Number    nTotalPoints;
+    cmsUInt32Number    nUnits;          // Nodes, or rows for row samplers
+    cmsUInt32Number    nTasks;
+    cmsBool            Result[SAMPLER_MAX_TASKS];
 
-    nSamples = clut->Params ->nSamples;
-    nInputs  = clut->Params ->nInputs;
-    nOutputs = clut->Params ->nOutputs;
+} _cmsSamplingJob;
 
-    if (nInputs <= 0) return FALSE;
-    if (nOutputs <= 0) return FALSE;
-    if (nInputs > MAX_INPUT_DIMENSIONS) return FALSE;
-    if (nOutputs >= MAX_STAGE_CHANNELS) return FALSE;
+
+// Samples nodes First..Last-1 on 16 bits. Returns FALSE if the sampler fails
+static
+cmsBool SampleRange16(cmsContext ContextID, const _cmsSamplingJob* job, cmsUInt32Number First, cmsUInt32Number Last)
+{
+    int t;
+    cmsUInt32Number i, index, rest;
+    _cmsStageCLutData* clut = job ->clut;
+    cmsUInt32Number* nSamples = clut->Params ->nSamples;
+    cmsUInt32Number nInputs  = clut->Params ->nInputs;
+    cmsUInt32Number nOutputs = clut->Params ->nOutputs;
+    cmsUInt16Number In[MAX_INPUT_DIMENSIONS+1], Out[MAX_STAGE_CHANNELS];
 
     memset(In, 0, sizeof(In));
     memset(Out, 0, sizeof(Out));
 
-    nTotalPoints = CubeSize(nSamples, nInputs);
-    if (nTotalPoints == 0) return FALSE;
-
-    index = 0;
-    for (i = 0; i < (int) nTotalPoints; i++) {
+    index = First * nOutputs;
+    for (i = First; i < Last; i++) {
 
         rest = i;
         for (t = (int)nInputs - 1; t >= 0; --t) {
@@ -822,10 +982,10 @@ cmsBool CMSEXPORT cmsStageSampleCLut16bit(cmsContext ContextID, cmsStage* mpe, c
                 Out[t] = clut->Tab.T[index + t];
         }
 
-        if (!Sampler(ContextID, In, Out, Cargo))
+        if (!job ->Sampler16(ContextID, In, Out, job ->Cargo))
             return FALSE;
 
-        if (!(dwFlags & SAMPLER_INSPECT)) {
+        if (!(job ->dwFlags & SAMPLER_INSPECT)) {
 
             if (clut ->Tab.T != NULL) {
                 for (t=0; t < (int) nOutputs; t++)
@@ -839,36 +999,23 @@ cmsBool CMSEXPORT cmsStageSampleCLut16bit(cmsContext ContextID, cmsStage* mpe, c
     return TRUE;
 }
 
-// Same as anterior, but for floating point
-cmsBool CMSEXPORT cmsStageSampleCLutFloat(cmsContext ContextID, cmsStage* mpe, cmsSAMPLERFLOAT Sampler, void * Cargo, cmsUInt32Number dwFlags)
-{
-    int i, t, index, rest;
-    cmsUInt32Number nTotalPoints;
-    cmsUInt32Number nInputs, nOutputs;
-    cmsUInt32Number* nSamples;
+// Same, for floating point
+static
+cmsBool SampleRangeFloat(cmsContext ContextID, const _cmsSamplingJob* job, cmsUInt32Number First, cmsUInt32Number Last)
+{
+    int t;
+    cmsUInt32Number i, index, rest;
+    _cmsStageCLutData* clut = job ->clut;
+    cmsUInt32Number* nSamples = clut->Params ->nSamples;
+    cmsUInt32Number nInputs  = clut->Params ->nInputs;
+    cmsUInt32Number nOutputs = clut->Params ->nOutputs;
     cmsFloat32Number In[MAX_INPUT_DIMENSIONS+1], Out[MAX_STAGE_CHANNELS];
-    _cmsStageCLutData* clut;
 
-    if (mpe == NULL) return FALSE;
-
-    clut = (_cmsStageCLutData*)mpe->Data;
-
-    if (clut == NULL) return FALSE;
-
-    nSamples = clut->Params ->nSamples;
-    nInputs  = clut->Params ->nInputs;
-    nOutputs = clut->Params ->nOutputs;
-
-    if (nInputs <= 0) return FALSE;
-    if (nOutputs <= 0) return FALSE;
-    if (nInputs  > MAX_INPUT_DIMENSIONS) return FALSE;
-    if (nOutputs >= MAX_STAGE_CHANNELS) return FALSE;
-
-    nTotalPoints = CubeSize(nSamples, nInputs);
-    if (nTotalPoints == 0) return FALSE;
+    memset(In, 0, sizeof(In));
+    memset(Out, 0, sizeof(Out));
 
-    index = 0;
-    for (i = 0; i < (int)nTotalPoints; i++) {
+    index = First * nOutputs;
+    for (i = First; i < Last; i++) {
 
         rest = i;
         for (t = (int) nInputs-1; t >=0; --t) {
@@ -885,10 +1032,10 @@ cmsBool CMSEXPORT cmsStageSampleCLutFloat(cmsContext ContextID, cmsStage* mpe, c
                 Out[t] = clut->Tab.TFloat[index + t];
         }
 
-        if (!Sampler(ContextID, In, Out, Cargo))
+        if (!job ->SamplerFloat(ContextID, In, Out, job ->Cargo))
             return FALSE;
 
-        if (!(dwFlags & SAMPLER_INSPECT)) {
+        if (!(job ->dwFlags & SAMPLER_INSPECT)) {
 
             if (clut ->Tab.TFloat != NULL) {
                 for (t=0; t < (int) nOutputs; t++)
@@ -902,6 +1049,243 @@ cmsBool CMSEXPORT cmsStageSampleCLutFloat(cmsContext ContextID, cmsStage* mpe, c
     return TRUE;
 }
 
+// Fills the outer coordinates of a row of nodes, the innermost one goes from 0 to nRow-1
+#define FILL_ROW(In, Row, Quantize)                                         \
+    do {                                                                    \
+        cmsUInt32Number rest = (Row), k;                                    \
+        for (t = (int) nInputs - 2; t >= 0; --t) {                          \
+            cmsUInt32Number Colorant = rest % nSamples[t];                  \
+            rest /= nSamples[t];                                            \
+            for (k = 0; k < nRow; k++)                                      \
+                (In)[k * nInputs + t] = Quantize(_cmsQuantizeVal(Colorant, nSamples[t])); \
+        }                                                                   \
+        for (k = 0; k < nRow; k++)                                          \
+            (In)[k * nInputs + nInputs - 1] = Quantize(_cmsQuantizeVal(k, nRow)); \
+    } while (0)
+
+#define QUANTIZE_16(v)      (v)
+#define QUANTIZE_FLOAT(v)   ((cmsFloat32Number) ((v) / 65535.0))
+
+// Samples rows First..Last-1 on 16 bits, each one in a single call
+static
+cmsBool SampleRows16(cmsContext ContextID, const _cmsSamplingJob* job, cmsUInt32Number First, cmsUInt32Number Last)
+{
+    int t;
+    cmsUInt32Number i, n;
+    _cmsStageCLutData* clut = job ->clut;
+    cmsUInt32Number* nSamples = clut->Params ->nSamples;
+    cmsUInt32Number nInputs  = clut->Params ->nInputs;
+    cmsUInt32Number nOutputs = clut->Params ->nOutputs;
+    cmsUInt32Number nRow = nSamples[nInputs - 1];
+    cmsUInt32Number nRowOut = nRow * nOutputs;
+    cmsUInt16Number *In, *Out;
+    cmsBool rc = TRUE;
+
+    In = (cmsUInt16Number*) _cmsCalloc(ContextID, nRow * (nInputs + nOutputs), sizeof(cmsUInt16Number));
+    if (In == NULL) return FALSE;
+    Out = In + nRow * nInputs;
+
+    for (i = First; i < Last && rc; i++) {
+
+        FILL_ROW(In, i, QUANTIZE_16);
+
+        if (clut ->Tab.T != NULL) {
+            for (n = 0; n < nRowOut; n++)
+                Out[n] = clut->Tab.T[i * nRowOut + n];
+        }
+
+        rc = job ->Sampler16N(ContextID, In, Out, nRow, job ->Cargo);
+
+        if (rc && !(job ->dwFlags & SAMPLER_INSPECT)) {
+
+            if (clut ->Tab.T != NULL) {
+                for (n = 0; n < nRowOut; n++)
+                    clut->Tab.T[i * nRowOut + n] = Out[n];
+            }
+        }
+    }
+
+    _cmsFree(ContextID, In);
+    return rc;
+}
+
+// Same, for floating point
+static
+cmsBool SampleRowsFloat(cmsContext ContextID, const _cmsSamplingJob* job, cmsUInt32Number First, cmsUInt32Number Last)
+{
+    int t;
+    cmsUInt32Number i, n;
+    _cmsStageCLutData* clut = job ->clut;
+    cmsUInt32Number* nSamples = clut->Params ->nSamples;
+    cmsUInt32Number nInputs  = clut->Params ->nInputs;
+    cmsUInt32Number nOutputs = clut->Params ->nOutputs;
+    cmsUInt32Number nRow = nSamples[nInputs - 1];
+    cmsUInt32Number nRowOut = nRow * nOutputs;
+    cmsFloat32Number *In, *Out;
+    cmsBool rc = TRUE;
+
+    In = (cmsFloat32Number*) _cmsCalloc(ContextID, nRow * (nInputs + nOutputs), sizeof(cmsFloat32Number));
+    if (In == NULL) return FALSE;
+    Out = In + nRow * nInputs;
+
+    for (i = First; i < Last && rc; i++) {
+
+        FILL_ROW(In, i, QUANTIZE_FLOAT);
+
+        if (clut ->Tab.TFloat != NULL) {
+            for (n = 0; n < nRowOut; n++)
+                Out[n] = clut->Tab.TFloat[i * nRowOut + n];
+        }
+
+        rc = job ->SamplerFloatN(ContextID, In, Out, nRow, job ->Cargo);
+
+        if (rc && !(job ->dwFlags & SAMPLER_INSPECT)) {
+
+            if (clut ->Tab.TFloat != NULL) {
+                for (n = 0; n < nRowOut; n++)
+                    clut->Tab.TFloat[i * nRowOut + n] = Out[n];
+            }
+        }
+    }
+
+    _cmsFree(ContextID, In);
+    return rc;
+}
+
+#undef FILL_ROW
+#undef QUANTIZE_16
+#undef QUANTIZE_FLOAT
+
+// Samples one of the ranges
+static
+void SamplingTask(cmsContext ContextID, cmsUInt32Number nTask, void* Cargo)
+{
+    _cmsSamplingJob* job = (_cmsSamplingJob*) Cargo;
+    cmsUInt32Number Size  = job ->nUnits / job ->nTasks;
+    cmsUInt32Number Rest  = job ->nUnits % job ->nTasks;
+    cmsUInt32Number First = nTask * Size + (nTask < Rest ? nTask : Rest);
+    cmsUInt32Number Last  = First + Size + (nTask < Rest ? 1 : 0);
+
+    if (job ->Sampler16 != NULL)
+        job ->Result[nTask] = SampleRange16(ContextID, job, First, Last);
+    else
+    if (job ->SamplerFloat != NULL)
+        job ->Result[nTask] = SampleRangeFloat(ContextID, job, First, Last);
+    else
+    if (job ->Sampler16N != NULL)
+        job ->Result[nTask] = SampleRows16(ContextID, job, First, Last);
+    else
+        job ->Result[nTask] = SampleRowsFloat(ContextID, job, First, Last);
+}
+
+// Validates the CLUT and does the sweep, in parallel if allowed
+static
+cmsBool SampleCLut(cmsContext ContextID, cmsStage* mpe, _cmsSamplingJob* job)
+{
+    cmsUInt32Number i, nInputs, nOutputs;
+    _cmsStageCLutData* clut;
+    cmsBool rc = TRUE;
+
+    if (mpe == NULL) return FALSE;
+
+    clut = (_cmsStageCLutData*) mpe->Data;
+
+    if (clut == NULL) return FALSE;
+
+    nInputs  = clut->Params ->nInputs;
+    nOutputs = clut->Params ->nOutputs;
+
+    if (nInputs <= 0) return FALSE;
+    if (nOutputs <= 0) return FALSE;
+    if (nInputs > MAX_INPUT_DIMENSIONS) return FALSE;
+    if (nOutputs >= MAX_STAGE_CHANNELS) return FALSE;
+
+    job ->clut = clut;
+    job ->nTotalPoints = CubeSize(clut->Params ->nSamples, nInputs);
+    if (job ->nTotalPoints == 0) return FALSE;
+
+    job ->nUnits = job ->nTotalPoints;
+    if (job ->Sampler16N != NULL || job ->SamplerFloatN != NULL)
+        job ->nUnits /= clut->Params ->nSamples[nInputs - 1];
+
+    job ->nTasks = 1;
+    if (job ->dwFlags & SAMPLER_THREADSAFE) {
+
+        job ->nTasks = job ->nTotalPoints / SAMPLER_NODES_PER_TASK;
+        if (job ->nTasks > SAMPLER_MAX_TASKS) job ->nTasks = SAMPLER_MAX_TASKS;
+        if (job ->nTasks > job ->nUnits) job ->nTasks = job ->nUnits;
+        if (job ->nTasks < 1) job ->nTasks = 1;
+    }
+
+    if (job ->nTasks == 1) {
+
+        SamplingTask(ContextID, 0, job);
+        return job ->Result[0];
+    }
+
+    _cmsParallelRun(ContextID, job ->nTasks, SamplingTask, job);
+
+    for (i = 0; i < job ->nTasks; i++)
+        rc = rc && job ->Result[i];
+
+    return rc;
+}
+
+
+// This routine does a sweep on whole input space, and calls its callback
+// function on knots. returns TRUE if all ok, FALSE otherwise.
+cmsBool CMSEXPORT cmsStageSampleCLut16bit(cmsContext ContextID, cmsStage* mpe, cmsSAMPLER16 Sampler, void * Cargo, cmsUInt32Number dwFlags)
+{
+    _cmsSamplingJob job;
+
+    memset(&job, 0, sizeof(job));
+    job.Sampler16 = Sampler;
+    job.Cargo     = Cargo;
+    job.dwFlags   = dwFlags;
+
+    return SampleCLut(ContextID, mpe, &job);
+}
+
+// Same as anterior, but for floating point
+cmsBool CMSEXPORT cmsStageSampleCLutFloat(cmsContext ContextID, cmsStage* mpe, cmsSAMPLERFLOAT Sampler, void * Cargo, cmsUInt32Number dwFlags)
+{
+    _cmsSamplingJob job;
+
+    memset(&job, 0, sizeof(job));
+    job.SamplerFloat = Sampler;
+    job.Cargo        = Cargo;
+    job.dwFlags      = dwFlags;
+
+    return SampleCLut(ContextID, mpe, &job);
+}
+
+// Row samplers get whole lines of nodes along the innermost dimension, so they can
+// evaluate a pipeline or a transform once per line instead of once per node.
+cmsBool CMSEXPORT cmsStageSampleCLut16bitN(cmsContext ContextID, cmsStage* mpe, cmsSAMPLER16N Sampler, void * Cargo, cmsUInt32Number dwFlags)
+{
+    _cmsSamplingJob job;
+
+    memset(&job, 0, sizeof(job));
+    job.Sampler16N = Sampler;
+    job.Cargo      = Cargo;
+    job.dwFlags    = dwFlags;
+
+    return SampleCLut(ContextID, mpe, &job);
+}
+
+// Same as anterior, but for floating point
+cmsBool CMSEXPORT cmsStageSampleCLutFloatN(cmsContext ContextID, cmsStage* mpe, cmsSAMPLERFLOATN Sampler, void * Cargo, cmsUInt32Number dwFlags)
+{
+    _cmsSamplingJob job;
+
+    memset(&job, 0, sizeof(job));
+    job.SamplerFloatN = Sampler;
+    job.Cargo         = Cargo;
+    job.dwFlags       = dwFlags;
+
+    return SampleCLut(ContextID, mpe, &job);
+}
+
 
 
 // This routine does a sweep on whole input space, and calls its callback
@@ -1000,11 +1384,41 @@ void EvaluateLab2XYZ(cmsContext ContextID, const cmsFloat32Number In[],
     cmsUNUSED_PARAMETER(mpe);
 }
 
+static
+void EvaluateLab2XYZN(cmsContext ContextID, const cmsFloat32Number In[],
+                      cmsFloat32Number Out[],
+                      cmsUInt32Number nPixels, cmsUInt32Number Stride,
+                      const cmsStage *mpe)
+{
+    cmsCIELab Lab;
+    cmsCIEXYZ XYZ;
+    const cmsFloat64Number XYZadj = MAX_ENCODEABLE_XYZ;
+    cmsUInt32Number k;
+
+    for (k=0; k < nPixels; k++) {
+
+        Lab.L = In[k] * 100.0;
+        Lab.a = In[Stride + k] * 255.0 - 128.0;
+        Lab.b = In[2 * Stride + k] * 255.0 - 128.0;
+
+        cmsLab2XYZ(ContextID, NULL, &XYZ, &Lab);
+
+        Out[k]              = (cmsFloat32Number) ((cmsFloat64Number) XYZ.X / XYZadj);
+        Out[Stride + k]     = (cmsFloat32Number) ((cmsFloat64Number) XYZ.Y / XYZadj);
+        Out[2 * Stride + k] = (cmsFloat32Number) ((cmsFloat64Number) XYZ.Z / XYZadj);
+    }
+
+    cmsUNUSED_PARAMETER(mpe);
+}
+
 
 // No dup or free routines needed, as the structure has no pointers in it.
 cmsStage* CMSEXPORT _cmsStageAllocLab2XYZ(cmsContext ContextID)
 {
-    return _cmsStageAllocPlaceholder(ContextID, cmsSigLab2XYZElemType, 3, 3, EvaluateLab2XYZ, NULL, NULL, NULL);
+    cmsStage* mpe = _cmsStageAllocPlaceholder(ContextID, cmsSigLab2XYZElemType, 3, 3, EvaluateLab2XYZ, NULL, NULL, NULL);
+
+    if (mpe != NULL) mpe ->EvalNPtr = EvaluateLab2XYZN;
+    return mpe;
 }
 
 // ********************************************************************************
@@ -1178,10 +1592,30 @@ void Clipper(cmsContext ContextID, const cmsFloat32Number In[], cmsFloat32Number
        }
 }
 
+static
+void ClipperN(cmsContext ContextID, const cmsFloat32Number In[], cmsFloat32Number Out[],
+              cmsUInt32Number nPixels, cmsUInt32Number Stride, const cmsStage *mpe)
+{
+       cmsUInt32Number i, k;
+       cmsUNUSED_PARAMETER(ContextID);
+
+       for (i = 0; i < mpe->InputChannels; i++) {
+
+              const cmsFloat32Number* Src = In + i * Stride;
+              cmsFloat32Number* Dst = Out + i * Stride;
+
+              for (k = 0; k < nPixels; k++)
+                     Dst[k] = Src[k] < 0 ? 0 : Src[k];
+       }
+}
+
 cmsStage*  _cmsStageClipNegatives(cmsContext ContextID, cmsUInt32Number nChannels)
 {
-       return _cmsStageAllocPlaceholder(ContextID, cmsSigClipNegativesElemType,
+       cmsStage* mpe = _cmsStageAllocPlaceholder(ContextID, cmsSigClipNegativesElemType,
               nChannels, nChannels, Clipper, NULL, NULL, NULL);
+
+       if (mpe != NULL) mpe ->EvalNPtr = ClipperN;
+       return mpe;
 }
 
 // ********************************************************************************
@@ -1213,10 +1647,37 @@ void EvaluateXYZ2Lab(cmsContext ContextID, const cmsFloat32Number In[], cmsFloat
     cmsUNUSED_PARAMETER(mpe);
 }
 
+static
+void EvaluateXYZ2LabN(cmsContext ContextID, const cmsFloat32Number In[], cmsFloat32Number Out[],
+                      cmsUInt32Number nPixels, cmsUInt32Number Stride, const cmsStage *mpe)
+{
+    cmsCIELab Lab;
+    cmsCIEXYZ XYZ;
+    const cmsFloat64Number XYZadj = MAX_ENCODEABLE_XYZ;
+    cmsUInt32Number k;
+
+    for (k=0; k < nPixels; k++) {
+
+        XYZ.X = In[k] * XYZadj;
+        XYZ.Y = In[Stride + k] * XYZadj;
+        XYZ.Z = In[2 * Stride + k] * XYZadj;
+
+        cmsXYZ2Lab(ContextID, NULL, &Lab, &XYZ);
+
+        Out[k]              = (cmsFloat32Number) (Lab.L / 100.0);
+        Out[Stride + k]     = (cmsFloat32Number) ((Lab.a + 128.0) / 255.0);
+        Out[2 * Stride + k] = (cmsFloat32Number) ((Lab.b + 128.0) / 255.0);
+    }
+
+    cmsUNUSED_PARAMETER(mpe);
+}
+
 cmsStage* CMSEXPORT _cmsStageAllocXYZ2Lab(cmsContext ContextID)
 {
-    return _cmsStageAllocPlaceholder(ContextID, cmsSigXYZ2LabElemType, 3, 3, EvaluateXYZ2Lab, NULL, NULL, NULL);
+    cmsStage* mpe = _cmsStageAllocPlaceholder(ContextID, cmsSigXYZ2LabElemType, 3, 3, EvaluateXYZ2Lab, NULL, NULL, NULL);
 
+    if (mpe != NULL) mpe ->EvalNPtr = EvaluateXYZ2LabN;
+    return mpe;
 }
 
 // ********************************************************************************
@@ -1276,6 +1737,13 @@ cmsStage*  CMSEXPORT cmsStageNext(cmsContext ContextID, const cmsStage* mpe)
     return mpe -> Next;
 }
 
+// Plug-in stages may provide a block evaluator. Otherwise, the per-pixel evaluator is used.
+void CMSEXPORT _cmsStageSetEvalN(cmsContext ContextID, cmsStage* mpe, _cmsStageEvalNFn EvalNPtr)
+{
+    cmsUNUSED_PARAMETER(ContextID);
+    mpe ->EvalNPtr = EvalNPtr;
+}
+
 
 // Duplicates an MPE
 cmsStage* CMSEXPORT cmsStageDup(cmsContext ContextID, cmsStage* mpe)
@@ -1295,6 +1763,7 @@ cmsStage* CMSEXPORT cmsStageDup(cmsContext ContextID, cmsStage* mpe)
     if (NewMPE == NULL) return NULL;
 
     NewMPE ->Implements = mpe ->Implements;
+    NewMPE ->EvalNPtr   = mpe ->EvalNPtr;
 
     if (mpe ->DupElemPtr) {
 
@@ -1405,6 +1874,133 @@ void _LUTevalFloat(cmsContext ContextID, const cmsFloat32Number In[], cmsFloat32
 }
 
 
+// Stages lacking a block evaluator are run pixel by pixel
+static
+void EvalStageN(cmsContext ContextID, const cmsFloat32Number In[], cmsFloat32Number Out[],
+                cmsUInt32Number nPixels, cmsUInt32Number Stride, const cmsStage* mpe)
+{
+    cmsFloat32Number Pixel[MAX_STAGE_CHANNELS], Result[MAX_STAGE_CHANNELS];
+    cmsUInt32Number i, k;
+
+    if (mpe ->EvalNPtr != NULL) {
+        mpe ->EvalNPtr(ContextID, In, Out, nPixels, Stride, mpe);
+        return;
+    }
+
+    for (k=0; k < nPixels; k++) {
+
+        for (i=0; i < mpe ->InputChannels; i++)
+            Pixel[i] = In[i * Stride + k];
+
+        mpe ->EvalPtr(ContextID, Pixel, Result, mpe);
+
+        for (i=0; i < mpe ->OutputChannels; i++)
+            Out[i * Stride + k] = Result[i];
+    }
+}
+
+// How many pixels fit in a block, given the widest stage
+static
+cmsUInt32Number BlockStride(const cmsPipeline* lut)
+{
+    cmsStage* mpe;
+    cmsUInt32Number MaxChannels = lut ->InputChannels;
+
+    for (mpe = lut ->Elements; mpe != NULL; mpe = mpe ->Next) {
+
+        if (mpe ->OutputChannels > MaxChannels)
+            MaxChannels = mpe ->OutputChannels;
+    }
+
+    if (MaxChannels == 0) MaxChannels = 1;
+    return PIPELINE_BLOCK_FLOATS / MaxChannels;
+}
+
+// Runs the stages on a block of planar pixels, returns the buffer holding the result
+static
+cmsFloat32Number* EvalBlock(cmsContext ContextID, const cmsPipeline* lut,
+                            cmsFloat32Number Storage[2][PIPELINE_BLOCK_FLOATS],
+                            cmsUInt32Number nPixels, cmsUInt32Number Stride)
+{
+    cmsStage *mpe;
+    int Phase = 0, NextPhase;
+
+    for (mpe = lut ->Elements;
+         mpe != NULL;
+         mpe = mpe ->Next) {
+
+             NextPhase = Phase ^ 1;
+             EvalStageN(ContextID, Storage[Phase], Storage[NextPhase], nPixels, Stride, mpe);
+             Phase = NextPhase;
+    }
+
+    return Storage[Phase];
+}
+
+// Same as _LUTeval16, but on many packed pixels
+static
+void _LUTeval16N(cmsContext ContextID, const cmsUInt16Number In[], cmsUInt16Number Out[],
+                 cmsUInt32Number nPixels, const void* D)
+{
+    cmsPipeline* lut = (cmsPipeline*) D;
+    cmsFloat32Number Storage[2][PIPELINE_BLOCK_FLOATS];
+    cmsFloat32Number* Result;
+    cmsUInt32Number nIn  = lut ->InputChannels;
+    cmsUInt32Number nOut = lut ->OutputChannels;
+    cmsUInt32Number Stride = BlockStride(lut);
+    cmsUInt32Number i, k, n;
+
+    for (; nPixels > 0; nPixels -= n) {
+
+        n = nPixels < Stride ? nPixels : Stride;
+
+        for (i=0; i < nIn; i++)
+            for (k=0; k < n; k++)
+                Storage[0][i * Stride + k] = (cmsFloat32Number) In[k * nIn + i] / 65535.0F;
+
+        Result = EvalBlock(ContextID, lut, Storage, n, Stride);
+
+        for (i=0; i < nOut; i++)
+            for (k=0; k < n; k++)
+                Out[k * nOut + i] = _cmsQuickSaturateWord(Result[i * Stride + k] * 65535.0);
+
+        In  += n * nIn;
+        Out += n * nOut;
+    }
+}
+
+// Same as _LUTevalFloat, but on many packed pixels
+static
+void _LUTevalFloatN(cmsContext ContextID, const cmsFloat32Number In[], cmsFloat32Number Out[],
+                    cmsUInt32Number nPixels, const cmsPipeline* lut)
+{
+    cmsFloat32Number Storage[2][PIPELINE_BLOCK_FLOATS];
+    cmsFloat32Number* Result;
+    cmsUInt32Number nIn  = lut ->InputChannels;
+    cmsUInt32Number nOut = lut ->OutputChannels;
+    cmsUInt32Number Stride = BlockStride(lut);
+    cmsUInt32Number i, k, n;
+
+    for (; nPixels > 0; nPixels -= n) {
+
+        n = nPixels < Stride ? nPixels : Stride;
+
+        for (i=0; i < nIn; i++)
+            for (k=0; k < n; k++)
+                Storage[0][i * Stride + k] = In[k * nIn + i];
+
+        Result = EvalBlock(ContextID, lut, Storage, n, Stride);
+
+        for (i=0; i < nOut; i++)
+            for (k=0; k < n; k++)
+                Out[k * nOut + i] = Result[i * Stride + k];
+
+        In  += n * nIn;
+        Out += n * nOut;
+    }
+}
+
+
 // LUT Creation & Destruction
 cmsPipeline* CMSEXPORT cmsPipelineAlloc(cmsContext ContextID, cmsUInt32Number InputChannels, cmsUInt32Number OutputChannels)
 {
@@ -1421,6 +2017,7 @@ cmsPipeline* CMSEXPORT cmsPipelineAlloc(cmsContext ContextID, cmsUInt32Number In
        NewLUT -> OutputChannels = OutputChannels;
 
        NewLUT ->Eval16Fn    = _LUTeval16;
+       NewLUT ->Eval16NFn   = _LUTeval16N;
        NewLUT ->EvalFloatFn = _LUTevalFloat;
        NewLUT ->DupDataFn   = NULL;
        NewLUT ->FreeDataFn  = NULL;
@@ -1435,6 +2032,12 @@ cmsPipeline* CMSEXPORT cmsPipelineAlloc(cmsContext ContextID, cmsUInt32Number In
        return NewLUT;
 }
 
+// TRUE if the pipeline has no optimized evaluator, so it goes across all stages
+cmsBool _cmsPipelineIsGeneric(const cmsPipeline* Lut)
+{
+    return Lut ->Eval16Fn == _LUTeval16 && Lut ->Data == (void*) Lut;
+}
+
 cmsUInt32Number CMSEXPORT cmsPipelineInputChannels(cmsContext ContextID, const cmsPipeline* lut)
 {
     cmsUNUSED_PARAMETER(ContextID);
@@ -1485,6 +2088,44 @@ void CMSEXPORT cmsPipelineEvalFloat(cmsContext ContextID, const cmsFloat32Number
     lut ->EvalFloatFn(ContextID, In, Out, lut);
 }
 
+
+// Same as cmsPipelineEval16, on nPixels packed pixels
+void CMSEXPORT cmsPipelineEval16N(cmsContext ContextID, const cmsUInt16Number In[], cmsUInt16Number Out[],
+                                  cmsUInt32Number nPixels, const cmsPipeline* lut)
+{
+    cmsUInt32Number k;
+
+    _cmsAssert(lut != NULL);
+
+    if (lut ->Eval16NFn != NULL) {
+        lut ->Eval16NFn(ContextID, In, Out, nPixels, lut->Data);
+        return;
+    }
+
+    for (k=0; k < nPixels; k++) {
+        lut ->Eval16Fn(ContextID, In + k * lut ->InputChannels, Out + k * lut ->OutputChannels, lut->Data);
+    }
+}
+
+
+// Same as cmsPipelineEvalFloat, on nPixels packed pixels
+void CMSEXPORT cmsPipelineEvalFloatN(cmsContext ContextID, const cmsFloat32Number In[], cmsFloat32Number Out[],
+                                     cmsUInt32Number nPixels, const cmsPipeline* lut)
+{
+    cmsUInt32Number k;
+
+    _cmsAssert(lut != NULL);
+
+    if (lut ->EvalFloatFn == _LUTevalFloat) {
+        _LUTevalFloatN(ContextID, In, Out, nPixels, lut);
+        return;
+    }
+
+    for (k=0; k < nPixels; k++) {
+        lut ->EvalFloatFn(ContextID, In + k * lut ->InputChannels, Out + k * lut ->OutputChannels, lut);
+    }
+}
+
 // Duplicates a LUT
 cmsPipeline* CMSEXPORT cmsPipelineDup(cmsContext ContextID, const cmsPipeline* lut)
 {
@@ -1521,6 +2162,7 @@ cmsPipeline* CMSEXPORT cmsPipelineDup(cmsContext ContextID, const cmsPipeline* l
     }
 
     NewLUT ->Eval16Fn    = lut ->Eval16Fn;
+    NewLUT ->Eval16NFn   = lut ->Eval16NFn;
     NewLUT ->EvalFloatFn = lut ->EvalFloatFn;
     NewLUT ->DupDataFn   = lut ->DupDataFn;
     NewLUT ->FreeDataFn  = lut ->FreeDataFn;
@@ -1710,6 +2352,7 @@ void CMSEXPORT _cmsPipelineSetOptimizationParameters(cmsContext ContextID,
     cmsUNUSED_PARAMETER(ContextID);
 
     Lut ->Eval16Fn = Eval16;
+    Lut ->Eval16NFn = NULL;
     Lut ->DupDataFn = DupPrivateDataFn;
     Lut ->FreeDataFn = FreePrivateDataFn;
     Lut ->Data = PrivateData;
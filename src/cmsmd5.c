@@ -247,41 +247,41 @@ void CMSEXPORT cmsMD5finish(cmsContext ContextID, cmsProfileID* ProfileID,  cmsH
 
 
 
-// Assuming io points to an ICC profile, compute and store MD5 checksum
-// In the header, rendering intentent, flags and ID should be set to zero
-// before computing MD5 checksum (per 7.2.18 of ICC spec 4.4)
-
-cmsBool CMSEXPORT cmsMD5computeID(cmsContext ContextID, cmsHPROFILE hProfile)
+// Computes the MD5 of a profile as it would be saved, with rendering intent, flags and ID set to zero
+// (per 7.2.18 of ICC spec 4.4). The profile is left untouched, so this is safe on profiles shared
+// across threads: saving holds the profile mutex and those fields are cleared on the saved copy.
+cmsBool _cmsMD5computeProfileID(cmsContext ContextID, cmsHPROFILE hProfile, cmsProfileID* ProfileID)
 {
     cmsUInt32Number BytesNeeded;
-    cmsUInt8Number* Mem = NULL;
-    cmsHANDLE  MD5 = NULL;
-    _cmsICCPROFILE* Icc = (_cmsICCPROFILE*) hProfile;
-    _cmsICCPROFILE Keep;
+    cmsUInt8Number* Mem;
+    cmsHANDLE  MD5;
 
     _cmsAssert(hProfile != NULL);
 
-    // Save a copy of the profile header
-    memmove(&Keep, Icc, sizeof(_cmsICCPROFILE));
-
-    // Set RI, flags and ID
-    Icc ->flags = 0;
-    Icc ->RenderingIntent = 0;
-    memset(&Icc ->ProfileID, 0, sizeof(Icc ->ProfileID));
-
     // Compute needed storage
-    if (!cmsSaveProfileToMem(ContextID, hProfile, NULL, &BytesNeeded)) goto Error;
+    if (!cmsSaveProfileToMem(ContextID, hProfile, NULL, &BytesNeeded)) return FALSE;
+    if (BytesNeeded < sizeof(cmsICCHeader)) return FALSE;
 
     // Allocate memory
     Mem = (cmsUInt8Number*) _cmsMalloc(ContextID, BytesNeeded);
-    if (Mem == NULL) goto Error;
+    if (Mem == NULL) return FALSE;
 
     // Save to temporary storage
-    if (!cmsSaveProfileToMem(ContextID, hProfile, Mem, &BytesNeeded)) goto Error;
+    if (!cmsSaveProfileToMem(ContextID, hProfile, Mem, &BytesNeeded)) {
+        _cmsFree(ContextID, Mem);
+        return FALSE;
+    }
+
+    memset(Mem + offsetof(cmsICCHeader, flags), 0, sizeof(cmsUInt32Number));
+    memset(Mem + offsetof(cmsICCHeader, renderingIntent), 0, sizeof(cmsUInt32Number));
+    memset(Mem + offsetof(cmsICCHeader, profileID), 0, sizeof(cmsProfileID));
 
     // Create MD5 object
     MD5 = cmsMD5alloc(ContextID);
-    if (MD5 == NULL) goto Error;
+    if (MD5 == NULL) {
+        _cmsFree(ContextID, Mem);
+        return FALSE;
+    }
 
     // Add all bytes
     cmsMD5add(MD5, Mem, BytesNeeded);
@@ -289,19 +289,103 @@ cmsBool CMSEXPORT cmsMD5computeID(cmsContext ContextID, cmsHPROFILE hProfile)
     // Temp storage is no longer needed
     _cmsFree(ContextID, Mem);
 
-    // Restore header
-    memmove(Icc, &Keep, sizeof(_cmsICCPROFILE));
+    cmsMD5finish(ContextID, ProfileID, MD5);
+    return TRUE;
+}
+
+// Same as above, on the block the profile was read from. Only valid if the profile has not been modified since
+static
+cmsBool MD5computeRawProfileID(cmsContext ContextID, _cmsICCPROFILE* Icc, cmsProfileID* ProfileID)
+{
+    cmsIOHANDLER* io = Icc ->IOhandler;
+    cmsUInt32Number Size = io ->ReportedSize, HeaderSize;
+    cmsUInt8Number* Mem;
+    cmsHANDLE  MD5;
+    cmsBool rc;
+
+    if (Size < sizeof(cmsICCHeader)) return FALSE;
+
+    Mem = (cmsUInt8Number*) _cmsMalloc(ContextID, Size);
+    if (Mem == NULL) return FALSE;
+
+    // The IO handler is also used by cmsReadTag
+    if (!_cmsLockMutex(ContextID, Icc ->UsrMutex)) {
+        _cmsFree(ContextID, Mem);
+        return FALSE;
+    }
+
+    rc = io ->Seek(ContextID, io, 0) && io ->Read(ContextID, io, Mem, Size, 1) == 1;
+    _cmsUnlockMutex(ContextID, Icc ->UsrMutex);
+
+    if (!rc) {
+        _cmsFree(ContextID, Mem);
+        return FALSE;
+    }
+
+    // Size as reported in the header, as _cmsReadHeader does
+    HeaderSize = _cmsAdjustEndianess32(*(cmsUInt32Number*) Mem);
+    if (HeaderSize >= sizeof(cmsICCHeader) && HeaderSize < Size)
+        Size = HeaderSize;
+
+    memset(Mem + offsetof(cmsICCHeader, flags), 0, sizeof(cmsUInt32Number));
+    memset(Mem + offsetof(cmsICCHeader, renderingIntent), 0, sizeof(cmsUInt32Number));
+    memset(Mem + offsetof(cmsICCHeader, profileID), 0, sizeof(cmsProfileID));
+
+    MD5 = cmsMD5alloc(ContextID);
+    if (MD5 == NULL) {
+        _cmsFree(ContextID, Mem);
+        return FALSE;
+    }
+
+    cmsMD5add(MD5, Mem, Size);
+    _cmsFree(ContextID, Mem);
+
+    cmsMD5finish(ContextID, ProfileID, MD5);
+    return TRUE;
+}
+
+// ID of the profile contents, computed once and kept until the profile is modified. Unmodified profiles are hashed
+// on the block they were read from, so the ID does not depend on which tags have been decoded. Others are hashed
+// as they would be saved.
+cmsBool _cmsGetProfileContentID(cmsContext ContextID, cmsHPROFILE hProfile, cmsProfileID* ProfileID)
+{
+    _cmsICCPROFILE* Icc = (_cmsICCPROFILE*) hProfile;
+    cmsProfileID ID;
+    cmsBool rc;
+
+    _cmsAssert(hProfile != NULL);
+
+    if (Icc ->HasContentID) {
+        *ProfileID = Icc ->ContentID;
+        return TRUE;
+    }
+
+    if (Icc ->IOhandler != NULL && !Icc ->IsWrite && !Icc ->IsModified)
+        rc = MD5computeRawProfileID(ContextID, Icc, &ID);
+    else
+        rc = _cmsMD5computeProfileID(ContextID, hProfile, &ID);
+
+    if (!rc) return FALSE;
 
-    // And store the ID
-    cmsMD5finish(ContextID, &Icc ->ProfileID,  MD5);
+    Icc ->ContentID = ID;
+    Icc ->HasContentID = TRUE;
+
+    *ProfileID = ID;
     return TRUE;
+}
+
+// Compute and store MD5 checksum in the header
+cmsBool CMSEXPORT cmsMD5computeID(cmsContext ContextID, cmsHPROFILE hProfile)
+{
+    _cmsICCPROFILE* Icc = (_cmsICCPROFILE*) hProfile;
+    cmsProfileID ID;
 
-Error:
+    _cmsAssert(hProfile != NULL);
+
+    if (_cmsIsPooledProfile(ContextID, Icc)) return FALSE;
+    if (!_cmsMD5computeProfileID(ContextID, hProfile, &ID)) return FALSE;
 
-    // Free resources as something went wrong
-    // "MD5" cannot be other than NULL here, so no need to free it
-    if (Mem != NULL) _cmsFree(ContextID, Mem);
-    memmove(Icc, &Keep, sizeof(_cmsICCPROFILE));
-    return FALSE;
+    Icc ->ProfileID = ID;
+    return TRUE;
 }
 
@@ -53,6 +53,7 @@ typedef struct {
     cmsInterpParams*  ParamsCurveIn16[MAX_INPUT_DIMENSIONS];
 
     _cmsInterpFn16 EvalCLUT;            // The evaluator for 3D grid
+    _cmsInterpFn16N EvalCLUTN;          // Same, on many pixels
     const cmsInterpParams* CLUTparams;  // (not-owned pointer)
 
 
@@ -317,6 +318,42 @@ void PrelinEval16(cmsContext ContextID, CMSREGISTER const cmsUInt16Number Input[
 }
 
 
+// Same, on many pixels. Curves go pixel by pixel, the CLUT gets whole groups
+#define PRELIN_BATCH 64
+
+static
+void PrelinEval16N(cmsContext ContextID,
+                   const cmsUInt16Number Input[],
+                   cmsUInt16Number Output[],
+                   cmsUInt32Number nPixels,
+                   const void* D)
+{
+    Prelin16Data* p16 = (Prelin16Data*) D;
+    cmsUInt16Number  StageABC[PRELIN_BATCH * MAX_INPUT_DIMENSIONS];
+    cmsUInt16Number  StageDEF[PRELIN_BATCH * cmsMAXCHANNELS];
+    cmsUInt32Number nIn  = p16 ->nInputs;
+    cmsUInt32Number nOut = p16 ->nOutputs;
+    cmsUInt32Number i, j, n;
+
+    for (; nPixels > 0; nPixels -= n) {
+
+        n = nPixels < PRELIN_BATCH ? nPixels : PRELIN_BATCH;
+
+        for (j=0; j < n; j++)
+            for (i=0; i < nIn; i++)
+                p16 ->EvalCurveIn16[i](ContextID, &Input[j * nIn + i], &StageABC[j * nIn + i], p16 ->ParamsCurveIn16[i]);
+
+        p16 ->EvalCLUTN(ContextID, StageABC, StageDEF, n, p16 ->CLUTparams);
+
+        for (j=0; j < n; j++)
+            for (i=0; i < nOut; i++)
+                p16 ->EvalCurveOut16[i](ContextID, &StageDEF[j * nOut + i], &Output[j * nOut + i], p16 ->ParamsCurveOut16[i]);
+
+        Input  += n * nIn;
+        Output += n * nOut;
+    }
+}
+
 static
 void PrelinOpt16free(cmsContext ContextID, void* ptr)
 {
@@ -372,6 +409,7 @@ Prelin16Data* PrelinOpt16alloc(cmsContext ContextID,
 
     p16 ->CLUTparams = ColorMap;
     p16 ->EvalCLUT   = ColorMap ->Interpolation.Lerp16;
+    p16 ->EvalCLUTN  = ColorMap ->InterpolationN.Lerp16N;
 
 
     p16 -> EvalCurveOut16 = (_cmsInterpFn16*) _cmsCalloc(ContextID, nOutputs, sizeof(_cmsInterpFn16));
@@ -413,29 +451,43 @@ Prelin16Data* PrelinOpt16alloc(cmsContext ContextID,
 
 // Sampler implemented by another LUT. This is a clean way to precalculate the devicelink 3D CLUT for
 // almost any transform. We use floating point precision and then convert from floating point to 16 bits.
+// Whole rows of nodes are evaluated at once, in chunks.
+#define XFORM_SAMPLER_CHUNK 64
+
 static
 cmsInt32Number XFormSampler16(cmsContext ContextID,
-                              CMSREGISTER const cmsUInt16Number In[],
-                              CMSREGISTER cmsUInt16Number Out[],
-                              CMSREGISTER void* Cargo)
+                              const cmsUInt16Number In[],
+                              cmsUInt16Number Out[],
+                              cmsUInt32Number nNodes,
+                              void* Cargo)
 {
     cmsPipeline* Lut = (cmsPipeline*) Cargo;
-    cmsFloat32Number InFloat[cmsMAXCHANNELS], OutFloat[cmsMAXCHANNELS];
-    cmsUInt32Number i;
+    cmsFloat32Number InFloat[XFORM_SAMPLER_CHUNK * cmsMAXCHANNELS], OutFloat[XFORM_SAMPLER_CHUNK * cmsMAXCHANNELS];
+    cmsUInt32Number nIn  = Lut ->InputChannels;
+    cmsUInt32Number nOut = Lut ->OutputChannels;
+    cmsUInt32Number i, n;
 
     _cmsAssert(Lut -> InputChannels < cmsMAXCHANNELS);
     _cmsAssert(Lut -> OutputChannels < cmsMAXCHANNELS);
 
-    // From 16 bit to floating point
-    for (i=0; i < Lut ->InputChannels; i++)
-        InFloat[i] = (cmsFloat32Number) (In[i] / 65535.0);
+    for (; nNodes > 0; nNodes -= n) {
+
+        n = nNodes < XFORM_SAMPLER_CHUNK ? nNodes : XFORM_SAMPLER_CHUNK;
+
+        // From 16 bit to floating point
+        for (i=0; i < n * nIn; i++)
+            InFloat[i] = (cmsFloat32Number) (In[i] / 65535.0);
+
+        // Evaluate in floating point
+        cmsPipelineEvalFloatN(ContextID, InFloat, OutFloat, n, Lut);
 
-    // Evaluate in floating point
-    cmsPipelineEvalFloat(ContextID, InFloat, OutFloat, Lut);
+        // Back to 16 bits representation
+        for (i=0; i < n * nOut; i++)
+            Out[i] = _cmsQuickSaturateWord(OutFloat[i] * 65535.0);
 
-    // Back to 16 bits representation
-    for (i=0; i < Lut ->OutputChannels; i++)
-        Out[i] = _cmsQuickSaturateWord(OutFloat[i] * 65535.0);
+        In  += n * nIn;
+        Out += n * nOut;
+    }
 
     // Always succeed
     return TRUE;
@@ -629,6 +681,115 @@ cmsBool FixWhiteMisalignment(cmsContext ContextID, cmsPipeline* Lut, cmsColorSpa
     return TRUE;
 }
 
+// -----------------------------------------------------------------------------------------------------------------------------------------------
+// Error driven grid sizing. When the context has an error budget (see cmsSetGridpointsErrorBudget), the grid sizes
+// are bisected for the smallest one that reproduces the pipeline within the budget on a set of probe points. The
+// pipeline is the one the CLUT replaces, that is, without the pre/post linearization curves kept aside. The default
+// grid for the colorspace is the upper limit, and needs no probing. Probes are a Halton sequence, which spreads
+// points evenly across the input space without falling on the nodes.
+// -----------------------------------------------------------------------------------------------------------------------------------------------
+
+#define GRID_PROBE_POINTS 1024
+
+// Radical inverse of i in the given prime base
+static
+cmsFloat64Number Halton(cmsUInt32Number i, cmsUInt32Number Base)
+{
+    cmsFloat64Number f = 1.0, r = 0.0;
+
+    while (i > 0) {
+        f /= Base;
+        r += f * (i % Base);
+        i /= Base;
+    }
+
+    return r;
+}
+
+// Maximum difference, in 16 bits, between the pipeline and a CLUT of nGridPoints on the probe points
+static
+cmsFloat64Number GridError(cmsContext ContextID, cmsPipeline* Lut, cmsUInt32Number nGridPoints,
+                           const cmsUInt16Number Probes[], const cmsUInt16Number Ref[], cmsUInt16Number Out[])
+{
+    cmsStage* CLUT;
+    _cmsStageCLutData* Data;
+    cmsUInt32Number i, Diff, MaxDiff = 0;
+
+    CLUT = cmsStageAllocCLut16bit(ContextID, nGridPoints, Lut ->InputChannels, Lut ->OutputChannels, NULL);
+    if (CLUT == NULL) return -1;
+
+    if (!cmsStageSampleCLut16bitN(ContextID, CLUT, XFormSampler16, (void*) Lut, SAMPLER_THREADSAFE)) {
+        cmsStageFree(ContextID, CLUT);
+        return -1;
+    }
+
+    Data = (_cmsStageCLutData*) CLUT ->Data;
+    Data ->Params ->InterpolationN.Lerp16N(ContextID, Probes, Out, GRID_PROBE_POINTS, Data ->Params);
+
+    for (i=0; i < GRID_PROBE_POINTS * Lut ->OutputChannels; i++) {
+
+        Diff = (cmsUInt32Number) abs((int) Out[i] - (int) Ref[i]);
+        if (Diff > MaxDiff) MaxDiff = Diff;
+    }
+
+    cmsStageFree(ContextID, CLUT);
+    return (cmsFloat64Number) MaxDiff;
+}
+
+// Returns the smallest grid not above MaxGridPoints that meets the error budget. Error goes down as the grid grows,
+// close enough to take a bisection over the candidates
+static
+cmsUInt32Number AdaptiveGridpoints(cmsContext ContextID, cmsPipeline* Lut, cmsUInt32Number MaxGridPoints, cmsFloat64Number MaxError)
+{
+    static const cmsUInt32Number Primes[MAX_INPUT_DIMENSIONS] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47 };
+    static const cmsUInt32Number Candidates[] = { 3, 5, 7, 9, 11, 13, 17, 21, 25, 33, 41, 49, 65 };
+    cmsUInt32Number nIn  = Lut ->InputChannels;
+    cmsUInt32Number nOut = Lut ->OutputChannels;
+    cmsUInt32Number i, t, Lo, Hi, Mid, nCandidates;
+    cmsUInt16Number *Probes, *Ref, *Out;
+    cmsFloat64Number Error;
+
+    if (nIn < 1 || nIn > MAX_INPUT_DIMENSIONS || nOut < 1 || nOut >= cmsMAXCHANNELS) return MaxGridPoints;
+
+    Probes = (cmsUInt16Number*) _cmsCalloc(ContextID, GRID_PROBE_POINTS * (nIn + 2 * nOut), sizeof(cmsUInt16Number));
+    if (Probes == NULL) return MaxGridPoints;
+
+    Ref = Probes + GRID_PROBE_POINTS * nIn;
+    Out = Ref + GRID_PROBE_POINTS * nOut;
+
+    // Index zero would give the first node, so skip it
+    for (i=0; i < GRID_PROBE_POINTS; i++)
+        for (t=0; t < nIn; t++)
+            Probes[i * nIn + t] = _cmsQuickSaturateWord(Halton(i + 1, Primes[t]) * 65535.0);
+
+    // The reference goes through the very same path as the nodes
+    XFormSampler16(ContextID, Probes, Ref, GRID_PROBE_POINTS, (void*) Lut);
+
+    // Candidates below the maximum, which stands past the last one and always meets the budget
+    nCandidates = 0;
+    while (nCandidates < sizeof(Candidates) / sizeof(Candidates[0]) && Candidates[nCandidates] < MaxGridPoints)
+        nCandidates++;
+
+    Lo = 0;
+    Hi = nCandidates;
+    while (Lo < Hi) {
+
+        Mid = (Lo + Hi) / 2;
+
+        Error = GridError(ContextID, Lut, Candidates[Mid], Probes, Ref, Out);
+        if (Error < 0) {
+            _cmsFree(ContextID, Probes);
+            return MaxGridPoints;
+        }
+
+        if (Error <= MaxError) Hi = Mid;
+        else                   Lo = Mid + 1;
+    }
+
+    _cmsFree(ContextID, Probes);
+    return Lo < nCandidates ? Candidates[Lo] : MaxGridPoints;
+}
+
 // -----------------------------------------------------------------------------------------------------------------------------------------------
 // This function creates simple LUT from complex ones. The generated LUT has an optional set of
 // prelinearization curves, a CLUT of nGridPoints and optional postlinearization tables.
@@ -653,6 +814,7 @@ cmsBool OptimizeByResampling(cmsContext ContextID, cmsPipeline** Lut, cmsUInt32N
     cmsToneCurve** DataSetIn;
     cmsToneCurve** DataSetOut;
     Prelin16Data* p16;
+    cmsFloat64Number MaxError = 0;
 
     // This is a lossy optimization! does not apply in floating-point cases
     if (_cmsFormatterIsFloat(*InputFormat) || _cmsFormatterIsFloat(*OutputFormat)) return FALSE;
@@ -669,6 +831,12 @@ cmsBool OptimizeByResampling(cmsContext ContextID, cmsPipeline** Lut, cmsUInt32N
     // For empty LUTs, 2 points are enough
     if (cmsPipelineStageCount(ContextID, *Lut) == 0)
         nGridPoints = 2;
+    else {
+
+        // Unless given or asked at maximum resolution by the caller, the error budget may allow a smaller grid
+        if (!(*dwFlags & (0x00FF0000 | cmsFLAGS_HIGHRESPRECALC)))
+            MaxError = _cmsGetGridpointsErrorBudget(ContextID);
+    }
 
     Src = *Lut;
 
@@ -700,15 +868,6 @@ cmsBool OptimizeByResampling(cmsContext ContextID, cmsPipeline** Lut, cmsUInt32N
         }
     }
 
-    // Allocate the CLUT
-    CLUT = cmsStageAllocCLut16bit(ContextID, nGridPoints, Src ->InputChannels, Src->OutputChannels, NULL);
-    if (CLUT == NULL) goto Error;
-
-    // Add the CLUT to the destination LUT
-    if (!cmsPipelineInsertStage(ContextID, Dest, cmsAT_END, CLUT)) {
-        goto Error;
-    }
-
     // Postlinearization tables are kept unless indicated by flags
     if (*dwFlags & cmsFLAGS_CLUT_POST_LINEARIZATION) {
 
@@ -721,20 +880,35 @@ cmsBool OptimizeByResampling(cmsContext ContextID, cmsPipeline** Lut, cmsUInt32N
             // Maybe this is a linear tram, so we can avoid the whole stuff
             if (!AllCurvesAreLinear(ContextID, PostLin)) {
 
-                // All seems ok, proceed.
-                NewPostLin = cmsStageDup(ContextID, PostLin);
-                if (!cmsPipelineInsertStage(ContextID, Dest, cmsAT_END, NewPostLin))
-                    goto Error;
-
-                // In destination LUT, the sampling should be applied after this stage.
+                // The sampling should be applied before this stage. It goes to the destination after the CLUT
                 cmsPipelineUnlinkStage(ContextID, Src, cmsAT_END, &KeepPostLin);
             }
         }
     }
 
+    // The error is measured on what the CLUT is going to replace
+    if (MaxError > 0)
+        nGridPoints = AdaptiveGridpoints(ContextID, Src, nGridPoints, MaxError);
+
+    // Allocate the CLUT
+    CLUT = cmsStageAllocCLut16bit(ContextID, nGridPoints, Src ->InputChannels, Src->OutputChannels, NULL);
+    if (CLUT == NULL) goto Error;
+
+    // Add the CLUT to the destination LUT
+    if (!cmsPipelineInsertStage(ContextID, Dest, cmsAT_END, CLUT)) {
+        goto Error;
+    }
+
+    if (KeepPostLin != NULL) {
+
+        NewPostLin = cmsStageDup(ContextID, KeepPostLin);
+        if (!cmsPipelineInsertStage(ContextID, Dest, cmsAT_END, NewPostLin))
+            goto Error;
+    }
+
     // Now its time to do the sampling. We have to ignore pre/post linearization
     // The source LUT without pre/post curves is passed as parameter.
-    if (!cmsStageSampleCLut16bit(ContextID, CLUT, XFormSampler16, (void*) Src, 0)) {
+    if (!cmsStageSampleCLut16bitN(ContextID, CLUT, XFormSampler16, (void*) Src, SAMPLER_THREADSAFE)) {
 Error:
         // Ops, something went wrong, Restore stages
         if (KeepPreLin != NULL) {
@@ -769,6 +943,7 @@ Error:
     if (DataSetIn == NULL && DataSetOut == NULL) {
 
         _cmsPipelineSetOptimizationParameters(ContextID, Dest, (_cmsPipelineEval16Fn) DataCLUT->Params->Interpolation.Lerp16, DataCLUT->Params, NULL, NULL);
+        Dest ->Eval16NFn = (_cmsPipelineEval16NFn) DataCLUT->Params->InterpolationN.Lerp16N;
     }
     else {
 
@@ -780,6 +955,7 @@ Error:
             DataSetOut);
 
         _cmsPipelineSetOptimizationParameters(ContextID, Dest, PrelinEval16, (void*) p16, PrelinOpt16free, Prelin16dup);
+        Dest ->Eval16NFn = PrelinEval16N;
     }
 
 
@@ -1171,7 +1347,7 @@ cmsBool OptimizeByComputingLinearization(cmsContext ContextID, cmsPipeline** Lut
         goto Error;
 
     // Resample the LUT
-    if (!cmsStageSampleCLut16bit(ContextID, OptimizedCLUTmpe, XFormSampler16, (void*) LutPlusCurves, 0)) goto Error;
+    if (!cmsStageSampleCLut16bitN(ContextID, OptimizedCLUTmpe, XFormSampler16, (void*) LutPlusCurves, SAMPLER_THREADSAFE)) goto Error;
 
     // Free resources
     for (t = 0; t < OriginalLut ->InputChannels; t++) {
@@ -1205,6 +1381,7 @@ cmsBool OptimizeByComputingLinearization(cmsContext ContextID, cmsPipeline** Lut
         if (p16 == NULL) return FALSE;
 
         _cmsPipelineSetOptimizationParameters(ContextID, OptimizedLUT, PrelinEval16, (void*) p16, PrelinOpt16free, Prelin16dup);
+        OptimizedLUT ->Eval16NFn = PrelinEval16N;
 
     }
 
@@ -1855,6 +2032,8 @@ void DupPluginOptimizationList(struct _cmsContext_struct* ctx,
                 newHead.OptimizationCollection = newEntry;
     }
 
+  newHead.GridErrorBudget = head ->GridErrorBudget;
+
   ctx ->chunks[OptimizationPlugin] = _cmsSubAllocDup(ctx->MemPool, &newHead, sizeof(_cmsOptimizationPluginChunkType));
 }
 
@@ -1905,6 +2084,26 @@ cmsBool  _cmsRegisterOptimizationPlugin(cmsContext ContextID, cmsPluginBase* Dat
     return TRUE;
 }
 
+// Sets the maximum error, in 16 bits, the optimizer may trade for a smaller CLUT grid. Zero goes back to
+// the fixed grids. Negative values just return the current setting
+cmsFloat64Number CMSEXPORT cmsSetGridpointsErrorBudget(cmsContext ContextID, cmsFloat64Number MaxError)
+{
+    _cmsOptimizationPluginChunkType* ctx = ( _cmsOptimizationPluginChunkType*) _cmsContextGetClientChunk(ContextID, OptimizationPlugin);
+    cmsFloat64Number prev = ctx ->GridErrorBudget;
+
+    if (MaxError >= 0.0)
+        ctx ->GridErrorBudget = MaxError;
+
+    return prev;
+}
+
+cmsFloat64Number _cmsGetGridpointsErrorBudget(cmsContext ContextID)
+{
+    _cmsOptimizationPluginChunkType* ctx = ( _cmsOptimizationPluginChunkType*) _cmsContextGetClientChunk(ContextID, OptimizationPlugin);
+
+    return ctx ->GridErrorBudget;
+}
+
 // The entry point for LUT optimization
 cmsBool CMSEXPORT _cmsOptimizePipeline(cmsContext ContextID,
                              cmsPipeline**    PtrLut,
@@ -1987,3 +2186,137 @@ cmsBool _cmsLutIsIdentity(cmsPipeline *PtrLut)
 {
     return !PtrLut || PtrLut->Eval16Fn == FastIdentity16;
 }
+
+// Saved transforms --------------------------------------------------------------------------------------------------
+// Optimized pipelines keep their stages, and the evaluator is computed from them. So, knowing which
+// optimization was applied is enough to rebuild the evaluator of a pipeline made of the same stages.
+
+// Returns which one of the built-in optimizations was applied, or cmsOPT_UNKNOWN for plug-ins
+cmsUInt32Number _cmsPipelineOptimizationKind(cmsContext ContextID, const cmsPipeline* Lut)
+{
+    cmsStage* First;
+
+    if (_cmsPipelineIsGeneric(Lut)) return cmsOPT_NONE;
+    if (Lut ->Eval16Fn == FastIdentity16 && Lut ->Data == (void*) Lut) return cmsOPT_IDENTITY;
+    if (Lut ->Eval16Fn == FastEvaluateCurves8)  return cmsOPT_CURVES8;
+    if (Lut ->Eval16Fn == FastEvaluateCurves16) return cmsOPT_CURVES16;
+    if (Lut ->Eval16Fn == MatShaperEval16) return cmsOPT_MATSHAPER;
+    if (Lut ->Eval16Fn == PrelinEval16) return cmsOPT_PRELIN16;
+    if (Lut ->Eval16Fn == PrelinEval8)  return cmsOPT_PRELIN8;
+
+    // A lone CLUT is evaluated by its interpolator
+    First = cmsPipelineGetPtrToFirstStage(ContextID, Lut);
+    if (First != NULL && First ->Next == NULL && cmsStageType(ContextID, First) == cmsSigCLutElemType) {
+
+        _cmsStageCLutData* Data = (_cmsStageCLutData*) First ->Data;
+
+        if (Lut ->Data == (void*) Data ->Params &&
+            Lut ->Eval16Fn == (_cmsPipelineEval16Fn) Data ->Params ->Interpolation.Lerp16) return cmsOPT_CLUT;
+    }
+
+    return cmsOPT_UNKNOWN;
+}
+
+// Curves of a curve set stage, NULL if the stage is of another kind
+static
+cmsToneCurve** CurvesOf(cmsContext ContextID, cmsStage* mpe)
+{
+    if (mpe == NULL || cmsStageType(ContextID, mpe) != cmsSigCurveSetElemType) return NULL;
+    return ((_cmsStageToneCurvesData*) mpe ->Data) ->TheCurves;
+}
+
+// Sets again the evaluator of the given kind on a pipeline holding the stages of an optimized one
+cmsBool _cmsPipelineRestoreOptimization(cmsContext ContextID, cmsPipeline* Lut, cmsUInt32Number Kind, cmsUInt32Number* OutputFormat)
+{
+    cmsStage* First = cmsPipelineGetPtrToFirstStage(ContextID, Lut);
+    cmsStage* Last  = cmsPipelineGetPtrToLastStage(ContextID, Lut);
+    cmsStage* CLUT;
+    _cmsStageCLutData* DataCLUT;
+
+    switch (Kind) {
+
+    case cmsOPT_NONE:
+        return TRUE;
+
+    case cmsOPT_IDENTITY:
+        _cmsPipelineSetOptimizationParameters(ContextID, Lut, FastIdentity16, (void*) Lut, NULL, NULL);
+        return TRUE;
+
+    case cmsOPT_CURVES8:
+    case cmsOPT_CURVES16:
+        {
+            Curves16Data* c16;
+
+            if (First == NULL || First != Last || CurvesOf(ContextID, First) == NULL) return FALSE;
+
+            c16 = CurvesAlloc(ContextID, Lut ->InputChannels, Kind == cmsOPT_CURVES8 ? 256 : 65536, CurvesOf(ContextID, First));
+            if (c16 == NULL) return FALSE;
+
+            _cmsPipelineSetOptimizationParameters(ContextID, Lut, Kind == cmsOPT_CURVES8 ? FastEvaluateCurves8 : FastEvaluateCurves16,
+                                                  c16, CurvesFree, CurvesDup);
+            return TRUE;
+        }
+
+    case cmsOPT_MATSHAPER:
+        {
+            _cmsStageMatrixData* Mat;
+
+            if (First == NULL || First ->Next == NULL || First ->Next ->Next != Last) return FALSE;
+            if (CurvesOf(ContextID, First) == NULL || CurvesOf(ContextID, Last) == NULL) return FALSE;
+            if (cmsStageType(ContextID, First ->Next) != cmsSigMatrixElemType) return FALSE;
+            if (Lut ->InputChannels != 3 || Lut ->OutputChannels != 3) return FALSE;
+
+            Mat = (_cmsStageMatrixData*) First ->Next ->Data;
+            return SetMatShaper(ContextID, Lut, CurvesOf(ContextID, First), (cmsMAT3*) Mat ->Double,
+                                (cmsVEC3*) Mat ->Offset, CurvesOf(ContextID, Last), OutputFormat);
+        }
+
+    case cmsOPT_CLUT:
+    case cmsOPT_PRELIN16:
+    case cmsOPT_PRELIN8:
+
+        // Optional curves around a CLUT
+        CLUT = CurvesOf(ContextID, First) != NULL ? First ->Next : First;
+        if (CLUT == NULL || cmsStageType(ContextID, CLUT) != cmsSigCLutElemType) return FALSE;
+        if (CLUT ->Next != NULL && (CLUT ->Next != Last || CurvesOf(ContextID, Last) == NULL)) return FALSE;
+
+        DataCLUT = (_cmsStageCLutData*) CLUT ->Data;
+        if (DataCLUT ->HasFloatValues) return FALSE;
+
+        if (Kind == cmsOPT_CLUT) {
+
+            if (CLUT != First || CLUT != Last) return FALSE;
+
+            _cmsPipelineSetOptimizationParameters(ContextID, Lut, (_cmsPipelineEval16Fn) DataCLUT->Params->Interpolation.Lerp16, DataCLUT->Params, NULL, NULL);
+            Lut ->Eval16NFn = (_cmsPipelineEval16NFn) DataCLUT->Params->InterpolationN.Lerp16N;
+            return TRUE;
+        }
+
+        if (Kind == cmsOPT_PRELIN8) {
+
+            Prelin8Data* p8;
+
+            if (CLUT == First || CLUT != Last || Lut ->InputChannels != 3) return FALSE;
+
+            p8 = PrelinOpt8alloc(ContextID, DataCLUT ->Params, CurvesOf(ContextID, First));
+            if (p8 == NULL) return FALSE;
+
+            _cmsPipelineSetOptimizationParameters(ContextID, Lut, PrelinEval8, (void*) p8, Prelin8free, Prelin8dup);
+            return TRUE;
+        }
+        else {
+
+            Prelin16Data* p16 = PrelinOpt16alloc(ContextID, DataCLUT ->Params,
+                                                 Lut ->InputChannels, CLUT != First ? CurvesOf(ContextID, First) : NULL,
+                                                 Lut ->OutputChannels, CLUT != Last ? CurvesOf(ContextID, Last) : NULL);
+            if (p16 == NULL) return FALSE;
+
+            _cmsPipelineSetOptimizationParameters(ContextID, Lut, PrelinEval16, (void*) p16, PrelinOpt16free, Prelin16dup);
+            Lut ->Eval16NFn = PrelinEval16N;
+            return TRUE;
+        }
+
+    default:
+        return FALSE;
+    }
+}
@@ -26,6 +26,19 @@
 
 #include "lcms2_internal.h"
 
+// Block formatters shuffle 16 bytes at a time with SSSE3, which is picked at runtime
+#if !defined(CMS_USE_BIG_ENDIAN) && !defined(CMS_DONT_USE_SSE2) && !defined(CMS_DONT_USE_SIMD) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)) && \
+    (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || (defined(_M_IX86) && _MSC_VER >= 1700))
+#   define CMS_PACK_SSSE3 1
+#   include <tmmintrin.h>
+#   ifdef _MSC_VER
+#       include <intrin.h>
+#       define CMS_TARGET_SSSE3
+#   else
+#       define CMS_TARGET_SSSE3 __attribute__((target("ssse3")))
+#   endif
+#endif
+
 // This module handles all formats supported by lcms. There are two flavors, 16 bits and
 // floating point. Floating point is supported only in a subset, those formats holding
 // cmsFloat32Number (4 bytes per component) and double (marked as 0 bytes per component
@@ -3898,6 +3911,556 @@ cmsFormatter _cmsGetStockOutputFormatter(cmsUInt32Number dwInput, cmsUInt32Numbe
     return fr;
 }
 
+// Block formatters ------------------------------------------------------------------------------------------------------
+
+// The batch worker unpacks and packs its pixels a group at a time. Only plain chunky layouts of 8
+// and 16 bits are dealt with: each channel lives at a fixed sample of the pixel, so a group is just
+// a shuffle of bytes, which SSSE3 does 16 bytes at a time. Extra channels are skipped both ways;
+// packers never write them, as alpha is copied on its own before packing. The layout, SSSE3
+// selectors included, is computed once when the formatter is handed out and kept in the transform.
+
+// Mirrors UnrollChunkyBytes/UnrollAnyWords and PackChunkyBytes/PackChunkyWords. Note that
+// unrollers rotate channels after reading and packers rotate samples after writing, so on
+// DoSwap + SwapFirst both directions don't match. Some stock packers of that layout follow the
+// unrollers instead, so it gets no block packer at all.
+static
+void ComputeBlockLayout(cmsUInt32Number Type, cmsFormatterDirection Dir, _cmsBlockLayout* l)
+{
+    cmsUInt32Number nChan     = T_CHANNELS(Type);
+    cmsUInt32Number DoSwap    = T_DOSWAP(Type);
+    cmsUInt32Number SwapFirst = T_SWAPFIRST(Type);
+    cmsUInt32Number Extra     = T_EXTRA(Type);
+    cmsUInt32Number First     = (DoSwap ^ SwapFirst) ? Extra : 0;
+    cmsUInt32Number i, index;
+
+    l->nChan      = nChan;
+    l->nSamples   = nChan + Extra;
+    l->SwapEndian = T_ENDIAN16(Type);
+
+    for (i = 0; i < nChan; i++) {
+
+        if (Extra == 0 && SwapFirst) {
+
+            if (Dir == cmsFormatterInput) {
+
+                index = (i + 1) % nChan;
+                l->Sample[i] = DoSwap ? (nChan - index - 1) : index;
+            }
+            else {
+
+                index = DoSwap ? (nChan - i - 1) : i;
+                l->Sample[i] = (index + 1) % nChan;
+            }
+        }
+        else {
+
+            l->Sample[i] = First + (DoSwap ? (nChan - i - 1) : i);
+        }
+    }
+}
+
+static
+cmsUInt8Number* BlockUnrollBytes(const _cmsBlockLayout* l, cmsUInt16Number Values[], cmsUInt8Number* accum, cmsUInt32Number nPixels)
+{
+    cmsUInt32Number i, j;
+
+    for (i = 0; i < nPixels; i++) {
+
+        for (j = 0; j < l->nChan; j++)
+            Values[j] = FROM_8_TO_16(accum[l->Sample[j]]);
+
+        Values += l->nChan;
+        accum  += l->nSamples;
+    }
+
+    return accum;
+}
+
+static
+cmsUInt8Number* BlockUnrollWords(const _cmsBlockLayout* l, cmsUInt16Number Values[], cmsUInt8Number* accum, cmsUInt32Number nPixels)
+{
+    cmsUInt32Number i, j;
+
+    for (i = 0; i < nPixels; i++) {
+
+        for (j = 0; j < l->nChan; j++) {
+
+            cmsUInt16Number v = ((cmsUInt16Number*) accum)[l->Sample[j]];
+            Values[j] = l->SwapEndian ? CHANGE_ENDIAN(v) : v;
+        }
+
+        Values += l->nChan;
+        accum  += l->nSamples * sizeof(cmsUInt16Number);
+    }
+
+    return accum;
+}
+
+static
+cmsUInt8Number* BlockPackBytes(const _cmsBlockLayout* l, const cmsUInt16Number Values[], cmsUInt8Number* output, cmsUInt32Number nPixels)
+{
+    cmsUInt32Number i, j;
+
+    for (i = 0; i < nPixels; i++) {
+
+        for (j = 0; j < l->nChan; j++)
+            output[l->Sample[j]] = FROM_16_TO_8(Values[j]);
+
+        Values += l->nChan;
+        output += l->nSamples;
+    }
+
+    return output;
+}
+
+static
+cmsUInt8Number* BlockPackWords(const _cmsBlockLayout* l, const cmsUInt16Number Values[], cmsUInt8Number* output, cmsUInt32Number nPixels)
+{
+    cmsUInt32Number i, j;
+
+    for (i = 0; i < nPixels; i++) {
+
+        for (j = 0; j < l->nChan; j++) {
+
+            cmsUInt16Number v = Values[j];
+            ((cmsUInt16Number*) output)[l->Sample[j]] = l->SwapEndian ? CHANGE_ENDIAN(v) : v;
+        }
+
+        Values += l->nChan;
+        output += l->nSamples * sizeof(cmsUInt16Number);
+    }
+
+    return output;
+}
+
+#ifdef CMS_PACK_SSSE3
+
+// The outcome never changes, so a race on first use is harmless
+static
+cmsBool HasSSSE3(void)
+{
+    static volatile int Available = -1;
+
+    if (Available < 0) {
+#ifdef _MSC_VER
+        int cpuinfo[4];
+
+        __cpuid(cpuinfo, 1);
+        Available = (cpuinfo[2] & (1 << 9)) != 0;
+#else
+        __builtin_cpu_init();
+        Available = __builtin_cpu_supports("ssse3") != 0;
+#endif
+    }
+
+    return Available;
+}
+
+// Each step loads 16 bytes holding as many whole pixels as fit, and stores one or two registers of
+// words. Steps go on while both the load and the stores stay within the block, the remaining
+// pixels are left to the scalar loop. Selectors of 0x80 yield zero.
+
+CMS_TARGET_SSSE3 static
+cmsUInt8Number* BlockUnrollBytesSSSE3(const _cmsBlockLayout* l, cmsUInt16Number Values[], cmsUInt8Number* accum, cmsUInt32Number nPixels)
+{
+    cmsUInt32Number Group  = 16 / l->nSamples;
+    cmsUInt32Number nWords = Group * l->nChan;
+    cmsUInt32Number nRegs  = (nWords + 7) / 8;
+    __m128i Lo = _mm_loadu_si128((const __m128i*) l->Shuffle);
+    __m128i Hi = _mm_loadu_si128((const __m128i*) (l->Shuffle + 16));
+
+    while (nPixels * l->nSamples >= 16 && nPixels * l->nChan >= nRegs * 8) {
+
+        __m128i v = _mm_loadu_si128((const __m128i*) accum);
+
+        _mm_storeu_si128((__m128i*) Values, _mm_shuffle_epi8(v, Lo));
+        if (nRegs > 1)
+            _mm_storeu_si128((__m128i*) (Values + 8), _mm_shuffle_epi8(v, Hi));
+
+        accum   += Group * l->nSamples;
+        Values  += nWords;
+        nPixels -= Group;
+    }
+
+    return BlockUnrollBytes(l, Values, accum, nPixels);
+}
+
+CMS_TARGET_SSSE3 static
+cmsUInt8Number* BlockUnrollWordsSSSE3(const _cmsBlockLayout* l, cmsUInt16Number Values[], cmsUInt8Number* accum, cmsUInt32Number nPixels)
+{
+    cmsUInt32Number Group  = 8 / l->nSamples;
+    cmsUInt32Number nWords = Group * l->nChan;
+    __m128i Sel = _mm_loadu_si128((const __m128i*) l->Shuffle);
+
+    while (nPixels * l->nSamples >= 8 && nPixels * l->nChan >= 8) {
+
+        _mm_storeu_si128((__m128i*) Values, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) accum), Sel));
+
+        accum   += Group * l->nSamples * sizeof(cmsUInt16Number);
+        Values  += nWords;
+        nPixels -= Group;
+    }
+
+    return BlockUnrollWords(l, Values, accum, nPixels);
+}
+
+// Packers shuffle the channels in place and blend them into what the buffer already holds, so
+// extra channels and the bytes past the last whole pixel are written back unchanged. Shuffle
+// gives the source byte of each output byte and Keep is all ones on bytes to preserve.
+static
+void BuildPackShuffle(_cmsBlockLayout* l, cmsUInt32Number nBytes)
+{
+    cmsUInt32Number Group = 16 / nBytes / l->nSamples;
+    cmsUInt32Number Chan[16];
+    cmsUInt32Number q, j;
+
+    for (q = 0; q < 16; q++)
+        Chan[q] = cmsMAXCHANNELS;
+
+    for (j = 0; j < l->nChan; j++)
+        Chan[l->Sample[j]] = j;
+
+    for (q = 0; q < 16; q++) {
+
+        cmsUInt32Number Sample = q / nBytes;
+        cmsUInt32Number Pixel  = Sample / l->nSamples;
+        cmsUInt32Number Ch     = Chan[Sample % l->nSamples];
+
+        if (Pixel < Group && Ch < cmsMAXCHANNELS) {
+
+            cmsUInt32Number Byte = q % nBytes;
+
+            if (nBytes == 2 && l->SwapEndian) Byte = 1 - Byte;
+
+            l->Shuffle[q] = (cmsUInt8Number) (nBytes * (Pixel * l->nChan + Ch) + Byte);
+            l->Keep[q]    = 0;
+        }
+        else {
+
+            l->Shuffle[q] = 0x80;
+            l->Keep[q]    = 0xFF;
+        }
+    }
+}
+
+// Unrollers pick the bytes of each word. 8 bits samples get duplicated into both halves of the
+// word, which is FROM_8_TO_16, and picking the bytes of a 16 bits word the other way around swaps
+// its endianness. Selectors of 0x80 yield zero.
+static
+void BuildUnrollShuffle(_cmsBlockLayout* l, cmsUInt32Number nBytes)
+{
+    cmsUInt32Number nWords = (16 / nBytes / l->nSamples) * l->nChan;
+    cmsUInt32Number w;
+
+    memset(l->Shuffle, 0x80, sizeof(l->Shuffle));
+
+    for (w = 0; w < nWords && w < 16 / nBytes; w++) {
+
+        cmsUInt8Number s = (cmsUInt8Number) (nBytes * ((w / l->nChan) * l->nSamples + l->Sample[w % l->nChan]));
+
+        if (nBytes == 1)
+            l->Shuffle[2 * w] = l->Shuffle[2 * w + 1] = s;
+        else {
+            l->Shuffle[2 * w]     = (cmsUInt8Number) (l->SwapEndian ? s + 1 : s);
+            l->Shuffle[2 * w + 1] = (cmsUInt8Number) (l->SwapEndian ? s : s + 1);
+        }
+    }
+}
+
+CMS_TARGET_SSSE3 static
+cmsUInt8Number* BlockPackBytesSSSE3(const _cmsBlockLayout* l, const cmsUInt16Number Values[], cmsUInt8Number* output, cmsUInt32Number nPixels)
+{
+    cmsUInt32Number Group  = 16 / l->nSamples;
+    cmsUInt32Number nWords = Group * l->nChan;
+    cmsUInt32Number nRegs  = (nWords + 7) / 8;
+    __m128i Sel   = _mm_loadu_si128((const __m128i*) l->Shuffle);
+    __m128i Mask  = _mm_loadu_si128((const __m128i*) l->Keep);
+    __m128i Mul   = _mm_set1_epi16((short) 0xFF01);
+    __m128i Round = _mm_set1_epi16(0x80);
+
+    while (nPixels * l->nSamples >= 16 && nPixels * l->nChan >= nRegs * 8) {
+
+        __m128i Lo = _mm_loadu_si128((const __m128i*) Values);
+        __m128i Hi = nRegs > 1 ? _mm_loadu_si128((const __m128i*) (Values + 8)) : _mm_setzero_si128();
+        __m128i v, d;
+
+        // (x * 0xFF01 + 0x800000) >> 24, as FROM_16_TO_8 does
+        Lo = _mm_srli_epi16(_mm_add_epi16(_mm_mulhi_epu16(Lo, Mul), Round), 8);
+        Hi = _mm_srli_epi16(_mm_add_epi16(_mm_mulhi_epu16(Hi, Mul), Round), 8);
+
+        v = _mm_shuffle_epi8(_mm_packus_epi16(Lo, Hi), Sel);
+        d = _mm_loadu_si128((const __m128i*) output);
+
+        _mm_storeu_si128((__m128i*) output, _mm_or_si128(_mm_and_si128(Mask, d), _mm_andnot_si128(Mask, v)));
+
+        Values  += nWords;
+        output  += Group * l->nSamples;
+        nPixels -= Group;
+    }
+
+    return BlockPackBytes(l, Values, output, nPixels);
+}
+
+CMS_TARGET_SSSE3 static
+cmsUInt8Number* BlockPackWordsSSSE3(const _cmsBlockLayout* l, const cmsUInt16Number Values[], cmsUInt8Number* output, cmsUInt32Number nPixels)
+{
+    cmsUInt32Number Group  = 8 / l->nSamples;
+    cmsUInt32Number nWords = Group * l->nChan;
+    __m128i Sel  = _mm_loadu_si128((const __m128i*) l->Shuffle);
+    __m128i Mask = _mm_loadu_si128((const __m128i*) l->Keep);
+
+    while (nPixels * l->nSamples >= 8 && nPixels * l->nChan >= 8) {
+
+        __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) Values), Sel);
+        __m128i d = _mm_loadu_si128((const __m128i*) output);
+
+        _mm_storeu_si128((__m128i*) output, _mm_or_si128(_mm_and_si128(Mask, d), _mm_andnot_si128(Mask, v)));
+
+        Values  += nWords;
+        output  += Group * l->nSamples * sizeof(cmsUInt16Number);
+        nPixels -= Group;
+    }
+
+    return BlockPackWords(l, Values, output, nPixels);
+}
+
+#endif
+
+static
+cmsUInt8Number* UnrollChunkyBytesBlock(cmsContext ContextID, _cmsTRANSFORM* info,
+                                       cmsUInt16Number Values[], cmsUInt8Number* accum, cmsUInt32Number nPixels)
+{
+    const _cmsBlockLayout* l = &info->InputBlockLayout;
+
+#ifdef CMS_PACK_SSSE3
+    if (l->UseSSSE3)
+        return BlockUnrollBytesSSSE3(l, Values, accum, nPixels);
+#endif
+    return BlockUnrollBytes(l, Values, accum, nPixels);
+
+    cmsUNUSED_PARAMETER(ContextID);
+}
+
+static
+cmsUInt8Number* UnrollChunkyWordsBlock(cmsContext ContextID, _cmsTRANSFORM* info,
+                                       cmsUInt16Number Values[], cmsUInt8Number* accum, cmsUInt32Number nPixels)
+{
+    const _cmsBlockLayout* l = &info->InputBlockLayout;
+
+#ifdef CMS_PACK_SSSE3
+    if (l->UseSSSE3)
+        return BlockUnrollWordsSSSE3(l, Values, accum, nPixels);
+#endif
+    return BlockUnrollWords(l, Values, accum, nPixels);
+
+    cmsUNUSED_PARAMETER(ContextID);
+}
+
+static
+cmsUInt8Number* PackChunkyBytesBlock(cmsContext ContextID, _cmsTRANSFORM* info,
+                                     cmsUInt16Number Values[], cmsUInt8Number* output, cmsUInt32Number nPixels)
+{
+    const _cmsBlockLayout* l = &info->OutputBlockLayout;
+
+#ifdef CMS_PACK_SSSE3
+    if (l->UseSSSE3)
+        return BlockPackBytesSSSE3(l, Values, output, nPixels);
+#endif
+    return BlockPackBytes(l, Values, output, nPixels);
+
+    cmsUNUSED_PARAMETER(ContextID);
+}
+
+static
+cmsUInt8Number* PackChunkyWordsBlock(cmsContext ContextID, _cmsTRANSFORM* info,
+                                     cmsUInt16Number Values[], cmsUInt8Number* output, cmsUInt32Number nPixels)
+{
+    const _cmsBlockLayout* l = &info->OutputBlockLayout;
+
+#ifdef CMS_PACK_SSSE3
+    if (l->UseSSSE3)
+        return BlockPackWordsSSSE3(l, Values, output, nPixels);
+#endif
+    return BlockPackWords(l, Values, output, nPixels);
+
+    cmsUNUSED_PARAMETER(ContextID);
+}
+
+#ifndef CMS_NO_HALF_SUPPORT
+
+// Half floats are gathered into a chunk of channels and converted as an array. Scaling keeps the
+// same operations as the pixel formatters, so results are identical.
+#define HALF_BLOCK_CHUNK   256
+
+static
+cmsUInt8Number* UnrollHalfToFloatBlock(cmsContext ContextID, _cmsTRANSFORM* info,
+                                       cmsFloat32Number Values[], cmsUInt8Number* accum, cmsUInt32Number nPixels)
+{
+    cmsUInt16Number  Half[HALF_BLOCK_CHUNK];
+    cmsFloat32Number maximum = IsInkSpace(info->InputFormat) ? 100.0F : 1.0F;
+    cmsUInt32Number  Reverse = T_FLAVOR(info->InputFormat);
+    const _cmsBlockLayout* l = &info->InputBlockLayout;
+    cmsUInt32Number  Chunk = HALF_BLOCK_CHUNK / l->nChan;
+    cmsUInt32Number  n, i, j;
+
+    while (nPixels > 0) {
+
+        n = nPixels < Chunk ? nPixels : Chunk;
+
+        for (i = 0; i < n; i++) {
+
+            for (j = 0; j < l->nChan; j++)
+                Half[i * l->nChan + j] = ((cmsUInt16Number*) accum)[l->Sample[j]];
+
+            accum += l->nSamples * sizeof(cmsUInt16Number);
+        }
+
+        _cmsHalf2FloatArray(Half, Values, n * l->nChan);
+
+        for (i = 0; i < n * l->nChan; i++) {
+
+            cmsFloat32Number v = Values[i] / maximum;
+            Values[i] = Reverse ? 1 - v : v;
+        }
+
+        Values  += n * l->nChan;
+        nPixels -= n;
+    }
+
+    return accum;
+
+    cmsUNUSED_PARAMETER(ContextID);
+}
+
+static
+cmsUInt8Number* PackHalfFromFloatBlock(cmsContext ContextID, _cmsTRANSFORM* info,
+                                       cmsFloat32Number Values[], cmsUInt8Number* output, cmsUInt32Number nPixels)
+{
+    cmsFloat32Number Scaled[HALF_BLOCK_CHUNK];
+    cmsUInt16Number  Half[HALF_BLOCK_CHUNK];
+    cmsFloat32Number maximum = IsInkSpace(info->OutputFormat) ? 100.0F : 1.0F;
+    cmsUInt32Number  Reverse = T_FLAVOR(info->OutputFormat);
+    const _cmsBlockLayout* l = &info->OutputBlockLayout;
+    cmsUInt32Number  Chunk = HALF_BLOCK_CHUNK / l->nChan;
+    cmsUInt32Number  n, i, j;
+
+    while (nPixels > 0) {
+
+        n = nPixels < Chunk ? nPixels : Chunk;
+
+        for (i = 0; i < n * l->nChan; i++) {
+
+            cmsFloat32Number v = Values[i] * maximum;
+            Scaled[i] = Reverse ? maximum - v : v;
+        }
+
+        _cmsFloat2HalfArray(Scaled, Half, n * l->nChan);
+
+        for (i = 0; i < n; i++) {
+
+            for (j = 0; j < l->nChan; j++)
+                ((cmsUInt16Number*) output)[l->Sample[j]] = Half[i * l->nChan + j];
+
+            output += l->nSamples * sizeof(cmsUInt16Number);
+        }
+
+        Values  += n * l->nChan;
+        nPixels -= n;
+    }
+
+    return output;
+
+    cmsUNUSED_PARAMETER(ContextID);
+}
+
+#endif
+
+// Layout and, when the CPU has SSSE3 and pixels fit in a register, selectors of the SSSE3 kernels
+static
+void SetupBlockLayout(cmsUInt32Number Type, cmsFormatterDirection Dir, cmsUInt32Number nBytes, _cmsBlockLayout* l)
+{
+    memset(l, 0, sizeof(_cmsBlockLayout));
+    ComputeBlockLayout(Type, Dir, l);
+
+#ifdef CMS_PACK_SSSE3
+    if (l->nSamples <= 16 / nBytes && HasSSSE3()) {
+
+        l->UseSSSE3 = TRUE;
+        if (Dir == cmsFormatterInput)
+            BuildUnrollShuffle(l, nBytes);
+        else
+            BuildPackShuffle(l, nBytes);
+    }
+#else
+    cmsUNUSED_PARAMETER(nBytes);
+#endif
+}
+
+// Block formatters are only handed out for layouts the stock formatters do the plain way. Those
+// coming from plug-ins may do something else, so the pixel formatter has to be the stock one.
+_cmsFormatter16Block CMSEXPORT _cmsGetBlockFormatter16(cmsUInt32Number Type,
+                                                       cmsFormatterDirection Dir,
+                                                       cmsFormatter16 PixelFormatter,
+                                                       _cmsBlockLayout* Layout)
+{
+    cmsUInt32Number Bytes = T_BYTES(Type);
+    cmsFormatter Stock;
+
+    if (T_CHANNELS(Type) == 0 || T_PLANAR(Type) || T_FLAVOR(Type) || T_PREMUL(Type) || T_FLOAT(Type)) return NULL;
+    if (T_COLORSPACE(Type) == PT_LabV2) return NULL;
+    if (Bytes != 1 && Bytes != 2) return NULL;
+    if (Bytes == 1 && T_ENDIAN16(Type)) return NULL;
+    if (Dir == cmsFormatterOutput && T_DOSWAP(Type) && T_SWAPFIRST(Type) && T_EXTRA(Type) == 0) return NULL;
+
+    if (Dir == cmsFormatterInput)
+        Stock = _cmsGetStockInputFormatter(Type, CMS_PACK_FLAGS_16BITS);
+    else
+        Stock = _cmsGetStockOutputFormatter(Type, CMS_PACK_FLAGS_16BITS);
+
+    if (Stock.Fmt16 == NULL || Stock.Fmt16 != PixelFormatter) return NULL;
+
+    SetupBlockLayout(Type, Dir, Bytes, Layout);
+
+    if (Dir == cmsFormatterInput)
+        return Bytes == 1 ? UnrollChunkyBytesBlock : UnrollChunkyWordsBlock;
+    else
+        return Bytes == 1 ? PackChunkyBytesBlock : PackChunkyWordsBlock;
+}
+
+// Only half floats so far
+_cmsFormatterFloatBlock CMSEXPORT _cmsGetBlockFormatterFloat(cmsUInt32Number Type,
+                                                             cmsFormatterDirection Dir,
+                                                             cmsFormatterFloat PixelFormatter,
+                                                             _cmsBlockLayout* Layout)
+{
+#ifndef CMS_NO_HALF_SUPPORT
+    cmsFormatter Stock;
+
+    if (T_CHANNELS(Type) == 0 || !T_FLOAT(Type) || T_BYTES(Type) != 2) return NULL;
+    if (T_PLANAR(Type) || T_PREMUL(Type) || T_ENDIAN16(Type)) return NULL;
+
+    if (Dir == cmsFormatterInput)
+        Stock = _cmsGetStockInputFormatter(Type, CMS_PACK_FLAGS_FLOAT);
+    else
+        Stock = _cmsGetStockOutputFormatter(Type, CMS_PACK_FLAGS_FLOAT);
+
+    if (Stock.FmtFloat == NULL || Stock.FmtFloat != PixelFormatter) return NULL;
+
+    // Half floats are converted as arrays, there are no selectors
+    memset(Layout, 0, sizeof(_cmsBlockLayout));
+    ComputeBlockLayout(Type, Dir, Layout);
+
+    return Dir == cmsFormatterInput ? UnrollHalfToFloatBlock : PackHalfFromFloatBlock;
+#else
+    return NULL;
+
+    cmsUNUSED_PARAMETER(Type);
+    cmsUNUSED_PARAMETER(Dir);
+    cmsUNUSED_PARAMETER(PixelFormatter);
+    cmsUNUSED_PARAMETER(Layout);
+#endif
+}
+
 
 typedef struct _cms_formatters_factory_list {
 
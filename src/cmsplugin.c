@@ -26,6 +26,17 @@
 
 #include "lcms2_internal.h"
 
+// Whole arrays are byte swapped 16 bytes at a time when SIMD is at hand. Only baseline instruction
+// sets are used, so no runtime detection is needed.
+#if !defined(CMS_USE_BIG_ENDIAN) && !defined(CMS_DONT_USE_SSE2) && !defined(CMS_DONT_USE_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#   define CMS_SWAP_SSE2 1
+#   include <emmintrin.h>
+#elif !defined(CMS_USE_BIG_ENDIAN) && !defined(CMS_DONT_USE_SIMD) && (defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64))
+#   define CMS_SWAP_NEON 1
+#   include <arm_neon.h>
+#endif
+
 
 // ----------------------------------------------------------------------------------
 // Encoding & Decoding support functions
@@ -106,6 +117,68 @@ void CMSEXPORT  _cmsAdjustEndianess64(cmsUInt64Number* Result, cmsUInt64Number*
 #endif
 }
 
+// Same as _cmsAdjustEndianess16, on a whole array in place
+void _cmsAdjustEndianess16Array(cmsUInt16Number* Array, cmsUInt32Number n)
+{
+#ifndef CMS_USE_BIG_ENDIAN
+    cmsUInt32Number i = 0;
+
+#if defined(CMS_SWAP_SSE2)
+    for (; i + 8 <= n; i += 8) {
+
+        __m128i v = _mm_loadu_si128((const __m128i*) (Array + i));
+        _mm_storeu_si128((__m128i*) (Array + i), _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+    }
+#elif defined(CMS_SWAP_NEON)
+    for (; i + 8 <= n; i += 8) {
+
+        uint8x16_t v = vld1q_u8((const uint8_t*) (Array + i));
+        vst1q_u8((uint8_t*) (Array + i), vrev16q_u8(v));
+    }
+#endif
+
+    for (; i < n; i++)
+        Array[i] = (cmsUInt16Number) ((Array[i] << 8) | (Array[i] >> 8));
+#else
+    cmsUNUSED_PARAMETER(Array);
+    cmsUNUSED_PARAMETER(n);
+#endif
+}
+
+// Same as _cmsAdjustEndianess32, on a whole array in place
+void _cmsAdjustEndianess32Array(cmsUInt32Number* Array, cmsUInt32Number n)
+{
+#ifndef CMS_USE_BIG_ENDIAN
+    cmsUInt32Number i = 0;
+
+#if defined(CMS_SWAP_SSE2)
+    for (; i + 4 <= n; i += 4) {
+
+        __m128i v = _mm_loadu_si128((const __m128i*) (Array + i));
+
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128((__m128i*) (Array + i), v);
+    }
+#elif defined(CMS_SWAP_NEON)
+    for (; i + 4 <= n; i += 4) {
+
+        uint8x16_t v = vld1q_u8((const uint8_t*) (Array + i));
+        vst1q_u8((uint8_t*) (Array + i), vrev32q_u8(v));
+    }
+#endif
+
+    for (; i < n; i++) {
+
+        cmsUInt32Number v = Array[i];
+        Array[i] = (v << 24) | ((v & 0xFF00U) << 8) | ((v >> 8) & 0xFF00U) | (v >> 24);
+    }
+#else
+    cmsUNUSED_PARAMETER(Array);
+    cmsUNUSED_PARAMETER(n);
+#endif
+}
+
 // Auxiliary -- read 8, 16 and 32-bit numbers
 cmsBool CMSEXPORT  _cmsReadUInt8Number(cmsContext ContextID, cmsIOHANDLER* io, cmsUInt8Number* n)
 {
@@ -133,22 +206,31 @@ cmsBool CMSEXPORT  _cmsReadUInt16Number(cmsContext ContextID, cmsIOHANDLER* io,
     return TRUE;
 }
 
+// The whole array is read at once and then byte swapped. If Array is NULL, the values are just skipped.
 cmsBool CMSEXPORT  _cmsReadUInt16Array(cmsContext ContextID, cmsIOHANDLER* io, cmsUInt32Number n, cmsUInt16Number* Array)
 {
-    cmsUInt32Number i;
-
     _cmsAssert(io != NULL);
 
-    for (i=0; i < n; i++) {
+    if (n == 0) return TRUE;
+    if (n > 0x7FFFFFFFU) return FALSE;
 
-        if (Array != NULL) {
-            if (!_cmsReadUInt16Number(ContextID, io, Array + i)) return FALSE;
-        }
-        else {
-            if (!_cmsReadUInt16Number(ContextID, io, NULL)) return FALSE;
-        }
+    if (Array == NULL) {
+
+        cmsUInt16Number Skip[256];
 
+        while (n > 0) {
+
+            cmsUInt32Number Chunk = n > 256 ? 256 : n;
+
+            if (io -> Read(ContextID, io, Skip, sizeof(cmsUInt16Number), Chunk) != Chunk) return FALSE;
+            n -= Chunk;
+        }
+        return TRUE;
     }
+
+    if (io -> Read(ContextID, io, Array, sizeof(cmsUInt16Number), n) != n) return FALSE;
+
+    _cmsAdjustEndianess16Array(Array, n);
     return TRUE;
 }
 
@@ -165,6 +247,25 @@ cmsBool CMSEXPORT  _cmsReadUInt32Number(cmsContext ContextID, cmsIOHANDLER* io,
     return TRUE;
 }
 
+// Safeguard which covers against absurd values
+static
+cmsBool IsSaneFloat32(cmsFloat32Number n)
+{
+    if (n > 1E+20 || n < -1E+20) return FALSE;
+
+    #if defined(_MSC_VER) && _MSC_VER < 1800
+       return TRUE;
+    #elif defined (__BORLANDC__)
+       return TRUE;
+    #elif !defined(_MSC_VER) && (defined(__STDC_VERSION__) && __STDC_VERSION__ < 199901L) && !defined(HAVE_FPCLASSIFY)
+       return TRUE;
+    #else
+
+       // fpclassify() required by C99 (only provided by MSVC >= 1800, VS2013 onwards)
+       return ((fpclassify(n) == FP_ZERO) || (fpclassify(n) == FP_NORMAL));
+    #endif
+}
+
 cmsBool CMSEXPORT  _cmsReadFloat32Number(cmsContext ContextID, cmsIOHANDLER* io, cmsFloat32Number* n)
 {
     union typeConverter {
@@ -182,26 +283,35 @@ cmsBool CMSEXPORT  _cmsReadFloat32Number(cmsContext ContextID, cmsIOHANDLER* io,
         tmp.integer = _cmsAdjustEndianess32(tmp.integer);
         *n = tmp.floating_point;
 
-        // Safeguard which covers against absurd values
-        if (*n > 1E+20 || *n < -1E+20) return FALSE;
+        return IsSaneFloat32(*n);
+    }
+
+    return TRUE;
+}
+
+
+// Bulk version of _cmsReadFloat32Number, every value goes thru the same checks
+cmsBool CMSEXPORT  _cmsReadFloat32Array(cmsContext ContextID, cmsIOHANDLER* io, cmsUInt32Number n, cmsFloat32Number* Array)
+{
+    cmsUInt32Number i;
+
+    _cmsAssert(io != NULL);
+    _cmsAssert(Array != NULL);
 
-        #if defined(_MSC_VER) && _MSC_VER < 1800
-           return TRUE;
-        #elif defined (__BORLANDC__)
-           return TRUE;
-        #elif !defined(_MSC_VER) && (defined(__STDC_VERSION__) && __STDC_VERSION__ < 199901L) && !defined(HAVE_FPCLASSIFY)
-           return TRUE;
-        #else
+    if (n == 0) return TRUE;
+    if (n > 0x3FFFFFFFU) return FALSE;
 
-           // fpclassify() required by C99 (only provided by MSVC >= 1800, VS2013 onwards)
-           return ((fpclassify(*n) == FP_ZERO) || (fpclassify(*n) == FP_NORMAL));
-        #endif
+    if (io -> Read(ContextID, io, Array, sizeof(cmsFloat32Number), n) != n) return FALSE;
+
+    _cmsAdjustEndianess32Array((cmsUInt32Number*) Array, n);
+
+    for (i=0; i < n; i++) {
+        if (!IsSaneFloat32(Array[i])) return FALSE;
     }
 
     return TRUE;
 }
 
-
 cmsBool CMSEXPORT   _cmsReadUInt64Number(cmsContext ContextID, cmsIOHANDLER* io, cmsUInt64Number* n)
 {
     cmsUInt64Number tmp;
@@ -649,7 +759,9 @@ static struct _cmsContext_struct globalContext = {
         &_cmsOptimizationPluginChunk,    //  OptimizationPlugin,
         &_cmsTransformPluginChunk,       //  TransformPlugin,
         &_cmsMutexPluginChunk,           //  MutexPlugin,
-        &_cmsParallelizationPluginChunk  //  ParallelizationPlugin
+        &_cmsParallelizationPluginChunk, //  ParallelizationPlugin
+        &_cmsTransformCacheChunk,        //  TransformCache
+        &_cmsProfilePoolChunk            //  ProfilePool
     },
 
     { NULL, NULL, NULL, NULL, NULL, NULL } // The default memory allocator is not used for context 0
@@ -660,6 +772,62 @@ static struct _cmsContext_struct globalContext = {
 static _cmsMutex _cmsContextPoolHeadMutex = CMS_MUTEX_INITIALIZER;
 static struct _cmsContext_struct* _cmsContextPoolHead = NULL;
 
+// Index of live contexts, for lookups without lock. Handles are only compared by value, never
+// dereferenced, so any pointer can be looked up. Each handle hashes to a window of slots that
+// fits in a cache line. Writers hold the pool mutex and publish slots and the overflow count with
+// release stores; readers use acquire loads. Handles finding their window full are only in the
+// linked list, which is then searched under lock as before. Without atomics the index is still
+// maintained, but every lookup takes the lock.
+#define CONTEXT_INDEX_BITS  11
+#define CONTEXT_INDEX_WAYS  8
+
+static struct _cmsContext_struct* _cmsContextIndex[1 << CONTEXT_INDEX_BITS];
+static cmsUInt32Number _cmsContextsNotIndexed = 0;
+
+// First slot of the window of a context handle
+cmsINLINE cmsUInt32Number ContextIndexWindow(const void* ContextID)
+{
+    size_t v = (size_t) ContextID;
+    cmsUInt32Number h = (cmsUInt32Number) (v >> 4) ^ (cmsUInt32Number) (v >> 20);
+
+    h = (h * 2654435761U) >> (32 - CONTEXT_INDEX_BITS);
+    return h & ~(cmsUInt32Number) (CONTEXT_INDEX_WAYS - 1);
+}
+
+// Pool mutex must be held
+static
+void IndexContext(struct _cmsContext_struct* ctx)
+{
+    cmsUInt32Number i, w = ContextIndexWindow(ctx);
+
+    for (i = 0; i < CONTEXT_INDEX_WAYS; i++) {
+
+        if (_cmsContextIndex[w + i] == NULL) {
+            _cmsAtomicStorePtr(&_cmsContextIndex[w + i], ctx);
+            return;
+        }
+    }
+
+    _cmsAtomicAdd32(&_cmsContextsNotIndexed, 1);
+}
+
+// Pool mutex must be held
+static
+void UnindexContext(struct _cmsContext_struct* ctx)
+{
+    cmsUInt32Number i, w = ContextIndexWindow(ctx);
+
+    for (i = 0; i < CONTEXT_INDEX_WAYS; i++) {
+
+        if (_cmsContextIndex[w + i] == ctx) {
+            _cmsAtomicStorePtr(&_cmsContextIndex[w + i], NULL);
+            return;
+        }
+    }
+
+    _cmsAtomicAdd32(&_cmsContextsNotIndexed, (cmsUInt32Number) -1);
+}
+
 
 // Make sure context is initialized (needed on windows)
 static
@@ -707,16 +875,34 @@ cmsBool InitContextMutex(void)
 
 
 
-// Internal, get associated pointer, with guessing. Never returns NULL.
+// Internal, get associated pointer, with guessing. Never returns NULL. This is called on every
+// allocation and plug-in lookup, so the usual case does not take any lock.
 struct _cmsContext_struct* _cmsGetContext(cmsContext ContextID)
 {
     struct _cmsContext_struct* id = (struct _cmsContext_struct*) ContextID;
     struct _cmsContext_struct* ctx;
+#ifdef CMS_ATOMIC_POINTERS
+    cmsUInt32Number i, w;
+#endif
 
     // On 0, use global settings
     if (id == NULL)
         return &globalContext;
 
+#ifdef CMS_ATOMIC_POINTERS
+    // Fast path, no locking
+    w = ContextIndexWindow(id);
+    for (i = 0; i < CONTEXT_INDEX_WAYS; i++) {
+
+        if (_cmsAtomicLoadPtr(&_cmsContextIndex[w + i]) == id)
+            return id;
+    }
+
+    // Not in index and the index has all contexts? Then use global settings
+    if (_cmsAtomicLoad32(&_cmsContextsNotIndexed) == 0)
+        return &globalContext;
+#endif
+
     InitContextMutex();
 
     // Search
@@ -776,6 +962,9 @@ void* _cmsContextGetClientChunk(cmsContext ContextID, _cmsMemoryClient mc)
 // identify which plug-in to unregister.
 void CMSEXPORT cmsUnregisterPlugins(cmsContext ContextID)
 {    
+    // Parallelization goes first, as the scheduler may need the memory
+    // plug-in to release its per-context resources
+    _cmsRegisterParallelizationPlugin(ContextID, NULL);
     _cmsRegisterMemHandlerPlugin(ContextID, NULL);
     _cmsRegisterInterpPlugin(ContextID, NULL);
     _cmsRegisterTagTypePlugin(ContextID, NULL);
@@ -787,8 +976,6 @@ void CMSEXPORT cmsUnregisterPlugins(cmsContext ContextID)
     _cmsRegisterOptimizationPlugin(ContextID, NULL);
     _cmsRegisterTransformPlugin(ContextID, NULL);
     _cmsRegisterMutexPlugin(ContextID, NULL);
-    _cmsRegisterParallelizationPlugin(ContextID, NULL);
-
 }
 
 
@@ -845,6 +1032,7 @@ cmsContext CMSEXPORT cmsCreateContext(void* Plugin, void* UserData)
     _cmsEnterCriticalSectionPrimitive(&_cmsContextPoolHeadMutex);
        ctx ->Next = _cmsContextPoolHead;
        _cmsContextPoolHead = ctx;
+       IndexContext(ctx);
     _cmsLeaveCriticalSectionPrimitive(&_cmsContextPoolHeadMutex);
 
     ctx ->chunks[UserPtr]     = UserData;
@@ -873,6 +1061,8 @@ cmsContext CMSEXPORT cmsCreateContext(void* Plugin, void* UserData)
     _cmsAllocTransformPluginChunk(ctx, NULL);
     _cmsAllocMutexPluginChunk(ctx, NULL);
     _cmsAllocParallelizationPluginChunk(ctx, NULL);
+    _cmsAllocTransformCacheChunk(ctx, NULL);
+    _cmsAllocProfilePoolChunk(ctx, NULL);
 
     // Setup the plug-ins
     if (!cmsPlugin(ctx, Plugin)) {
@@ -912,6 +1102,7 @@ cmsContext CMSEXPORT cmsDupContext(cmsContext ContextID, void* NewUserData)
     _cmsEnterCriticalSectionPrimitive(&_cmsContextPoolHeadMutex);
        ctx ->Next = _cmsContextPoolHead;
        _cmsContextPoolHead = ctx;
+       IndexContext(ctx);
     _cmsLeaveCriticalSectionPrimitive(&_cmsContextPoolHeadMutex);
 
     ctx ->chunks[UserPtr]    = userData;
@@ -940,6 +1131,8 @@ cmsContext CMSEXPORT cmsDupContext(cmsContext ContextID, void* NewUserData)
     _cmsAllocTransformPluginChunk(ctx, src);
     _cmsAllocMutexPluginChunk(ctx, src);
     _cmsAllocParallelizationPluginChunk(ctx, src);
+    _cmsAllocTransformCacheChunk(ctx, src);
+    _cmsAllocProfilePoolChunk(ctx, src);
 
     // Make sure no one failed
     for (i=Logger; i < MemoryClientMax; i++) {
@@ -961,6 +1154,8 @@ void CMSEXPORT cmsDeleteContext(cmsContext ContextID)
 {
     if (ContextID == NULL) {
 
+        _cmsFreeTransformCache(ContextID);
+        _cmsFreeProfilePool(ContextID);
         cmsUnregisterPlugins(ContextID);
         if (globalContext.MemPool != NULL)
             _cmsSubAllocDestroy(globalContext.MemPool);
@@ -979,6 +1174,10 @@ void CMSEXPORT cmsDeleteContext(cmsContext ContextID)
         fakeContext.chunks[UserPtr]     = ctx ->chunks[UserPtr];
         fakeContext.chunks[MemPlugin]   = &fakeContext.DefaultMemoryManager;
 
+        // Cached transforms and pooled profiles may hold plug-in data, so they go first
+        _cmsFreeTransformCache(ContextID);
+        _cmsFreeProfilePool(ContextID);
+
         // Get rid of plugins
         cmsUnregisterPlugins(ContextID);
 
@@ -989,6 +1188,7 @@ void CMSEXPORT cmsDeleteContext(cmsContext ContextID)
 
         // Maintain list
         _cmsEnterCriticalSectionPrimitive(&_cmsContextPoolHeadMutex);
+        UnindexContext(ctx);
         if (_cmsContextPoolHead == ctx) {
 
             _cmsContextPoolHead = ctx->Next;
@@ -1063,3 +1263,36 @@ cmsUInt32Number _cmsAdjustReferenceCount(cmsUInt32Number *rc, int delta)
 
     return refs;
 }
+
+void _cmsAccumulateCounter(cmsUInt32Number *Counter, cmsUInt32Number Delta)
+{
+    _cmsAssert(Counter != NULL);
+
+    if (Delta == 0) return;
+
+#ifdef CMS_ATOMIC_POINTERS
+    _cmsAtomicAdd32(Counter, Delta);
+#else
+    _cmsEnterCriticalSectionPrimitive(&_cmsContextPoolHeadMutex);
+    *Counter += Delta;
+    _cmsLeaveCriticalSectionPrimitive(&_cmsContextPoolHeadMutex);
+#endif
+}
+
+void* _cmsExchangePointer(void** Ptr, void* Value)
+{
+    void* Old;
+
+    _cmsAssert(Ptr != NULL);
+
+#ifdef CMS_ATOMIC_POINTERS
+    Old = _cmsAtomicExchangePtr(Ptr, Value);
+#else
+    _cmsEnterCriticalSectionPrimitive(&_cmsContextPoolHeadMutex);
+    Old  = *Ptr;
+    *Ptr = Value;
+    _cmsLeaveCriticalSectionPrimitive(&_cmsContextPoolHeadMutex);
+#endif
+
+    return Old;
+}
@@ -51,7 +51,7 @@ cmsHTRANSFORM CreateRoundtripXForm(cmsContext ContextID, cmsHPROFILE hProfile, c
     Intents[0]   = INTENT_RELATIVE_COLORIMETRIC; Intents[1] = nIntent; Intents[2] = INTENT_RELATIVE_COLORIMETRIC; Intents[3] = INTENT_RELATIVE_COLORIMETRIC;
 
     xform =  cmsCreateExtendedTransform(ContextID, 4, hProfiles, BPC, Intents,
-        States, NULL, 0, TYPE_Lab_DBL, TYPE_Lab_DBL, cmsFLAGS_NOCACHE|cmsFLAGS_NOOPTIMIZE);
+        States, NULL, 0, TYPE_Lab_DBL, TYPE_Lab_DBL, cmsFLAGS_NOCACHE|cmsFLAGS_NOOPTIMIZE|cmsFLAGS_NOTRANSFORMCACHE);
 
     cmsCloseProfile(ContextID, hLab);
     return xform;
@@ -109,7 +109,7 @@ cmsBool  BlackPointAsDarkerColorant(cmsContext ContextID,
 
     // Create the transform
     xform = cmsCreateTransform(ContextID, hInput, dwFormat,
-                                hLab, TYPE_Lab_DBL, Intent, cmsFLAGS_NOOPTIMIZE|cmsFLAGS_NOCACHE);
+                                hLab, TYPE_Lab_DBL, Intent, cmsFLAGS_NOOPTIMIZE|cmsFLAGS_NOCACHE|cmsFLAGS_NOTRANSFORMCACHE);
     cmsCloseProfile(ContextID, hLab);
 
     if (xform == NULL) {
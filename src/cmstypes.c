@@ -2667,17 +2667,18 @@ cmsStage* ReadCLUT(cmsContext ContextID, struct _cms_typehandler_struct* self, c
     // Precision can be 1 or 2 bytes
     if (Precision == 1) {
 
-        cmsUInt8Number  v;
+        // Read the bytes into the tail of the table and expand from the start, so no byte
+        // is overwritten before being used
+        cmsUInt8Number* v = (cmsUInt8Number*) Data ->Tab.T + Data ->nEntries;
 
-        for (i=0; i < Data ->nEntries; i++) {
-
-            if (io ->Read(ContextID, io, &v, sizeof(cmsUInt8Number), 1) != 1) {
-                cmsStageFree(ContextID, CLUT);
-                return NULL;
-            }
-            Data ->Tab.T[i] = FROM_8_TO_16(v);
+        if (Data ->nEntries > 0 && io ->Read(ContextID, io, v, sizeof(cmsUInt8Number), Data ->nEntries) != Data ->nEntries) {
+            cmsStageFree(ContextID, CLUT);
+            return NULL;
         }
 
+        for (i=0; i < Data ->nEntries; i++)
+            Data ->Tab.T[i] = FROM_8_TO_16(v[i]);
+
     }
     else
         if (Precision == 2) {
@@ -4350,9 +4351,7 @@ cmsToneCurve* ReadSegmentedCurve(cmsContext ContextID, struct _cms_typehandler_s
                if (Segments[i].SampledPoints == NULL) goto Error;
 
                Segments[i].SampledPoints[0] = 0;
-               for (j = 1; j < Count; j++) {
-                   if (!_cmsReadFloat32Number(ContextID, io, &Segments[i].SampledPoints[j])) goto Error;
-               }
+               if (!_cmsReadFloat32Array(ContextID, io, Count - 1, Segments[i].SampledPoints + 1)) goto Error;
            }
            break;
 
@@ -4702,10 +4701,7 @@ void *Type_MPEclut_Read(cmsContext ContextID, struct _cms_typehandler_struct* se
 
     // Read and sanitize the data
     clut = (_cmsStageCLutData*) mpe ->Data;
-    for (i=0; i < clut ->nEntries; i++) {
-
-        if (!_cmsReadFloat32Number(ContextID, io, &clut->Tab.TFloat[i])) goto Error;
-    }
+    if (!_cmsReadFloat32Array(ContextID, io, clut ->nEntries, clut->Tab.TFloat)) goto Error;
 
     *nItems = 1;
     return mpe;
@@ -341,30 +341,34 @@ Error:
 //     K: Does not change
 
 static
-int InkLimitingSampler(cmsContext ContextID, CMSREGISTER const cmsUInt16Number In[], CMSREGISTER cmsUInt16Number Out[], CMSREGISTER void* Cargo)
+int InkLimitingSampler(cmsContext ContextID, const cmsUInt16Number In[], cmsUInt16Number Out[], cmsUInt32Number nNodes, void* Cargo)
 {
     cmsFloat64Number InkLimit = *(cmsFloat64Number *) Cargo;
     cmsFloat64Number SumCMY, SumCMYK, Ratio;
+    cmsUInt32Number k;
     cmsUNUSED_PARAMETER(ContextID);
 
     InkLimit = (InkLimit * 655.35);
 
-    SumCMY   = (cmsFloat64Number) In[0]  + In[1] + In[2];
-    SumCMYK  = SumCMY + In[3];
+    for (k = 0; k < nNodes; k++, In += 4, Out += 4) {
 
-    if (SumCMYK > InkLimit) {
+        SumCMY   = (cmsFloat64Number) In[0]  + In[1] + In[2];
+        SumCMYK  = SumCMY + In[3];
 
-        Ratio = 1 - ((SumCMYK - InkLimit) / SumCMY);
-        if (Ratio < 0)
-            Ratio = 0;
-    }
-    else Ratio = 1;
+        if (SumCMYK > InkLimit) {
+
+            Ratio = 1 - ((SumCMYK - InkLimit) / SumCMY);
+            if (Ratio < 0)
+                Ratio = 0;
+        }
+        else Ratio = 1;
 
-    Out[0] = _cmsQuickSaturateWord(In[0] * Ratio);     // C
-    Out[1] = _cmsQuickSaturateWord(In[1] * Ratio);     // M
-    Out[2] = _cmsQuickSaturateWord(In[2] * Ratio);     // Y
+        Out[0] = _cmsQuickSaturateWord(In[0] * Ratio);     // C
+        Out[1] = _cmsQuickSaturateWord(In[1] * Ratio);     // M
+        Out[2] = _cmsQuickSaturateWord(In[2] * Ratio);     // Y
 
-    Out[3] = In[3];                                    // K (untouched)
+        Out[3] = In[3];                                    // K (untouched)
+    }
 
     return TRUE;
 }
@@ -415,7 +419,7 @@ cmsHPROFILE CMSEXPORT cmsCreateInkLimitingDeviceLink(cmsContext ContextID,
     CLUT = cmsStageAllocCLut16bit(ContextID, 17, nChannels, nChannels, NULL);
     if (CLUT == NULL) goto Error;
 
-    if (!cmsStageSampleCLut16bit(ContextID, CLUT, InkLimitingSampler, (void*) &Limit, 0)) goto Error;
+    if (!cmsStageSampleCLut16bitN(ContextID, CLUT, InkLimitingSampler, (void*) &Limit, SAMPLER_THREADSAFE)) goto Error;
 
     if (!cmsPipelineInsertStage(ContextID, LUT, cmsAT_BEGIN, _cmsStageAllocIdentityCurves(ContextID, nChannels)) ||
         !cmsPipelineInsertStage(ContextID, LUT, cmsAT_END, CLUT) ||
@@ -764,37 +768,40 @@ typedef struct {
 
 
 static
-int bchswSampler(cmsContext ContextID, CMSREGISTER const cmsUInt16Number In[], CMSREGISTER cmsUInt16Number Out[], CMSREGISTER void* Cargo)
+int bchswSampler(cmsContext ContextID, const cmsUInt16Number In[], cmsUInt16Number Out[], cmsUInt32Number nNodes, void* Cargo)
 {
     cmsCIELab LabIn, LabOut;
     cmsCIELCh LChIn, LChOut;
     cmsCIEXYZ XYZ;
     LPBCHSWADJUSTS bchsw = (LPBCHSWADJUSTS) Cargo;
+    cmsUInt32Number k;
 
+    for (k = 0; k < nNodes; k++, In += 3, Out += 3) {
 
-    cmsLabEncoded2Float(ContextID, &LabIn, In);
+        cmsLabEncoded2Float(ContextID, &LabIn, In);
 
 
-    cmsLab2LCh(ContextID, &LChIn, &LabIn);
+        cmsLab2LCh(ContextID, &LChIn, &LabIn);
 
-    // Do some adjusts on LCh
+        // Do some adjusts on LCh
 
-    LChOut.L = LChIn.L * bchsw ->Contrast + bchsw ->Brightness;
-    LChOut.C = LChIn.C + bchsw -> Saturation;
-    LChOut.h = LChIn.h + bchsw -> Hue;
+        LChOut.L = LChIn.L * bchsw ->Contrast + bchsw ->Brightness;
+        LChOut.C = LChIn.C + bchsw -> Saturation;
+        LChOut.h = LChIn.h + bchsw -> Hue;
 
 
-    cmsLCh2Lab(ContextID, &LabOut, &LChOut);
+        cmsLCh2Lab(ContextID, &LabOut, &LChOut);
 
-    // Move white point in Lab
-    if (bchsw->lAdjustWP) {
-           cmsLab2XYZ(ContextID, &bchsw->WPsrc, &XYZ, &LabOut);
-           cmsXYZ2Lab(ContextID, &bchsw->WPdest, &LabOut, &XYZ);
-    }
+        // Move white point in Lab
+        if (bchsw->lAdjustWP) {
+               cmsLab2XYZ(ContextID, &bchsw->WPsrc, &XYZ, &LabOut);
+               cmsXYZ2Lab(ContextID, &bchsw->WPdest, &LabOut, &XYZ);
+        }
 
-    // Back to encoded
+        // Back to encoded
 
-    cmsFloat2LabEncoded(ContextID, Out, &LabOut);
+        cmsFloat2LabEncoded(ContextID, Out, &LabOut);
+    }
 
     return TRUE;
 }
@@ -859,7 +866,7 @@ cmsHPROFILE CMSEXPORT cmsCreateBCHSWabstractProfile(cmsContext ContextID,
     if (CLUT == NULL) goto Error;
 
 
-    if (!cmsStageSampleCLut16bit(ContextID, CLUT, bchswSampler, (void*) &bchsw, 0)) {
+    if (!cmsStageSampleCLut16bitN(ContextID, CLUT, bchswSampler, (void*) &bchsw, SAMPLER_THREADSAFE)) {
 
         // Shouldn't reach here
         goto Error;
@@ -1059,7 +1066,7 @@ cmsHPROFILE CreateNamedColorDevicelink(cmsContext ContextID, cmsHTRANSFORM xform
     v ->OutputFormat = OutputFormat;
     v ->FromInput    = FromInput;
     v ->ToOutput     = ToOutput;
-    _cmsFindFormatter(v, InputFormat, OutputFormat, v->core->dwOriginalFlags);
+    _cmsFindFormatter(ContextID, v, InputFormat, OutputFormat, v->core->dwOriginalFlags);
 
     // Apply the transform to colorants.
     for (i=0; i < nColors; i++) {
@@ -125,6 +125,283 @@ void _cmsAllocAlarmCodesChunk(struct _cmsContext_struct* ctx,
 
 // -----------------------------------------------------------------------
 
+// Transform cache. Creating a transform means linking, optimizing and maybe sampling a CLUT,
+// which can take milliseconds. Applications creating the same transforms over and over may
+// enable this cache, which returns copies sharing the core of a previously created transform.
+// Profiles are identified by their profile ID, which is computed if absent.
+
+#define MAX_CACHED_PROFILES  8
+
+// Everything that makes a transform different. Zeroed before filled, so it can be compared as a whole
+typedef struct {
+
+    cmsUInt32Number  nProfiles;
+    cmsProfileID     ProfileIDs[MAX_CACHED_PROFILES];
+    cmsUInt32Number  Intents[MAX_CACHED_PROFILES];
+    cmsBool          BPC[MAX_CACHED_PROFILES];
+    cmsFloat64Number AdaptationStates[MAX_CACHED_PROFILES];
+
+    cmsProfileID     GamutProfileID;
+    cmsUInt32Number  nGamutPCSposition;
+
+    cmsUInt32Number  InputFormat;
+    cmsUInt32Number  OutputFormat;
+    cmsUInt32Number  dwFlags;
+    cmsFloat64Number GridErrorBudget;
+
+} _cmsTransformKey;
+
+typedef struct _cmsTransformCacheEntry_st {
+
+    struct _cmsTransformCacheEntry_st* Next;
+
+    _cmsTransformKey Key;
+    _cmsTRANSFORM*   xform;         // Owned by the cache
+
+} _cmsTransformCacheEntry;
+
+_cmsTransformCacheChunkType _cmsTransformCacheChunk = { NULL, 0, 0, NULL, 0, 0 };
+
+// Cached transforms belong to the context, so duplicates start empty and disabled
+void _cmsAllocTransformCacheChunk(struct _cmsContext_struct* ctx,
+                                  const struct _cmsContext_struct* src)
+{
+    static _cmsTransformCacheChunkType TransformCacheChunk = { NULL, 0, 0, NULL, 0, 0 };
+
+    cmsUNUSED_PARAMETER(src);
+
+    ctx ->chunks[TransformCacheContext] = _cmsSubAllocDup(ctx ->MemPool, &TransformCacheChunk, sizeof(_cmsTransformCacheChunkType));
+}
+
+static void* AllocHashCache(cmsContext ContextID);
+static void  FreeHashCache(cmsContext ContextID, void* HashCache);
+
+// Another handle sharing the core of the given transform. Handles that are never used on pixels
+// don't need a multi-entry cache table of their own.
+static
+_cmsTRANSFORM* DupTransform(cmsContext ContextID, const _cmsTRANSFORM* p, cmsBool WithPixelCache)
+{
+    _cmsTRANSFORM* xform = (_cmsTRANSFORM*) _cmsDupMem(ContextID, p, sizeof(_cmsTRANSFORM));
+
+    if (xform != NULL) {
+        (void) _cmsAdjustReferenceCount(&xform->core->refs, 1);
+        xform->HashCacheHits = xform->HashCacheMisses = 0;
+        xform->HashCache = NULL;
+
+        // Without a table, the multi-entry cache just runs uncached
+        if (WithPixelCache && p->HashCacheFallback != NULL)
+            xform->HashCache = AllocHashCache(ContextID);
+    }
+
+    return xform;
+}
+
+// Unlinks the entries beyond the allowed size and returns them as a list. Cache must be locked
+static
+_cmsTransformCacheEntry* TrimTransformCache(_cmsTransformCacheChunkType* cache, cmsUInt32Number MaxEntries)
+{
+    _cmsTransformCacheEntry** pt = &cache->Head;
+    _cmsTransformCacheEntry* Evicted;
+    cmsUInt32Number n = 0;
+
+    if (cache->nEntries <= MaxEntries) return NULL;
+
+    while (n < MaxEntries) {
+        pt = &(*pt)->Next;
+        n++;
+    }
+
+    Evicted = *pt;
+    *pt = NULL;
+    cache->nEntries = MaxEntries;
+
+    return Evicted;
+}
+
+// Deletes a list of entries, out of the cache lock
+static
+void FreeTransformCacheEntries(cmsContext ContextID, _cmsTransformCacheEntry* e)
+{
+    _cmsTransformCacheEntry* Next;
+
+    for (; e != NULL; e = Next) {
+
+        Next = e->Next;
+        cmsDeleteTransform(ContextID, (cmsHTRANSFORM) e->xform);
+        _cmsFree(ContextID, e);
+    }
+}
+
+// Sets the number of transforms kept by the cache of this context. Zero disables the cache and
+// releases all entries. Not meant to be called while other threads are creating transforms.
+void CMSEXPORT cmsSetTransformCacheSize(cmsContext ContextID, cmsUInt32Number MaxEntries)
+{
+    _cmsTransformCacheChunkType* cache = (_cmsTransformCacheChunkType*) _cmsContextGetClientChunk(ContextID, TransformCacheContext);
+    _cmsTransformCacheEntry* Evicted;
+
+    if (cache->Mutex == NULL) {
+
+        if (MaxEntries == 0) return;
+
+        cache->Mutex = _cmsCreateMutex(ContextID);
+        if (cache->Mutex == NULL) return;
+    }
+
+    if (!_cmsLockMutex(ContextID, cache->Mutex)) return;
+
+    cache->MaxEntries = MaxEntries;
+    Evicted = TrimTransformCache(cache, MaxEntries);
+
+    _cmsUnlockMutex(ContextID, cache->Mutex);
+
+    FreeTransformCacheEntries(ContextID, Evicted);
+}
+
+// Hit and miss counts since the context was created
+void CMSEXPORT cmsGetTransformCacheStats(cmsContext ContextID, cmsUInt32Number* Hits, cmsUInt32Number* Misses)
+{
+    _cmsTransformCacheChunkType* cache = (_cmsTransformCacheChunkType*) _cmsContextGetClientChunk(ContextID, TransformCacheContext);
+    cmsBool Locked = cache->Mutex != NULL && _cmsLockMutex(ContextID, cache->Mutex);
+
+    if (Hits)   *Hits   = cache->Hits;
+    if (Misses) *Misses = cache->Misses;
+
+    if (Locked) _cmsUnlockMutex(ContextID, cache->Mutex);
+}
+
+// Called on context deletion
+void _cmsFreeTransformCache(cmsContext ContextID)
+{
+    _cmsTransformCacheChunkType* cache = (_cmsTransformCacheChunkType*) _cmsContextGetClientChunk(ContextID, TransformCacheContext);
+
+    if (cache->Mutex == NULL) return;
+
+    cmsSetTransformCacheSize(ContextID, 0);
+
+    _cmsDestroyMutex(ContextID, cache->Mutex);
+    cache->Mutex = NULL;
+}
+
+// Gets the key of a profile. Embedded IDs are not trusted, as nothing tells whether they still match the
+// contents. The content ID is computed once per profile, and pooled profiles get it from the pool.
+static
+cmsBool GetProfileIDForCache(cmsContext ContextID, cmsHPROFILE hProfile, cmsProfileID* ID)
+{
+    return _cmsGetProfileContentID(ContextID, hProfile, ID);
+}
+
+// Fills the key. Returns FALSE if the transform cannot be cached
+static
+cmsBool ComputeTransformKey(cmsContext ContextID, _cmsTransformKey* Key,
+                            cmsUInt32Number nProfiles, cmsHPROFILE hProfiles[],
+                            cmsBool  BPC[],
+                            cmsUInt32Number Intents[],
+                            cmsFloat64Number AdaptationStates[],
+                            cmsHPROFILE hGamutProfile,
+                            cmsUInt32Number nGamutPCSposition,
+                            cmsUInt32Number InputFormat,
+                            cmsUInt32Number OutputFormat,
+                            cmsUInt32Number dwFlags)
+{
+    cmsUInt32Number i;
+
+    if (nProfiles == 0 || nProfiles > MAX_CACHED_PROFILES) return FALSE;
+
+    memset(Key, 0, sizeof(_cmsTransformKey));
+
+    Key->nProfiles = nProfiles;
+
+    for (i = 0; i < nProfiles; i++) {
+
+        if (hProfiles[i] == NULL) return FALSE;
+        if (!GetProfileIDForCache(ContextID, hProfiles[i], &Key->ProfileIDs[i])) return FALSE;
+
+        Key->Intents[i] = Intents[i];
+        Key->BPC[i] = BPC[i] ? TRUE : FALSE;
+        Key->AdaptationStates[i] = AdaptationStates[i];
+    }
+
+    if (hGamutProfile != NULL && (dwFlags & cmsFLAGS_GAMUTCHECK)) {
+
+        if (!GetProfileIDForCache(ContextID, hGamutProfile, &Key->GamutProfileID)) return FALSE;
+        Key->nGamutPCSposition = nGamutPCSposition;
+    }
+
+    Key->InputFormat  = InputFormat;
+    Key->OutputFormat = OutputFormat;
+    Key->dwFlags      = dwFlags;
+    Key->GridErrorBudget = _cmsGetGridpointsErrorBudget(ContextID);
+
+    return TRUE;
+}
+
+// Returns a new handle on a cached transform, or NULL if not found. The entry becomes the most recent one.
+static
+_cmsTRANSFORM* LookupTransformCache(cmsContext ContextID, _cmsTransformCacheChunkType* cache, const _cmsTransformKey* Key)
+{
+    _cmsTransformCacheEntry** pt;
+    _cmsTransformCacheEntry* e;
+    _cmsTRANSFORM* xform = NULL;
+
+    if (!_cmsLockMutex(ContextID, cache->Mutex)) return NULL;
+
+    for (pt = &cache->Head; *pt != NULL; pt = &(*pt)->Next) {
+
+        e = *pt;
+        if (memcmp(&e->Key, Key, sizeof(_cmsTransformKey)) == 0) {
+
+            // Move to front
+            *pt = e->Next;
+            e->Next = cache->Head;
+            cache->Head = e;
+
+            xform = DupTransform(ContextID, e->xform, TRUE);
+            break;
+        }
+    }
+
+    if (xform != NULL) cache->Hits++;
+    else               cache->Misses++;
+
+    _cmsUnlockMutex(ContextID, cache->Mutex);
+    return xform;
+}
+
+// Keeps a handle on a just created transform. On any error the transform is just not cached.
+static
+void InsertTransformCache(cmsContext ContextID, _cmsTransformCacheChunkType* cache, const _cmsTransformKey* Key, const _cmsTRANSFORM* xform)
+{
+    _cmsTransformCacheEntry* e;
+    _cmsTransformCacheEntry* Evicted = NULL;
+
+    e = (_cmsTransformCacheEntry*) _cmsMalloc(ContextID, sizeof(_cmsTransformCacheEntry));
+    if (e == NULL) return;
+
+    memcpy(&e->Key, Key, sizeof(_cmsTransformKey));
+    e->xform = DupTransform(ContextID, xform, FALSE);
+    if (e->xform == NULL) {
+        _cmsFree(ContextID, e);
+        return;
+    }
+
+    if (!_cmsLockMutex(ContextID, cache->Mutex)) {
+        FreeTransformCacheEntries(ContextID, e);
+        return;
+    }
+
+    e->Next = cache->Head;
+    cache->Head = e;
+    cache->nEntries++;
+
+    Evicted = TrimTransformCache(cache, cache->MaxEntries);
+
+    _cmsUnlockMutex(ContextID, cache->Mutex);
+
+    FreeTransformCacheEntries(ContextID, Evicted);
+}
+
+// -----------------------------------------------------------------------
+
 // Get rid of transform resources
 void CMSEXPORT cmsDeleteTransform(cmsContext ContextID, cmsHTRANSFORM hTransform)
 {
@@ -140,6 +417,9 @@ void CMSEXPORT cmsDeleteTransform(cmsContext ContextID, cmsHTRANSFORM hTransform
     _cmsAssert(core != NULL);
 
     refs = _cmsAdjustReferenceCount(&core->refs, -1);
+
+    if (p->HashCache)
+        FreeHashCache(ContextID, p->HashCache);
     _cmsFree(ContextID, (void *) p);
 
     if (refs != 0)
@@ -247,6 +527,9 @@ void CMSEXPORT cmsDoTransformLineStrideEx(cmsContext ContextID, cmsHTRANSFORM  T
 
 // Transform routines ----------------------------------------------------------------------------------------------------------
 
+// Pipelines are fed with groups of this many pixels when no per-pixel decision is needed
+#define BATCH_XFORM_PIXELS 64
+
 // Float xform converts floats. Since there are no performance issues, one routine does all job, including gamut check.
 // Note that because extended range, we can use a -1.0 value for out of gamut in this case.
 static
@@ -260,9 +543,12 @@ void FloatXFORM(cmsContext ContextID, _cmsTRANSFORM* p,
     cmsUInt8Number* accum;
     cmsUInt8Number* output;
     cmsFloat32Number fIn[cmsMAXCHANNELS], fOut[cmsMAXCHANNELS];
+    cmsFloat32Number BatchIn[BATCH_XFORM_PIXELS * cmsMAXCHANNELS], BatchOut[BATCH_XFORM_PIXELS * cmsMAXCHANNELS];
     cmsFloat32Number OutOfGamut;
-    size_t i, j, c, strideIn, strideOut;
+    size_t i, j, k, n, c, strideIn, strideOut;
     _cmsTRANSFORMCORE *core = p->core;
+    cmsUInt32Number nIn  = cmsPipelineInputChannels(ContextID, core->Lut);
+    cmsUInt32Number nOut = cmsPipelineOutputChannels(ContextID, core->Lut);
 
     _cmsHandleExtraChannels(ContextID, p, in, out, PixelsPerLine, LineCount, Stride);
 
@@ -276,6 +562,48 @@ void FloatXFORM(cmsContext ContextID, _cmsTRANSFORM* p,
         accum = (cmsUInt8Number*)in + strideIn;
         output = (cmsUInt8Number*)out + strideOut;
 
+        // No gamut check at all, the pipeline runs on groups of pixels
+        if (core->GamutCheck == NULL) {
+
+            for (j = 0; j < PixelsPerLine; j += n) {
+
+                n = PixelsPerLine - j;
+                if (n > BATCH_XFORM_PIXELS) n = BATCH_XFORM_PIXELS;
+
+                if (p->FromInputFloatBlock != NULL) {
+
+                    accum = p->FromInputFloatBlock(ContextID, p, BatchIn, accum, (cmsUInt32Number) n);
+                }
+                else {
+
+                    for (k = 0; k < n; k++) {
+
+                        accum = p->FromInputFloat(ContextID, p, fIn, accum, Stride->BytesPerPlaneIn);
+                        memmove(BatchIn + k * nIn, fIn, nIn * sizeof(cmsFloat32Number));
+                    }
+                }
+
+                cmsPipelineEvalFloatN(ContextID, BatchIn, BatchOut, (cmsUInt32Number) n, core->Lut);
+
+                if (p->ToOutputFloatBlock != NULL) {
+
+                    output = p->ToOutputFloatBlock(ContextID, p, BatchOut, output, (cmsUInt32Number) n);
+                }
+                else {
+
+                    for (k = 0; k < n; k++) {
+
+                        memmove(fOut, BatchOut + k * nOut, nOut * sizeof(cmsFloat32Number));
+                        output = p->ToOutputFloat(ContextID, p, fOut, output, Stride->BytesPerPlaneOut);
+                    }
+                }
+            }
+
+            strideIn += Stride->BytesPerLineIn;
+            strideOut += Stride->BytesPerLineOut;
+            continue;
+        }
+
         for (j = 0; j < PixelsPerLine; j++) {
 
             accum = p->FromInputFloat(ContextID, p, fIn, accum, Stride->BytesPerPlaneIn);
@@ -1764,136 +2092,467 @@ do {                                            \
 } while (0)
 #include "extra_xform.h"
 
+// Batch evaluation --------------------------------------------------------------------------------------------------
 
-// Transform plug-ins ----------------------------------------------------------------------------------------------------
+// Pipelines having a batch evaluator are fed with groups of pixels. Unless the cache is disabled,
+// a pixel equal to the one before takes the same result, as the 1-pixel cache would do.
 
-// List of used-defined transform factories
-typedef struct _cmsTransformCollection_st {
+static
+void BatchXFORM(cmsContext ContextID,
+                _cmsTRANSFORM* p,
+                const cmsUInt8Number* in,
+                cmsUInt8Number* out,
+                cmsUInt32Number PixelsPerLine,
+                cmsUInt32Number LineCount,
+                const cmsStride* Stride)
+{
+    _cmsTRANSFORMCORE* core = p->core;
+    cmsPipeline* Lut = core->Lut;
+    cmsUInt32Number nIn  = Lut->InputChannels;
+    cmsUInt32Number nOut = Lut->OutputChannels;
+    cmsBool Dedup = !(core->dwOriginalFlags & cmsFLAGS_NOCACHE);
+    cmsUInt16Number wIn[cmsMAXCHANNELS];
+    cmsUInt16Number BatchIn[BATCH_XFORM_PIXELS * cmsMAXCHANNELS];
+    cmsUInt16Number BatchOut[BATCH_XFORM_PIXELS * cmsMAXCHANNELS];
+    cmsUInt32Number Slot[BATCH_XFORM_PIXELS];
+    cmsUInt32Number i, j, k, n, nSlots;
 
-    _cmsTransform2Factory  Factory;
-    //cmsBool                OldXform;   // Factory returns xform function in the old style
+    if (core->dwOriginalFlags & cmsFLAGS_COPY_ALPHA)
+        _cmsHandleExtraChannels(ContextID, p, in, out, PixelsPerLine, LineCount, Stride);
 
-    struct _cmsTransformCollection_st *Next;
+    memset(wIn, 0, sizeof(wIn));
 
-} _cmsTransformCollection;
+    for (i = 0; i < LineCount; i++) {
 
-// The linked list head
-_cmsTransformPluginChunkType _cmsTransformPluginChunk = { NULL };
+        cmsUInt8Number* accum  = (cmsUInt8Number*) in;
+        cmsUInt8Number* output = out;
 
+        for (j = 0; j < PixelsPerLine; j += n) {
 
-// Duplicates the zone of memory used by the plug-in in the new context
-static
-void DupPluginTransformList(struct _cmsContext_struct* ctx,
-                                               const struct _cmsContext_struct* src)
-{
-   _cmsTransformPluginChunkType newHead = { NULL };
-   _cmsTransformCollection*  entry;
-   _cmsTransformCollection*  Anterior = NULL;
-   _cmsTransformPluginChunkType* head = (_cmsTransformPluginChunkType*) src->chunks[TransformPlugin];
+            n = PixelsPerLine - j;
+            if (n > BATCH_XFORM_PIXELS) n = BATCH_XFORM_PIXELS;
 
-    // Walk the list copying all nodes
-   for (entry = head->TransformCollection;
-        entry != NULL;
-        entry = entry ->Next) {
+            nSlots = 0;
 
-            _cmsTransformCollection *newEntry = ( _cmsTransformCollection *) _cmsSubAllocDup(ctx ->MemPool, entry, sizeof(_cmsTransformCollection));
+            if (p->FromInputBlock != NULL) {
 
-            if (newEntry == NULL)
-                return;
+                // The whole group is unrolled at once, then repeated pixels are squeezed out in place
+                accum = p->FromInputBlock(ContextID, p, BatchIn, accum, n);
 
-            // We want to keep the linked list order, so this is a little bit tricky
-            newEntry -> Next = NULL;
-            if (Anterior)
-                Anterior -> Next = newEntry;
+                for (k = 0; k < n; k++) {
 
-            Anterior = newEntry;
+                    cmsUInt16Number* Pixel = BatchIn + k * nIn;
 
-            if (newHead.TransformCollection == NULL)
-                newHead.TransformCollection = newEntry;
-    }
+                    if (Dedup && nSlots > 0 &&
+                        memcmp(Pixel, BatchIn + (nSlots - 1) * nIn, nIn * sizeof(cmsUInt16Number)) == 0) {
 
-  ctx ->chunks[TransformPlugin] = _cmsSubAllocDup(ctx->MemPool, &newHead, sizeof(_cmsTransformPluginChunkType));
-}
+                        Slot[k] = nSlots - 1;
+                    }
+                    else {
 
-// Allocates memory for transform plugin factory
-void _cmsAllocTransformPluginChunk(struct _cmsContext_struct* ctx,
-                                        const struct _cmsContext_struct* src)
-{
-    if (src != NULL) {
+                        if (nSlots != k)
+                            memcpy(BatchIn + nSlots * nIn, Pixel, nIn * sizeof(cmsUInt16Number));
+                        Slot[k] = nSlots++;
+                    }
+                }
+            }
+            else {
 
-        // Copy all linked list
-        DupPluginTransformList(ctx, src);
-    }
-    else {
-        static _cmsTransformPluginChunkType TransformPluginChunkType = { NULL };
-        ctx ->chunks[TransformPlugin] = _cmsSubAllocDup(ctx ->MemPool, &TransformPluginChunkType, sizeof(_cmsTransformPluginChunkType));
-    }
-}
+                for (k = 0; k < n; k++) {
 
-#if 0
-// Adaptor for old versions of plug-in
-static
-void _cmsTransform2toTransformAdaptor(cmsContext ContextID, struct _cmstransform_struct *CMMcargo,
-                                      const void* InputBuffer,
-                                      void* OutputBuffer,
-                                      cmsUInt32Number PixelsPerLine,
-                                      cmsUInt32Number LineCount,
-                                      const cmsStride* Stride)
-{
+                    accum = p->FromInput(ContextID, p, wIn, accum, Stride->BytesPerPlaneIn);
 
-       size_t i, strideIn, strideOut;
+                    if (Dedup && nSlots > 0 &&
+                        memcmp(wIn, BatchIn + (nSlots - 1) * nIn, nIn * sizeof(cmsUInt16Number)) == 0) {
 
-       _cmsHandleExtraChannels(ContextID, CMMcargo, InputBuffer, OutputBuffer, PixelsPerLine, LineCount, Stride);
+                        Slot[k] = nSlots - 1;
+                    }
+                    else {
 
-       strideIn = 0;
-       strideOut = 0;
+                        memcpy(BatchIn + nSlots * nIn, wIn, nIn * sizeof(cmsUInt16Number));
+                        Slot[k] = nSlots++;
+                    }
+                }
+            }
 
-       for (i = 0; i < LineCount; i++) {
+            Lut->Eval16NFn(ContextID, BatchIn, BatchOut, nSlots, Lut->Data);
 
-              void *accum = (cmsUInt8Number*)InputBuffer + strideIn;
-              void *output = (cmsUInt8Number*)OutputBuffer + strideOut;
+            if (p->ToOutputBlock != NULL) {
 
-              CMMcargo->OldXform(ContextID, CMMcargo, accum, output, PixelsPerLine, Stride->BytesPerPlaneIn);
+                // Results are spread back to one per pixel. No slot is above its pixel, so going
+                // downwards never overwrites a slot still to be read
+                if (nSlots != n) {
 
-              strideIn += Stride->BytesPerLineIn;
-              strideOut += Stride->BytesPerLineOut;
-       }
-}
-#endif
+                    for (k = n; k-- > 0; ) {
 
+                        if (Slot[k] != k)
+                            memcpy(BatchOut + k * nOut, BatchOut + Slot[k] * nOut, nOut * sizeof(cmsUInt16Number));
+                    }
+                }
 
-// Register new ways to transform
-cmsBool  _cmsRegisterTransformPlugin(cmsContext ContextID, cmsPluginBase* Data)
-{
-    cmsPluginTransform* Plugin = (cmsPluginTransform*) Data;
-    _cmsTransformCollection* fl;
-    _cmsTransformPluginChunkType* ctx = ( _cmsTransformPluginChunkType*) _cmsContextGetClientChunk(ContextID, TransformPlugin);
+                output = p->ToOutputBlock(ContextID, p, BatchOut, output, n);
+            }
+            else {
 
-    if (Data == NULL) {
+                for (k = 0; k < n; k++)
+                    output = p->ToOutput(ContextID, p, BatchOut + Slot[k] * nOut, output, Stride->BytesPerPlaneOut);
+            }
+        }
 
-        // Free the chain. Memory is safely freed at exit
-        ctx->TransformCollection = NULL;
-        return TRUE;
+        in  += Stride->BytesPerLineIn;
+        out += Stride->BytesPerLineOut;
     }
+}
 
-    // Factory callback is required
-    if (Plugin->xform == NULL) return FALSE;
+// Multi-entry pixel cache -------------------------------------------------------------------------------------------
 
+// The 1-pixel cache above only pays off on runs of identical pixels. Images with a limited
+// palette (graphics, posterized or heavily quantized photos) repeat colors that are not
+// adjacent, so cmsFLAGS_HASHCACHE selects a small 2-way set-associative cache keyed by the
+// unpacked 16 bit input. Tables stay warm across calls. Each handle has one slot per worker of
+// the parallelization plug-in, and a worker takes the table of a free slot for the whole call by
+// swapping the pointer out, so lookups need no locking. Workers are not told their index, so
+// slots are tried in order. Tables are allocated the first time their slot is taken, so
+// transforms that are not split only ever get one. A worker finding all slots taken, which only
+// happens if the handle is used by other threads on top of the plug-in, runs uncached.
 
-    fl = (_cmsTransformCollection*) _cmsPluginMalloc(ContextID, sizeof(_cmsTransformCollection));
-    if (fl == NULL) return FALSE;
+#define HASH_CACHE_BITS        9                           // 512 sets of 2 ways
+#define HASH_CACHE_SETS        (1 << HASH_CACHE_BITS)
+#define HASH_CACHE_MAXIN       4                           // Channels that form the key
+#define HASH_CACHE_AUTO_SLOTS  16                          // When the plug-in guesses the number of workers
+#define HASH_CACHE_MAX_SLOTS   64
 
-#if 0
-	// Check for full xform plug-ins previous to 2.8, we would need an adapter in that case
-    if (Plugin->base.ExpectedVersion < (2080 - 2000)) {
+typedef struct {
 
-           fl->OldXform = TRUE;
-    }
-    else
-           fl->OldXform = FALSE;
-#endif
+    cmsUInt16Number In[HASH_CACHE_MAXIN];
+    cmsUInt16Number Out[cmsMAXCHANNELS];
 
-    // Copy the parameters
+} _cmsHashCacheEntry;
+
+typedef struct {
+
+    cmsBool Seeded;                                         // Entries hold the zero seed
+    _cmsHashCacheEntry Entries[2 * HASH_CACHE_SETS];
+
+} _cmsHashCache;
+
+typedef struct {
+
+    cmsUInt32Number nSlots;
+    void*           Slots[HASH_CACHE_MAX_SLOTS];            // NULL=not allocated yet, HASH_CACHE_TAKEN=in use
+
+} _cmsHashCacheSlots;
+
+static cmsUInt8Number HashCacheTakenMark;
+#define HASH_CACHE_TAKEN ((void*) &HashCacheTakenMark)
+
+// As many slots as workers may run the transform at once. Tables are allocated on first use and
+// seeded then, once the zero of the 1-pixel cache is known
+static
+void* AllocHashCache(cmsContext ContextID)
+{
+    cmsInt32Number MaxWorkers = _cmsGetContextMaxWorkers(ContextID);
+    _cmsHashCacheSlots* h = (_cmsHashCacheSlots*) _cmsMallocZero(ContextID, sizeof(_cmsHashCacheSlots));
+
+    if (h == NULL) return NULL;
+
+    if (MaxWorkers < 0)
+        h->nSlots = HASH_CACHE_AUTO_SLOTS;
+    else
+    if (MaxWorkers == 0)
+        h->nSlots = 1;
+    else
+        h->nSlots = (cmsUInt32Number) (MaxWorkers < HASH_CACHE_MAX_SLOTS ? MaxWorkers : HASH_CACHE_MAX_SLOTS);
+
+    return h;
+}
+
+// No worker may be running
+static
+void FreeHashCache(cmsContext ContextID, void* HashCache)
+{
+    _cmsHashCacheSlots* h = (_cmsHashCacheSlots*) HashCache;
+    cmsUInt32Number i;
+
+    for (i = 0; i < h->nSlots; i++) {
+
+        if (h->Slots[i] != NULL && h->Slots[i] != HASH_CACHE_TAKEN)
+            _cmsFree(ContextID, h->Slots[i]);
+    }
+
+    _cmsFree(ContextID, h);
+}
+
+// Takes the table of the first free slot. Writing the mark over a slot already taken is harmless, as
+// its owner puts the table back when done. Returns NULL if all slots are taken or out of memory.
+static
+_cmsHashCache* TakeHashCache(cmsContext ContextID, _cmsHashCacheSlots* h, cmsUInt32Number* Slot)
+{
+    cmsUInt32Number i;
+
+    for (i = 0; i < h->nSlots; i++) {
+
+        void* Old = _cmsExchangePointer(&h->Slots[i], HASH_CACHE_TAKEN);
+
+        if (Old == HASH_CACHE_TAKEN) continue;
+
+        if (Old == NULL) {
+
+            Old = _cmsMallocZero(ContextID, sizeof(_cmsHashCache));
+            if (Old == NULL) {
+                (void) _cmsExchangePointer(&h->Slots[i], NULL);
+                return NULL;
+            }
+        }
+
+        *Slot = i;
+        return (_cmsHashCache*) Old;
+    }
+
+    return NULL;
+}
+
+cmsINLINE cmsUInt32Number HashCacheIndex(const cmsUInt16Number wIn[])
+{
+    cmsUInt32Number h;
+
+    h  = ((cmsUInt32Number) wIn[0] | ((cmsUInt32Number) wIn[1] << 16)) * 0x9E3779B1U;
+    h ^= ((cmsUInt32Number) wIn[2] | ((cmsUInt32Number) wIn[3] << 16)) * 0x85EBCA77U;
+
+    return h >> (32 - HASH_CACHE_BITS);
+}
+
+cmsINLINE cmsBool HashCacheMatch(const cmsUInt16Number a[], const cmsUInt16Number b[])
+{
+    return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
+}
+
+static
+void HashCachedXFORM(cmsContext ContextID,
+                     _cmsTRANSFORM* p,
+                     const cmsUInt8Number* in,
+                     cmsUInt8Number* out,
+                     cmsUInt32Number PixelsPerLine,
+                     cmsUInt32Number LineCount,
+                     const cmsStride* Stride)
+{
+    _cmsTRANSFORMCORE* core = p->core;
+    _cmsHashCacheSlots* h = (_cmsHashCacheSlots*) p->HashCache;
+    _cmsHashCache* Cache;
+    _cmsHashCacheEntry* Table;
+    cmsUInt16Number wIn[cmsMAXCHANNELS];
+    cmsUInt32Number i, j, Slot = 0;
+    cmsUInt32Number Hits = 0, Misses = 0;
+
+    // Take a table. If other workers have them all, go uncached
+    Cache = TakeHashCache(ContextID, h, &Slot);
+    if (Cache == NULL) {
+
+        p->HashCacheFallback(ContextID, p, in, out, PixelsPerLine, LineCount, Stride);
+        return;
+    }
+
+    Table = Cache->Entries;
+
+    // The first call seeds every entry with the precomputed zero, so no valid bits are needed
+    if (!Cache->Seeded) {
+
+        for (i = 0; i < 2 * HASH_CACHE_SETS; i++) {
+
+            memset(Table[i].In, 0, sizeof(Table[i].In));
+            memcpy(Table[i].Out, p->Cache.CacheOut, sizeof(Table[i].Out));
+        }
+
+        Cache->Seeded = TRUE;
+    }
+
+    if (core->dwOriginalFlags & cmsFLAGS_COPY_ALPHA)
+        _cmsHandleExtraChannels(ContextID, p, in, out, PixelsPerLine, LineCount, Stride);
+
+    // Channels beyond the input ones stay zero and take part in the key
+    memset(wIn, 0, sizeof(wIn));
+
+    for (i = 0; i < LineCount; i++) {
+
+        cmsUInt8Number* accum  = (cmsUInt8Number*) in;
+        cmsUInt8Number* output = out;
+
+        for (j = 0; j < PixelsPerLine; j++) {
+
+            _cmsHashCacheEntry* Set;
+
+            accum = p->FromInput(ContextID, p, wIn, accum, Stride->BytesPerPlaneIn);
+
+            Set = Table + 2 * HashCacheIndex(wIn);
+
+            if (HashCacheMatch(Set[0].In, wIn)) {
+                Hits++;
+            }
+            else
+            if (HashCacheMatch(Set[1].In, wIn)) {
+
+                // Most recently used goes first
+                _cmsHashCacheEntry tmp = Set[0];
+                Set[0] = Set[1];
+                Set[1] = tmp;
+                Hits++;
+            }
+            else {
+
+                Set[1] = Set[0];
+                memcpy(Set[0].In, wIn, sizeof(Set[0].In));
+
+                if (core->GamutCheck != NULL)
+                    TransformOnePixelWithGamutCheck(ContextID, p, wIn, Set[0].Out);
+                else
+                    core->Lut->Eval16Fn(ContextID, wIn, Set[0].Out, core->Lut->Data);
+                Misses++;
+            }
+
+            output = p->ToOutput(ContextID, p, Set[0].Out, output, Stride->BytesPerPlaneOut);
+        }
+
+        in  += Stride->BytesPerLineIn;
+        out += Stride->BytesPerLineOut;
+    }
+
+    // Give the table back
+    (void) _cmsExchangePointer(&h->Slots[Slot], Cache);
+
+    _cmsAccumulateCounter(&p->HashCacheHits, Hits);
+    _cmsAccumulateCounter(&p->HashCacheMisses, Misses);
+}
+
+
+// Transform plug-ins ----------------------------------------------------------------------------------------------------
+
+// List of used-defined transform factories
+typedef struct _cmsTransformCollection_st {
+
+    _cmsTransform2Factory  Factory;
+    //cmsBool                OldXform;   // Factory returns xform function in the old style
+
+    struct _cmsTransformCollection_st *Next;
+
+} _cmsTransformCollection;
+
+// The linked list head
+_cmsTransformPluginChunkType _cmsTransformPluginChunk = { NULL };
+
+
+// Duplicates the zone of memory used by the plug-in in the new context
+static
+void DupPluginTransformList(struct _cmsContext_struct* ctx,
+                                               const struct _cmsContext_struct* src)
+{
+   _cmsTransformPluginChunkType newHead = { NULL };
+   _cmsTransformCollection*  entry;
+   _cmsTransformCollection*  Anterior = NULL;
+   _cmsTransformPluginChunkType* head = (_cmsTransformPluginChunkType*) src->chunks[TransformPlugin];
+
+    // Walk the list copying all nodes
+   for (entry = head->TransformCollection;
+        entry != NULL;
+        entry = entry ->Next) {
+
+            _cmsTransformCollection *newEntry = ( _cmsTransformCollection *) _cmsSubAllocDup(ctx ->MemPool, entry, sizeof(_cmsTransformCollection));
+
+            if (newEntry == NULL)
+                return;
+
+            // We want to keep the linked list order, so this is a little bit tricky
+            newEntry -> Next = NULL;
+            if (Anterior)
+                Anterior -> Next = newEntry;
+
+            Anterior = newEntry;
+
+            if (newHead.TransformCollection == NULL)
+                newHead.TransformCollection = newEntry;
+    }
+
+  ctx ->chunks[TransformPlugin] = _cmsSubAllocDup(ctx->MemPool, &newHead, sizeof(_cmsTransformPluginChunkType));
+}
+
+// Allocates memory for transform plugin factory
+void _cmsAllocTransformPluginChunk(struct _cmsContext_struct* ctx,
+                                        const struct _cmsContext_struct* src)
+{
+    if (src != NULL) {
+
+        // Copy all linked list
+        DupPluginTransformList(ctx, src);
+    }
+    else {
+        static _cmsTransformPluginChunkType TransformPluginChunkType = { NULL };
+        ctx ->chunks[TransformPlugin] = _cmsSubAllocDup(ctx ->MemPool, &TransformPluginChunkType, sizeof(_cmsTransformPluginChunkType));
+    }
+}
+
+#if 0
+// Adaptor for old versions of plug-in
+static
+void _cmsTransform2toTransformAdaptor(cmsContext ContextID, struct _cmstransform_struct *CMMcargo,
+                                      const void* InputBuffer,
+                                      void* OutputBuffer,
+                                      cmsUInt32Number PixelsPerLine,
+                                      cmsUInt32Number LineCount,
+                                      const cmsStride* Stride)
+{
+
+       size_t i, strideIn, strideOut;
+
+       _cmsHandleExtraChannels(ContextID, CMMcargo, InputBuffer, OutputBuffer, PixelsPerLine, LineCount, Stride);
+
+       strideIn = 0;
+       strideOut = 0;
+
+       for (i = 0; i < LineCount; i++) {
+
+              void *accum = (cmsUInt8Number*)InputBuffer + strideIn;
+              void *output = (cmsUInt8Number*)OutputBuffer + strideOut;
+
+              CMMcargo->OldXform(ContextID, CMMcargo, accum, output, PixelsPerLine, Stride->BytesPerPlaneIn);
+
+              strideIn += Stride->BytesPerLineIn;
+              strideOut += Stride->BytesPerLineOut;
+       }
+}
+#endif
+
+
+// Register new ways to transform
+cmsBool  _cmsRegisterTransformPlugin(cmsContext ContextID, cmsPluginBase* Data)
+{
+    cmsPluginTransform* Plugin = (cmsPluginTransform*) Data;
+    _cmsTransformCollection* fl;
+    _cmsTransformPluginChunkType* ctx = ( _cmsTransformPluginChunkType*) _cmsContextGetClientChunk(ContextID, TransformPlugin);
+
+    if (Data == NULL) {
+
+        // Free the chain. Memory is safely freed at exit
+        ctx->TransformCollection = NULL;
+        return TRUE;
+    }
+
+    // Factory callback is required
+    if (Plugin->xform == NULL) return FALSE;
+
+
+    fl = (_cmsTransformCollection*) _cmsPluginMalloc(ContextID, sizeof(_cmsTransformCollection));
+    if (fl == NULL) return FALSE;
+
+#if 0
+	// Check for full xform plug-ins previous to 2.8, we would need an adapter in that case
+    if (Plugin->base.ExpectedVersion < (2080 - 2000)) {
+
+           fl->OldXform = TRUE;
+    }
+    else
+           fl->OldXform = FALSE;
+#endif
+
+    // Copy the parameters
     fl->Factory = Plugin->xform;
 
     // Keep linked list
@@ -1941,8 +2600,8 @@ cmsUInt32Number CMSEXPORT _cmsGetTransformFlags(struct _cmstransform_struct* CMM
     return CMMcargo->core->dwOriginalFlags;
 }
 
-void
-_cmsFindFormatter(_cmsTRANSFORM* p, cmsUInt32Number InputFormat, cmsUInt32Number OutputFormat, cmsUInt32Number dwFlags)
+static
+void FindStandardXForm(_cmsTRANSFORM* p, cmsUInt32Number InputFormat, cmsUInt32Number OutputFormat, cmsUInt32Number dwFlags)
 {
     if (dwFlags & cmsFLAGS_NULLTRANSFORM) {
         p ->xform = NullXFORM;
@@ -2209,6 +2868,61 @@ _cmsFindFormatter(_cmsTRANSFORM* p, cmsUInt32Number InputFormat, cmsUInt32Number
     }
 }
 
+// Some of the standard workers copy extra channels even without cmsFLAGS_COPY_ALPHA. The
+// alternative ones only do it on the flag, so they can't replace those.
+static
+cmsBool ExtraChannelsByFlag(cmsUInt32Number InputFormat, cmsUInt32Number OutputFormat, cmsUInt32Number dwFlags)
+{
+    if (dwFlags & cmsFLAGS_COPY_ALPHA) return TRUE;
+    return T_EXTRA(InputFormat) == 0 && T_EXTRA(OutputFormat) == 0;
+}
+
+void
+_cmsFindFormatter(cmsContext ContextID, _cmsTRANSFORM* p, cmsUInt32Number InputFormat, cmsUInt32Number OutputFormat, cmsUInt32Number dwFlags)
+{
+    FindStandardXForm(p, InputFormat, OutputFormat, dwFlags);
+
+    p->FromInputBlock = NULL;
+    p->ToOutputBlock  = NULL;
+
+    // Pipelines that can evaluate many pixels at once get them in groups
+    if (p->core->Lut != NULL && p->core->Lut->Eval16NFn != NULL &&
+        !(dwFlags & (cmsFLAGS_NULLTRANSFORM | cmsFLAGS_GAMUTCHECK | cmsFLAGS_PREMULT)) &&
+        ExtraChannelsByFlag(InputFormat, OutputFormat, dwFlags) &&
+        p->xform != PrecalculatedXFORMIdentity && p->xform != PrecalculatedXFORMIdentityPlanar) {
+
+        p->xform = BatchXFORM;
+
+        // Plain chunky layouts are unrolled and packed a group at a time
+        if (T_CHANNELS(InputFormat) == p->core->Lut->InputChannels)
+            p->FromInputBlock = _cmsGetBlockFormatter16(InputFormat, cmsFormatterInput, p->FromInput, &p->InputBlockLayout);
+
+        if (T_CHANNELS(OutputFormat) == p->core->Lut->OutputChannels)
+            p->ToOutputBlock = _cmsGetBlockFormatter16(OutputFormat, cmsFormatterOutput, p->ToOutput, &p->OutputBlockLayout);
+    }
+
+    p->HashCacheFallback = NULL;
+    p->HashCacheHits = p->HashCacheMisses = 0;
+
+    // The multi-entry cache is seeded from the 1-pixel cache, keys on up to 4 channels
+    // and does not deal with premultiplied alpha. Identities have nothing to cache.
+    if (!(dwFlags & cmsFLAGS_HASHCACHE)) return;
+    if (dwFlags & (cmsFLAGS_NOCACHE | cmsFLAGS_NULLTRANSFORM | cmsFLAGS_PREMULT)) return;
+    if (T_CHANNELS(InputFormat) > HASH_CACHE_MAXIN) return;
+    if (!ExtraChannelsByFlag(InputFormat, OutputFormat, dwFlags)) return;
+    if (p->xform == PrecalculatedXFORMIdentity || p->xform == PrecalculatedXFORMIdentityPlanar) return;
+
+    // Formats do not take part in the key, so a table kept from previous formats is still good
+    if (p->HashCache == NULL) {
+
+        p->HashCache = AllocHashCache(ContextID);
+        if (p->HashCache == NULL) return;
+    }
+
+    p->HashCacheFallback = p->xform;
+    p->xform = HashCachedXFORM;
+}
+
 // Returns the worker callback for parallelization plug-ins
 _cmsTransform2Fn CMSEXPORT _cmsGetTransformWorker(struct _cmstransform_struct* CMMcargo)
 {
@@ -2284,7 +2998,8 @@ cmsUInt8Number* PackNothing(cmsContext ContextID,
 // for separated transforms. If this is the case,
 static
 _cmsTRANSFORM* AllocEmptyTransform(cmsContext ContextID, cmsPipeline* lut,
-                                               cmsUInt32Number Intent, cmsUInt32Number* InputFormat, cmsUInt32Number* OutputFormat, cmsUInt32Number* dwFlags)
+                                               cmsUInt32Number Intent, cmsUInt32Number* InputFormat, cmsUInt32Number* OutputFormat, cmsUInt32Number* dwFlags,
+                                               cmsBool Optimize)
 {
     _cmsTransformPluginChunkType* ctx = ( _cmsTransformPluginChunkType*) _cmsContextGetClientChunk(ContextID, TransformPlugin);
     _cmsTransformCollection* Plugin;
@@ -2309,8 +3024,8 @@ _cmsTRANSFORM* AllocEmptyTransform(cmsContext ContextID, cmsPipeline* lut,
     // Store the proposed pipeline
     p->core->Lut = lut;
 
-       // Let's see if any plug-in want to do the transform by itself
-       if (core->Lut != NULL) {
+       // Let's see if any plug-in want to do the transform by itself. Pipelines of saved transforms are already optimized
+       if (core->Lut != NULL && Optimize) {
            if (!(*dwFlags & cmsFLAGS_NOOPTIMIZE)) {
 
                for (Plugin = ctx->TransformCollection;
@@ -2328,6 +3043,7 @@ _cmsTRANSFORM* AllocEmptyTransform(cmsContext ContextID, cmsPipeline* lut,
                        p->InputFormat = *InputFormat;
                        p->OutputFormat = *OutputFormat;
                        core->dwOriginalFlags = *dwFlags;
+                       core->XformByPlugin = TRUE;
 
                        // Fill the formatters just in case the optimized routine is interested.
                        // No error is thrown if the formatter doesn't exist. It is up to the optimization
@@ -2377,6 +3093,13 @@ _cmsTRANSFORM* AllocEmptyTransform(cmsContext ContextID, cmsPipeline* lut,
         else {
             // Float transforms don't use cache, always are non-NULL
             p ->xform = FloatXFORM;
+
+            // Some layouts are unrolled and packed a group at a time
+            if (core->Lut != NULL && T_CHANNELS(*InputFormat) == core->Lut->InputChannels)
+                p->FromInputFloatBlock = _cmsGetBlockFormatterFloat(*InputFormat, cmsFormatterInput, p->FromInputFloat, &p->InputBlockLayout);
+
+            if (core->Lut != NULL && T_CHANNELS(*OutputFormat) == core->Lut->OutputChannels)
+                p->ToOutputFloatBlock = _cmsGetBlockFormatterFloat(*OutputFormat, cmsFormatterOutput, p->ToOutputFloat, &p->OutputBlockLayout);
         }
 
     }
@@ -2408,7 +3131,7 @@ _cmsTRANSFORM* AllocEmptyTransform(cmsContext ContextID, cmsPipeline* lut,
 
         }
 
-        _cmsFindFormatter(p, *InputFormat, *OutputFormat, *dwFlags);
+        _cmsFindFormatter(ContextID, p, *InputFormat, *OutputFormat, *dwFlags);
     }
 
     /**
@@ -2539,16 +3262,17 @@ void SetWhitePoint(cmsCIEXYZ* wtPt, const cmsCIEXYZ* src)
 }
 
 // New to lcms 2.0 -- have all parameters available.
-cmsHTRANSFORM CMSEXPORT cmsCreateExtendedTransform(cmsContext ContextID,
-                                                   cmsUInt32Number nProfiles, cmsHPROFILE hProfiles[],
-                                                   cmsBool  BPC[],
-                                                   cmsUInt32Number Intents[],
-                                                   cmsFloat64Number AdaptationStates[],
-                                                   cmsHPROFILE hGamutProfile,
-                                                   cmsUInt32Number nGamutPCSposition,
-                                                   cmsUInt32Number InputFormat,
-                                                   cmsUInt32Number OutputFormat,
-                                                   cmsUInt32Number dwFlags)
+static
+cmsHTRANSFORM CreateExtendedTransform(cmsContext ContextID,
+                                      cmsUInt32Number nProfiles, cmsHPROFILE hProfiles[],
+                                      cmsBool  BPC[],
+                                      cmsUInt32Number Intents[],
+                                      cmsFloat64Number AdaptationStates[],
+                                      cmsHPROFILE hGamutProfile,
+                                      cmsUInt32Number nGamutPCSposition,
+                                      cmsUInt32Number InputFormat,
+                                      cmsUInt32Number OutputFormat,
+                                      cmsUInt32Number dwFlags)
 {
     _cmsTRANSFORM* xform;
     cmsColorSpaceSignature EntryColorSpace;
@@ -2567,7 +3291,7 @@ cmsHTRANSFORM CMSEXPORT cmsCreateExtendedTransform(cmsContext ContextID,
     // If it is a fake transform
     if (dwFlags & cmsFLAGS_NULLTRANSFORM)
     {
-        return AllocEmptyTransform(ContextID, NULL, INTENT_PERCEPTUAL, &InputFormat, &OutputFormat, &dwFlags);
+        return AllocEmptyTransform(ContextID, NULL, INTENT_PERCEPTUAL, &InputFormat, &OutputFormat, &dwFlags, TRUE);
     }
 
     // If gamut check is requested, make sure we have a gamut profile
@@ -2637,7 +3361,7 @@ cmsHTRANSFORM CMSEXPORT cmsCreateExtendedTransform(cmsContext ContextID,
 
 
     // All seems ok
-    xform = AllocEmptyTransform(ContextID, Lut, LastIntent, &InputFormat, &OutputFormat, &dwFlags);
+    xform = AllocEmptyTransform(ContextID, Lut, LastIntent, &InputFormat, &OutputFormat, &dwFlags, TRUE);
     if (xform == NULL) {
         return NULL;
     }
@@ -2711,6 +3435,41 @@ cmsHTRANSFORM CMSEXPORT cmsCreateExtendedTransform(cmsContext ContextID,
     return (cmsHTRANSFORM) xform;
 }
 
+// Goes through the transform cache, if enabled in this context
+cmsHTRANSFORM CMSEXPORT cmsCreateExtendedTransform(cmsContext ContextID,
+                                                   cmsUInt32Number nProfiles, cmsHPROFILE hProfiles[],
+                                                   cmsBool  BPC[],
+                                                   cmsUInt32Number Intents[],
+                                                   cmsFloat64Number AdaptationStates[],
+                                                   cmsHPROFILE hGamutProfile,
+                                                   cmsUInt32Number nGamutPCSposition,
+                                                   cmsUInt32Number InputFormat,
+                                                   cmsUInt32Number OutputFormat,
+                                                   cmsUInt32Number dwFlags)
+{
+    _cmsTransformCacheChunkType* cache = (_cmsTransformCacheChunkType*) _cmsContextGetClientChunk(ContextID, TransformCacheContext);
+    _cmsTransformKey Key;
+    _cmsTRANSFORM* xform;
+
+    if (cache->Mutex == NULL || (dwFlags & cmsFLAGS_NOTRANSFORMCACHE) ||
+        !ComputeTransformKey(ContextID, &Key, nProfiles, hProfiles, BPC, Intents, AdaptationStates,
+                             hGamutProfile, nGamutPCSposition, InputFormat, OutputFormat, dwFlags)) {
+
+        return CreateExtendedTransform(ContextID, nProfiles, hProfiles, BPC, Intents, AdaptationStates,
+                                       hGamutProfile, nGamutPCSposition, InputFormat, OutputFormat, dwFlags);
+    }
+
+    xform = LookupTransformCache(ContextID, cache, &Key);
+    if (xform != NULL) return (cmsHTRANSFORM) xform;
+
+    xform = (_cmsTRANSFORM*) CreateExtendedTransform(ContextID, nProfiles, hProfiles, BPC, Intents, AdaptationStates,
+                                                     hGamutProfile, nGamutPCSposition, InputFormat, OutputFormat, dwFlags);
+    if (xform != NULL)
+        InsertTransformCache(ContextID, cache, &Key, xform);
+
+    return (cmsHTRANSFORM) xform;
+}
+
 // Multiprofile transforms: Gamut check is not available here, as it is unclear from which profile the gamut comes.
 cmsHTRANSFORM CMSEXPORT cmsCreateMultiprofileTransform(cmsContext ContextID,
                                                        cmsHPROFILE hProfiles[],
@@ -2812,6 +3571,16 @@ cmsUInt32Number CMSEXPORT cmsGetTransformOutputFormat(cmsContext ContextID, cmsH
     return xform->OutputFormat;
 }
 
+// Hits and misses of the multi-entry pixel cache (cmsFLAGS_HASHCACHE) since the transform was created
+void CMSEXPORT cmsGetTransformPixelCacheStats(cmsContext ContextID, cmsHTRANSFORM hTransform, cmsUInt32Number* Hits, cmsUInt32Number* Misses)
+{
+    _cmsTRANSFORM* xform = (_cmsTRANSFORM*) hTransform;
+    cmsUNUSED_PARAMETER(ContextID);
+
+    if (Hits != NULL) *Hits = xform != NULL ? _cmsAtomicLoad32(&xform->HashCacheHits) : 0;
+    if (Misses != NULL) *Misses = xform != NULL ? _cmsAtomicLoad32(&xform->HashCacheMisses) : 0;
+}
+
 cmsHTRANSFORM cmsCloneTransformChangingFormats(cmsContext ContextID,
                                                const cmsHTRANSFORM hTransform,
                                                cmsUInt32Number InputFormat,
@@ -2834,6 +3603,7 @@ cmsHTRANSFORM cmsCloneTransformChangingFormats(cmsContext ContextID,
         return NULL;
 
     memcpy(xform, oldXform, sizeof(*xform));
+    xform ->HashCache = NULL;
 
     FromInput = _cmsGetFormatter(ContextID, InputFormat,  cmsFormatterInput, CMS_PACK_FLAGS_16BITS).Fmt16;
     ToOutput  = _cmsGetFormatter(ContextID, OutputFormat, cmsFormatterOutput, CMS_PACK_FLAGS_16BITS).Fmt16;
@@ -2848,9 +3618,818 @@ cmsHTRANSFORM cmsCloneTransformChangingFormats(cmsContext ContextID,
     xform ->OutputFormat = OutputFormat;
     xform ->FromInput    = FromInput;
     xform ->ToOutput     = ToOutput;
-    _cmsFindFormatter(xform, InputFormat, OutputFormat, xform->core->dwOriginalFlags);
+    _cmsFindFormatter(ContextID, xform, InputFormat, OutputFormat, xform->core->dwOriginalFlags);
 
     (void)_cmsAdjustReferenceCount(&xform->core->refs, 1);
 
     return xform;
 }
+
+// Saved transforms -------------------------------------------------------------------------------------------------------
+// The optimized pipeline of a transform, along with formats, flags and the IDs of the profiles it comes from, can be
+// written to a memory block. Loading it back skips linking and optimization, only the evaluator is rebuilt from the
+// stages. Big endian, as everything else. Only stages created by the library and built-in optimizations are supported.
+
+#define cmsTRANSFORM_BLOB_MAGIC  0x6C637866       // 'lcxf'
+
+#define MAX_BLOB_SEGMENTS        64
+#define MAX_BLOB_ENTRIES         65536
+#define MAX_BLOB_TRANSLATIONS    1024
+
+// Doubles are kept bit by bit
+static
+cmsBool WriteFloat64(cmsContext ContextID, cmsIOHANDLER* io, cmsFloat64Number d)
+{
+    cmsUInt64Number n;
+
+    memcpy(&n, &d, sizeof(n));
+    return _cmsWriteUInt64Number(ContextID, io, &n);
+}
+
+static
+cmsBool ReadFloat64(cmsContext ContextID, cmsIOHANDLER* io, cmsFloat64Number* d)
+{
+    cmsUInt64Number n;
+
+    if (!_cmsReadUInt64Number(ContextID, io, &n)) return FALSE;
+    memcpy(d, &n, sizeof(n));
+    return TRUE;
+}
+
+// Segments, if any, and the 16 bits table, which is what the optimizations use. Segment limits and sampled points
+// are cmsFloat32Number, widened to doubles on write, which is exact. The ICC float reader would refuse the +-1E22
+// limits of the outer segments.
+static
+cmsBool WriteBlobCurve(cmsContext ContextID, cmsIOHANDLER* io, const cmsToneCurve* Curve)
+{
+    cmsUInt32Number i, j;
+
+    if (!_cmsWriteUInt32Number(ContextID, io, Curve ->nSegments)) return FALSE;
+
+    for (i=0; i < Curve ->nSegments; i++) {
+
+        const cmsCurveSegment* Seg = Curve ->Segments + i;
+
+        if (!WriteFloat64(ContextID, io, Seg ->x0)) return FALSE;
+        if (!WriteFloat64(ContextID, io, Seg ->x1)) return FALSE;
+        if (!_cmsWriteUInt32Number(ContextID, io, (cmsUInt32Number) Seg ->Type)) return FALSE;
+
+        for (j=0; j < 10; j++)
+            if (!WriteFloat64(ContextID, io, Seg ->Params[j])) return FALSE;
+
+        if (Seg ->Type != 0) continue;
+
+        if (!_cmsWriteUInt32Number(ContextID, io, Seg ->nGridPoints)) return FALSE;
+        for (j=0; j < Seg ->nGridPoints; j++)
+            if (!WriteFloat64(ContextID, io, Seg ->SampledPoints[j])) return FALSE;
+    }
+
+    if (!_cmsWriteUInt32Number(ContextID, io, Curve ->nEntries)) return FALSE;
+    return _cmsWriteUInt16Array(ContextID, io, Curve ->nEntries, Curve ->Table16);
+}
+
+static
+cmsToneCurve* ReadBlobCurve(cmsContext ContextID, cmsIOHANDLER* io)
+{
+    cmsUInt32Number i, j, nSegments, nEntries;
+    cmsCurveSegment* Segments = NULL;
+    cmsUInt16Number* Table = NULL;
+    cmsToneCurve* Curve = NULL;
+
+    if (!_cmsReadUInt32Number(ContextID, io, &nSegments)) return NULL;
+    if (nSegments > MAX_BLOB_SEGMENTS) return NULL;
+
+    if (nSegments > 0) {
+
+        Segments = (cmsCurveSegment*) _cmsCalloc(ContextID, nSegments, sizeof(cmsCurveSegment));
+        if (Segments == NULL) return NULL;
+    }
+
+    for (i=0; i < nSegments; i++) {
+
+        cmsCurveSegment* Seg = Segments + i;
+        cmsUInt32Number Type;
+        cmsFloat64Number v;
+
+        if (!ReadFloat64(ContextID, io, &v)) goto Error;
+        Seg ->x0 = (cmsFloat32Number) v;
+        if (!ReadFloat64(ContextID, io, &v)) goto Error;
+        Seg ->x1 = (cmsFloat32Number) v;
+        if (!_cmsReadUInt32Number(ContextID, io, &Type)) goto Error;
+        Seg ->Type = (cmsInt32Number) Type;
+
+        for (j=0; j < 10; j++)
+            if (!ReadFloat64(ContextID, io, &Seg ->Params[j])) goto Error;
+
+        if (Seg ->Type != 0) continue;
+
+        if (!_cmsReadUInt32Number(ContextID, io, &Seg ->nGridPoints)) goto Error;
+        if (Seg ->nGridPoints > MAX_BLOB_ENTRIES) goto Error;
+
+        Seg ->SampledPoints = (cmsFloat32Number*) _cmsCalloc(ContextID, Seg ->nGridPoints, sizeof(cmsFloat32Number));
+        if (Seg ->SampledPoints == NULL) goto Error;
+
+        for (j=0; j < Seg ->nGridPoints; j++) {
+            if (!ReadFloat64(ContextID, io, &v)) goto Error;
+            Seg ->SampledPoints[j] = (cmsFloat32Number) v;
+        }
+    }
+
+    if (!_cmsReadUInt32Number(ContextID, io, &nEntries)) goto Error;
+    if (nEntries < 2 || nEntries > MAX_BLOB_ENTRIES) goto Error;
+
+    Table = (cmsUInt16Number*) _cmsCalloc(ContextID, nEntries, sizeof(cmsUInt16Number));
+    if (Table == NULL) goto Error;
+    if (!_cmsReadUInt16Array(ContextID, io, nEntries, Table)) goto Error;
+
+    if (nSegments == 0)
+        Curve = cmsBuildTabulatedToneCurve16(ContextID, nEntries, Table);
+    else {
+
+        // The table is computed again from the segments, but it may have been tweaked afterwards
+        Curve = cmsBuildSegmentedToneCurve(ContextID, nSegments, Segments);
+        if (Curve != NULL) {
+
+            if (Curve ->nEntries == nEntries)
+                memmove(Curve ->Table16, Table, nEntries * sizeof(cmsUInt16Number));
+            else {
+                cmsFreeToneCurve(ContextID, Curve);
+                Curve = NULL;
+            }
+        }
+    }
+
+Error:
+    for (i=0; i < nSegments; i++)
+        if (Segments[i].SampledPoints != NULL) _cmsFree(ContextID, Segments[i].SampledPoints);
+
+    if (Segments != NULL) _cmsFree(ContextID, Segments);
+    if (Table != NULL) _cmsFree(ContextID, Table);
+    return Curve;
+}
+
+static
+cmsBool WriteBlobStage(cmsContext ContextID, cmsIOHANDLER* io, const cmsStage* mpe)
+{
+    cmsUInt32Number i;
+
+    if (!_cmsWriteUInt32Number(ContextID, io, (cmsUInt32Number) mpe ->Type)) return FALSE;
+    if (!_cmsWriteUInt32Number(ContextID, io, (cmsUInt32Number) mpe ->Implements)) return FALSE;
+    if (!_cmsWriteUInt32Number(ContextID, io, mpe ->InputChannels)) return FALSE;
+    if (!_cmsWriteUInt32Number(ContextID, io, mpe ->OutputChannels)) return FALSE;
+
+    switch (mpe ->Type) {
+
+    case cmsSigCurveSetElemType:
+        {
+            _cmsStageToneCurvesData* Data = (_cmsStageToneCurvesData*) mpe ->Data;
+
+            for (i=0; i < Data ->nCurves; i++)
+                if (!WriteBlobCurve(ContextID, io, Data ->TheCurves[i])) return FALSE;
+        }
+        return TRUE;
+
+    case cmsSigMatrixElemType:
+        {
+            _cmsStageMatrixData* Data = (_cmsStageMatrixData*) mpe ->Data;
+
+            for (i=0; i < mpe ->InputChannels * mpe ->OutputChannels; i++)
+                if (!WriteFloat64(ContextID, io, Data ->Double[i])) return FALSE;
+
+            if (!_cmsWriteUInt32Number(ContextID, io, Data ->Offset != NULL)) return FALSE;
+
+            if (Data ->Offset != NULL) {
+                for (i=0; i < mpe ->OutputChannels; i++)
+                    if (!WriteFloat64(ContextID, io, Data ->Offset[i])) return FALSE;
+            }
+        }
+        return TRUE;
+
+    case cmsSigCLutElemType:
+        {
+            _cmsStageCLutData* Data = (_cmsStageCLutData*) mpe ->Data;
+
+            if (Data ->HasFloatValues || Data ->Tab.T == NULL) return FALSE;
+
+            for (i=0; i < mpe ->InputChannels; i++)
+                if (!_cmsWriteUInt32Number(ContextID, io, Data ->Params ->nSamples[i])) return FALSE;
+
+            return _cmsWriteUInt16Array(ContextID, io, Data ->nEntries, Data ->Tab.T);
+        }
+
+    // Those have no parameters
+    case cmsSigIdentityElemType:
+    case cmsSigLab2XYZElemType:
+    case cmsSigXYZ2LabElemType:
+    case cmsSigClipNegativesElemType:
+        return TRUE;
+
+    default:
+        return FALSE;
+    }
+}
+
+static
+cmsStage* ReadBlobStage(cmsContext ContextID, cmsIOHANDLER* io)
+{
+    cmsUInt32Number Type, Implements, nIn, nOut, i;
+    cmsStage* mpe = NULL;
+
+    if (!_cmsReadUInt32Number(ContextID, io, &Type)) return NULL;
+    if (!_cmsReadUInt32Number(ContextID, io, &Implements)) return NULL;
+    if (!_cmsReadUInt32Number(ContextID, io, &nIn)) return NULL;
+    if (!_cmsReadUInt32Number(ContextID, io, &nOut)) return NULL;
+
+    if (nIn < 1 || nIn >= cmsMAXCHANNELS || nOut < 1 || nOut >= cmsMAXCHANNELS) return NULL;
+
+    switch ((cmsStageSignature) Type) {
+
+    case cmsSigCurveSetElemType:
+        {
+            cmsToneCurve* Curves[cmsMAXCHANNELS];
+            cmsBool rc = TRUE;
+
+            if (nIn != nOut) return NULL;
+
+            memset(Curves, 0, sizeof(Curves));
+            for (i=0; i < nIn && rc; i++) {
+                Curves[i] = ReadBlobCurve(ContextID, io);
+                rc = Curves[i] != NULL;
+            }
+
+            if (rc)
+                mpe = cmsStageAllocToneCurves(ContextID, nIn, Curves);
+
+            for (i=0; i < nIn; i++)
+                if (Curves[i] != NULL) cmsFreeToneCurve(ContextID, Curves[i]);
+        }
+        break;
+
+    case cmsSigMatrixElemType:
+        {
+            cmsFloat64Number Matrix[cmsMAXCHANNELS * cmsMAXCHANNELS], Offset[cmsMAXCHANNELS];
+            cmsUInt32Number HasOffset;
+
+            for (i=0; i < nIn * nOut; i++)
+                if (!ReadFloat64(ContextID, io, &Matrix[i])) return NULL;
+
+            if (!_cmsReadUInt32Number(ContextID, io, &HasOffset)) return NULL;
+
+            if (HasOffset) {
+                for (i=0; i < nOut; i++)
+                    if (!ReadFloat64(ContextID, io, &Offset[i])) return NULL;
+            }
+
+            mpe = cmsStageAllocMatrix(ContextID, nOut, nIn, Matrix, HasOffset ? Offset : NULL);
+        }
+        break;
+
+    case cmsSigCLutElemType:
+        {
+            cmsUInt32Number nSamples[MAX_INPUT_DIMENSIONS];
+            _cmsStageCLutData* Data;
+
+            if (nIn > MAX_INPUT_DIMENSIONS) return NULL;
+
+            for (i=0; i < nIn; i++)
+                if (!_cmsReadUInt32Number(ContextID, io, &nSamples[i])) return NULL;
+
+            mpe = cmsStageAllocCLut16bitGranular(ContextID, nSamples, nIn, nOut, NULL);
+            if (mpe == NULL) return NULL;
+
+            Data = (_cmsStageCLutData*) mpe ->Data;
+            if (!_cmsReadUInt16Array(ContextID, io, Data ->nEntries, Data ->Tab.T)) {
+                cmsStageFree(ContextID, mpe);
+                return NULL;
+            }
+        }
+        break;
+
+    case cmsSigIdentityElemType:
+        if (nIn != nOut) return NULL;
+        mpe = cmsStageAllocIdentity(ContextID, nIn);
+        break;
+
+    case cmsSigLab2XYZElemType:
+        mpe = _cmsStageAllocLab2XYZ(ContextID);
+        break;
+
+    case cmsSigXYZ2LabElemType:
+        mpe = _cmsStageAllocXYZ2Lab(ContextID);
+        break;
+
+    case cmsSigClipNegativesElemType:
+        if (nIn != nOut) return NULL;
+        mpe = _cmsStageClipNegatives(ContextID, nIn);
+        break;
+
+    default:
+        return NULL;
+    }
+
+    if (mpe == NULL) return NULL;
+
+    if (mpe ->InputChannels != nIn || mpe ->OutputChannels != nOut) {
+        cmsStageFree(ContextID, mpe);
+        return NULL;
+    }
+
+    mpe ->Implements = (cmsStageSignature) Implements;
+    return mpe;
+}
+
+static
+cmsBool WriteBlobXYZ(cmsContext ContextID, cmsIOHANDLER* io, const cmsCIEXYZ* XYZ)
+{
+    return WriteFloat64(ContextID, io, XYZ ->X) &&
+           WriteFloat64(ContextID, io, XYZ ->Y) &&
+           WriteFloat64(ContextID, io, XYZ ->Z);
+}
+
+static
+cmsBool ReadBlobXYZ(cmsContext ContextID, cmsIOHANDLER* io, cmsCIEXYZ* XYZ)
+{
+    return ReadFloat64(ContextID, io, &XYZ ->X) &&
+           ReadFloat64(ContextID, io, &XYZ ->Y) &&
+           ReadFloat64(ContextID, io, &XYZ ->Z);
+}
+
+// Strings go as UTF-8, preceded by the length, which includes the terminator
+static
+cmsBool WriteBlobString(cmsContext ContextID, cmsIOHANDLER* io, const char* Str, cmsUInt32Number Len)
+{
+    if (!_cmsWriteUInt32Number(ContextID, io, Len)) return FALSE;
+    return Len == 0 || io ->Write(ContextID, io, Len, Str);
+}
+
+static
+char* ReadBlobString(cmsContext ContextID, cmsIOHANDLER* io, cmsUInt32Number MaxLen)
+{
+    cmsUInt32Number Len;
+    char* Str;
+
+    if (!_cmsReadUInt32Number(ContextID, io, &Len)) return NULL;
+    if (Len > MaxLen) return NULL;
+
+    Str = (char*) _cmsMallocZero(ContextID, Len + 1);
+    if (Str == NULL) return NULL;
+
+    if (Len > 0 && io ->Read(ContextID, io, Str, Len, 1) != 1) {
+        _cmsFree(ContextID, Str);
+        return NULL;
+    }
+
+    Str[Len] = 0;
+    return Str;
+}
+
+// All translations of a multilocalized string. A missing one is written as no translations
+static
+cmsBool WriteBlobMLU(cmsContext ContextID, cmsIOHANDLER* io, const cmsMLU* mlu)
+{
+    cmsUInt32Number i, n = cmsMLUtranslationsCount(ContextID, mlu);
+
+    if (!_cmsWriteUInt32Number(ContextID, io, n)) return FALSE;
+
+    for (i=0; i < n; i++) {
+
+        char Lang[3], Cntry[3];
+        cmsUInt32Number Len;
+        char* Str;
+        cmsBool rc;
+
+        if (!cmsMLUtranslationsCodes(ContextID, mlu, i, Lang, Cntry)) return FALSE;
+        if (!io ->Write(ContextID, io, 3, Lang) || !io ->Write(ContextID, io, 3, Cntry)) return FALSE;
+
+        Len = cmsMLUgetUTF8(ContextID, mlu, Lang, Cntry, NULL, 0);
+        if (Len == 0) {
+            if (!WriteBlobString(ContextID, io, NULL, 0)) return FALSE;
+            continue;
+        }
+
+        Str = (char*) _cmsMalloc(ContextID, Len);
+        if (Str == NULL) return FALSE;
+
+        cmsMLUgetUTF8(ContextID, mlu, Lang, Cntry, Str, Len);
+        rc = WriteBlobString(ContextID, io, Str, Len);
+        _cmsFree(ContextID, Str);
+
+        if (!rc) return FALSE;
+    }
+
+    return TRUE;
+}
+
+static
+cmsBool ReadBlobMLU(cmsContext ContextID, cmsIOHANDLER* io, cmsMLU** mlu)
+{
+    cmsUInt32Number i, n;
+
+    *mlu = NULL;
+
+    if (!_cmsReadUInt32Number(ContextID, io, &n)) return FALSE;
+    if (n == 0) return TRUE;
+    if (n > MAX_BLOB_TRANSLATIONS) return FALSE;
+
+    *mlu = cmsMLUalloc(ContextID, n);
+    if (*mlu == NULL) return FALSE;
+
+    for (i=0; i < n; i++) {
+
+        char Lang[3], Cntry[3];
+        char* Str;
+        cmsBool rc;
+
+        if (io ->Read(ContextID, io, Lang, 3, 1) != 1 || io ->Read(ContextID, io, Cntry, 3, 1) != 1) return FALSE;
+
+        Str = ReadBlobString(ContextID, io, MAX_BLOB_ENTRIES);
+        if (Str == NULL) return FALSE;
+
+        rc = cmsMLUsetUTF8(ContextID, *mlu, Lang, Cntry, Str);
+        _cmsFree(ContextID, Str);
+
+        if (!rc) return FALSE;
+    }
+
+    return TRUE;
+}
+
+// Colorant tables, device values included. A missing table is written as a zero flag
+static
+cmsBool WriteBlobColorants(cmsContext ContextID, cmsIOHANDLER* io, const cmsNAMEDCOLORLIST* List)
+{
+    cmsUInt32Number i, nColors;
+
+    if (!_cmsWriteUInt32Number(ContextID, io, List != NULL)) return FALSE;
+    if (List == NULL) return TRUE;
+
+    nColors = cmsNamedColorCount(ContextID, List);
+
+    if (!_cmsWriteUInt32Number(ContextID, io, nColors)) return FALSE;
+    if (!_cmsWriteUInt32Number(ContextID, io, List ->ColorantCount)) return FALSE;
+    if (!WriteBlobString(ContextID, io, List ->Prefix, (cmsUInt32Number) strlen(List ->Prefix) + 1)) return FALSE;
+    if (!WriteBlobString(ContextID, io, List ->Suffix, (cmsUInt32Number) strlen(List ->Suffix) + 1)) return FALSE;
+
+    for (i=0; i < nColors; i++) {
+
+        char Name[cmsMAX_PATH];
+        cmsUInt16Number PCS[3];
+        cmsUInt16Number Colorant[cmsMAXCHANNELS];
+
+        memset(Name, 0, sizeof(Name));
+        memset(Colorant, 0, sizeof(Colorant));
+
+        if (!cmsNamedColorInfo(ContextID, List, i, Name, NULL, NULL, PCS, Colorant)) return FALSE;
+        Name[cmsMAX_PATH-1] = 0;
+
+        if (!WriteBlobString(ContextID, io, Name, (cmsUInt32Number) strlen(Name) + 1)) return FALSE;
+        if (!_cmsWriteUInt16Array(ContextID, io, 3, PCS)) return FALSE;
+        if (!_cmsWriteUInt16Array(ContextID, io, List ->ColorantCount, Colorant)) return FALSE;
+    }
+
+    return TRUE;
+}
+
+static
+cmsBool ReadBlobColorants(cmsContext ContextID, cmsIOHANDLER* io, cmsNAMEDCOLORLIST** List)
+{
+    cmsUInt32Number i, Present, nColors, ColorantCount;
+    char *Prefix, *Suffix;
+
+    *List = NULL;
+
+    if (!_cmsReadUInt32Number(ContextID, io, &Present)) return FALSE;
+    if (!Present) return TRUE;
+
+    if (!_cmsReadUInt32Number(ContextID, io, &nColors)) return FALSE;
+    if (!_cmsReadUInt32Number(ContextID, io, &ColorantCount)) return FALSE;
+    if (nColors > MAX_BLOB_ENTRIES || ColorantCount > cmsMAXCHANNELS) return FALSE;
+
+    Prefix = ReadBlobString(ContextID, io, 33);
+    Suffix = ReadBlobString(ContextID, io, 33);
+
+    if (Prefix != NULL && Suffix != NULL)
+        *List = cmsAllocNamedColorList(ContextID, nColors, ColorantCount, Prefix, Suffix);
+
+    if (Prefix != NULL) _cmsFree(ContextID, Prefix);
+    if (Suffix != NULL) _cmsFree(ContextID, Suffix);
+    if (*List == NULL) return FALSE;
+
+    for (i=0; i < nColors; i++) {
+
+        char* Name;
+        cmsUInt16Number PCS[3];
+        cmsUInt16Number Colorant[cmsMAXCHANNELS];
+        cmsBool rc;
+
+        Name = ReadBlobString(ContextID, io, cmsMAX_PATH);
+        if (Name == NULL) return FALSE;
+
+        memset(Colorant, 0, sizeof(Colorant));
+        rc = _cmsReadUInt16Array(ContextID, io, 3, PCS) &&
+             _cmsReadUInt16Array(ContextID, io, ColorantCount, Colorant) &&
+             cmsAppendNamedColor(ContextID, *List, Name, PCS, Colorant);
+
+        _cmsFree(ContextID, Name);
+        if (!rc) return FALSE;
+    }
+
+    return TRUE;
+}
+
+// The sequence of profiles, as kept by cmsFLAGS_KEEP_SEQUENCE
+static
+cmsBool WriteBlobSequence(cmsContext ContextID, cmsIOHANDLER* io, const cmsSEQ* Seq)
+{
+    cmsUInt32Number i;
+
+    if (!_cmsWriteUInt32Number(ContextID, io, Seq != NULL)) return FALSE;
+    if (Seq == NULL) return TRUE;
+
+    if (!_cmsWriteUInt32Number(ContextID, io, Seq ->n)) return FALSE;
+
+    for (i=0; i < Seq ->n; i++) {
+
+        const cmsPSEQDESC* sec = &Seq ->seq[i];
+
+        if (!_cmsWriteUInt32Number(ContextID, io, sec ->deviceMfg)) return FALSE;
+        if (!_cmsWriteUInt32Number(ContextID, io, sec ->deviceModel)) return FALSE;
+        if (!_cmsWriteUInt64Number(ContextID, io, (cmsUInt64Number*) &sec ->attributes)) return FALSE;
+        if (!_cmsWriteUInt32Number(ContextID, io, (cmsUInt32Number) sec ->technology)) return FALSE;
+        if (!io ->Write(ContextID, io, sizeof(sec ->ProfileID.ID8), (void*) sec ->ProfileID.ID8)) return FALSE;
+        if (!WriteBlobMLU(ContextID, io, sec ->Manufacturer)) return FALSE;
+        if (!WriteBlobMLU(ContextID, io, sec ->Model)) return FALSE;
+        if (!WriteBlobMLU(ContextID, io, sec ->Description)) return FALSE;
+    }
+
+    return TRUE;
+}
+
+static
+cmsBool ReadBlobSequence(cmsContext ContextID, cmsIOHANDLER* io, cmsSEQ** Seq)
+{
+    cmsUInt32Number i, Present, n, Technology;
+
+    *Seq = NULL;
+
+    if (!_cmsReadUInt32Number(ContextID, io, &Present)) return FALSE;
+    if (!Present) return TRUE;
+
+    if (!_cmsReadUInt32Number(ContextID, io, &n)) return FALSE;
+    if (n == 0 || n > 255) return FALSE;
+
+    *Seq = cmsAllocProfileSequenceDescription(ContextID, n);
+    if (*Seq == NULL) return FALSE;
+
+    for (i=0; i < n; i++) {
+
+        cmsPSEQDESC* sec = &(*Seq) ->seq[i];
+
+        if (!_cmsReadUInt32Number(ContextID, io, &sec ->deviceMfg)) return FALSE;
+        if (!_cmsReadUInt32Number(ContextID, io, &sec ->deviceModel)) return FALSE;
+        if (!_cmsReadUInt64Number(ContextID, io, &sec ->attributes)) return FALSE;
+        if (!_cmsReadUInt32Number(ContextID, io, &Technology)) return FALSE;
+        sec ->technology = (cmsTechnologySignature) Technology;
+        if (io ->Read(ContextID, io, sec ->ProfileID.ID8, sizeof(sec ->ProfileID.ID8), 1) != 1) return FALSE;
+        if (!ReadBlobMLU(ContextID, io, &sec ->Manufacturer)) return FALSE;
+        if (!ReadBlobMLU(ContextID, io, &sec ->Model)) return FALSE;
+        if (!ReadBlobMLU(ContextID, io, &sec ->Description)) return FALSE;
+    }
+
+    return TRUE;
+}
+
+// Writes the whole thing. Returns the used space, or zero on error
+static
+cmsUInt32Number SaveTransformToIOhandler(cmsContext ContextID, const _cmsTRANSFORM* xform,
+                                         cmsUInt32Number nProfiles, cmsHPROFILE hProfiles[],
+                                         cmsIOHANDLER* io)
+{
+    const _cmsTRANSFORMCORE* core = xform ->core;
+    cmsUInt32Number i, Kind, nStages = 0;
+    cmsProfileID ID;
+    cmsStage* mpe;
+
+    Kind = _cmsPipelineOptimizationKind(ContextID, core ->Lut);
+    if (Kind == cmsOPT_UNKNOWN) return 0;
+
+    for (mpe = core ->Lut ->Elements; mpe != NULL; mpe = mpe ->Next)
+        nStages++;
+
+    if (!_cmsWriteUInt32Number(ContextID, io, cmsTRANSFORM_BLOB_MAGIC)) return 0;
+    if (!_cmsWriteUInt32Number(ContextID, io, LCMS_VERSION)) return 0;
+
+    // The key
+    if (!_cmsWriteUInt32Number(ContextID, io, nProfiles)) return 0;
+    for (i=0; i < nProfiles; i++) {
+
+        if (!GetProfileIDForCache(ContextID, hProfiles[i], &ID)) return 0;
+        if (!io ->Write(ContextID, io, sizeof(ID.ID8), ID.ID8)) return 0;
+    }
+
+    // The optimized formats are marked again by the optimization when restored
+    if (!_cmsWriteUInt32Number(ContextID, io, xform ->InputFormat & ~OPTIMIZED_SH(1))) return 0;
+    if (!_cmsWriteUInt32Number(ContextID, io, xform ->OutputFormat & ~OPTIMIZED_SH(1))) return 0;
+    if (!_cmsWriteUInt32Number(ContextID, io, core ->dwOriginalFlags)) return 0;
+    if (!_cmsWriteUInt32Number(ContextID, io, core ->RenderingIntent)) return 0;
+    if (!_cmsWriteUInt32Number(ContextID, io, (cmsUInt32Number) core ->EntryColorSpace)) return 0;
+    if (!_cmsWriteUInt32Number(ContextID, io, (cmsUInt32Number) core ->ExitColorSpace)) return 0;
+    if (!WriteBlobXYZ(ContextID, io, &core ->EntryWhitePoint)) return 0;
+    if (!WriteBlobXYZ(ContextID, io, &core ->ExitWhitePoint)) return 0;
+
+    // The pipeline
+    if (!_cmsWriteUInt32Number(ContextID, io, Kind)) return 0;
+    if (!_cmsWriteUInt32Number(ContextID, io, core ->Lut ->InputChannels)) return 0;
+    if (!_cmsWriteUInt32Number(ContextID, io, core ->Lut ->OutputChannels)) return 0;
+    if (!_cmsWriteUInt32Number(ContextID, io, nStages)) return 0;
+
+    for (mpe = core ->Lut ->Elements; mpe != NULL; mpe = mpe ->Next)
+        if (!WriteBlobStage(ContextID, io, mpe)) return 0;
+
+    // What cmsTransform2DeviceLink would take from the profiles
+    if (!WriteBlobColorants(ContextID, io, core ->InputColorant)) return 0;
+    if (!WriteBlobColorants(ContextID, io, core ->OutputColorant)) return 0;
+    if (!WriteBlobSequence(ContextID, io, core ->Sequence)) return 0;
+
+    return io ->UsedSpace;
+}
+
+// Saves the optimized state of a transform created from the given profiles. Works as cmsSaveProfileToMem: if MemPtr
+// is NULL, BytesNeeded gets the size of the block. Transforms on floating point, with gamut check, or done by plug-ins
+// cannot be saved.
+cmsBool CMSEXPORT cmsSaveTransformToMem(cmsContext ContextID, cmsHTRANSFORM hTransform,
+                                        cmsUInt32Number nProfiles, cmsHPROFILE hProfiles[],
+                                        void* MemPtr, cmsUInt32Number* BytesNeeded)
+{
+    _cmsTRANSFORM* xform = (_cmsTRANSFORM*) hTransform;
+    cmsIOHANDLER* io;
+    cmsUInt32Number Used;
+    cmsBool rc;
+
+    _cmsAssert(xform != NULL);
+    _cmsAssert(BytesNeeded != NULL);
+
+    if (xform ->core ->Lut == NULL || xform ->core ->GamutCheck != NULL || xform ->core ->XformByPlugin ||
+        _cmsFormatterIsFloat(xform ->InputFormat) || _cmsFormatterIsFloat(xform ->OutputFormat) ||
+        nProfiles > 255 || (nProfiles > 0 && hProfiles == NULL)) {
+
+        cmsSignalError(ContextID, cmsERROR_NOT_SUITABLE, "This transform cannot be saved");
+        return FALSE;
+    }
+
+    io = (MemPtr == NULL) ? cmsOpenIOhandlerFromNULL(ContextID) : cmsOpenIOhandlerFromMem(ContextID, MemPtr, *BytesNeeded, "w");
+    if (io == NULL) return FALSE;
+
+    Used = SaveTransformToIOhandler(ContextID, xform, nProfiles, hProfiles, io);
+    rc = cmsCloseIOhandler(ContextID, io) && Used != 0;
+
+    if (!rc) {
+        cmsSignalError(ContextID, cmsERROR_NOT_SUITABLE, "This transform cannot be saved");
+        return FALSE;
+    }
+
+    *BytesNeeded = Used;
+    return TRUE;
+}
+
+// Reads a saved transform. The profile IDs, if given, and the formats must match the saved ones
+static
+cmsHTRANSFORM LoadTransformFromIOhandler(cmsContext ContextID, cmsIOHANDLER* io,
+                                         cmsUInt32Number nProfiles, cmsHPROFILE hProfiles[],
+                                         cmsUInt32Number InputFormat, cmsUInt32Number OutputFormat)
+{
+    cmsUInt32Number Magic, Version, nSaved, i;
+    cmsUInt32Number SavedInput, SavedOutput, dwFlags, Intent, EntrySpace, ExitSpace;
+    cmsUInt32Number Kind, nIn, nOut, nStages;
+    cmsCIEXYZ EntryWhite, ExitWhite;
+    cmsProfileID ID, Saved;
+    cmsPipeline* Lut;
+    cmsNAMEDCOLORLIST *InputColorant = NULL, *OutputColorant = NULL;
+    cmsSEQ* Sequence = NULL;
+    _cmsTRANSFORM* xform;
+
+    if (!_cmsReadUInt32Number(ContextID, io, &Magic) || Magic != cmsTRANSFORM_BLOB_MAGIC) {
+        cmsSignalError(ContextID, cmsERROR_BAD_SIGNATURE, "Not a saved transform");
+        return NULL;
+    }
+
+    if (!_cmsReadUInt32Number(ContextID, io, &Version) || Version != LCMS_VERSION) {
+        cmsSignalError(ContextID, cmsERROR_NOT_SUITABLE, "Saved transform comes from another version");
+        return NULL;
+    }
+
+    if (!_cmsReadUInt32Number(ContextID, io, &nSaved) || nSaved > 255) return NULL;
+    if (nProfiles > 0 && nProfiles != nSaved) goto WrongKey;
+
+    for (i=0; i < nSaved; i++) {
+
+        if (io ->Read(ContextID, io, Saved.ID8, sizeof(Saved.ID8), 1) != 1) return NULL;
+
+        if (nProfiles > 0) {
+            if (!GetProfileIDForCache(ContextID, hProfiles[i], &ID)) return NULL;
+            if (memcmp(ID.ID8, Saved.ID8, sizeof(ID.ID8)) != 0) goto WrongKey;
+        }
+    }
+
+    if (!_cmsReadUInt32Number(ContextID, io, &SavedInput)) return NULL;
+    if (!_cmsReadUInt32Number(ContextID, io, &SavedOutput)) return NULL;
+
+    if (SavedInput != (InputFormat & ~OPTIMIZED_SH(1)) || SavedOutput != (OutputFormat & ~OPTIMIZED_SH(1))) {
+        cmsSignalError(ContextID, cmsERROR_NOT_SUITABLE, "Saved transform has other formats");
+        return NULL;
+    }
+
+    if (!_cmsReadUInt32Number(ContextID, io, &dwFlags)) return NULL;
+    if (!_cmsReadUInt32Number(ContextID, io, &Intent)) return NULL;
+    if (!_cmsReadUInt32Number(ContextID, io, &EntrySpace)) return NULL;
+    if (!_cmsReadUInt32Number(ContextID, io, &ExitSpace)) return NULL;
+    if (!ReadBlobXYZ(ContextID, io, &EntryWhite)) return NULL;
+    if (!ReadBlobXYZ(ContextID, io, &ExitWhite)) return NULL;
+
+    if (!_cmsReadUInt32Number(ContextID, io, &Kind)) return NULL;
+    if (!_cmsReadUInt32Number(ContextID, io, &nIn)) return NULL;
+    if (!_cmsReadUInt32Number(ContextID, io, &nOut)) return NULL;
+    if (!_cmsReadUInt32Number(ContextID, io, &nStages)) return NULL;
+
+    Lut = cmsPipelineAlloc(ContextID, nIn, nOut);
+    if (Lut == NULL) return NULL;
+
+    for (i=0; i < nStages; i++) {
+
+        cmsStage* mpe = ReadBlobStage(ContextID, io);
+
+        if (mpe == NULL || !cmsPipelineInsertStage(ContextID, Lut, cmsAT_END, mpe)) {
+
+            if (mpe != NULL) cmsStageFree(ContextID, mpe);
+            cmsPipelineFree(ContextID, Lut);
+            cmsSignalError(ContextID, cmsERROR_CORRUPTION_DETECTED, "Corrupted saved transform");
+            return NULL;
+        }
+    }
+
+    if (!ReadBlobColorants(ContextID, io, &InputColorant) ||
+        !ReadBlobColorants(ContextID, io, &OutputColorant) ||
+        !ReadBlobSequence(ContextID, io, &Sequence) ||
+        Lut ->InputChannels != nIn || Lut ->OutputChannels != nOut ||
+        !_cmsPipelineRestoreOptimization(ContextID, Lut, Kind, &OutputFormat)) {
+
+        if (InputColorant != NULL) cmsFreeNamedColorList(ContextID, InputColorant);
+        if (OutputColorant != NULL) cmsFreeNamedColorList(ContextID, OutputColorant);
+        if (Sequence != NULL) cmsFreeProfileSequenceDescription(ContextID, Sequence);
+        cmsPipelineFree(ContextID, Lut);
+        cmsSignalError(ContextID, cmsERROR_CORRUPTION_DETECTED, "Corrupted saved transform");
+        return NULL;
+    }
+
+    // The pipeline is already optimized
+    xform = AllocEmptyTransform(ContextID, Lut, Intent, &InputFormat, &OutputFormat, &dwFlags, FALSE);
+    if (xform == NULL) {
+
+        if (InputColorant != NULL) cmsFreeNamedColorList(ContextID, InputColorant);
+        if (OutputColorant != NULL) cmsFreeNamedColorList(ContextID, OutputColorant);
+        if (Sequence != NULL) cmsFreeProfileSequenceDescription(ContextID, Sequence);
+        return NULL;
+    }
+
+    xform ->core ->EntryColorSpace = (cmsColorSpaceSignature) EntrySpace;
+    xform ->core ->ExitColorSpace  = (cmsColorSpaceSignature) ExitSpace;
+    xform ->core ->RenderingIntent = Intent;
+    xform ->core ->EntryWhitePoint = EntryWhite;
+    xform ->core ->ExitWhitePoint  = ExitWhite;
+    xform ->core ->InputColorant   = InputColorant;
+    xform ->core ->OutputColorant  = OutputColorant;
+    xform ->core ->Sequence        = Sequence;
+
+    if (!(dwFlags & cmsFLAGS_NOCACHE)) {
+
+        memset(&xform ->Cache.CacheIn, 0, sizeof(xform ->Cache.CacheIn));
+        xform ->core ->Lut ->Eval16Fn(ContextID, xform ->Cache.CacheIn, xform ->Cache.CacheOut, xform ->core ->Lut ->Data);
+    }
+
+    return (cmsHTRANSFORM) xform;
+
+WrongKey:
+    cmsSignalError(ContextID, cmsERROR_NOT_SUITABLE, "Saved transform comes from other profiles");
+    return NULL;
+}
+
+// Creates a transform from a block written by cmsSaveTransformToMem. If nProfiles is not zero, the IDs of the given
+// profiles are checked against the saved ones. Formats have to be the same used when saving.
+cmsHTRANSFORM CMSEXPORT cmsLoadTransformFromMem(cmsContext ContextID, const void* MemPtr, cmsUInt32Number dwSize,
+                                                cmsUInt32Number nProfiles, cmsHPROFILE hProfiles[],
+                                                cmsUInt32Number InputFormat, cmsUInt32Number OutputFormat)
+{
+    cmsIOHANDLER* io;
+    cmsHTRANSFORM xform;
+
+    if (MemPtr == NULL || (nProfiles > 0 && hProfiles == NULL)) return NULL;
+
+    // The block is only read while loading, no need to copy it
+    io = cmsOpenIOhandlerFromMemNoCopy(ContextID, MemPtr, dwSize);
+    if (io == NULL) return NULL;
+
+    xform = LoadTransformFromIOhandler(ContextID, io, nProfiles, hProfiles, InputFormat, OutputFormat);
+    cmsCloseIOhandler(ContextID, io);
+
+    return xform;
+}
@@ -467,6 +467,30 @@ cmsINLINE int _cmsLeaveCriticalSectionPrimitive(_cmsMutex *m)
 
 #endif
 
+// Pointers published to other threads. Stores have release semantics and loads acquire semantics, so whatever was
+// written before the store is visible to the thread that reads the pointer. The 32 bits variants are for counters
+// shared by threads. Without support, callers should lock.
+#if !defined(CMS_NO_PTHREADS) && (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))))
+#   define CMS_ATOMIC_POINTERS 1
+#   define _cmsAtomicLoadPtr(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#   define _cmsAtomicStorePtr(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#   define _cmsAtomicLoad32(p)       __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#   define _cmsAtomicAdd32(p, v)     ((void) __atomic_fetch_add((p), (v), __ATOMIC_ACQ_REL))
+#   define _cmsAtomicExchangePtr(p, v) __atomic_exchange_n((p), (v), __ATOMIC_ACQ_REL)
+#elif !defined(CMS_NO_PTHREADS) && defined(CMS_IS_WINDOWS_)
+#   define CMS_ATOMIC_POINTERS 1
+#   define _cmsAtomicLoadPtr(p)      InterlockedCompareExchangePointer((PVOID volatile*) (p), NULL, NULL)
+#   define _cmsAtomicStorePtr(p, v)  ((void) InterlockedExchangePointer((PVOID volatile*) (p), (v)))
+#   define _cmsAtomicLoad32(p)       ((cmsUInt32Number) InterlockedCompareExchange((LONG volatile*) (p), 0, 0))
+#   define _cmsAtomicAdd32(p, v)     ((void) InterlockedExchangeAdd((LONG volatile*) (p), (LONG) (v)))
+#   define _cmsAtomicExchangePtr(p, v) InterlockedExchangePointer((PVOID volatile*) (p), (v))
+#else
+#   define _cmsAtomicLoadPtr(p)      (*(p))
+#   define _cmsAtomicStorePtr(p, v)  (*(p) = (v))
+#   define _cmsAtomicLoad32(p)       (*(p))
+#   define _cmsAtomicAdd32(p, v)     (*(p) += (v))
+#endif
+
 // Plug-In registration ---------------------------------------------------------------
 
 #ifndef CMS_USE_CPP_API
@@ -562,6 +586,8 @@ typedef enum {
     TransformPlugin,
     MutexPlugin,
     ParallelizationPlugin,
+    TransformCacheContext,
+    ProfilePoolContext,
 
     // Last in list
     MemoryClientMax
@@ -651,6 +677,52 @@ void _cmsAllocAdaptationStateChunk(struct _cmsContext_struct* ctx,
                                    const struct _cmsContext_struct* src);
 
 
+// Container for transform cache -- not a plug-in
+typedef struct {
+
+    void*            Mutex;         // Created when the cache is first enabled
+    cmsUInt32Number  MaxEntries;    // Zero means disabled
+    cmsUInt32Number  nEntries;
+    struct _cmsTransformCacheEntry_st* Head;    // Most recently used first
+
+    cmsUInt32Number  Hits;
+    cmsUInt32Number  Misses;
+
+} _cmsTransformCacheChunkType;
+
+// The global Context0 storage for transform cache
+extern  _cmsTransformCacheChunkType    _cmsTransformCacheChunk;
+
+// Allocate and init transform cache container. Duplicated contexts start with an empty, disabled cache
+void _cmsAllocTransformCacheChunk(struct _cmsContext_struct* ctx,
+                                  const struct _cmsContext_struct* src);
+
+// Releases all cached transforms and the cache mutex
+void _cmsFreeTransformCache(cmsContext ContextID);
+
+// Container for profile pool -- not a plug-in
+typedef struct {
+
+    void*            Mutex;         // Created when the pool is first enabled
+    cmsUInt32Number  MaxBytes;      // Zero means disabled
+    cmsUInt64Number  UsedBytes;     // Blocks and decoded tags
+    struct _cmsProfilePoolEntry_st* Head;       // Most recently used first
+
+    cmsUInt32Number  Hits;
+    cmsUInt32Number  Misses;
+
+} _cmsProfilePoolChunkType;
+
+// The global Context0 storage for profile pool
+extern  _cmsProfilePoolChunkType    _cmsProfilePoolChunk;
+
+// Allocate and init profile pool container. Duplicated contexts start with an empty, disabled pool
+void _cmsAllocProfilePoolChunk(struct _cmsContext_struct* ctx,
+                               const struct _cmsContext_struct* src);
+
+// Releases the pool references on all profiles and the pool mutex
+void _cmsFreeProfilePool(cmsContext ContextID);
+
 // The global Context0 storage for memory management
 extern  _cmsMemPluginChunkType _cmsMemPluginChunk;
 
@@ -662,6 +734,7 @@ void _cmsAllocMemPluginChunk(struct _cmsContext_struct* ctx,
 typedef struct {
 
     cmsInterpFnFactory Interpolators;
+    cmsInterpFnFactoryN InterpolatorsN;
 
 } _cmsInterpPluginChunkType;
 
@@ -755,6 +828,7 @@ void _cmsAllocIntentsPluginChunk(struct _cmsContext_struct* ctx,
 typedef struct {
 
     struct _cmsOptimizationCollection_st* OptimizationCollection;
+    cmsFloat64Number GridErrorBudget;       // Set by cmsSetGridpointsErrorBudget, zero for fixed grids
 
 } _cmsOptimizationPluginChunkType;
 
@@ -766,6 +840,9 @@ extern  _cmsOptimizationPluginChunkType _cmsOptimizationPluginChunk;
 void _cmsAllocOptimizationPluginChunk(struct _cmsContext_struct* ctx,
                                          const struct _cmsContext_struct* src);
 
+// The error budget of the context for CLUT grids, zero if disabled
+cmsFloat64Number _cmsGetGridpointsErrorBudget(cmsContext ContextID);
+
 // Container for transform plug-in
 typedef struct {
 
@@ -803,6 +880,8 @@ typedef struct {
     cmsInt32Number      MaxWorkers;       // Number of workers to do as maximum
     cmsInt32Number      WorkerFlags;      // reserved
     _cmsTransform2Fn    SchedulerFn;      // callback to setup functions
+    _cmsParallelizationReleaseFn ReleaseFn; // frees per-context scheduler resources, may be NULL
+    _cmsParallelizationRunFn RunTasksFn;    // runs independent tasks, may be NULL
 
 } _cmsParallelizationPluginChunkType;
 
@@ -813,6 +892,9 @@ extern  _cmsParallelizationPluginChunkType _cmsParallelizationPluginChunk;
 void _cmsAllocParallelizationPluginChunk(struct _cmsContext_struct* ctx,
                                          const struct _cmsContext_struct* src);
 
+// Runs independent tasks on the parallelization plug-in, or serially if there is no one to do so
+void _cmsParallelRun(cmsContext ContextID, cmsUInt32Number nTasks, _cmsParallelTaskFn Task, void* Cargo);
+
 
 
 // ----------------------------------------------------------------------------------
@@ -869,6 +951,9 @@ struct _cms_NAMEDCOLORLIST_struct {
 // Maximum supported tags in a profile
 #define MAX_TABLE_TAG       100
 
+// Slots of the hash index on tag signatures. Must be a power of two, well above MAX_TABLE_TAG
+#define TAG_INDEX_SIZE      256
+
 typedef struct _cms_iccprofile_struct {
 
     // I/O handler
@@ -895,6 +980,10 @@ typedef struct _cms_iccprofile_struct {
 
     cmsProfileID             ProfileID;
 
+    // Hash of the contents, as used by the transform cache. Dropped on any change
+    cmsProfileID             ContentID;
+    cmsBool                  HasContentID;
+
     // Dictionary
     cmsUInt32Number          TagCount;
     cmsTagSignature          TagNames[MAX_TABLE_TAG];
@@ -906,18 +995,33 @@ typedef struct _cms_iccprofile_struct {
     cmsTagTypeHandler*       TagTypeHandlers[MAX_TABLE_TAG];     // Same structure may be serialized on different types
                                                                  // depending on profile version, so we keep track of the
                                                                  // type handler for each tag in the list.
+    cmsUInt8Number           TagIndex[TAG_INDEX_SIZE];           // Position + 1 of each tag, by signature hash. 0=empty
+
+    // Decoded LUT tags that can be read again from the IO handler
+    cmsUInt32Number          TagMemory[MAX_TABLE_TAG];           // Estimated size once decoded, 0=not releasable
+    cmsUInt32Number          TagLastUse[MAX_TABLE_TAG];
+    cmsUInt32Number          TagClock;
+    cmsUInt32Number          DecodedBudget;                      // 0=no limit
+
     // Special
     cmsBool                  IsWrite;
+    cmsBool                  IsModified;                         // Contents changed since read
 
     // Keep a mutex for cmsReadTag -- Note that this only works if the user includes a mutex plugin
     void *                   UsrMutex;
 
+    // Handles given by the profile pool, including the one of the pool itself. Zero if not pooled
+    cmsUInt32Number          PoolRefs;
+
 } _cmsICCPROFILE;
 
 // IO helpers for profiles
 cmsBool              _cmsReadHeader(cmsContext ContextID, _cmsICCPROFILE* Icc);
 cmsBool              _cmsWriteHeader(cmsContext ContextID, _cmsICCPROFILE* Icc, cmsUInt32Number UsedSpace);
 int                  _cmsSearchTag(cmsContext ContextID, _cmsICCPROFILE* Icc, cmsTagSignature sig, cmsBool lFollowLinks);
+cmsBool              _cmsMD5computeProfileID(cmsContext ContextID, cmsHPROFILE hProfile, cmsProfileID* ProfileID);
+cmsBool              _cmsGetProfileContentID(cmsContext ContextID, cmsHPROFILE hProfile, cmsProfileID* ProfileID);
+cmsBool              _cmsIsPooledProfile(cmsContext ContextID, _cmsICCPROFILE* Icc);
 
 // Tag types
 cmsTagTypeHandler*   _cmsGetTagTypeHandler(cmsContext ContextID, cmsTagTypeSignature sig);
@@ -971,6 +1075,7 @@ struct _cmsStage_struct {
     _cmsStageEvalFn     EvalPtr;        // Points to fn that evaluates the stage (always in floating point)
     _cmsStageDupElemFn  DupElemPtr;     // Points to a fn that duplicates the *data* of the stage
     _cmsStageFreeElemFn FreePtr;        // Points to a fn that sets the *data* of the stage free
+    _cmsStageEvalNFn    EvalNPtr;       // Optional, evaluates a planar block of pixels
 
     // A generic pointer to whatever memory needed by the stage
     void*               Data;
@@ -1007,6 +1112,13 @@ cmsToneCurve**  _cmsStageGetPtrToCurveSet(const cmsStage* mpe);
 cmsStage*          _cmsStageAllocToneCurvesWithSlopeLimit(cmsContext ContextID, cmsUInt32Number nChannels, cmsToneCurve* const Curves[], int SlopeLimit);
 cmsFloat32Number   _cmsEvalToneCurveFloatWithSlopeLimit(cmsContext ContextID, const cmsToneCurve* Curve, cmsFloat32Number v, int SlopeLimit);
 
+// Batch evaluator of pipelines, In and Out hold nPixels packed pixels
+typedef void (* _cmsPipelineEval16NFn)(cmsContext ContextID,
+                                       const cmsUInt16Number In[],
+                                       cmsUInt16Number Out[],
+                                       cmsUInt32Number nPixels,
+                                       const void* Data);
+
 struct _cmsPipeline_struct {
 
     cmsStage* Elements;                                // Points to elements chain
@@ -1017,6 +1129,7 @@ struct _cmsPipeline_struct {
 
    _cmsPipelineEval16Fn    Eval16Fn;
    _cmsPipelineEvalFloatFn EvalFloatFn;
+   _cmsPipelineEval16NFn   Eval16NFn;      // Same as Eval16Fn on many pixels, NULL if not available
    _cmsFreeUserDataFn      FreeDataFn;
    _cmsDupUserDataFn       DupDataFn;
 
@@ -1076,6 +1189,21 @@ CMSAPI cmsBool CMSEXPORT _cmsOptimizePipeline(cmsContext ContextID,
 
 cmsBool _cmsLutIsIdentity(cmsPipeline *PtrLut);
 
+// Built-in optimizations, as kept in saved transforms
+#define cmsOPT_NONE         0       // Stages are evaluated one after another
+#define cmsOPT_IDENTITY     1
+#define cmsOPT_CURVES8      2
+#define cmsOPT_CURVES16     3
+#define cmsOPT_MATSHAPER    4
+#define cmsOPT_CLUT         5
+#define cmsOPT_PRELIN16     6
+#define cmsOPT_PRELIN8      7
+#define cmsOPT_UNKNOWN      0xFFFFFFFFU     // Done by a plug-in
+
+cmsUInt32Number  _cmsPipelineOptimizationKind(cmsContext ContextID, const cmsPipeline* Lut);
+cmsBool          _cmsPipelineRestoreOptimization(cmsContext ContextID, cmsPipeline* Lut, cmsUInt32Number Kind, cmsUInt32Number* OutputFormat);
+cmsBool          _cmsPipelineIsGeneric(const cmsPipeline* Lut);
+
 // Hi level LUT building ----------------------------------------------------------------------------------------------
 
 cmsPipeline*     _cmsCreateGamutCheckPipeline(cmsContext ContextID,
@@ -1099,6 +1227,49 @@ CMSCHECKPOINT cmsFormatter CMSEXPORT _cmsGetFormatter(cmsContext ContextID,
                                                       cmsFormatterDirection Dir,
                                                       cmsUInt32Number dwFlags);
 
+// Block formatters unpack or pack nPixels chunky pixels in a single call. Values holds the
+// channels of each pixel one after the other, with no extra channels in between.
+
+// Where each channel lives in the pixel, computed when the block formatter is handed out and kept
+// in the transform, so it is not rebuilt on each call
+typedef struct {
+
+    cmsUInt32Number nChan;                      // Channels per pixel in Values
+    cmsUInt32Number nSamples;                   // Samples per pixel in the buffer, extra included
+    cmsUInt32Number Sample[cmsMAXCHANNELS];     // The sample holding each channel
+    cmsUInt32Number SwapEndian;
+
+    cmsBool         UseSSSE3;
+    cmsUInt8Number  Shuffle[32];                // Byte selectors of the SSSE3 kernels
+    cmsUInt8Number  Keep[16];                   // Bytes packers write back unchanged
+
+} _cmsBlockLayout;
+
+typedef cmsUInt8Number* (* _cmsFormatter16Block)(cmsContext ContextID,
+                                                 struct _cmstransform_struct* CMMcargo,
+                                                 cmsUInt16Number Values[],
+                                                 cmsUInt8Number* Buffer,
+                                                 cmsUInt32Number nPixels);
+
+// Returns a block formatter doing the same as PixelFormatter, or NULL if the layout has none. Layout is
+// filled for the formatter, which reads it from InputBlockLayout or OutputBlockLayout of the transform
+CMSCHECKPOINT _cmsFormatter16Block CMSEXPORT _cmsGetBlockFormatter16(cmsUInt32Number Type,
+                                                                     cmsFormatterDirection Dir,
+                                                                     cmsFormatter16 PixelFormatter,
+                                                                     _cmsBlockLayout* Layout);
+
+// Same on floating point values
+typedef cmsUInt8Number* (* _cmsFormatterFloatBlock)(cmsContext ContextID,
+                                                    struct _cmstransform_struct* CMMcargo,
+                                                    cmsFloat32Number Values[],
+                                                    cmsUInt8Number* Buffer,
+                                                    cmsUInt32Number nPixels);
+
+CMSCHECKPOINT _cmsFormatterFloatBlock CMSEXPORT _cmsGetBlockFormatterFloat(cmsUInt32Number Type,
+                                                                           cmsFormatterDirection Dir,
+                                                                           cmsFormatterFloat PixelFormatter,
+                                                                           _cmsBlockLayout* Layout);
+
 
 #ifndef CMS_NO_HALF_SUPPORT
 
@@ -1106,6 +1277,10 @@ CMSCHECKPOINT cmsFormatter CMSEXPORT _cmsGetFormatter(cmsContext ContextID,
 CMSCHECKPOINT cmsFloat32Number CMSEXPORT _cmsHalf2Float(cmsUInt16Number h);
 CMSCHECKPOINT cmsUInt16Number  CMSEXPORT _cmsFloat2Half(cmsFloat32Number flt);
 
+// Same as above on n values, with identical results
+CMSCHECKPOINT void CMSEXPORT _cmsHalf2FloatArray(const cmsUInt16Number In[], cmsFloat32Number Out[], cmsUInt32Number n);
+CMSCHECKPOINT void CMSEXPORT _cmsFloat2HalfArray(const cmsFloat32Number In[], cmsUInt16Number Out[], cmsUInt32Number n);
+
 #endif
 
 // Transform logic ------------------------------------------------------------------------------------------------------
@@ -1158,6 +1333,9 @@ typedef struct _cmstransform_core {
     void* UserData;
     _cmsFreeUserDataFn FreeUserData;
 
+    // The worker comes from a transform plug-in
+    cmsBool XformByPlugin;
+
 } _cmsTRANSFORMCORE;
 
 typedef struct _cmstransform_struct {
@@ -1171,9 +1349,20 @@ typedef struct _cmstransform_struct {
     cmsFormatter16 FromInput;
     cmsFormatter16 ToOutput;
 
+    // Same as above, many pixels at once. Only set when the batch worker is in use
+    _cmsFormatter16Block FromInputBlock;
+    _cmsFormatter16Block ToOutputBlock;
+
     cmsFormatterFloat FromInputFloat;
     cmsFormatterFloat ToOutputFloat;
 
+    _cmsFormatterFloatBlock FromInputFloatBlock;
+    _cmsFormatterFloatBlock ToOutputFloatBlock;
+
+    // What the block formatters above need to know about the layouts
+    _cmsBlockLayout InputBlockLayout;
+    _cmsBlockLayout OutputBlockLayout;
+
     // 1-pixel cache seed for zero as input (16 bits, read only)
     _cmsCACHE Cache;
 
@@ -1187,6 +1376,12 @@ typedef struct _cmstransform_struct {
     cmsInt32Number   MaxWorkers;
     cmsUInt32Number  WorkerFlags;
 
+    // Multi-entry pixel cache (cmsFLAGS_HASHCACHE): the worker it wraps, the table of this handle
+    // (NULL while a worker holds it) and its counters
+    _cmsTransform2Fn HashCacheFallback;
+    void*            HashCache;
+    cmsUInt32Number  HashCacheHits, HashCacheMisses;
+
 } _cmsTRANSFORM;
 
 // Copies extra channels from input to output if the original flags in the transform structure
@@ -1223,13 +1418,23 @@ cmsBool   _cmsAdaptationMatrix(cmsContext ContextID, cmsMAT3* r, const cmsMAT3*
 
 cmsBool   _cmsBuildRGB2XYZtransferMatrix(cmsContext ContextID, cmsMAT3* r, const cmsCIExyY* WhitePoint, const cmsCIExyYTRIPLE* Primaries);
 
-void _cmsFindFormatter(_cmsTRANSFORM* p, cmsUInt32Number InputFormat, cmsUInt32Number OutputFormat, cmsUInt32Number flags);
+void _cmsFindFormatter(cmsContext ContextID, _cmsTRANSFORM* p, cmsUInt32Number InputFormat, cmsUInt32Number OutputFormat, cmsUInt32Number flags);
 
 cmsUInt32Number _cmsAdjustReferenceCount(cmsUInt32Number *rc, int delta);
 
+// Adds to a counter shared among threads
+void _cmsAccumulateCounter(cmsUInt32Number *Counter, cmsUInt32Number Delta);
+
+// Replaces a pointer shared among threads, returns the previous value
+void* _cmsExchangePointer(void** Ptr, void* Value);
+
 // thread-safe gettime
 cmsBool _cmsGetTime(struct tm* ptr_time);
 
+// In place byte swap of whole arrays read from/written to ICC profiles
+void _cmsAdjustEndianess16Array(cmsUInt16Number* Array, cmsUInt32Number n);
+void _cmsAdjustEndianess32Array(cmsUInt32Number* Array, cmsUInt32Number n);
+
 #ifndef CMS_USE_CPP_API
 #ifdef __cplusplus
 }
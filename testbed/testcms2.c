@@ -789,6 +789,79 @@ cmsInt32Number CheckEndianness(cmsContext ContextID)
     return 1;
 }
 
+// Bulk readers should give the same values as reading one number at a time
+static
+cmsInt32Number CheckBulkReaders(cmsContext ContextID)
+{
+    cmsUInt8Number Block[1003 * 2 + 517 * 4];
+    cmsUInt16Number Words[1003];
+    cmsFloat32Number Floats[517];
+    cmsUInt16Number w;
+    cmsFloat32Number f;
+    cmsIOHANDLER* io;
+    cmsUInt32Number i;
+    cmsInt32Number rc = 1;
+
+    io = cmsOpenIOhandlerFromMem(ContextID, Block, sizeof(Block), "w");
+    if (io == NULL) return 0;
+
+    for (i=0; i < 1003; i++)
+        _cmsWriteUInt16Number(ContextID, io, (cmsUInt16Number) (i * 65));
+    for (i=0; i < 517; i++)
+        _cmsWriteFloat32Number(ContextID, io, (cmsFloat32Number) (i * 0.37 - 11.0));
+    cmsCloseIOhandler(ContextID, io);
+
+    io = cmsOpenIOhandlerFromMem(ContextID, Block, sizeof(Block), "r");
+    if (io == NULL) return 0;
+
+    if (!_cmsReadUInt16Array(ContextID, io, 1003, Words) ||
+        !_cmsReadFloat32Array(ContextID, io, 517, Floats)) {
+        cmsCloseIOhandler(ContextID, io);
+        Fail("Bulk read failed");
+        return 0;
+    }
+
+    // Nothing left
+    cmsSetLogErrorHandler(ContextID, NULL);
+    if (_cmsReadUInt16Array(ContextID, io, 1, Words)) {
+        Fail("Bulk read past the end of the block");
+        rc = 0;
+    }
+    ResetFatalError(ContextID);
+
+    if (!io ->Seek(ContextID, io, 0)) rc = 0;
+
+    for (i=0; rc && i < 1003; i++) {
+        if (!_cmsReadUInt16Number(ContextID, io, &w) || w != Words[i]) {
+            Fail("Bulk read of 16 bits, element %u", i);
+            rc = 0;
+        }
+    }
+
+    for (i=0; rc && i < 517; i++) {
+        if (!_cmsReadFloat32Number(ContextID, io, &f) || f != Floats[i]) {
+            Fail("Bulk read of floats, element %u", i);
+            rc = 0;
+        }
+    }
+
+    cmsCloseIOhandler(ContextID, io);
+
+    // Absurd values are rejected as well
+    for (i=0; i < 4; i++) Block[2 * 4 + i] = 0xFF;     // A NaN as third float
+
+    io = cmsOpenIOhandlerFromMem(ContextID, Block, 5 * 4, "r");
+    if (io == NULL) return 0;
+
+    if (_cmsReadFloat32Array(ContextID, io, 5, Floats)) {
+        Fail("Bulk read of floats accepts NaN");
+        rc = 0;
+    }
+
+    cmsCloseIOhandler(ContextID, io);
+    return rc;
+}
+
 // Check quick floor
 static
 cmsInt32Number CheckQuickFloor(cmsContext ContextID)
@@ -1294,6 +1367,132 @@ Error:
     return 0;
 }
 
+// The block interpolator must give exactly the same as the per-pixel one, whatever the CPU runs
+static
+cmsInt32Number Check3DinterpolationTetrahedral16Block(cmsContext ContextID)
+{
+    cmsUInt32Number nGrid, nOut, i;
+    const cmsUInt32Number nPixels = 4099;
+    cmsUInt16Number* Table;
+    cmsUInt16Number* In  = (cmsUInt16Number*) malloc(nPixels * 3 * sizeof(cmsUInt16Number));
+    cmsUInt16Number* Out = (cmsUInt16Number*) malloc(nPixels * 8 * sizeof(cmsUInt16Number));
+    cmsUInt16Number Ref[8];
+    cmsInt32Number rc = 1;
+
+    // Corners, ties among the fractional parts and random values
+    for (i = 0; i < nPixels * 3; i++) {
+
+        switch (i % 11) {
+        case 0:  In[i] = 0; break;
+        case 1:  In[i] = 0xFFFF; break;
+        case 2:  In[i] = In[i - 1]; break;
+        default: In[i] = (cmsUInt16Number) (((cmsUInt32Number) rand() << 8) ^ (cmsUInt32Number) rand());
+        }
+    }
+
+    for (nGrid = 2; nGrid <= 33 && rc; nGrid += 15) {
+
+        for (nOut = 1; nOut <= 8 && rc; nOut++) {
+
+            cmsUInt32Number nEntries = nGrid * nGrid * nGrid * nOut;
+            cmsInterpParams* p;
+
+            Table = (cmsUInt16Number*) malloc(nEntries * sizeof(cmsUInt16Number));
+            for (i = 0; i < nEntries; i++)
+                Table[i] = (cmsUInt16Number) (((cmsUInt32Number) rand() << 8) ^ (cmsUInt32Number) rand());
+
+            p = _cmsComputeInterpParams(ContextID, nGrid, 3, nOut, Table, CMS_LERP_FLAGS_16BITS);
+
+            p->InterpolationN.Lerp16N(ContextID, In, Out, nPixels, p);
+
+            for (i = 0; i < nPixels; i++) {
+
+                p->Interpolation.Lerp16(ContextID, In + i * 3, Ref, p);
+                if (memcmp(Ref, Out + i * nOut, nOut * sizeof(cmsUInt16Number)) != 0) {
+
+                    Fail("Block interpolation differs: grid %u, %u outputs, pixel %u", nGrid, nOut, i);
+                    rc = 0;
+                    break;
+                }
+            }
+
+            _cmsFreeInterpParams(ContextID, p);
+            free(Table);
+        }
+    }
+
+    free(In); free(Out);
+    return rc;
+}
+
+// Batch interpolators against the per-pixel ones, on the dimensions having their own batch version and one that is looped
+static
+cmsInt32Number CheckBatchInterpolation(cmsContext ContextID)
+{
+    static const cmsUInt32Number Cases[][3] = {
+        { 1, 1, CMS_LERP_FLAGS_16BITS }, { 1, 3, CMS_LERP_FLAGS_16BITS },
+        { 3, 3, CMS_LERP_FLAGS_16BITS|CMS_LERP_FLAGS_TRILINEAR }, { 3, 4, CMS_LERP_FLAGS_16BITS },
+        { 4, 3, CMS_LERP_FLAGS_16BITS }, { 5, 2, CMS_LERP_FLAGS_16BITS },
+        { 1, 1, CMS_LERP_FLAGS_FLOAT }, { 1, 3, CMS_LERP_FLAGS_FLOAT },
+        { 3, 3, CMS_LERP_FLAGS_FLOAT|CMS_LERP_FLAGS_TRILINEAR }, { 3, 4, CMS_LERP_FLAGS_FLOAT },
+        { 4, 3, CMS_LERP_FLAGS_FLOAT }, { 5, 2, CMS_LERP_FLAGS_FLOAT } };
+    const cmsUInt32Number nGrid = 9, nPixels = 300;
+    cmsUInt32Number c, i, j;
+
+    for (c = 0; c < sizeof(Cases) / sizeof(Cases[0]); c++) {
+
+        cmsUInt32Number nIn = Cases[c][0], nOut = Cases[c][1];
+        cmsBool IsFloat = (Cases[c][2] & CMS_LERP_FLAGS_FLOAT) != 0;
+        cmsUInt32Number nEntries = nOut;
+        cmsUInt32Number SampleSize = IsFloat ? sizeof(cmsFloat32Number) : sizeof(cmsUInt16Number);
+        cmsUInt8Number *Table, *In, *Out, Ref[MAX_STAGE_CHANNELS * sizeof(cmsFloat32Number)];
+        cmsInterpParams* p;
+        cmsInt32Number rc = 1;
+
+        for (i = 0; i < nIn; i++) nEntries *= nGrid;
+
+        Table = (cmsUInt8Number*) malloc(nEntries * SampleSize);
+        In    = (cmsUInt8Number*) malloc(nPixels * nIn * SampleSize);
+        Out   = (cmsUInt8Number*) malloc(nPixels * nOut * SampleSize);
+
+        for (i = 0; i < nEntries; i++) {
+            if (IsFloat) ((cmsFloat32Number*) Table)[i] = (cmsFloat32Number) rand() / RAND_MAX;
+            else         ((cmsUInt16Number*) Table)[i]  = (cmsUInt16Number) (((cmsUInt32Number) rand() << 8) ^ (cmsUInt32Number) rand());
+        }
+
+        for (i = 0; i < nPixels * nIn; i++) {
+            if (IsFloat) ((cmsFloat32Number*) In)[i] = (cmsFloat32Number) rand() / RAND_MAX;
+            else         ((cmsUInt16Number*) In)[i]  = (cmsUInt16Number) (i % 7 == 0 ? 0xFFFF : (((cmsUInt32Number) rand() << 8) ^ (cmsUInt32Number) rand()));
+        }
+
+        p = _cmsComputeInterpParams(ContextID, nGrid, nIn, nOut, Table, Cases[c][2]);
+
+        if (IsFloat)
+            p->InterpolationN.LerpFloatN(ContextID, (cmsFloat32Number*) In, (cmsFloat32Number*) Out, nPixels, p);
+        else
+            p->InterpolationN.Lerp16N(ContextID, (cmsUInt16Number*) In, (cmsUInt16Number*) Out, nPixels, p);
+
+        for (j = 0; j < nPixels && rc; j++) {
+
+            if (IsFloat)
+                p->Interpolation.LerpFloat(ContextID, (cmsFloat32Number*) In + j * nIn, (cmsFloat32Number*) Ref, p);
+            else
+                p->Interpolation.Lerp16(ContextID, (cmsUInt16Number*) In + j * nIn, (cmsUInt16Number*) Ref, p);
+
+            if (memcmp(Ref, Out + j * nOut * SampleSize, nOut * SampleSize) != 0) {
+                Fail("Batch interpolation differs: %u -> %u %s, pixel %u", nIn, nOut, IsFloat ? "float" : "16 bits", j);
+                rc = 0;
+            }
+        }
+
+        _cmsFreeInterpParams(ContextID, p);
+        free(Table); free(In); free(Out);
+        if (!rc) return 0;
+    }
+
+    return 1;
+}
+
 static
 cmsInt32Number Check3DinterpolationTrilinear16(cmsContext ContextID)
 {
@@ -3504,6 +3703,252 @@ cmsInt32Number CheckLab2LabMatLUT(cmsContext ContextID)
     return rc;
 }
 
+// A stage with no block evaluator, to exercise the per-pixel fallback
+static
+void EvaluateInverter(cmsContext ContextID, const cmsFloat32Number In[], cmsFloat32Number Out[], const cmsStage *mpe)
+{
+    cmsUInt32Number i;
+
+    for (i=0; i < cmsStageInputChannels(ContextID, mpe); i++)
+        Out[i] = 1.0F - In[i];
+}
+
+// Block evaluation should give the very same results as pixel by pixel, on all default stages
+static
+cmsInt32Number CheckPipelineEvalN(cmsContext ContextID)
+{
+    static const cmsFloat64Number Mat[] = { 0.5, 0.25, 0.125,  0.1, 0.7, 0.1,  0.3, 0.2, 0.4 };
+    static const cmsFloat64Number Off[] = { 0.1, 0.0, 0.05 };
+    const cmsUInt32Number nPixels = 3000;
+    cmsUInt16Number Table16[9 * 9 * 9 * 4];
+    cmsFloat32Number TableFloat[5 * 5 * 5 * 5 * 3];
+    cmsFloat32Number *InF, *OutF, RefF[3];
+    cmsUInt16Number *In16, *Out16, Ref16[3];
+    cmsPipeline* lut = cmsPipelineAlloc(ContextID, 3, 3);
+    cmsUInt32Number i;
+    cmsInt32Number rc = 1;
+
+    for (i=0; i < 9 * 9 * 9 * 4; i++)
+        Table16[i] = (cmsUInt16Number) (((cmsUInt32Number) rand() << 8) ^ (cmsUInt32Number) rand());
+    for (i=0; i < 5 * 5 * 5 * 5 * 3; i++)
+        TableFloat[i] = (cmsFloat32Number) rand() / RAND_MAX;
+
+    Add3GammaCurves(ContextID, lut, 2.2);
+    cmsPipelineInsertStage(ContextID, lut, cmsAT_END, cmsStageAllocMatrix(ContextID, 3, 3, Mat, Off));
+    cmsPipelineInsertStage(ContextID, lut, cmsAT_END, _cmsStageAllocLab2XYZ(ContextID));
+    cmsPipelineInsertStage(ContextID, lut, cmsAT_END, _cmsStageAllocXYZ2Lab(ContextID));
+    cmsPipelineInsertStage(ContextID, lut, cmsAT_END, _cmsStageAllocPlaceholder(ContextID, cmsSigIdentityElemType, 3, 3, EvaluateInverter, NULL, NULL, NULL));
+    cmsPipelineInsertStage(ContextID, lut, cmsAT_END, cmsStageAllocCLut16bit(ContextID, 9, 3, 4, Table16));
+    cmsPipelineInsertStage(ContextID, lut, cmsAT_END, cmsStageAllocCLutFloat(ContextID, 5, 4, 3, TableFloat));
+    cmsPipelineInsertStage(ContextID, lut, cmsAT_END, cmsStageAllocIdentity(ContextID, 3));
+
+    InF   = (cmsFloat32Number*) malloc(nPixels * 3 * sizeof(cmsFloat32Number));
+    OutF  = (cmsFloat32Number*) malloc(nPixels * 3 * sizeof(cmsFloat32Number));
+    In16  = (cmsUInt16Number*) malloc(nPixels * 3 * sizeof(cmsUInt16Number));
+    Out16 = (cmsUInt16Number*) malloc(nPixels * 3 * sizeof(cmsUInt16Number));
+
+    for (i=0; i < nPixels * 3; i++) {
+        In16[i] = (cmsUInt16Number) (((cmsUInt32Number) rand() << 8) ^ (cmsUInt32Number) rand());
+        InF[i]  = (cmsFloat32Number) rand() / RAND_MAX;
+    }
+
+    cmsPipelineEvalFloatN(ContextID, InF, OutF, nPixels, lut);
+    cmsPipelineEval16N(ContextID, In16, Out16, nPixels, lut);
+
+    for (i=0; i < nPixels && rc; i++) {
+
+        cmsPipelineEvalFloat(ContextID, InF + i * 3, RefF, lut);
+        cmsPipelineEval16(ContextID, In16 + i * 3, Ref16, lut);
+
+        if (memcmp(RefF, OutF + i * 3, sizeof(RefF)) != 0) {
+            Fail("Float block evaluation differs at pixel %u", i);
+            rc = 0;
+        }
+
+        if (memcmp(Ref16, Out16 + i * 3, sizeof(Ref16)) != 0) {
+            Fail("16 bits block evaluation differs at pixel %u", i);
+            rc = 0;
+        }
+    }
+
+    free(InF); free(OutF); free(In16); free(Out16);
+    cmsPipelineFree(ContextID, lut);
+    return rc;
+}
+
+// A sampler mixing coordinates, in per-node and in row form. Cargo counts the nodes seen.
+static
+cmsInt32Number MixNode16(cmsContext ContextID, CMSREGISTER const cmsUInt16Number In[], CMSREGISTER cmsUInt16Number Out[], CMSREGISTER void* Cargo)
+{
+    cmsUNUSED_PARAMETER(ContextID);
+
+    Out[0] = (cmsUInt16Number) (In[0] ^ (In[1] >> 1));
+    Out[1] = (cmsUInt16Number) (In[2] + In[1] * 3);
+    (*(cmsUInt32Number*) Cargo)++;
+    return 1;
+}
+
+static
+cmsInt32Number MixRow16(cmsContext ContextID, const cmsUInt16Number In[], cmsUInt16Number Out[], cmsUInt32Number nNodes, void* Cargo)
+{
+    cmsUInt32Number k;
+
+    for (k=0; k < nNodes; k++)
+        MixNode16(ContextID, In + k * 3, Out + k * 2, Cargo);
+    return 1;
+}
+
+static
+cmsInt32Number MixNodeFloat(cmsContext ContextID, CMSREGISTER const cmsFloat32Number In[], CMSREGISTER cmsFloat32Number Out[], CMSREGISTER void* Cargo)
+{
+    cmsUNUSED_PARAMETER(ContextID);
+
+    Out[0] = In[0] * 0.5F + In[1];
+    Out[1] = In[2] - In[1] * 0.25F;
+    (*(cmsUInt32Number*) Cargo)++;
+    return 1;
+}
+
+static
+cmsInt32Number MixRowFloat(cmsContext ContextID, const cmsFloat32Number In[], cmsFloat32Number Out[], cmsUInt32Number nNodes, void* Cargo)
+{
+    cmsUInt32Number k;
+
+    for (k=0; k < nNodes; k++)
+        MixNodeFloat(ContextID, In + k * 3, Out + k * 2, Cargo);
+    return 1;
+}
+
+// Row samplers should fill the very same table as per-node ones, also on uneven grids
+static
+cmsInt32Number CheckRowSampler(cmsContext ContextID)
+{
+    static const cmsUInt32Number Grid[] = { 2, 3, 5 };
+    cmsStage *Node16, *Row16, *NodeFloat, *RowFloat;
+    _cmsStageCLutData *n16, *r16, *nf, *rf;
+    cmsUInt32Number nNode = 0, nRow = 0;
+    cmsInt32Number rc = 1;
+
+    Node16    = cmsStageAllocCLut16bitGranular(ContextID, Grid, 3, 2, NULL);
+    Row16     = cmsStageAllocCLut16bitGranular(ContextID, Grid, 3, 2, NULL);
+    NodeFloat = cmsStageAllocCLutFloat(ContextID, 7, 3, 2, NULL);
+    RowFloat  = cmsStageAllocCLutFloat(ContextID, 7, 3, 2, NULL);
+
+    if (!cmsStageSampleCLut16bit(ContextID, Node16, MixNode16, &nNode, 0)) rc = 0;
+    if (!cmsStageSampleCLut16bitN(ContextID, Row16, MixRow16, &nRow, 0)) rc = 0;
+    if (!cmsStageSampleCLutFloat(ContextID, NodeFloat, MixNodeFloat, &nNode, 0)) rc = 0;
+    if (!cmsStageSampleCLutFloatN(ContextID, RowFloat, MixRowFloat, &nRow, 0)) rc = 0;
+
+    if (rc == 0 || nNode != 2 * 3 * 5 + 7 * 7 * 7 || nRow != nNode) {
+        Fail("Row sampling failed or visited a wrong number of nodes");
+        rc = 0;
+    }
+
+    n16 = (_cmsStageCLutData*) cmsStageData(ContextID, Node16);
+    r16 = (_cmsStageCLutData*) cmsStageData(ContextID, Row16);
+    nf  = (_cmsStageCLutData*) cmsStageData(ContextID, NodeFloat);
+    rf  = (_cmsStageCLutData*) cmsStageData(ContextID, RowFloat);
+
+    if (rc && memcmp(n16 ->Tab.T, r16 ->Tab.T, n16 ->nEntries * sizeof(cmsUInt16Number)) != 0) {
+        Fail("16 bits row sampler differs from the node sampler");
+        rc = 0;
+    }
+
+    if (rc && memcmp(nf ->Tab.TFloat, rf ->Tab.TFloat, nf ->nEntries * sizeof(cmsFloat32Number)) != 0) {
+        Fail("Float row sampler differs from the node sampler");
+        rc = 0;
+    }
+
+    // Inspecting should leave the table untouched
+    memset(r16 ->Tab.T, 0, r16 ->nEntries * sizeof(cmsUInt16Number));
+    if (rc && (!cmsStageSampleCLut16bitN(ContextID, Row16, MixRow16, &nRow, SAMPLER_INSPECT) ||
+                r16 ->Tab.T[r16 ->nEntries - 1] != 0)) {
+        Fail("Row sampler wrote the table on inspect");
+        rc = 0;
+    }
+
+    cmsStageFree(ContextID, Node16);
+    cmsStageFree(ContextID, Row16);
+    cmsStageFree(ContextID, NodeFloat);
+    cmsStageFree(ContextID, RowFloat);
+    return rc;
+}
+
+// Optimizes the pipeline into a CLUT and returns its grid size
+static
+cmsUInt32Number OptimizedGridpoints(cmsContext ContextID, cmsPipeline* lut, cmsUInt32Number dwFlags)
+{
+    cmsUInt32Number InFormat = TYPE_RGB_16, OutFormat = TYPE_RGB_16;
+    cmsUInt32Number nGridPoints = 0;
+    cmsStage* CLUT;
+
+    dwFlags |= cmsFLAGS_FORCE_CLUT;
+    if (_cmsOptimizePipeline(ContextID, &lut, INTENT_PERCEPTUAL, &InFormat, &OutFormat, &dwFlags)) {
+
+        // There may be linearization curves around
+        for (CLUT = cmsPipelineGetPtrToFirstStage(ContextID, lut); CLUT != NULL; CLUT = cmsStageNext(ContextID, CLUT)) {
+
+            if (cmsStageType(ContextID, CLUT) == cmsSigCLutElemType) {
+                nGridPoints = ((_cmsStageCLutData*) cmsStageData(ContextID, CLUT)) ->Params ->nSamples[0];
+                break;
+            }
+        }
+    }
+
+    cmsPipelineFree(ContextID, lut);
+    return nGridPoints;
+}
+
+// Linear pipelines are exactly reproduced by the smallest grid, curved ones need more nodes
+static
+cmsInt32Number CheckGridErrorBudget(cmsContext ContextID)
+{
+    static const cmsFloat64Number Mat[] = { 0.5, 0.25, 0.125,  0.1, 0.7, 0.1,  0.3, 0.2, 0.4 };
+    cmsPipeline* lut;
+    cmsUInt32Number Linear, Curved, Fixed, Given, HighRes, Prelinearized;
+    cmsFloat64Number Prev;
+
+    Prev = cmsSetGridpointsErrorBudget(ContextID, 4);
+    if (Prev != 0) { Fail("Error budget should be disabled by default"); return 0; }
+
+    lut = cmsPipelineAlloc(ContextID, 3, 3);
+    cmsPipelineInsertStage(ContextID, lut, cmsAT_END, cmsStageAllocMatrix(ContextID, 3, 3, Mat, NULL));
+    Linear = OptimizedGridpoints(ContextID, lut, 0);
+
+    lut = cmsPipelineAlloc(ContextID, 3, 3);
+    Add3GammaCurves(ContextID, lut, 2.2);
+    Curved = OptimizedGridpoints(ContextID, lut, 0);
+
+    lut = cmsPipelineAlloc(ContextID, 3, 3);
+    Add3GammaCurves(ContextID, lut, 2.2);
+    Given = OptimizedGridpoints(ContextID, lut, cmsFLAGS_GRIDPOINTS(17));
+
+    lut = cmsPipelineAlloc(ContextID, 3, 3);
+    cmsPipelineInsertStage(ContextID, lut, cmsAT_END, cmsStageAllocMatrix(ContextID, 3, 3, Mat, NULL));
+    HighRes = OptimizedGridpoints(ContextID, lut, cmsFLAGS_HIGHRESPRECALC);
+
+    // Curves kept aside as prelinearization are not part of the sampled error
+    lut = cmsPipelineAlloc(ContextID, 3, 3);
+    Add3GammaCurves(ContextID, lut, 2.2);
+    cmsPipelineInsertStage(ContextID, lut, cmsAT_END, cmsStageAllocMatrix(ContextID, 3, 3, Mat, NULL));
+    Prelinearized = OptimizedGridpoints(ContextID, lut, cmsFLAGS_CLUT_PRE_LINEARIZATION);
+
+    cmsSetGridpointsErrorBudget(ContextID, 0);
+
+    lut = cmsPipelineAlloc(ContextID, 3, 3);
+    cmsPipelineInsertStage(ContextID, lut, cmsAT_END, cmsStageAllocMatrix(ContextID, 3, 3, Mat, NULL));
+    Fixed = OptimizedGridpoints(ContextID, lut, 0);
+
+    if (Linear != 3) { Fail("Linear pipeline got %u gridpoints", Linear); return 0; }
+    if (Curved <= 3 || Curved > 33) { Fail("Curved pipeline got %u gridpoints", Curved); return 0; }
+    if (Given != 17) { Fail("Explicit gridpoints were not honored (%u)", Given); return 0; }
+    if (HighRes != 49) { Fail("High resolution precalc was reduced to %u gridpoints", HighRes); return 0; }
+    if (Prelinearized != 3) { Fail("Prelinearized pipeline got %u gridpoints", Prelinearized); return 0; }
+    if (Fixed != 33) { Fail("Fixed grid expected without budget, got %u", Fixed); return 0; }
+
+    return 1;
+}
+
 static
 cmsInt32Number CheckNamedColorLUT(cmsContext ContextID)
 {
@@ -4237,33 +4682,319 @@ cmsInt32Number CheckFormattersFloat(cmsContext ContextID)
 
 
 
-   return FormatterFailed == 0 ? 1 : 0;
+   return FormatterFailed == 0 ? 1 : 0;
+}
+#undef C
+
+// Block formatters must do the same as the stock pixel formatters, on whole groups
+#define BLOCK_CHECK_PIXELS  37
+
+static
+cmsBool CheckSingleBlockFormatter(cmsContext ContextID, cmsUInt32Number Type, cmsFormatterDirection Dir, cmsUInt32Number* Seed)
+{
+    cmsUInt8Number  Buffer[BLOCK_CHECK_PIXELS * 2 * (cmsMAXCHANNELS + 4)];
+    cmsUInt8Number  Ref[BLOCK_CHECK_PIXELS * 2 * (cmsMAXCHANNELS + 4)];
+    cmsUInt16Number Values[BLOCK_CHECK_PIXELS * cmsMAXCHANNELS];
+    cmsUInt16Number Block[BLOCK_CHECK_PIXELS * cmsMAXCHANNELS];
+    cmsUInt32Number nChan  = T_CHANNELS(Type);
+    cmsUInt32Number nBytes = BLOCK_CHECK_PIXELS * T_BYTES(Type) * (nChan + T_EXTRA(Type));
+    cmsUInt8Number  *Ptr, *End;
+    _cmsFormatter16Block fb;
+    cmsFormatter f;
+    _cmsTRANSFORM info;
+    cmsUInt32Number i;
+
+    memset(&info, 0, sizeof(info));
+    info.OutputFormat = info.InputFormat = Type;
+
+    f = _cmsGetFormatter(ContextID, Type, Dir, CMS_PACK_FLAGS_16BITS);
+    fb = _cmsGetBlockFormatter16(Type, Dir, f.Fmt16, Dir == cmsFormatterInput ? &info.InputBlockLayout : &info.OutputBlockLayout);
+
+    // Stock packers don't agree among themselves on this one
+    if (Dir == cmsFormatterOutput && T_DOSWAP(Type) && T_SWAPFIRST(Type) && T_EXTRA(Type) == 0)
+        return fb == NULL;
+
+    if (f.Fmt16 == NULL || fb == NULL) {
+        Fail("No block formatter for type %x", Type);
+        return FALSE;
+    }
+
+    for (i = 0; i < sizeof(Buffer); i++) {
+        *Seed = *Seed * 1103515245U + 12345U;
+        Buffer[i] = Ref[i] = (cmsUInt8Number) (*Seed >> 16);
+    }
+
+    for (i = 0; i < BLOCK_CHECK_PIXELS * nChan; i++) {
+        *Seed = *Seed * 1103515245U + 12345U;
+        Values[i] = (cmsUInt16Number) (*Seed >> 8);
+    }
+
+    if (Dir == cmsFormatterInput) {
+
+        Ptr = Buffer;
+        for (i = 0; i < BLOCK_CHECK_PIXELS; i++)
+            Ptr = f.Fmt16(ContextID, &info, Values + i * nChan, Ptr, 0);
+
+        End = fb(ContextID, &info, Block, Buffer, BLOCK_CHECK_PIXELS);
+
+        if (End != Ptr || memcmp(Values, Block, BLOCK_CHECK_PIXELS * nChan * sizeof(cmsUInt16Number)) != 0) {
+            Fail("Block unroll of type %x differs", Type);
+            return FALSE;
+        }
+    }
+    else {
+
+        // Extra channels must come out untouched
+        Ptr = Ref;
+        for (i = 0; i < BLOCK_CHECK_PIXELS; i++)
+            Ptr = f.Fmt16(ContextID, &info, Values + i * nChan, Ptr, 0);
+
+        End = fb(ContextID, &info, Values, Buffer, BLOCK_CHECK_PIXELS);
+
+        if (End - Buffer != Ptr - Ref || memcmp(Buffer, Ref, sizeof(Buffer)) != 0 || (cmsUInt32Number) (End - Buffer) != nBytes) {
+            Fail("Block pack of type %x differs", Type);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+// The batch worker goes through block formatters and squeezes out repeated pixels. Doing a
+// group at once must give the same as doing each pixel on its own.
+static
+cmsBool CheckBlockFormattersOnTransform(cmsContext ContextID)
+{
+    cmsUInt8Number  In[BLOCK_CHECK_PIXELS * 4];
+    cmsUInt16Number Out[BLOCK_CHECK_PIXELS * 3], One[3];
+    cmsHPROFILE hsRGB, hLab;
+    cmsHTRANSFORM xform;
+    cmsBool rc = TRUE;
+    cmsUInt32Number i;
+
+    hsRGB = cmsCreate_sRGBProfile(ContextID);
+    hLab  = cmsCreateLab4Profile(ContextID, NULL);
+    xform = cmsCreateTransform(ContextID, hsRGB, TYPE_ARGB_8, hLab, TYPE_Lab_16 | ENDIAN16_SH(1), INTENT_PERCEPTUAL, 0);
+    cmsCloseProfile(ContextID, hsRGB);
+    cmsCloseProfile(ContextID, hLab);
+
+    if (xform == NULL) return FALSE;
+
+    // Runs of equal pixels, with alpha that should not matter
+    for (i = 0; i < BLOCK_CHECK_PIXELS; i++) {
+        In[4 * i]     = (cmsUInt8Number) (i * 31);
+        In[4 * i + 1] = (cmsUInt8Number) ((i / 3) * 57);
+        In[4 * i + 2] = (cmsUInt8Number) ((i / 3) * 91);
+        In[4 * i + 3] = (cmsUInt8Number) ((i / 3) * 13);
+    }
+
+    cmsDoTransform(ContextID, xform, In, Out, BLOCK_CHECK_PIXELS);
+
+    for (i = 0; i < BLOCK_CHECK_PIXELS && rc; i++) {
+
+        cmsDoTransform(ContextID, xform, In + 4 * i, One, 1);
+
+        if (memcmp(One, Out + 3 * i, sizeof(One)) != 0) {
+            Fail("Pixel %u differs when transformed in a group", i);
+            rc = FALSE;
+        }
+    }
+
+    cmsDeleteTransform(ContextID, xform);
+    return rc;
+}
+
+static
+cmsInt32Number CheckBlockFormatters(cmsContext ContextID)
+{
+    static const cmsUInt32Number Channels[] = { 1, 2, 3, 4, 5, 6, 8, 15 };
+    cmsUInt32Number Seed = 1;
+    cmsUInt32Number c, Extra, Bytes, DoSwap, SwapFirst, Endian;
+
+    for (Bytes = 1; Bytes <= 2; Bytes++)
+    for (c = 0; c < sizeof(Channels) / sizeof(Channels[0]); c++)
+    for (Extra = 0; Extra <= 2; Extra++)
+    for (DoSwap = 0; DoSwap <= 1; DoSwap++)
+    for (SwapFirst = 0; SwapFirst <= 1; SwapFirst++)
+    for (Endian = 0; Endian < Bytes; Endian++) {
+
+        cmsUInt32Number Type = CHANNELS_SH(Channels[c]) | EXTRA_SH(Extra) | BYTES_SH(Bytes) |
+                               DOSWAP_SH(DoSwap) | SWAPFIRST_SH(SwapFirst) | ENDIAN16_SH(Endian);
+
+        if (!CheckSingleBlockFormatter(ContextID, Type, cmsFormatterInput, &Seed)) return 0;
+        if (!CheckSingleBlockFormatter(ContextID, Type, cmsFormatterOutput, &Seed)) return 0;
+    }
+
+    return CheckBlockFormattersOnTransform(ContextID);
+}
+
+#ifndef CMS_NO_HALF_SUPPORT
+
+// Check half float
+#define my_isfinite(x) ((x) != (x))
+static
+cmsInt32Number CheckFormattersHalf(cmsContext ContextID)
+{
+    int i, j;
+
+
+    for (i=0; i < 0xffff; i++) {
+
+        cmsFloat32Number f = _cmsHalf2Float((cmsUInt16Number) i);
+
+        if (!my_isfinite(f))  {
+
+            j = _cmsFloat2Half(f);
+
+            if (i != j) {
+                Fail("%d != %d in Half float support!\n", i, j);
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+// Array conversions must give the same bits as the tables. Every half, and floats all over
+// the range including denormals, values beyond the half range, infinities and NaN.
+static
+cmsInt32Number CheckHalfArrays(cmsContext ContextID)
+{
+    cmsUInt16Number  Half[4096], Back[4096];
+    cmsFloat32Number Flt[4096];
+    cmsUInt32Number  i, j, n;
+
+    for (i = 0; i < 0x10000; i += 4096) {
+
+        for (j = 0; j < 4096; j++)
+            Half[j] = (cmsUInt16Number) (i + j);
+
+        _cmsHalf2FloatArray(Half, Flt, 4096);
+
+        for (j = 0; j < 4096; j++) {
+
+            cmsFloat32Number f = _cmsHalf2Float(Half[j]);
+
+            if (memcmp(&f, &Flt[j], sizeof(f)) != 0) {
+                Fail("Half %x converts to a different float in arrays", Half[j]);
+                return 0;
+            }
+        }
+    }
+
+    for (n = 0; n < 0x10000; n += 4096 / 16) {
+
+        // Stepping by 0x10001 hits every exponent with varying mantissas
+        for (j = 0; j < 4096; j++) {
+
+            cmsUInt32Number u = (n * 16 + j) * 0x10001U;
+            memcpy(&Flt[j], &u, sizeof(u));
+        }
+
+        _cmsFloat2HalfArray(Flt, Back, 4095);
+
+        for (j = 0; j < 4095; j++) {
+
+            if (Back[j] != _cmsFloat2Half(Flt[j])) {
+                Fail("Float %g converts to a different half in arrays", Flt[j]);
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+
+    cmsUNUSED_PARAMETER(ContextID);
+}
+
+// Half floats are converted a group at a time in float transforms
+static
+cmsBool CheckSingleBlockFormatterHalf(cmsContext ContextID, cmsUInt32Number Type, cmsFormatterDirection Dir, cmsUInt32Number* Seed)
+{
+    cmsUInt8Number   Buffer[BLOCK_CHECK_PIXELS * 2 * (cmsMAXCHANNELS + 4)];
+    cmsUInt8Number   Ref[BLOCK_CHECK_PIXELS * 2 * (cmsMAXCHANNELS + 4)];
+    cmsFloat32Number Values[BLOCK_CHECK_PIXELS * cmsMAXCHANNELS];
+    cmsFloat32Number Block[BLOCK_CHECK_PIXELS * cmsMAXCHANNELS];
+    cmsUInt32Number  nChan = T_CHANNELS(Type);
+    cmsUInt8Number   *Ptr, *End;
+    _cmsFormatterFloatBlock fb;
+    cmsFormatter f;
+    _cmsTRANSFORM info;
+    cmsUInt32Number i;
+
+    memset(&info, 0, sizeof(info));
+    info.OutputFormat = info.InputFormat = Type;
+
+    f  = _cmsGetFormatter(ContextID, Type, Dir, CMS_PACK_FLAGS_FLOAT);
+    fb = _cmsGetBlockFormatterFloat(Type, Dir, f.FmtFloat, Dir == cmsFormatterInput ? &info.InputBlockLayout : &info.OutputBlockLayout);
+
+    if (f.FmtFloat == NULL || fb == NULL) {
+        Fail("No block formatter for type %x", Type);
+        return FALSE;
+    }
+
+    for (i = 0; i < sizeof(Buffer); i++) {
+        *Seed = *Seed * 1103515245U + 12345U;
+        Buffer[i] = Ref[i] = (cmsUInt8Number) (*Seed >> 16);
+    }
+
+    for (i = 0; i < BLOCK_CHECK_PIXELS * nChan; i++) {
+        *Seed = *Seed * 1103515245U + 12345U;
+        Values[i] = (cmsFloat32Number) ((*Seed >> 8) & 0xffff) / 32768.0F - 0.5F;
+    }
+
+    if (Dir == cmsFormatterInput) {
+
+        Ptr = Buffer;
+        for (i = 0; i < BLOCK_CHECK_PIXELS; i++)
+            Ptr = f.FmtFloat(ContextID, &info, Values + i * nChan, Ptr, 0);
+
+        End = fb(ContextID, &info, Block, Buffer, BLOCK_CHECK_PIXELS);
+
+        if (End != Ptr || memcmp(Values, Block, BLOCK_CHECK_PIXELS * nChan * sizeof(cmsFloat32Number)) != 0) {
+            Fail("Block unroll of type %x differs", Type);
+            return FALSE;
+        }
+    }
+    else {
+
+        Ptr = Ref;
+        for (i = 0; i < BLOCK_CHECK_PIXELS; i++)
+            Ptr = f.FmtFloat(ContextID, &info, Values + i * nChan, Ptr, 0);
+
+        End = fb(ContextID, &info, Values, Buffer, BLOCK_CHECK_PIXELS);
+
+        if (End - Buffer != Ptr - Ref || memcmp(Buffer, Ref, sizeof(Buffer)) != 0) {
+            Fail("Block pack of type %x differs", Type);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
 }
-#undef C
 
-#ifndef CMS_NO_HALF_SUPPORT
-
-// Check half float
-#define my_isfinite(x) ((x) != (x))
 static
-cmsInt32Number CheckFormattersHalf(cmsContext ContextID)
+cmsInt32Number CheckBlockFormattersHalf(cmsContext ContextID)
 {
-    int i, j;
-
-
-    for (i=0; i < 0xffff; i++) {
-
-        cmsFloat32Number f = _cmsHalf2Float((cmsUInt16Number) i);
+    static const cmsUInt32Number Channels[] = { 1, 3, 4, 6, 15 };
+    static const cmsUInt32Number Spaces[] = { PT_RGB, PT_CMYK };
+    cmsUInt32Number Seed = 1;
+    cmsUInt32Number c, s, Extra, DoSwap, SwapFirst, Flavor;
 
-        if (!my_isfinite(f))  {
+    for (s = 0; s < sizeof(Spaces) / sizeof(Spaces[0]); s++)
+    for (c = 0; c < sizeof(Channels) / sizeof(Channels[0]); c++)
+    for (Extra = 0; Extra <= 2; Extra++)
+    for (DoSwap = 0; DoSwap <= 1; DoSwap++)
+    for (SwapFirst = 0; SwapFirst <= 1; SwapFirst++)
+    for (Flavor = 0; Flavor <= 1; Flavor++) {
 
-            j = _cmsFloat2Half(f);
+        cmsUInt32Number Type = COLORSPACE_SH(Spaces[s]) | CHANNELS_SH(Channels[c]) | EXTRA_SH(Extra) | BYTES_SH(2) | FLOAT_SH(1) |
+                               DOSWAP_SH(DoSwap) | SWAPFIRST_SH(SwapFirst) | FLAVOR_SH(Flavor);
 
-            if (i != j) {
-                Fail("%d != %d in Half float support!\n", i, j);
-                return 0;
-            }
-        }
+        // Half unrollers have no flavor
+        if (!Flavor && !CheckSingleBlockFormatterHalf(ContextID, Type, cmsFormatterInput, &Seed)) return 0;
+        if (!CheckSingleBlockFormatterHalf(ContextID, Type, cmsFormatterOutput, &Seed)) return 0;
     }
 
     return 1;
@@ -5777,6 +6508,230 @@ cmsInt32Number CheckErrReportingOnBadProfiles(cmsContext ContextID)
     return rc;
 }
 
+// Serializes a profile, which reads all tags from its iohandler
+static
+cmsUInt8Number* SavedProfileBytes(cmsContext ContextID, cmsHPROFILE h, cmsUInt32Number* Size)
+{
+    cmsUInt8Number* Mem;
+
+    if (h == NULL || !cmsSaveProfileToMem(ContextID, h, NULL, Size)) return NULL;
+
+    Mem = (cmsUInt8Number*) malloc(*Size);
+    if (!cmsSaveProfileToMem(ContextID, h, Mem, Size)) {
+        free(Mem);
+        return NULL;
+    }
+
+    return Mem;
+}
+
+// Memory mapped files and borrowed memory blocks should read the same as regular files
+static
+cmsInt32Number CheckMappedAndBorrowedProfiles(cmsContext ContextID)
+{
+    cmsHPROFILE hFile, hMapped, hBorrowed;
+    cmsUInt8Number *Raw, *FromFile, *FromMapped, *FromBorrowed;
+    cmsUInt32Number RawSize, FileSize, MappedSize, BorrowedSize;
+    cmsInt32Number rc = 1;
+
+    hFile   = cmsOpenProfileFromFile(ContextID, "test1.icc", "r");
+    hMapped = cmsOpenProfileFromFile(ContextID, "test1.icc", "rm");
+
+    if (hFile == NULL || hMapped == NULL) { Fail("Cannot open test1.icc"); return 0; }
+
+    Raw = SavedProfileBytes(ContextID, hFile, &RawSize);
+    if (Raw == NULL) { Fail("Cannot save test1.icc"); return 0; }
+
+    hBorrowed = cmsOpenProfileFromMemNoCopy(ContextID, Raw, RawSize);
+
+    FromFile     = SavedProfileBytes(ContextID, hFile, &FileSize);
+    FromMapped   = SavedProfileBytes(ContextID, hMapped, &MappedSize);
+    FromBorrowed = SavedProfileBytes(ContextID, hBorrowed, &BorrowedSize);
+
+    if (FromMapped == NULL || MappedSize != FileSize || memcmp(FromFile, FromMapped, FileSize) != 0) {
+        Fail("Memory mapped profile differs");
+        rc = 0;
+    }
+
+    if (FromBorrowed == NULL || BorrowedSize != RawSize || memcmp(Raw, FromBorrowed, RawSize) != 0) {
+        Fail("Profile on borrowed memory differs");
+        rc = 0;
+    }
+
+    cmsCloseProfile(ContextID, hFile);
+    cmsCloseProfile(ContextID, hMapped);
+    cmsCloseProfile(ContextID, hBorrowed);
+    free(FromFile); free(FromMapped); free(FromBorrowed);
+
+    // The block has not been touched and can be released now
+    free(Raw);
+
+    // Mapping is read only
+    cmsSetLogErrorHandler(ContextID, NULL);
+    hMapped = cmsOpenProfileFromFile(ContextID, "test1.icc", "wm");
+    ResetFatalError(ContextID);
+
+    if (hMapped != NULL) {
+        cmsCloseProfile(ContextID, hMapped);
+        Fail("Memory mapped profile opened for writing");
+        rc = 0;
+    }
+
+    return rc;
+}
+
+// Parsed tags are kept and given back on further reads, whatever the iohandler
+static
+cmsInt32Number CheckTagCache(cmsContext ContextID)
+{
+    cmsHPROFILE hFile, hMem;
+    cmsUInt8Number* Raw;
+    cmsUInt32Number RawSize;
+    cmsInt32Number i, n;
+    cmsInt32Number rc = 1;
+
+    hFile = cmsOpenProfileFromFile(ContextID, "test1.icc", "r");
+    Raw = SavedProfileBytes(ContextID, hFile, &RawSize);
+    cmsCloseProfile(ContextID, hFile);
+    if (Raw == NULL) return 0;
+
+    hFile = cmsOpenProfileFromFile(ContextID, "test1.icc", "r");
+    hMem  = cmsOpenProfileFromMem(ContextID, Raw, RawSize);
+    free(Raw);
+
+    n = cmsGetTagCount(ContextID, hMem);
+    for (i=0; i < n && rc; i++) {
+
+        cmsTagSignature sig = cmsGetTagSignature(ContextID, hMem, (cmsUInt32Number) i);
+        void* First  = cmsReadTag(ContextID, hMem, sig);
+        void* Second = cmsReadTag(ContextID, hMem, sig);
+        void* InFile = cmsReadTag(ContextID, hFile, sig);
+
+        if (First != Second) {
+            Fail("Tag %d was parsed twice", i);
+            rc = 0;
+        }
+
+        if ((First == NULL) != (InFile == NULL)) {
+            Fail("Tag %d read differs between file and memory", i);
+            rc = 0;
+        }
+    }
+
+    cmsCloseProfile(ContextID, hFile);
+    cmsCloseProfile(ContextID, hMem);
+    return rc;
+}
+
+// Decoded LUTs released by the budget are decoded again to the same contents
+static
+cmsInt32Number CheckDecodedTagsBudget(cmsContext ContextID)
+{
+    cmsHPROFILE h;
+    cmsPipeline *Lut, *Copy;
+    cmsFloat32Number In[4] = { 0.1f, 0.5f, 0.7f, 0.2f }, Out1[3], Out2[3];
+    cmsHTRANSFORM xform;
+    cmsInt32Number rc = 1;
+
+    h = cmsOpenProfileFromFile(ContextID, "test1.icc", "r");
+    if (h == NULL) return 0;
+
+    Lut = (cmsPipeline*) cmsReadTag(ContextID, h, cmsSigAToB0Tag);
+    Copy = Lut != NULL ? cmsPipelineDup(ContextID, Lut) : NULL;
+    if (Copy == NULL) { cmsCloseProfile(ContextID, h); Fail("Cannot read AToB0"); return 0; }
+
+    // Room for just one LUT
+    cmsSetDecodedTagsBudget(ContextID, h, 1);
+
+    if (cmsReadTag(ContextID, h, cmsSigBToA0Tag) == NULL) { Fail("Cannot read BToA0"); rc = 0; }
+    if (cmsReadTag(ContextID, h, cmsSigAToB1Tag) == NULL) { Fail("Cannot read AToB1"); rc = 0; }
+
+    Lut = (cmsPipeline*) cmsReadTag(ContextID, h, cmsSigAToB0Tag);
+    if (Lut == NULL) { Fail("Released AToB0 is not decoded again"); rc = 0; }
+    else {
+
+        cmsPipelineEvalFloat(ContextID, In, Out1, Copy);
+        cmsPipelineEvalFloat(ContextID, In, Out2, Lut);
+
+        if (memcmp(Out1, Out2, sizeof(Out1)) != 0) { Fail("AToB0 decoded again differs"); rc = 0; }
+    }
+
+    // Only the last one was left
+    if (cmsDropDecodedTags(ContextID, h) != 1) { Fail("Decoded tags over the budget"); rc = 0; }
+    if (cmsDropDecodedTags(ContextID, h) != 0) { Fail("Decoded tags not released"); rc = 0; }
+
+    cmsSetDecodedTagsBudget(ContextID, h, 0);
+
+    xform = cmsCreateTransform(ContextID, h, TYPE_CMYK_16, h, TYPE_CMYK_16, INTENT_PERCEPTUAL, 0);
+    if (xform == NULL) { Fail("Cannot create transform after releasing tags"); rc = 0; }
+    else cmsDeleteTransform(ContextID, xform);
+
+    cmsPipelineFree(ContextID, Copy);
+    cmsCloseProfile(ContextID, h);
+    return rc;
+}
+
+// Many private tags, some deleted and written again, should be found after saving and reopening
+static
+cmsInt32Number CheckTagDirectoryIndex(cmsContext ContextID)
+{
+    cmsHPROFILE h, hReopen;
+    cmsUInt8Number* Mem;
+    cmsUInt32Number i, Size, Value;
+    cmsInt32Number rc = 1;
+
+    h = cmsCreateProfilePlaceholder(ContextID);
+
+    for (i=0; i < 90; i++) {
+
+        Value = i;
+        cmsWriteRawTag(ContextID, h, (cmsTagSignature) (0x70727630 + i), &Value, sizeof(Value));
+    }
+
+    // Delete every third tag, and write again some of them
+    for (i=0; i < 90; i += 3)
+        cmsWriteTag(ContextID, h, (cmsTagSignature) (0x70727630 + i), NULL);
+
+    for (i=0; i < 90; i += 9) {
+
+        Value = i + 1000;
+        cmsWriteRawTag(ContextID, h, (cmsTagSignature) (0x70727630 + i), &Value, sizeof(Value));
+    }
+
+    Mem = SavedProfileBytes(ContextID, h, &Size);
+    cmsCloseProfile(ContextID, h);
+    if (Mem == NULL) { Fail("Cannot save profile with many tags"); return 0; }
+
+    hReopen = cmsOpenProfileFromMem(ContextID, Mem, Size);
+    free(Mem);
+    if (hReopen == NULL) { Fail("Cannot reopen profile with many tags"); return 0; }
+
+    for (i=0; i < 90 && rc; i++) {
+
+        cmsTagSignature sig = (cmsTagSignature) (0x70727630 + i);
+        cmsUInt32Number Expected = (i % 9 == 0) ? i + 1000 : i;
+        cmsBool Present = (i % 3 != 0) || (i % 9 == 0);
+
+        if (cmsIsTag(ContextID, hReopen, sig) != Present) {
+            Fail("Tag %u presence is wrong", i);
+            rc = 0;
+        }
+        else
+        if (Present && (cmsReadRawTag(ContextID, hReopen, sig, &Value, sizeof(Value)) != sizeof(Value) || Value != Expected)) {
+            Fail("Tag %u has wrong contents", i);
+            rc = 0;
+        }
+    }
+
+    if (cmsIsTag(ContextID, hReopen, cmsSigAToB0Tag)) {
+        Fail("Phantom tag found");
+        rc = 0;
+    }
+
+    cmsCloseProfile(ContextID, hReopen);
+    return rc;
+}
+
 
 static
 cmsInt32Number CheckBadTransforms(cmsContext ContextID)
@@ -8880,6 +9835,325 @@ int CheckGamutCheckFloats(cmsContext ContextID)
     return 1;
 }
 
+// Optimized CLUTs are evaluated in groups of pixels. Results must be the same as pixel by pixel,
+// runs of equal pixels included, and alpha has to be copied on request.
+static
+int CheckBatchTransform(cmsContext ContextID)
+{
+    cmsHPROFILE hsRGB = cmsCreate_sRGBProfile(ContextID);
+    cmsHPROFILE hLab  = cmsCreateLab4Profile(ContextID, NULL);
+    cmsHTRANSFORM xform;
+    cmsPipeline* Lut;
+    cmsUInt16Number In[1000 * 4], Out[1000 * 4];
+    cmsUInt16Number Ref[cmsMAXCHANNELS];
+    cmsUInt32Number i, j;
+    int rc = 1;
+
+    xform = cmsCreateTransform(ContextID, hsRGB, TYPE_RGBA_16, hLab, COLORSPACE_SH(PT_Lab)|EXTRA_SH(1)|CHANNELS_SH(3)|BYTES_SH(2), INTENT_PERCEPTUAL, cmsFLAGS_COPY_ALPHA);
+    cmsCloseProfile(ContextID, hsRGB);
+    cmsCloseProfile(ContextID, hLab);
+
+    if (xform == NULL) return 0;
+
+    Lut = ((_cmsTRANSFORM*) xform)->core->Lut;
+    if (Lut->Eval16NFn == NULL) {
+        Fail("Optimized CLUT without batch evaluator");
+        rc = 0;
+    }
+
+    for (i = 0; i < 1000; i++) {
+
+        cmsUInt32Number k = (i / 5) % 3 == 0 ? i / 5 : i;     // Some runs
+
+        In[i * 4 + 0] = (cmsUInt16Number) (k * 4099);
+        In[i * 4 + 1] = (cmsUInt16Number) (k * 257);
+        In[i * 4 + 2] = (cmsUInt16Number) (65535 - k * 61);
+        In[i * 4 + 3] = (cmsUInt16Number) i;
+    }
+
+    cmsDoTransform(ContextID, xform, In, Out, 1000);
+
+    for (i = 0; i < 1000 && rc; i++) {
+
+        Lut->Eval16Fn(ContextID, In + i * 4, Ref, Lut->Data);
+
+        for (j = 0; j < 3; j++) {
+
+            if (Out[i * 4 + j] != Ref[j]) {
+                Fail("Batch transform differs at pixel %u", i);
+                rc = 0;
+            }
+        }
+
+        if (Out[i * 4 + 3] != In[i * 4 + 3]) {
+            Fail("Alpha not copied at pixel %u", i);
+            rc = 0;
+        }
+    }
+
+    cmsDeleteTransform(ContextID, xform);
+    return rc;
+}
+
+static
+cmsBool SameColorants(cmsContext ContextID, const cmsNAMEDCOLORLIST* a, const cmsNAMEDCOLORLIST* b)
+{
+    cmsUInt32Number i;
+
+    if (a == NULL || b == NULL) return a == b;
+    if (cmsNamedColorCount(ContextID, a) != cmsNamedColorCount(ContextID, b)) return FALSE;
+
+    for (i=0; i < cmsNamedColorCount(ContextID, a); i++) {
+
+        char Name1[cmsMAX_PATH], Name2[cmsMAX_PATH];
+        cmsUInt16Number PCS1[3], PCS2[3];
+
+        if (!cmsNamedColorInfo(ContextID, a, i, Name1, NULL, NULL, PCS1, NULL)) return FALSE;
+        if (!cmsNamedColorInfo(ContextID, b, i, Name2, NULL, NULL, PCS2, NULL)) return FALSE;
+        if (strcmp(Name1, Name2) != 0 || memcmp(PCS1, PCS2, sizeof(PCS1)) != 0) return FALSE;
+    }
+
+    return TRUE;
+}
+
+static
+cmsBool SameSequence(cmsContext ContextID, const cmsSEQ* a, const cmsSEQ* b)
+{
+    cmsUInt32Number i;
+
+    if (a == NULL || b == NULL) return a == b;
+    if (a ->n != b ->n) return FALSE;
+
+    for (i=0; i < a ->n; i++) {
+
+        char Desc1[256], Desc2[256];
+
+        Desc1[0] = Desc2[0] = 0;
+        cmsMLUgetASCII(ContextID, a ->seq[i].Description, cmsNoLanguage, cmsNoCountry, Desc1, sizeof(Desc1));
+        cmsMLUgetASCII(ContextID, b ->seq[i].Description, cmsNoLanguage, cmsNoCountry, Desc2, sizeof(Desc2));
+
+        if (strcmp(Desc1, Desc2) != 0) return FALSE;
+        if (a ->seq[i].deviceMfg != b ->seq[i].deviceMfg || a ->seq[i].technology != b ->seq[i].technology) return FALSE;
+        if (memcmp(a ->seq[i].ProfileID.ID8, b ->seq[i].ProfileID.ID8, 16) != 0) return FALSE;
+    }
+
+    return TRUE;
+}
+
+// Saves a transform, loads it back and compares both on the same pixels
+static
+int SavedTransformMatches(cmsContext ContextID, cmsUInt32Number nProfiles, cmsHPROFILE hChain[],
+                          cmsUInt32Number InFmt, cmsUInt32Number OutFmt, cmsUInt32Number dwFlags)
+{
+    cmsHPROFILE hProfiles[3];
+    cmsHTRANSFORM xform, xformLoaded;
+    cmsUInt32Number i, Size, nPixels = 4096;
+    cmsUInt32Number InSize  = T_BYTES(InFmt)  * (T_CHANNELS(InFmt) + T_EXTRA(InFmt));
+    cmsUInt32Number OutSize = T_BYTES(OutFmt) * (T_CHANNELS(OutFmt) + T_EXTRA(OutFmt));
+    cmsUInt8Number *Blob, *In, *Out1, *Out2;
+    int rc = 1;
+
+    xform = cmsCreateMultiprofileTransform(ContextID, hChain, nProfiles, InFmt, OutFmt, INTENT_PERCEPTUAL, dwFlags);
+    if (xform == NULL) return 0;
+
+    if (!cmsSaveTransformToMem(ContextID, xform, nProfiles, hChain, NULL, &Size)) {
+        cmsDeleteTransform(ContextID, xform);
+        Fail("Cannot compute size of saved transform");
+        return 0;
+    }
+
+    Blob = (cmsUInt8Number*) malloc(Size);
+    if (!cmsSaveTransformToMem(ContextID, xform, nProfiles, hChain, Blob, &Size)) {
+        free(Blob);
+        cmsDeleteTransform(ContextID, xform);
+        Fail("Cannot save transform");
+        return 0;
+    }
+
+    xformLoaded = cmsLoadTransformFromMem(ContextID, Blob, Size, nProfiles, hChain, InFmt, OutFmt);
+    if (xformLoaded == NULL) {
+        free(Blob);
+        cmsDeleteTransform(ContextID, xform);
+        Fail("Cannot load saved transform");
+        return 0;
+    }
+
+    In   = (cmsUInt8Number*) malloc(nPixels * InSize);
+    Out1 = (cmsUInt8Number*) malloc(nPixels * OutSize);
+    Out2 = (cmsUInt8Number*) malloc(nPixels * OutSize);
+
+    for (i=0; i < nPixels * InSize; i++)
+        In[i] = (cmsUInt8Number) ((i * 2654435761U) >> 13);
+
+    cmsDoTransform(ContextID, xform, In, Out1, nPixels);
+    cmsDoTransform(ContextID, xformLoaded, In, Out2, nPixels);
+
+    if (memcmp(Out1, Out2, nPixels * OutSize) != 0) {
+        Fail("Loaded transform gives different results");
+        rc = 0;
+    }
+
+    if (!SameColorants(ContextID, ((_cmsTRANSFORM*) xform) ->core ->InputColorant, ((_cmsTRANSFORM*) xformLoaded) ->core ->InputColorant) ||
+        !SameColorants(ContextID, ((_cmsTRANSFORM*) xform) ->core ->OutputColorant, ((_cmsTRANSFORM*) xformLoaded) ->core ->OutputColorant) ||
+        !SameSequence(ContextID, ((_cmsTRANSFORM*) xform) ->core ->Sequence, ((_cmsTRANSFORM*) xformLoaded) ->core ->Sequence)) {
+        Fail("Loaded transform lost colorant tables or profile sequence");
+        rc = 0;
+    }
+
+    cmsDeleteTransform(ContextID, xformLoaded);
+
+    // Other formats or other profiles should not be accepted
+    cmsSetLogErrorHandler(ContextID, NULL);
+
+    if (cmsLoadTransformFromMem(ContextID, Blob, Size, nProfiles, hChain, InFmt, TYPE_CMYK_16) != NULL) {
+        Fail("Saved transform accepted wrong formats");
+        rc = 0;
+    }
+
+    for (i=0; i < nProfiles; i++)
+        hProfiles[i] = hChain[nProfiles - 1 - i];
+
+    if (hChain[0] != hChain[nProfiles - 1] &&
+        cmsLoadTransformFromMem(ContextID, Blob, Size, nProfiles, hProfiles, InFmt, OutFmt) != NULL) {
+        Fail("Saved transform accepted wrong profiles");
+        rc = 0;
+    }
+
+    Blob[0] ^= 0xFF;
+    if (cmsLoadTransformFromMem(ContextID, Blob, Size, 0, NULL, InFmt, OutFmt) != NULL) {
+        Fail("Saved transform accepted bad signature");
+        rc = 0;
+    }
+
+    ResetFatalError(ContextID);
+
+    free(In); free(Out1); free(Out2); free(Blob);
+    cmsDeleteTransform(ContextID, xform);
+    return rc;
+}
+
+static
+int CheckSavedTransforms(cmsContext ContextID)
+{
+    cmsHPROFILE hsRGB  = cmsCreate_sRGBProfile(ContextID);
+    cmsHPROFILE hLab   = cmsCreateLab4Profile(ContextID, NULL);
+    cmsHPROFILE hAbove = Create_AboveRGB(ContextID);
+    cmsHPROFILE hGray  = Create_Gray22(ContextID);
+    cmsHPROFILE hLin   = Create_Gray30(ContextID);
+    cmsHPROFILE hT61   = cmsOpenProfileFromFile(ContextID, "ibm-t61.icc", "r");
+    cmsHPROFILE hCMYK  = cmsOpenProfileFromFile(ContextID, "test1.icc", "r");
+    cmsHPROFILE hNamed = cmsCreate_sRGBProfile(ContextID);
+    cmsHPROFILE MatShaper[2], ToLab[2], FromLab[2], Gray[2], Same[2], ThruLab[3], Prelin[2], Printer[2], Named[2];
+    cmsNAMEDCOLORLIST* Colorants;
+    cmsUInt16Number PCS[3] = { 0x8000, 0x4000, 0x2000 };
+    int rc = 1;
+
+    // Colorant tables on both ends
+    Colorants = cmsAllocNamedColorList(ContextID, 3, 0, "", "");
+    cmsAppendNamedColor(ContextID, Colorants, "Red", PCS, NULL);
+    cmsAppendNamedColor(ContextID, Colorants, "Green", PCS, NULL);
+    cmsAppendNamedColor(ContextID, Colorants, "Blue", PCS, NULL);
+    cmsWriteTag(ContextID, hNamed, cmsSigColorantTableTag, Colorants);
+    cmsFreeNamedColorList(ContextID, Colorants);
+
+    MatShaper[0] = hsRGB; MatShaper[1] = hAbove;
+    ToLab[0]     = hsRGB; ToLab[1]     = hLab;
+    FromLab[0]   = hLab;  FromLab[1]   = hsRGB;
+    Gray[0]      = hGray; Gray[1]      = hLin;
+    Same[0]      = hsRGB; Same[1]      = hsRGB;
+    ThruLab[0]   = hsRGB; ThruLab[1]   = hLab; ThruLab[2] = hAbove;
+    Prelin[0]    = hT61;  Prelin[1]    = hsRGB;
+    Printer[0]   = hCMYK; Printer[1]   = hsRGB;
+    Named[0]     = hNamed; Named[1]    = hNamed;
+
+    rc &= SavedTransformMatches(ContextID, 2, MatShaper, TYPE_RGB_8,   TYPE_RGB_8,   0);
+    rc &= SavedTransformMatches(ContextID, 2, MatShaper, TYPE_RGB_16,  TYPE_RGB_16,  0);
+    rc &= SavedTransformMatches(ContextID, 2, MatShaper, TYPE_RGB_16,  TYPE_RGB_16,  cmsFLAGS_CLUT_PRE_LINEARIZATION);
+    rc &= SavedTransformMatches(ContextID, 3, ThruLab,   TYPE_RGB_8,   TYPE_RGB_8,   0);
+    rc &= SavedTransformMatches(ContextID, 2, Prelin,    TYPE_RGB_8,   TYPE_RGB_8,   0);
+    rc &= SavedTransformMatches(ContextID, 2, Printer,   TYPE_CMYK_16, TYPE_RGB_16,  0);
+    rc &= SavedTransformMatches(ContextID, 2, ToLab,     TYPE_RGB_8,   TYPE_Lab_16,  0);
+    rc &= SavedTransformMatches(ContextID, 2, FromLab,   TYPE_Lab_16,  TYPE_RGB_16,  0);
+    rc &= SavedTransformMatches(ContextID, 2, Gray,      TYPE_GRAY_8,  TYPE_GRAY_8,  0);
+    rc &= SavedTransformMatches(ContextID, 2, Same,      TYPE_RGB_16,  TYPE_RGB_16,  cmsFLAGS_NOCACHE);
+    rc &= SavedTransformMatches(ContextID, 3, ThruLab,   TYPE_RGB_8,   TYPE_RGB_8,   cmsFLAGS_KEEP_SEQUENCE);
+    rc &= SavedTransformMatches(ContextID, 2, Named,     TYPE_RGB_16,  TYPE_RGB_16,  cmsFLAGS_KEEP_SEQUENCE);
+
+    cmsCloseProfile(ContextID, hsRGB);
+    cmsCloseProfile(ContextID, hLab);
+    cmsCloseProfile(ContextID, hAbove);
+    cmsCloseProfile(ContextID, hGray);
+    cmsCloseProfile(ContextID, hLin);
+    cmsCloseProfile(ContextID, hT61);
+    cmsCloseProfile(ContextID, hCMYK);
+    cmsCloseProfile(ContextID, hNamed);
+    return rc;
+}
+
+// A palette of scattered colors, so the 1-pixel cache misses but the multi-entry cache does not
+static
+int CheckPixelHashCache(cmsContext ContextID)
+{
+    cmsHPROFILE hsRGB = cmsCreate_sRGBProfile(ContextID);
+    cmsHPROFILE hLab  = cmsCreateLab4Profile(ContextID, NULL);
+    cmsHTRANSFORM xformPlain, xformHash;
+    cmsUInt8Number* In;
+    cmsUInt16Number *OutPlain, *OutHash;
+    cmsUInt32Number i, Hits, Misses, Hits2, Misses2, nPixels = 256 * 64;
+    int rc = 1;
+
+    xformPlain = cmsCreateTransform(ContextID, hsRGB, TYPE_RGB_8, hLab, TYPE_Lab_16, INTENT_PERCEPTUAL, 0);
+    xformHash  = cmsCreateTransform(ContextID, hsRGB, TYPE_RGB_8, hLab, TYPE_Lab_16, INTENT_PERCEPTUAL, cmsFLAGS_HASHCACHE);
+
+    cmsCloseProfile(ContextID, hsRGB);
+    cmsCloseProfile(ContextID, hLab);
+
+    In       = (cmsUInt8Number*) malloc(nPixels * 3);
+    OutPlain = (cmsUInt16Number*) malloc(nPixels * 3 * sizeof(cmsUInt16Number));
+    OutHash  = (cmsUInt16Number*) malloc(nPixels * 3 * sizeof(cmsUInt16Number));
+
+    for (i = 0; i < nPixels; i++) {
+
+        cmsUInt32Number k = (i * 7) % 97;
+
+        In[i * 3 + 0] = (cmsUInt8Number) (k * 37);
+        In[i * 3 + 1] = (cmsUInt8Number) (k * 101);
+        In[i * 3 + 2] = (cmsUInt8Number) (255 - k);
+    }
+
+    cmsDoTransformLineStride(ContextID, xformPlain, In, OutPlain, 256, 64, 256 * 3, 256 * 3 * sizeof(cmsUInt16Number), 0, 0);
+    cmsDoTransformLineStride(ContextID, xformHash,  In, OutHash,  256, 64, 256 * 3, 256 * 3 * sizeof(cmsUInt16Number), 0, 0);
+
+    if (memcmp(OutPlain, OutHash, nPixels * 3 * sizeof(cmsUInt16Number)) != 0) {
+        Fail("Multi-entry cache gives different results");
+        rc = 0;
+    }
+
+    cmsGetTransformPixelCacheStats(ContextID, xformHash, &Hits, &Misses);
+    if (Hits + Misses != nPixels || Misses > 97) {
+        Fail("Unexpected cache counters: %u hits, %u misses", Hits, Misses);
+        rc = 0;
+    }
+
+    // The table stays warm across calls, so colors seen before hit even on small calls
+    cmsDoTransform(ContextID, xformHash, In, OutHash, 16);
+    if (memcmp(OutPlain, OutHash, 16 * 3 * sizeof(cmsUInt16Number)) != 0) {
+        Fail("Multi-entry cache gives different results on small calls");
+        rc = 0;
+    }
+
+    cmsGetTransformPixelCacheStats(ContextID, xformHash, &Hits2, &Misses2);
+    if (Hits2 != Hits + 16 || Misses2 != Misses) {
+        Fail("Multi-entry cache is not kept across calls: %u hits, %u misses", Hits2, Misses2);
+        rc = 0;
+    }
+
+    free(In); free(OutPlain); free(OutHash);
+    cmsDeleteTransform(ContextID, xformPlain);
+    cmsDeleteTransform(ContextID, xformHash);
+    return rc;
+}
+
 
 // --------------------------------------------------------------------------------------------------
 // P E R F O R M A N C E   C H E C K S
@@ -9622,6 +10896,7 @@ int main(int argc, const char** argv)
 
     Check(ctx, "Base types", CheckBaseTypes);
     Check(ctx, "endianness", CheckEndianness);
+    Check(ctx, "Bulk readers", CheckBulkReaders);
     Check(ctx, "quick floor", CheckQuickFloor);
     Check(ctx, "quick floor word", CheckQuickFloorWord);
     Check(ctx, "Fixed point 15.16 representation", CheckFixedPoint15_16);
@@ -9655,6 +10930,8 @@ int main(int argc, const char** argv)
     Check(ctx, "3D interpolation Tetrahedral (float) ", Check3DinterpolationFloatTetrahedral);
     Check(ctx, "3D interpolation Trilinear (float) ", Check3DinterpolationFloatTrilinear);
     Check(ctx, "3D interpolation Tetrahedral (16) ", Check3DinterpolationTetrahedral16);
+    Check(ctx, "3D interpolation Tetrahedral (16) block", Check3DinterpolationTetrahedral16Block);
+    Check(ctx, "Batch interpolation", CheckBatchInterpolation);
     Check(ctx, "3D interpolation Trilinear (16) ", Check3DinterpolationTrilinear16);
 
     if (Exhaustive) {
@@ -9734,11 +11011,17 @@ int main(int argc, const char** argv)
     Check(ctx, "XYZ to XYZ LUT (float only) ", CheckXYZ2XYZLUT);
     Check(ctx, "Lab to Lab MAT LUT (float only) ", CheckLab2LabMatLUT);
     Check(ctx, "Named Color LUT", CheckNamedColorLUT);
+    Check(ctx, "Block evaluation of pipelines", CheckPipelineEvalN);
+    Check(ctx, "Row samplers", CheckRowSampler);
+    Check(ctx, "Error driven CLUT grid", CheckGridErrorBudget);
     Check(ctx, "Usual formatters", CheckFormatters16);
     Check(ctx, "Floating point formatters", CheckFormattersFloat);
+    Check(ctx, "Block formatters", CheckBlockFormatters);
 
 #ifndef CMS_NO_HALF_SUPPORT
     Check(ctx, "HALF formatters", CheckFormattersHalf);
+    Check(ctx, "HALF arrays", CheckHalfArrays);
+    Check(ctx, "HALF block formatters", CheckBlockFormattersHalf);
 #endif
     // ChangeBuffersFormat
     Check(ctx, "ChangeBuffersFormat", CheckChangeBufferFormat);
@@ -9758,6 +11041,10 @@ int main(int argc, const char** argv)
 
     // Error reporting
     Check(ctx, "Error reporting on bad profiles", CheckErrReportingOnBadProfiles);
+    Check(ctx, "Mapped and borrowed profiles", CheckMappedAndBorrowedProfiles);
+    Check(ctx, "Tag cache", CheckTagCache);
+    Check(ctx, "Tag directory index", CheckTagDirectoryIndex);
+    Check(ctx, "Decoded tags budget", CheckDecodedTagsBudget);
     Check(ctx, "Error reporting on bad transforms", CheckErrReportingOnBadTransforms);
 
     // Transforms
@@ -9831,6 +11118,9 @@ int main(int argc, const char** argv)
     Check(ctx, "Bad CGATS file", CheckBadCGATS);
     Check(ctx, "Saving linearization devicelink", CheckSaveLinearizationDevicelink);
     Check(ctx, "Gamut check on floats", CheckGamutCheckFloats);
+    Check(ctx, "Batch evaluation in transforms", CheckBatchTransform);
+    Check(ctx, "Multi-entry pixel cache", CheckPixelHashCache);
+    Check(ctx, "Saved transforms", CheckSavedTransforms);
     }
 
     if (DoPluginTests)
@@ -9840,6 +11130,8 @@ int main(int argc, const char** argv)
         Check(ctx, "Simple context functionality", CheckSimpleContext);
         Check(ctx, "Alarm codes context", CheckAlarmColorsContext);
         Check(ctx, "Adaptation state context", CheckAdaptationStateContext);
+        Check(ctx, "Transform cache context", CheckTransformCacheContext);
+        Check(ctx, "Profile pool context", CheckProfilePoolContext);
         Check(ctx, "1D interpolation plugin", CheckInterp1DPlugin);
         Check(ctx, "3D interpolation plugin", CheckInterp3DPlugin);
         Check(ctx, "Parametric curve plugin", CheckParametricCurvePlugin);
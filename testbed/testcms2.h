@@ -74,6 +74,8 @@ cmsInt32Number CheckSimpleContext(cmsContext ContextID);
 cmsInt32Number CheckAllocContext(cmsContext ContextID);
 cmsInt32Number CheckAlarmColorsContext(cmsContext ContextID);
 cmsInt32Number CheckAdaptationStateContext(cmsContext ContextID);
+cmsInt32Number CheckTransformCacheContext(cmsContext ContextID);
+cmsInt32Number CheckProfilePoolContext(cmsContext ContextID);
 cmsInt32Number CheckInterp1DPlugin(cmsContext ContextID);
 cmsInt32Number CheckInterp3DPlugin(cmsContext ContextID);
 cmsInt32Number CheckParametricCurvePlugin(cmsContext ContextID);
@@ -212,6 +212,288 @@ cmsInt32Number CheckAdaptationStateContext(cmsContext ContextID)
     return rc;
 }
 
+// --------------------------------------------------------------------------------------------------
+// Transform cache
+// --------------------------------------------------------------------------------------------------
+
+static
+cmsInt32Number CheckCacheStats(cmsContext ctx, cmsUInt32Number ExpectedHits, cmsUInt32Number ExpectedMisses)
+{
+    cmsUInt32Number Hits, Misses;
+
+    cmsGetTransformCacheStats(ctx, &Hits, &Misses);
+
+    if (Hits != ExpectedHits || Misses != ExpectedMisses) {
+        Fail("Transform cache: %u hits, %u misses, expected %u, %u", Hits, Misses, ExpectedHits, ExpectedMisses);
+        return 0;
+    }
+
+    return 1;
+}
+
+// Transforms are shared, survive the deletion of their siblings and are evicted by LRU
+cmsInt32Number CheckTransformCacheContext(cmsContext ContextID)
+{
+    cmsInt32Number rc = 1;
+    cmsContext c1;
+    cmsHPROFILE hsRGB, hLab, hLab2, hXYZ, hA, hB;
+    cmsHTRANSFORM x1, x2, x3, x4, x5;
+    cmsUInt8Number rgb[3] = { 10, 200, 90 };
+    cmsUInt16Number Lab1[3], Lab2[3];
+    cmsProfileID ID, Zero;
+
+    memset(&Zero, 0, sizeof(Zero));
+
+    c1 = WatchDogContext(NULL);
+    cmsSetTransformCacheSize(c1, 2);
+
+    hsRGB = cmsCreate_sRGBProfile(c1);
+    hLab  = cmsCreateLab4Profile(c1, NULL);
+    hXYZ  = cmsCreateXYZProfile(c1);
+
+    x1 = cmsCreateTransform(c1, hsRGB, TYPE_RGB_8, hLab, TYPE_Lab_16, INTENT_PERCEPTUAL, 0);
+    x2 = cmsCreateTransform(c1, hsRGB, TYPE_RGB_8, hLab, TYPE_Lab_16, INTENT_PERCEPTUAL, 0);
+    rc &= CheckCacheStats(c1, 1, 1);
+
+    cmsDoTransform(c1, x1, rgb, Lab1, 1);
+    cmsDeleteTransform(c1, x1);
+    cmsDoTransform(c1, x2, rgb, Lab2, 1);
+
+    if (memcmp(Lab1, Lab2, sizeof(Lab1)) != 0) {
+        Fail("Transform cache: shared transforms disagree");
+        rc = 0;
+    }
+
+    // Two more keys push the first one out
+    x3 = cmsCreateTransform(c1, hsRGB, TYPE_RGB_8, hXYZ, TYPE_XYZ_16, INTENT_PERCEPTUAL, 0);
+    x4 = cmsCreateTransform(c1, hsRGB, TYPE_RGB_8, hLab, TYPE_Lab_16, INTENT_RELATIVE_COLORIMETRIC, 0);
+    x5 = cmsCreateTransform(c1, hsRGB, TYPE_RGB_8, hLab, TYPE_Lab_16, INTENT_PERCEPTUAL, 0);
+    rc &= CheckCacheStats(c1, 1, 4);
+
+    cmsDeleteTransform(c1, x2);
+    cmsDeleteTransform(c1, x3);
+    cmsDeleteTransform(c1, x4);
+    cmsDeleteTransform(c1, x5);
+
+    // Keys come from the contents. Headers are left alone and an ID that doesn't match is ignored
+    cmsGetHeaderProfileID(c1, hsRGB, ID.ID8);
+    if (memcmp(&ID, &Zero, sizeof(ID)) != 0) {
+        Fail("Transform cache: profile header modified");
+        rc = 0;
+    }
+
+    hLab2 = cmsCreateLab2Profile(c1, NULL);
+
+    memset(&ID, 0x5A, sizeof(ID));
+    cmsSetHeaderProfileID(c1, hLab, ID.ID8);
+    cmsSetHeaderProfileID(c1, hLab2, ID.ID8);
+
+    x1 = cmsCreateTransform(c1, hsRGB, TYPE_RGB_8, hLab, TYPE_Lab_16, INTENT_SATURATION, 0);
+    x2 = cmsCreateTransform(c1, hsRGB, TYPE_RGB_8, hLab2, TYPE_Lab_16, INTENT_SATURATION, 0);
+    rc &= CheckCacheStats(c1, 1, 6);
+
+    cmsDeleteTransform(c1, x1);
+    cmsDeleteTransform(c1, x2);
+    cmsCloseProfile(c1, hLab2);
+
+    // Handles on the same file share the key, whatever tags have been decoded, until the contents change
+    hA = cmsOpenProfileFromFile(c1, "test1.icc", "r");
+    hB = cmsOpenProfileFromFile(c1, "test1.icc", "r");
+    cmsReadTag(c1, hA, cmsSigAToB0Tag);
+
+    x1 = cmsCreateTransform(c1, hsRGB, TYPE_RGB_8, hA, TYPE_CMYK_16, INTENT_PERCEPTUAL, 0);
+    x2 = cmsCreateTransform(c1, hsRGB, TYPE_RGB_8, hB, TYPE_CMYK_16, INTENT_PERCEPTUAL, 0);
+    rc &= CheckCacheStats(c1, 2, 7);
+
+    cmsSetHeaderManufacturer(c1, hB, 0x12345678);
+    x3 = cmsCreateTransform(c1, hsRGB, TYPE_RGB_8, hB, TYPE_CMYK_16, INTENT_PERCEPTUAL, 0);
+    rc &= CheckCacheStats(c1, 2, 8);
+
+    cmsDeleteTransform(c1, x1);
+    cmsDeleteTransform(c1, x2);
+    cmsDeleteTransform(c1, x3);
+    cmsCloseProfile(c1, hA);
+    cmsCloseProfile(c1, hB);
+
+    cmsCloseProfile(c1, hsRGB);
+    cmsCloseProfile(c1, hLab);
+    cmsCloseProfile(c1, hXYZ);
+
+    // Cached entries are released along with the context
+    cmsDeleteContext(c1);
+
+    return rc;
+}
+
+// --------------------------------------------------------------------------------------------------
+// Profile pool
+// --------------------------------------------------------------------------------------------------
+
+static
+void* SaveProfileBlock(cmsContext ctx, cmsHPROFILE hProfile, cmsUInt32Number* Size)
+{
+    void* Mem;
+
+    if (!cmsSaveProfileToMem(ctx, hProfile, NULL, Size)) return NULL;
+
+    Mem = malloc(*Size);
+    if (Mem == NULL) return NULL;
+
+    if (!cmsSaveProfileToMem(ctx, hProfile, Mem, Size)) {
+        free(Mem);
+        return NULL;
+    }
+
+    cmsCloseProfile(ctx, hProfile);
+    return Mem;
+}
+
+static
+cmsInt32Number CheckPoolStats(cmsContext ctx, cmsUInt32Number ExpectedHits, cmsUInt32Number ExpectedMisses)
+{
+    cmsUInt32Number Hits, Misses;
+
+    cmsGetProfilePoolStats(ctx, &Hits, &Misses);
+
+    if (Hits != ExpectedHits || Misses != ExpectedMisses) {
+        Fail("Profile pool: %u hits, %u misses, expected %u, %u", Hits, Misses, ExpectedHits, ExpectedMisses);
+        return 0;
+    }
+
+    return 1;
+}
+
+// Same contents give same handle, handles are read only and outlive their eviction
+cmsInt32Number CheckProfilePoolContext(cmsContext ContextID)
+{
+    cmsInt32Number rc = 1;
+    cmsContext c1;
+    void *sRGB, *Lab, *Ink;
+    cmsUInt32Number sRGBSize, LabSize, InkSize;
+    cmsHPROFILE h1, h2, h3, h4;
+    cmsHTRANSFORM xform;
+    cmsUInt8Number rgb[3] = { 10, 200, 90 };
+    cmsUInt16Number Lab16[3];
+
+    c1 = WatchDogContext(NULL);
+
+    sRGB = SaveProfileBlock(c1, cmsCreate_sRGBProfile(c1), &sRGBSize);
+    Lab  = SaveProfileBlock(c1, cmsCreateLab4Profile(c1, NULL), &LabSize);
+    if (sRGB == NULL || Lab == NULL) {
+        Fail("Profile pool: cannot save profiles");
+        return 0;
+    }
+
+    // Disabled pool just opens the profile
+    h1 = cmsOpenProfileFromMemPooled(c1, sRGB, sRGBSize);
+    rc &= CheckPoolStats(c1, 0, 0);
+    cmsCloseProfile(c1, h1);
+
+    // Room for one profile only
+    cmsSetProfilePoolSize(c1, sRGBSize > LabSize ? sRGBSize : LabSize);
+
+    h1 = cmsOpenProfileFromMemPooled(c1, sRGB, sRGBSize);
+    h2 = cmsOpenProfileFromMemPooled(c1, sRGB, sRGBSize);
+    rc &= CheckPoolStats(c1, 1, 1);
+
+    if (h1 == NULL || h1 != h2) {
+        Fail("Profile pool: same contents not shared");
+        rc = 0;
+    }
+
+    cmsSetLogErrorHandler(c1, NULL);
+    if (cmsWriteTag(c1, h1, cmsSigCopyrightTag, NULL)) {
+        Fail("Profile pool: pooled profile is writable");
+        rc = 0;
+    }
+
+    // Header changes would show thru every handle and leave the pool key stale
+    cmsSetHeaderRenderingIntent(c1, h1, INTENT_SATURATION);
+    cmsSetHeaderFlags(c1, h1, cmsEmbeddedProfileTrue);
+    cmsSetColorSpace(c1, h1, cmsSigCmykData);
+    cmsSetEncodedICCversion(c1, h1, 0x2100000);
+    cmsSetProfileVersion(c1, h1, 2.0);
+    if (cmsGetHeaderRenderingIntent(c1, h2) == INTENT_SATURATION || cmsGetHeaderFlags(c1, h2) != 0 ||
+        cmsGetColorSpace(c1, h2) != cmsSigRgbData || cmsGetEncodedICCversion(c1, h2) == 0x2100000 ||
+        cmsGetEncodedICCversion(c1, h2) == 0x2000000 ||
+        cmsMD5computeID(c1, h1)) {
+        Fail("Profile pool: header of a pooled profile can be changed");
+        rc = 0;
+    }
+
+    // Other handles may be using the decoded tags
+    if (cmsSetDecodedTagsBudget(c1, h1, 1) || cmsDropDecodedTags(c1, h1) != 0) {
+        Fail("Profile pool: decoded tags of a pooled profile can be released");
+        rc = 0;
+    }
+    ResetFatalError(c1);
+
+    // Evicts sRGB, which is still usable thru both handles
+    h3 = cmsOpenProfileFromMemPooled(c1, Lab, LabSize);
+    cmsCloseProfile(c1, h1);
+
+    xform = cmsCreateTransform(c1, h2, TYPE_RGB_8, h3, TYPE_Lab_16, INTENT_PERCEPTUAL, 0);
+    if (xform == NULL) {
+        Fail("Profile pool: evicted profile is not usable");
+        rc = 0;
+    }
+    else {
+        cmsDoTransform(c1, xform, rgb, Lab16, 1);
+        cmsDeleteTransform(c1, xform);
+    }
+
+    cmsCloseProfile(c1, h2);
+
+    h4 = cmsOpenProfileFromMemPooled(c1, sRGB, sRGBSize);
+    rc &= CheckPoolStats(c1, 1, 3);
+
+    cmsCloseProfile(c1, h3);
+    cmsCloseProfile(c1, h4);
+
+    // Decoded tags count in the pool size, the CLUT of this link is way bigger than the slack left
+    Ink = SaveProfileBlock(c1, cmsCreateInkLimitingDeviceLink(c1, cmsSigCmykData, 150), &InkSize);
+    if (Ink == NULL) {
+        Fail("Profile pool: cannot save profiles");
+        rc = 0;
+    }
+    else {
+
+        cmsSetProfilePoolSize(c1, InkSize + 1024);
+
+        h1 = cmsOpenProfileFromMemPooled(c1, Ink, InkSize);
+        h2 = cmsOpenProfileFromMemPooled(c1, Ink, InkSize);
+        rc &= CheckPoolStats(c1, 2, 4);
+
+        if (cmsReadTag(c1, h1, cmsSigAToB0Tag) == NULL) {
+            Fail("Profile pool: cannot read pooled tag");
+            rc = 0;
+        }
+
+        // Still usable thru the other handle once evicted
+        if (cmsReadTag(c1, h2, cmsSigAToB0Tag) == NULL) {
+            Fail("Profile pool: evicted profile is not usable");
+            rc = 0;
+        }
+
+        cmsCloseProfile(c1, h1);
+        cmsCloseProfile(c1, h2);
+
+        h1 = cmsOpenProfileFromMemPooled(c1, Ink, InkSize);
+        rc &= CheckPoolStats(c1, 2, 5);
+        cmsCloseProfile(c1, h1);
+
+        free(Ink);
+    }
+
+    free(sRGB);
+    free(Lab);
+
+    // Pooled profiles are released along with the context
+    cmsDeleteContext(c1);
+
+    return rc;
+}
+
 // --------------------------------------------------------------------------------------------------
 // Interpolation plugin check: A fake 1D and 3D interpolation will be used to test the functionality.
 // --------------------------------------------------------------------------------------------------
@@ -281,7 +563,8 @@ static
 cmsPluginInterpolation InterpPluginSample = {
 
     { cmsPluginMagicNumber, 2060-2000, cmsPluginInterpolationSig, NULL },
-    my_Interpolators_Factory
+    my_Interpolators_Factory,
+    NULL
 };
 
 
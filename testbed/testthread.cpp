@@ -1,5 +1,6 @@
 
 #include <windows.h>
+#include <stdio.h>
 #include "lcms2mt_plugin.h"
 
 #include "monolithic_examples.h"
@@ -82,6 +83,66 @@ static DWORD WINAPI one_thread(LPVOID lpParameter)
     return 0;
 }
 
+// Scaling of context resolution. Every thread works on its own context while many others
+// are alive, so any global lock or list walk when resolving a context shows as poor scaling.
+
+#define NCONTEXTS  256
+#define NLOOKUPS   2000000
+
+static cmsContext bench_ctx[NCONTEXTS];
+
+static DWORD WINAPI lookup_thread(LPVOID lpParameter)
+{
+    cmsContext c = bench_ctx[(INT_PTR) lpParameter];
+    int i;
+
+    // Each call has to resolve the context to reach the adaptation state
+    for (i=0; i < NLOOKUPS; i++)
+        cmsSetAdaptationState(c, -1);
+
+    return 0;
+}
+
+static
+void bench_context_lookup(void)
+{
+    HANDLE threads[16];
+    LARGE_INTEGER freq, t0, t1;
+    char msg[256];
+    int i, n;
+
+    // The first ones created are the deepest in the list of contexts
+    for (i=0; i < NCONTEXTS; i++)
+        bench_ctx[i] = cmsCreateContext(NULL, 0);
+
+    QueryPerformanceFrequency(&freq);
+
+    for (n=1; n <= 16; n *= 2) {
+
+        QueryPerformanceCounter(&t0);
+
+        for (i=0; i < n; i++) {
+
+            DWORD threadid;
+            threads[i] = CreateThread(NULL, 0, lookup_thread, (LPVOID) (INT_PTR) i, 0, &threadid);
+        }
+
+        WaitForMultipleObjects(n, threads, TRUE, INFINITE);
+
+        QueryPerformanceCounter(&t1);
+
+        for (i=0; i < n; i++)
+            CloseHandle(threads[i]);
+
+        sprintf(msg, "Context lookup, %2d threads: %8.2f M lookups/s\n", n,
+                ((double) n * NLOOKUPS) / ((double) (t1.QuadPart - t0.QuadPart) / freq.QuadPart) / 1.0E6);
+        OutputDebugStringA(msg);
+    }
+
+    for (i=0; i < NCONTEXTS; i++)
+        cmsDeleteContext(bench_ctx[i]);
+}
+
 int WINAPI WinMain(HINSTANCE hInstance,HINSTANCE hPrevInstance,LPSTR lpCmdLine,int nCmdShow)
 {
     int i;
@@ -116,6 +177,8 @@ int WINAPI WinMain(HINSTANCE hInstance,HINSTANCE hPrevInstance,LPSTR lpCmdLine,i
     cmsCloseProfile(ctx, prof_cmyk);
     cmsDeleteContext(ctx);
 
+    bench_context_lookup();
+
     OutputDebugString(L"Test Done\n");
 
     return rc;